@@ -107,3 +107,40 @@ void* BufferFront(const Buffer_t* const buffer)
     return &(buffer->data[buffer->start]);
 }
 
+uint16_t BufferContiguousCount(const Buffer_t* const buffer)
+{
+    ASSERT(buffer != NULL);
+
+    if (buffer->end >= buffer->start)
+    {
+        return (buffer->end - buffer->start) / buffer->typeSize;
+    }
+
+    return (buffer->length - buffer->start) / buffer->typeSize;
+}
+
+void BufferSkip(Buffer_t* const buffer, uint16_t count)
+{
+    ASSERT(buffer != NULL);
+    ASSERT(count <= BufferCount(buffer));
+
+    buffer->start = (buffer->start + count * buffer->typeSize) % buffer->length;
+}
+
+bool BufferCommit(Buffer_t* const buffer, uint16_t count)
+{
+    ASSERT(buffer != NULL);
+
+    uint16_t space = BufferCapacity(buffer) - BufferCount(buffer);
+    bool fit = (count <= space);
+
+    if (!fit)
+    {
+        /* head index belongs to the reader: keep the oldest data, drop the rest */
+        count = space;
+    }
+
+    buffer->end = (buffer->end + count * buffer->typeSize) % buffer->length;
+
+    return fit;
+}
@@ -64,4 +64,26 @@ bool BufferGet(Buffer_t* const buffer, void* data, uint16_t size);
  * */
 void* BufferFront(const Buffer_t* const buffer);
 
+/*Brief: Calculate number of items stored contiguously from the head element
+ * [in] - buffer - pointer to buffer object
+ * [out] - number of items that can be accessed via BufferFront without wrap-around
+ * */
+uint16_t BufferContiguousCount(const Buffer_t* const buffer);
+
+/*Brief: Discard items from the head of circular buffer
+ * [in] - buffer - pointer to buffer object
+ * [in] - count - number of items to discard
+ * [out] - none
+ * */
+void BufferSkip(Buffer_t* const buffer, uint16_t count);
+
+/*Brief: Append items already written into the storage (e.g. by DMA)
+ * NOTE: only the tail index is written, so the writer may commit while
+ * the reader gets or skips items (single producer, single consumer)
+ * [in] - buffer - pointer to buffer object
+ * [in] - count - number of items written after the tail element
+ * [out] - true - items appended; false - buffer is full, items that did not fit are dropped
+ * */
+bool BufferCommit(Buffer_t* const buffer, uint16_t count);
+
 #endif /* BUFFER_H */
@@ -15,6 +15,12 @@
 #define configMAX_TASK_NAME_LEN                         10
 #define configIDLE_SHOULD_YIELD                         1
 
+/* Software timers (deferred driver work, e.g. I2C START after STOP) */
+#define configUSE_TIMERS                                1
+#define configTIMER_TASK_PRIORITY                       (configMAX_PRIORITIES - 1)
+#define configTIMER_QUEUE_LENGTH                        8
+#define configTIMER_TASK_STACK_DEPTH                    (configMINIMAL_STACK_SIZE * 2)
+
 /* Memory */
 #define configSUPPORT_DYNAMIC_ALLOCATION                1
 #define configSUPPORT_STATIC_ALLOCATION                 0
@@ -1,5 +1,7 @@
 #include <stddef.h>
 
+#include "stm32f411xe.h"
+
 #include "custom-assert.h"
 #include "event.h"
 #include "buffer.h"
@@ -9,19 +11,35 @@ static Event_t m_events[EVENT_QUEUE_SIZE + 1];
 
 void EventQueueInit(void)
 {
-    BufferCreate(&m_eventQueue, m_events, sizeof(m_events), sizeof(Event_t), true);
+    /* new events are rejected when full: overwriting would move the reader index */
+    BufferCreate(&m_eventQueue, m_events, sizeof(m_events), sizeof(Event_t), false);
 }
 
 bool EventQueue_Enqueue(const Event_t* const event)
 {
     ASSERT(event != NULL);
 
-    return BufferPut(&m_eventQueue, event, sizeof(Event_t));
+    /* producers are tasks and interrupts of any priority */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    bool result = BufferPut(&m_eventQueue, event, sizeof(Event_t));
+
+    __set_PRIMASK(primask);
+
+    return result;
 }
 
 bool EventQueue_Dequeue(Event_t* const event)
 {
     ASSERT(event != NULL);
 
-    return BufferGet(&m_eventQueue, event, sizeof(Event_t));
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    bool result = BufferGet(&m_eventQueue, event, sizeof(Event_t));
+
+    __set_PRIMASK(primask);
+
+    return result;
 }
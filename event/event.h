@@ -16,6 +16,7 @@ typedef enum
     EVENT_ESP_NEXT,
     EVENT_ESP_LED_ON,
     EVENT_ESP_LED_OFF,
+    EVENT_GPIO_EDGE,            /* gpio edges queued, read them with getEvents */
 } EVENT_TYPE;
 
 typedef struct
@@ -31,6 +32,8 @@ typedef struct
 void EventQueueInit(void);
 
 /*Brief: Put event into the queue
+ * NOTE: may be called from tasks and interrupts; a full queue keeps the
+ * queued events and rejects the new one
  * [in] - pointer to event
  * [out] - true - event successfully sent to queue; false - otherwise (queue is full)
  * */
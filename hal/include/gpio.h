@@ -4,8 +4,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-/* Gpio not connected */
-#define PIN_NC                  (-1)
+/* Gpio not connected (pins are passed as uint8_t) */
+#define PIN_NC                  (0xFFU)
 
 /* pin direction / mode */
 typedef enum
@@ -85,7 +85,8 @@ typedef struct
             volatile uint8_t* ddr;
             volatile uint8_t* port;
             volatile uint8_t* pinReg;
-            uint8_t bit;
+            uint8_t bit;            /* pin mask */
+            bool openDrain;         /* emulated: low - output 0, high - input */
         } atmega328;
     } gpio;
 
@@ -93,6 +94,51 @@ typedef struct
 
 } GpioHandle_t;
 
+/* debounced edge reported through the gpio event queue */
+typedef struct
+{
+    const GpioHandle_t* handle;
+    PIN_STATES state;
+    uint32_t timestamp;     /* time base ticks (see timebase.h) at interrupt entry */
+} GpioEvent_t;
+
+/* group of consecutive pins on one port, driven as a parallel bus */
+typedef struct
+{
+    const GpioOps_t* ops;
+
+    union
+    {
+        struct
+        {
+            void* port;
+        } stm32f411;
+
+        struct
+        {
+            uint32_t base;
+        } cc3220;
+
+        struct
+        {
+            volatile uint8_t* ddr;
+            volatile uint8_t* port;
+            volatile uint8_t* pinReg;
+            bool openDrain;         /* bus value is driven through DDRx */
+        } atmega328;
+    } gpio;
+
+    uint32_t mask;      /* group pins in port bit positions */
+    uint8_t shift;      /* port bit of group bit 0 */
+
+    bool initialized;
+
+} GpioPortHandle_t;
+
+/* Event mode ops (filter, getEvent, getEvents, getEventsLost) are optional:
+ * stm32f4xx provides them, cc32xx and atmega328 have no edge queue, leave
+ * them NULL and take interrupts with a handler only; check getEvents
+ * before using event mode, the four ops are present or absent together */
 struct GpioOps
 {
 /*Brief: Gpio open
@@ -137,10 +183,89 @@ struct GpioOps
 * [in] - handle - pointer to gpio object
 * [in] - mode - IRQ mode
 * [in] - priority - IRQ priority
-* [in] - handler - callback function pointer
+* [in] - handler - callback function pointer; NULL - edges are queued for getEvents
+* and announced by EVENT_GPIO_EDGE on the event queue (see event.h), which must
+* be initialized; backends without getEvents assert on NULL
 * [out] - none
 * */
     void (*interrupt)(GpioHandle_t* const handle, PIN_IRQ_MODES mode, uint8_t priority, GpioIrqHandler handler);
+
+/*Brief: Gpio debounce and glitch filter
+* NOTE: optional, NULL without getEvents; pin interrupt must be in event
+* mode (no handler); first edge is reported at once and edges inside the
+* window are dropped; with PIN_IRQ_BOTH
+* the level is re-checked by a FreeRTOS software timer once the window ends,
+* so the pin interrupt priority must allow FromISR calls; pulses that are
+* gone before interrupt reads the pin are dropped as glitches
+* [in] - handle - pointer to gpio object
+* [in] - debounceUs - window in microseconds, 0 - filter disabled
+* [out] - none
+* */
+    void (*filter)(GpioHandle_t* const handle, uint32_t debounceUs);
+
+/*Brief: Gpio get event
+* NOTE: optional, NULL without an edge queue
+* [in] - event - pointer to event
+* [out] - true - event is returned; false - queue is empty
+* */
+    bool (*getEvent)(GpioEvent_t* const event);
+
+/*Brief: Gpio get events in batch
+* NOTE: optional, NULL without an edge queue; events are in edge order,
+* events arriving while the queue is full are dropped (see getEventsLost);
+* on EVENT_GPIO_EDGE call until it returns 0, the next edge is announced
+* again only after the queue was found empty;
+* the queue is not lock-free: pin interrupts of different priorities and
+* the debounce timer push under a short IRQ lock, only this reader takes none
+* [in] - events - array for events
+* [in] - max - array size
+* [out] - number of returned events
+* */
+    uint16_t (*getEvents)(GpioEvent_t* const events, uint16_t max);
+
+/*Brief: Gpio get number of dropped events
+* NOTE: optional, NULL without getEvents
+* [in] - none
+* [out] - events dropped since start because the queue was full
+* */
+    uint32_t (*getEventsLost)(void);
+
+/*Brief: Gpio port group open
+* [in] - handle - pointer to gpio port object
+* [in] - pin - first pin of the group defined in platforms/gpio-name.h
+* [in] - width - number of consecutive pins on the same port
+* [in] - mode - gpio mode
+* [in] - pull - gpio pull-up/pull-down
+* [in] - strength - gpio speed
+* [in] - config - gpio config
+* [in] - value - initial bus value
+* NOTE: this param can be used as alternate function
+* [out] - none
+* */
+    void (*portOpen)(GpioPortHandle_t* const handle, uint8_t pin, uint8_t width, PIN_MODES mode, PIN_TYPES pull, PIN_STRENGTH strength, PIN_CONFIGS config, uint32_t value);
+
+/*Brief: Gpio port group write
+* NOTE: all pins of the group change in one register store
+* [in] - handle - pointer to gpio port object
+* [in] - value - bus value, bit 0 is the first pin
+* [out] - none
+* */
+    void (*portWrite)(const GpioPortHandle_t* const handle, uint32_t value);
+
+/*Brief: Gpio port group set and reset
+* NOTE: atomic, pins outside both masks keep their state; set wins over reset
+* [in] - handle - pointer to gpio port object
+* [in] - set - pins to drive high, bit 0 is the first pin
+* [in] - reset - pins to drive low, bit 0 is the first pin
+* [out] - none
+* */
+    void (*portSetReset)(const GpioPortHandle_t* const handle, uint32_t set, uint32_t reset);
+
+/*Brief: Gpio port group read
+* [in] - handle - pointer to gpio port object
+* [out] - bus value, bit 0 is the first pin
+* */
+    uint32_t (*portRead)(const GpioPortHandle_t* const handle);
 };
 
 #endif /* GPIO_H */
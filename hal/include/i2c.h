@@ -5,8 +5,12 @@
 
 #include "stm32f411xe.h"
 
+#include "FreeRTOS.h"
+#include "timers.h"
+
 #include "gpio.h"
 #include "buffer.h"
+#include "dma.h"
 
 #define I2C_TRANSACTION_QUEUE_SIZE 31
 
@@ -15,6 +19,8 @@ typedef enum
     I2C_OK = 0,
     I2C_BUSY,
     I2C_QUEUE_FULL,
+    I2C_NACK,
+    I2C_TIMEOUT,
     I2C_ERROR
 } I2C_RESULT;
 
@@ -39,15 +45,28 @@ typedef enum
     I2C_BUSY_RX
 } I2C_STATE;
 
+typedef enum
+{
+    I2C_STATUS_PENDING = 0,
+    I2C_STATUS_DONE,
+    I2C_STATUS_NACK,
+    I2C_STATUS_ARBITRATION_LOST,
+    I2C_STATUS_BUS_ERROR,
+    I2C_STATUS_OVERRUN,
+    I2C_STATUS_DMA_ERROR
+} I2C_STATUS;
+
 typedef void (*I2C_EventHandler_t)(void* context);
+typedef void (*I2C_ErrorHandler_t)(I2C_STATUS status, void* context);
 
 typedef struct
 {
-    uint32_t speed;
+    uint32_t speed;         /* Hz, any value up to I2C_SPEED_FAST_MODE */
     uint8_t ackControl;
-    uint8_t dutyCycle;
+    uint8_t dutyCycle;      /* fast mode only: 0 - Tlow/Thigh = 2, 1 - 16/9 */
 } I2C_Config_t;
 
+/* txLen != 0 and rxLen != 0: write, repeated START, read (register read) */
 typedef struct
 {
     uint8_t devAddress;
@@ -55,21 +74,85 @@ typedef struct
     uint8_t* rxBuffer;
     uint32_t txLen;
     uint32_t rxLen;
-    uint8_t TxRxState;
-    I2C_EventHandler_t onTxDone;
-    I2C_EventHandler_t onRxDone;
+    uint8_t TxRxState;              /* set by driver */
+    I2C_EventHandler_t onTxDone;    /* write only transaction done */
+    I2C_EventHandler_t onRxDone;    /* transaction with read phase done */
+    I2C_ErrorHandler_t onError;     /* failed after all retries, optional */
+    volatile I2C_STATUS* status;    /* optional, PENDING when queued, final status on completion */
+    uint8_t retries;                /* extra attempts on NACK, arbitration loss or bus error */
     void* context;
 } I2C_Transaction_t;
 
+/* register read of one device within a batch */
+typedef struct
+{
+    uint8_t devAddress;
+    uint8_t reg;
+    uint8_t* rxBuffer;
+    uint16_t rxLen;
+    volatile I2C_STATUS status;     /* set by driver */
+} I2C_Read_t;
+
+typedef struct
+{
+    I2C_Read_t* reads;
+    uint8_t count;
+    uint8_t retries;                /* per read, see I2C_Transaction_t */
+    volatile uint8_t failed;        /* set by driver, number of reads not DONE */
+    I2C_EventHandler_t onDone;      /* all reads finished, called from interrupt */
+    void* context;
+} I2C_Batch_t;
+
+typedef void (*I2C_RegisterHandler_t)(uint8_t reg, const uint8_t* data, uint16_t len, void* context);
+
+/* slave register file: host sets register pointer with the first written
+ * byte, then reads or writes from it with auto-increment; host reads are
+ * served straight from the front page, firmware fills the back page and
+ * publishes it as a whole, so a burst read always sees one snapshot;
+ * host writes land only in the writable block, which is never swapped, so
+ * they survive publish; writes to other registers are dropped */
+typedef struct
+{
+    uint8_t* pages[2];
+    uint16_t size;                  /* bytes per page, up to 256 */
+    uint8_t* writable;              /* host writable registers, optional, read back from here */
+    uint8_t writableStart;          /* register address of writable[0] */
+    uint16_t writableSize;          /* writableStart + writableSize <= size */
+    I2C_RegisterHandler_t onWrite;  /* host wrote registers (data in writable block), called from interrupt at end of access */
+    I2C_RegisterHandler_t onRead;   /* host read registers (data in front page), optional */
+    void* context;
+    /* set by driver */
+    volatile uint8_t front;
+    volatile bool swapPending;
+    volatile bool active;           /* host access in progress */
+    bool pointerSet;
+    bool transmit;
+    uint16_t start;
+    uint16_t pointer;
+} I2C_RegisterMap_t;
+
+typedef struct
+{
+    DMA_Stream_t rx;
+    DMA_Stream_t tx;
+} I2C_Dma_t;
+
 typedef struct
 {
     I2C_TypeDef* instance;
     I2C_NAMES name;
-    Gpio_t sda;
-    Gpio_t scl;
+    GpioHandle_t sda;
+    GpioHandle_t scl;
+    const I2C_Dma_t* dma;
     Buffer_t queue;
     I2C_Transaction_t transactions[I2C_TRANSACTION_QUEUE_SIZE + 1];
-    I2C_Transaction_t* currentTransaction;
+    I2C_Transaction_t current;
+    volatile bool busy;
+    bool startRequested;            /* repeated START for next transaction set at ADDR of single byte read */
+    bool startDeferred;             /* START waits for previous STOP, re-checked by startTimer */
+    uint32_t deferredSince;         /* time base ticks */
+    TimerHandle_t startTimer;       /* one tick software timer, created by I2C_Init */
+    I2C_RegisterMap_t* slave;       /* not NULL in slave mode */
     I2C_Config_t config;
     bool initialized;
 } I2C_Handle_t;
@@ -88,28 +171,45 @@ void I2C_Init(I2C_Handle_t* const obj, I2C_NAMES name);
 void I2C_Deinit(I2C_Handle_t* const obj);
 
 /*Brief: I2C transmit in blocking mode
+ * NOTE: every wait is bounded, bus is recovered on timeout or stuck BUSY
  * [in] - obj - pointer to I2C object
  * [in] - txBuffer - buffer to transmit
  * [in] - size - buffer size
  * [in] - slaveAddr - address of the slave device
- * [out] - none
+ * [out] - I2C_OK, I2C_NACK, I2C_TIMEOUT or I2C_BUSY (bus is stuck after recovery)
  * */
-void I2C_MasterTransmit(I2C_Handle_t* const obj, const uint8_t* txBuffer, uint8_t size, uint8_t slaveAddr);
+I2C_RESULT I2C_MasterTransmit(I2C_Handle_t* const obj, const uint8_t* txBuffer, uint8_t size, uint8_t slaveAddr);
 
 /*Brief: I2C receive in blocking mode
+ * NOTE: every wait is bounded, bus is recovered on timeout or stuck BUSY
  * [in] - obj - pointer to I2C object
  * [in] - rxBuffer - buffer to receive
  * [in] - size - buffer size
  * [in] - slaveAddr - address of the slave device
- * [out] - none
+ * [out] - I2C_OK, I2C_NACK, I2C_TIMEOUT or I2C_BUSY (bus is stuck after recovery)
  * */
-void I2C_MasterReceive(I2C_Handle_t* const obj, uint8_t* rxBuffer, uint8_t size, uint8_t slaveAddr);
+I2C_RESULT I2C_MasterReceive(I2C_Handle_t* const obj, uint8_t* rxBuffer, uint8_t size, uint8_t slaveAddr);
 
 /*Brief: I2C bus recover
+ * NOTE: clocks SCL up to 9 times until slave releases SDA, generates STOP
+ * and resets the peripheral; not allowed while non-blocking transfer is active
  * [in] - obj - pointer to I2C object
- * [out] - none
+ * [out] - true - SDA and SCL are released; false - line is still held low
+ * */
+bool I2C_Recovery(I2C_Handle_t* const obj);
+
+/*Brief: I2C write then read in non-blocking mode (DMA)
+ * NOTE: write and read phases are joined by repeated START, so register read
+ * is a single bus transaction; a write only transaction always ends with STOP
+ * (devices commit writes on STOP), after a read the next queued transaction
+ * follows by repeated START; transaction is copied into the driver queue,
+ * buffers and status must stay valid until callback; failed transaction is
+ * restarted up to retries times, then onError is called and queue goes on
+ * [in] - obj - pointer to I2C object
+ * [in] - transaction - pointer to transaction
+ * [out] - I2C state
  * */
-void I2C_Recovery(I2C_Handle_t* const obj);
+I2C_RESULT I2C_MasterTransfer_IT(I2C_Handle_t* const obj, I2C_Transaction_t* transaction);
 
 /*Brief: I2C transmit in non-blocking mode
  * [in] - obj - pointer to I2C object
@@ -125,4 +225,38 @@ I2C_RESULT I2C_MasterTransmit_IT(I2C_Handle_t* const obj, I2C_Transaction_t* tra
  * */
 I2C_RESULT I2C_MasterReceive_IT(I2C_Handle_t* const obj, I2C_Transaction_t* transaction);
 
+/*Brief: Queue register reads of many devices as one back-to-back batch
+ * NOTE: reads run from interrupt one after another in array order, batch is
+ * queued as a whole or not at all; batch and buffers must stay valid until
+ * onDone, read results are in reads[i].status
+ * [in] - obj - pointer to I2C object
+ * [in] - batch - pointer to batch, count up to I2C_TRANSACTION_QUEUE_SIZE
+ * [out] - I2C_OK, I2C_QUEUE_FULL or I2C_ERROR
+ * */
+I2C_RESULT I2C_ReadBatch_IT(I2C_Handle_t* const obj, I2C_Batch_t* batch);
+
+/*Brief: Switch I2C to slave mode serving register map
+ * NOTE: call after I2C_Init; master transfers are not allowed in slave mode
+ * [in] - obj - pointer to I2C object
+ * [in] - ownAddress - 7 bit slave address
+ * [in] - map - pointer to register map with both pages and size set, writable block optional
+ * [out] - none
+ * */
+void I2C_SlaveInit(I2C_Handle_t* const obj, uint8_t ownAddress, I2C_RegisterMap_t* map);
+
+/*Brief: Get register page owned by firmware
+ * NOTE: fill it, then call I2C_SlavePublish
+ * [in] - map - pointer to register map
+ * [out] - back page
+ * */
+uint8_t* I2C_SlaveBackPage(I2C_RegisterMap_t* map);
+
+/*Brief: Make back page visible to host
+ * NOTE: if host access is in progress swap is deferred to its end, so the
+ * back page must not be touched until I2C_SlaveBackPage is called again
+ * [in] - map - pointer to register map
+ * [out] - none
+ * */
+void I2C_SlavePublish(I2C_RegisterMap_t* map);
+
 #endif /* I2C_H */
@@ -7,9 +7,11 @@
 #include "stm32f411xe.h"
 
 #include "gpio.h"
+#include "gpio-fast.h"
 #include "buffer.h"
+#include "dma.h"
 
-#define SPI_TRANSACTION_QUEUE_SIZE 31
+#define SPI_TRANSACTION_QUEUE_SIZE 15     /* per priority */
 
 typedef enum
 {
@@ -29,6 +31,24 @@ typedef enum
     SPI_COUNT
 } SPI_NAMES;
 
+/* Queued transactions are served highest priority first, a running
+ * transaction is never interrupted (preemption at transaction boundary) */
+typedef enum
+{
+    SPI_PRIORITY_NORMAL = 0,
+    SPI_PRIORITY_HIGH,
+    SPI_PRIORITY_LOW,
+    SPI_PRIORITY_COUNT
+} SPI_PRIORITY;
+
+typedef enum
+{
+    SPI_STATUS_PENDING = 0,
+    SPI_STATUS_DONE,
+    SPI_STATUS_DMA_ERROR,
+    SPI_STATUS_TIMEOUT      /* bus stayed busy while switching device */
+} SPI_STATUS;
+
 typedef enum
 {
     CPOL_0 = 0,
@@ -43,35 +63,83 @@ typedef enum
 
 typedef struct
 {
-    Gpio_t miso;
-    Gpio_t mosi;
-    Gpio_t sck;
-    Gpio_t nss;
+    GpioHandle_t miso;
+    GpioHandle_t mosi;
+    GpioHandle_t sck;
+    GpioHandle_t nss;
 } SPI_Gpio_t;
 
 typedef void (*SPI_EventHandler_t)(void* context);
+typedef void (*SPI_ErrorHandler_t)(SPI_STATUS status, void* context);
 typedef void (*SPI_CsCallback_t)(void* context);
 
+struct SPI_Handle;
+
+/* Device on shared bus: mode and clock are applied lazily when device changes */
+typedef struct
+{
+    struct SPI_Handle* bus;
+    uint32_t cr1;           /* CPOL, CPHA and BR bits */
+    GpioHandle_t cs;
+    GpioFast_t csPin;       /* toggled per transaction */
+} SPI_Device_t;
+
+/* Scatter-gather element, transferred full duplex under one CS assertion */
+typedef struct
+{
+    const uint8_t* txBuffer;    /* NULL - 0xFF is sent */
+    uint8_t* rxBuffer;          /* NULL - received data is discarded */
+    uint16_t len;
+} SPI_Segment_t;
+
 typedef struct
 {
     uint8_t* txBuffer;
     uint8_t* rxBuffer;
     uint16_t txLen;
     uint16_t rxLen;
+    const SPI_Segment_t* segments;  /* optional descriptor list, used instead of buffers above */
+    uint8_t segmentCount;
+    SPI_Device_t* device;           /* set by SpiDeviceTransfer_IT, NULL - bus config and CS untouched */
+    SPI_PRIORITY priority;
+    uint32_t queuedAt;              /* set by driver, time base ticks */
     SPI_EventHandler_t onTransactionDone;
+    SPI_ErrorHandler_t onError;     /* transaction dropped, optional */
+    volatile SPI_STATUS* status;    /* optional, PENDING when queued, final status on completion */
     SPI_CsCallback_t preTransaction;
     SPI_CsCallback_t postTransaction;
     void* context;
 } SPI_Transaction_t;
 
 typedef struct
+{
+    DMA_Stream_t rx;
+    DMA_Stream_t tx;
+} SPI_Dma_t;
+
+/* Queue latency (submit to start on the bus) of one priority class */
+typedef struct
+{
+    uint32_t count;
+    uint32_t latencyMin;    /* time base ticks */
+    uint32_t latencyMax;    /* time base ticks */
+    uint64_t latencySum;    /* time base ticks */
+} SPI_Stats_t;
+
+typedef struct SPI_Handle
 {
     SPI_TypeDef* instance;
     SPI_NAMES name;
     SPI_Gpio_t gpio;
-    Buffer_t queue;
-    SPI_Transaction_t transactions[SPI_TRANSACTION_QUEUE_SIZE + 1];
-    SPI_Transaction_t* currentTransaction;
+    const SPI_Dma_t* dma;
+    Buffer_t queue[SPI_PRIORITY_COUNT];
+    SPI_Transaction_t transactions[SPI_PRIORITY_COUNT][SPI_TRANSACTION_QUEUE_SIZE + 1];
+    SPI_Stats_t stats[SPI_PRIORITY_COUNT];
+    SPI_Transaction_t current;
+    SPI_Segment_t segment;
+    uint8_t segmentIndex;
+    SPI_Device_t* activeDevice;
+    volatile bool busy;
     bool initialized;
 } SPI_Handle_t;
 
@@ -92,22 +160,69 @@ uint32_t SpiInit(SPI_Handle_t* const obj, SPI_NAMES name, SPI_POLARITY polarity,
 void SpiDeinit(SPI_Handle_t* const obj);
 
 /*Brief: SPI transmit/receive in blocking mode
+ * NOTE: frames are pipelined back-to-back; even lengths from 8 bytes are
+ * clocked as 16-bit frames, byte order on the wire is unchanged
  * [in] - obj - pointer to SPI object
- * [in] - txBuffer - buffer to transmit
- * [in] - rxBuffer - buffer to receive
+ * [in] - txBuffer - buffer to transmit (NULL - 0xFF is sent)
+ * [in] - rxBuffer - buffer to receive (NULL - received data is discarded)
  * [in] - size - buffer size
- * [out] - true - transfer successful; false - otherwise
+ * [out] - true - transfer successful; false - otherwise (timeout, overrun or DMA transfer ongoing)
  * */
-bool SpiTransfer(SPI_Handle_t* const obj, const uint8_t* const txBuffer, uint8_t* const rxBuffer, uint8_t size);
+bool SpiTransfer(SPI_Handle_t* const obj, const uint8_t* const txBuffer, uint8_t* const rxBuffer, uint32_t size);
 
-/*Brief: SPI transmit/receive in non-blocking mode
+/*Brief: SPI transmit/receive in non-blocking mode (DMA)
+ * NOTE: transaction is copied into the driver queue, buffers, segment list and
+ * status must stay valid until onTransactionDone or onError; queued transactions
+ * are chained back-to-back from DMA completion interrupt with CS callbacks
+ * around each one; on DMA error the rest of transaction is dropped
  * [in] - obj - pointer to SPI object
- * [in] - txBuffer - buffer to transmit
- * [in] - rxBuffer - buffer to receive
- * [in] - size - buffer size
- * [in] - context - pointer to context (storage for response)
+ * [in] - transaction - pointer to transaction description
  * [out] - spi transaction state
  * */
 SPI_RESULT SpiTransfer_IT(SPI_Handle_t* const obj, SPI_Transaction_t* transaction);
 
+/*Brief: Register device on initialized SPI bus
+ * NOTE: CS is driven by the driver around each device transaction
+ * [in] - device - pointer to device object
+ * [in] - bus - pointer to SPI object (shared by several devices)
+ * [in] - polarity - device clock polarity
+ * [in] - phase - device clock phase
+ * [in] - deriredFrequencyHz - device SPI frequency in Hz
+ * [in] - cs - chip select pin
+ * [out] - actual SPI frequency in Hz
+ * */
+uint32_t SpiDeviceInit(SPI_Device_t* const device, SPI_Handle_t* const bus, SPI_POLARITY polarity, SPI_PHASE phase,
+                       uint32_t deriredFrequencyHz, uint8_t cs);
+
+/*Brief: Device transmit/receive in blocking mode
+ * [in] - device - pointer to device object
+ * [in] - txBuffer - buffer to transmit (NULL - 0xFF is sent)
+ * [in] - rxBuffer - buffer to receive (NULL - received data is discarded)
+ * [in] - size - buffer size
+ * [out] - true - transfer successful; false - otherwise (bus is busy)
+ * */
+bool SpiDeviceTransfer(SPI_Device_t* const device, const uint8_t* const txBuffer, uint8_t* const rxBuffer, uint32_t size);
+
+/*Brief: Device transmit/receive in non-blocking mode (DMA)
+ * NOTE: transactions of all devices on the bus share one queue, bus config
+ * is switched between transactions only when the device changes
+ * [in] - device - pointer to device object
+ * [in] - transaction - pointer to transaction description
+ * [out] - spi transaction state
+ * */
+SPI_RESULT SpiDeviceTransfer_IT(SPI_Device_t* const device, SPI_Transaction_t* transaction);
+
+/*Brief: Get queue latency stats of priority class
+ * [in] - obj - pointer to SPI object
+ * [in] - priority - priority class
+ * [out] - stats - pointer to stats copy
+ * */
+void SpiGetStats(SPI_Handle_t* const obj, SPI_PRIORITY priority, SPI_Stats_t* const stats);
+
+/*Brief: Reset queue latency stats
+ * [in] - obj - pointer to SPI object
+ * [out] - none
+ * */
+void SpiResetStats(SPI_Handle_t* const obj);
+
 #endif /* SPI_H */
@@ -6,16 +6,28 @@
 
 #include "stm32f411xe.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
+
 #include "buffer.h"
 #include "gpio.h"
+#include "gpio-name.h"
+#include "dma.h"
+
+/* Ring buffer keeps one slot free to tell full from empty */
+#define UART_STORAGE_SIZE(size)    ((size) + 1)
+
+#define UART_BAUD_MAX    6000000     /* baud */
 
-#define BUFFER_SIZE      1023
+/* RX DMA staging buffer: drained into the RX ring on line idle and on every
+ * half, so RX interrupts may be held off for up to half of it (characters) */
+#define UART_RX_DMA_SIZE    64
 
 /* USART baud rate supported */
 #if 0
-There might be an issue with writting data over UART on lower baudrate due to
-circular buffer might be flooded with data.
-Recommended baudrate: 921600.
+On lower baudrate TX circular buffer might be filled faster than it is drained.
+Data which does not fit is rejected (not overwritten): check the value returned
+by UartWrite_IT or use blocking UartWriteTimeout/UartWriteNotify.
 #endif
 typedef enum
 {
@@ -40,46 +52,166 @@ typedef enum
     UART_COUNT
 } UART_NAMES;
 
+typedef enum
+{
+    UART_FLOW_NONE = 0,
+    UART_FLOW_RTS_CTS,      /* hardware flow control */
+    UART_FLOW_RS485,        /* half-duplex transceiver, DE driven while transmitting */
+} UART_FLOW_CONTROL;
+
 typedef struct
 {
-    Gpio_t tx;
-    Gpio_t rx;
+    GpioHandle_t tx;
+    GpioHandle_t rx;
+    GpioHandle_t rts;
+    GpioHandle_t cts;
+    GpioHandle_t de;
 } UART_GPIO_t;
 
 typedef void (*UART_EventHandler_t)(void* context);
 
+/* UART instance descriptor: board wiring and SoC resources of one port */
+typedef struct
+{
+    UART_NAMES name;
+    USART_TypeDef* instance;
+    uint8_t txPin;
+    uint8_t rxPin;
+    uint8_t rtsPin;
+    uint8_t ctsPin;
+    uint8_t dePin;
+    uint8_t af;
+    UART_FLOW_CONTROL flowControl;
+    volatile uint32_t* clockEnableReg;
+    uint32_t clockEnableMask;
+    IRQn_Type irq;
+    DMA_Stream_t txDma;
+    DMA_Stream_t rxDma;
+} UART_Config_t;
+
+/* UART link counters, updated from interrupt context */
+typedef struct
+{
+    uint32_t txBytes;
+    uint32_t rxBytes;
+    uint32_t overrunErrors;
+    uint32_t framingErrors;
+    uint32_t noiseErrors;
+    uint32_t rxDropped;         /* RX bytes dropped because the ring was full (oldest data kept) */
+    uint32_t dmaErrors;
+} UART_Stats_t;
+
 typedef struct
 {
     USART_TypeDef* instance;
+    const UART_Config_t* config;
     UART_NAMES uartName;
     UART_GPIO_t gpio;
     Buffer_t txBuffer;
     Buffer_t rxBuffer;
     UART_EventHandler_t onRxDone;
-    uint8_t txData[BUFFER_SIZE + 1];
-    uint8_t rxData[BUFFER_SIZE + 1];
+    volatile uint16_t txDmaCount;
+    volatile TaskHandle_t txWaiter;
+    uint16_t rxDmaPosition;
+    uint8_t rxDmaData[UART_RX_DMA_SIZE];
+    volatile UART_Stats_t stats;
+    uint8_t* txData;
+    uint8_t* rxData;
+    uint16_t txSize;
+    uint16_t rxSize;
     volatile bool isTransmitting;
     volatile bool isTransmitCompeted;
-    TIM_TypeDef* timer;
     bool initialized;
 } UART_Handle_t;
 
-/*Brief: UART initialization
+/* Define UART handle together with its ring storage
+ * [in] - name - handle name
+ * [in] - txCapacity - TX buffer capacity in bytes
+ * [in] - rxCapacity - RX buffer capacity in bytes
+ * */
+#define UART_HANDLE_DEFINE(name, txCapacity, rxCapacity)                    \
+    static uint8_t name##TxData[UART_STORAGE_SIZE(txCapacity)];             \
+    static uint8_t name##RxData[UART_STORAGE_SIZE(rxCapacity)];             \
+    static UART_Handle_t name = {                                           \
+        .txData = name##TxData, .txSize = sizeof(name##TxData),             \
+        .rxData = name##RxData, .rxSize = sizeof(name##RxData) }
+
+/*Brief: Attach ring storage to UART handle (alternative to UART_HANDLE_DEFINE)
+ * NOTE: must be called before UART initialization, storage must stay valid
+ * while UART is used; use UART_STORAGE_SIZE(capacity) for sizes
  * [in] - obj - pointer to UART handle
- * [in] - baud - baud rate
+ * [in] - txData - TX storage
+ * [in] - txSize - TX storage size
+ * [in] - rxData - RX storage
+ * [in] - rxSize - RX storage size
  * [out] - none
  * */
-void UartInit(UART_Handle_t* const obj, UART_NAMES uartName, BAUD_RATE baud);
+void UartSetStorage(UART_Handle_t* const obj, uint8_t* const txData, uint16_t txSize,
+                    uint8_t* const rxData, uint16_t rxSize);
+
+/*Brief: UART initialization with default pins and resources
+ * NOTE: ring storage must be attached by UART_HANDLE_DEFINE or UartSetStorage
+ * [in] - obj - pointer to UART handle
+ * [in] - uartName - UART name
+ * [in] - baud - baud rate
+ * [out] - true - UART initialized; false - baud rate is not reachable from UART clock
+ * */
+bool UartInit(UART_Handle_t* const obj, UART_NAMES uartName, BAUD_RATE baud);
+
+/*Brief: UART initialization with user descriptor (e.g. remapped pins)
+ * [in] - obj - pointer to UART handle
+ * [in] - config - pointer to UART descriptor (must stay valid while UART is used)
+ * [in] - baud - baud rate
+ * [out] - true - UART initialized; false - baud rate is not reachable from UART clock
+ * */
+bool UartInitConfig(UART_Handle_t* const obj, const UART_Config_t* const config, BAUD_RATE baud);
+
+/*Brief: Set arbitrary baud rate
+ * NOTE: oversampling by 8 is selected automatically above 1 Mbaud
+ * [in] - obj - pointer to UART handle
+ * [in] - baudrate - baud rate up to UART_BAUD_MAX
+ * [out] - actual baud rate; 0 - rate is not reachable from UART clock, setting is unchanged
+ * */
+uint32_t UartSetBaudRate(UART_Handle_t* const obj, uint32_t baudrate);
+
+/*Brief: Get default UART descriptor
+ * [in] - uartName - UART name
+ * [out] - pointer to default descriptor
+ * */
+const UART_Config_t* UartGetDefaultConfig(UART_NAMES uartName);
 
 /*Brief: Send message over UART in non-blocking mode
  * [in] - obj - pointer to UART handle
  * [in] - buff - pointer to buffer
  * [in] - size - buffer size
- * [out] - none
+ * [out] - number of bytes accepted (less than size if TX buffer is full)
  * */
-void UartWrite_IT(UART_Handle_t* const obj, const uint8_t* const buffer, uint8_t size);
+uint32_t UartWrite_IT(UART_Handle_t* const obj, const uint8_t* const buffer, uint32_t size);
+
+/*Brief: Send message over UART, busy-wait for TX buffer space
+ * [in] - obj - pointer to UART handle
+ * [in] - buff - pointer to buffer
+ * [in] - size - buffer size
+ * [in] - timeoutUs - max time to wait for TX buffer space
+ * [out] - number of bytes accepted
+ * */
+uint32_t UartWriteTimeout(UART_Handle_t* const obj, const uint8_t* const buffer, uint32_t size, uint32_t timeoutUs);
+
+/*Brief: Send message over UART, block calling task until TX buffer space is freed
+ * NOTE: FreeRTOS task context only, task is woken by TX DMA completion through
+ * its direct to task notification (index 0, vTaskNotifyGiveFromISR), which the
+ * task must not use for anything else while it writes; only one task per port
+ * may block at a time, a concurrent call is rejected
+ * [in] - obj - pointer to UART handle
+ * [in] - buff - pointer to buffer
+ * [in] - size - buffer size
+ * [in] - timeoutMs - max time to wait for TX buffer space
+ * [out] - number of bytes accepted; 0 - another task is already blocked on this port
+ * */
+uint32_t UartWriteNotify(UART_Handle_t* const obj, const uint8_t* const buffer, uint32_t size, uint32_t timeoutMs);
 
 /*Brief: Register receive callback
+ * NOTE: invoked from interrupt context on line idle and on half/full RX buffer
  * [in] - obj - pointer to UART handle
  * [in] - callback - callback
  * [out] - none
@@ -92,4 +224,18 @@ void UartRegisterReceiveHandler(UART_Handle_t* const obj, UART_EventHandler_t ca
  * */
 bool UartIdle(UART_Handle_t* const obj);
 
+/*Brief: Get snapshot of UART link counters
+ * NOTE: overrun grows when the line outruns RX DMA, dropped bytes when the reader
+ * is too slow, framing/noise errors point to the line or baud rate mismatch
+ * [in] - obj - pointer to UART handle
+ * [out] - stats - pointer to counters copy
+ * */
+void UartGetStats(UART_Handle_t* const obj, UART_Stats_t* const stats);
+
+/*Brief: Reset UART link counters
+ * [in] - obj - pointer to UART handle
+ * [out] - none
+ * */
+void UartResetStats(UART_Handle_t* const obj);
+
 #endif /* UART_H */
@@ -1,13 +1,16 @@
 #include <stddef.h>
 #include <string.h>
 
-#include "assert.h"
+#include "custom-assert.h"
+#include "ignore.h"
 #include "adxl345.h"
 #include "adxl345-regs.h"
 #include "spi.h"
 
 #include "i2c.h"
 #define ADXL345_I2C_ADDRESS     0x53
+#define ADXL345_I2C_SPEED       I2C_SPEED_FAST_MODE     /* Hz, sensor supports up to 400 kHz */
+#define ADXL345_I2C_RETRIES     2
 
 #define SPI_CLOCK_RATE  5000000     /* Hz */
 
@@ -28,8 +31,7 @@ AdxlInterface_t g_adxlI2CDriver = {
 
 typedef struct
 {
-    SPI_Handle_t spi;
-    Gpio_t nss;
+    SPI_Device_t spi;
 } Adxl345_t;
 
 typedef enum
@@ -59,16 +61,6 @@ static void AdxlCreateRequest(  AdxlRequest_t* req,
                                 ADXL_RequestHandler_t callback,
                                 void* context);
 
-static void Adxl345_Activate(void* context)
-{
-    GpioWrite(&m_adxl345.nss, 0);
-}
-
-static void Adxl345_Deactivate(void* context)
-{
-    GpioWrite(&m_adxl345.nss, 1);
-}
-
 static void OnRegisterRequestCompleted(void* context)
 {
     Acceleration_t acceleration;
@@ -133,40 +125,33 @@ static void OnRegisterRequestCompleted(void* context)
     }
 }
 
-static void I2C_OnRegisterWriteCompleted(void* context)
+/* transfer failed after all retries, request completes without value */
+static void I2C_OnRegisterRequestFailed(I2C_STATUS status, void* context)
 {
     AdxlRequest_t* request = (AdxlRequest_t*)context;
 
-    if (request->length == 0)
+    IGNORE(status);
+
+    if (request->callback != NULL)
     {
-        if (request->callback != NULL)
-        {
-            (*request->callback)(NULL, request->userContext);
-        }
+        (*request->callback)(NULL, request->userContext);
     }
-    else
+}
+
+static void I2C_OnRegisterWriteCompleted(void* context)
+{
+    AdxlRequest_t* request = (AdxlRequest_t*)context;
+
+    if (request->callback != NULL)
     {
-        I2C_Transaction_t i2cTransaction = {
-            .devAddress = ADXL345_I2C_ADDRESS,
-            .txBuffer = NULL,
-            .txLen = 0,
-            .rxBuffer = request->rx,
-            .rxLen = request->length,
-            .onTxDone = NULL,
-            .onRxDone = &OnRegisterRequestCompleted,
-            .context = request,
-        };
-
-        I2C_MasterReceive_IT(&m_i2c, &i2cTransaction);
+        (*request->callback)(NULL, request->userContext);
     }
 }
 
-void ADXL_InitSPI(void)
+void ADXL_InitSPI(SPI_Handle_t* const bus)
 {
-    SpiInit(&m_adxl345.spi, SPI_1, CPOL_1, CPHA_1, SPI_CLOCK_RATE);
-
-    /* chip select gpio */
-    GpioInit(&m_adxl345.nss, PA_0, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, 1);
+    /* bus may be shared, mode and clock are switched by SPI driver */
+    SpiDeviceInit(&m_adxl345.spi, bus, CPOL_1, CPHA_1, SPI_CLOCK_RATE, PA_0);
 }
 
 void ADXL_ReadRegisterAsyncSPI(uint8_t address, ADXL_RequestHandler_t callback, void* context)
@@ -180,13 +165,11 @@ void ADXL_ReadRegisterAsyncSPI(uint8_t address, ADXL_RequestHandler_t callback,
         .rxBuffer = m_adxlRequest.rx,
         .txLen = sizeof(tx),
         .rxLen = m_adxlRequest.length,
-        .preTransaction = &Adxl345_Activate,
-        .postTransaction = &Adxl345_Deactivate,
         .onTransactionDone = &OnRegisterRequestCompleted,
         .context = &m_adxlRequest
     };
 
-    SpiTransfer_IT(&m_adxl345.spi, &spiTransaction);
+    SpiDeviceTransfer_IT(&m_adxl345.spi, &spiTransaction);
 }
 
 void ADXL_WriteRegisterAsyncSPI(uint8_t address, ADXL_RequestHandler_t callback, void* value)
@@ -202,13 +185,11 @@ void ADXL_WriteRegisterAsyncSPI(uint8_t address, ADXL_RequestHandler_t callback,
         .rxBuffer = NULL,
         .txLen = sizeof(tx),
         .rxLen = m_adxlRequest.length,
-        .preTransaction = &Adxl345_Activate,
-        .postTransaction = &Adxl345_Deactivate,
         .onTransactionDone = &OnRegisterRequestCompleted,
         .context = &m_adxlRequest
     };
 
-    SpiTransfer_IT(&m_adxl345.spi, &spiTransaction);
+    SpiDeviceTransfer_IT(&m_adxl345.spi, &spiTransaction);
 }
 
 void ADXL_ReadVectorAsyncSPI(uint8_t address, ADXL_RequestHandler_t callback, void* context)
@@ -224,26 +205,19 @@ void ADXL_ReadVectorAsyncSPI(uint8_t address, ADXL_RequestHandler_t callback, vo
         .rxBuffer = m_adxlRequest.rx,
         .txLen = sizeof(tx),
         .rxLen = m_adxlRequest.length,
-        .preTransaction = &Adxl345_Activate,
-        .postTransaction = &Adxl345_Deactivate,
         .onTransactionDone = OnRegisterRequestCompleted,
-        .context = &m_adxlRequest
+        .context = &m_adxlRequest,
+        .priority = SPI_PRIORITY_HIGH,     /* sampling jitter matters */
     };
 
-    SpiTransfer_IT(&m_adxl345.spi, &spiTransaction);
+    SpiDeviceTransfer_IT(&m_adxl345.spi, &spiTransaction);
 }
 
 void ADXL_InitI2C(void)
 {
-#if 0
-    m_i2c.config.speed = I2C_SPEED_FAST_MODE;
-    m_i2c.config.dutyCycle = 1;
-    m_i2c.config.ackControl = 1;
-#else
-    m_i2c.config.speed = I2C_SPEED_STANDARD_MODE;
+    m_i2c.config.speed = ADXL345_I2C_SPEED;
     m_i2c.config.dutyCycle = 0;
     m_i2c.config.ackControl = 1;
-#endif
     I2C_Init(&m_i2c, I2C_1);
 }
 
@@ -259,12 +233,15 @@ void ADXL_ReadRegisterAsyncI2C(uint8_t address, ADXL_RequestHandler_t callback,
         .txLen = sizeof(tx),
         .rxBuffer = m_adxlRequest.rx,
         .rxLen = m_adxlRequest.length,
-        .onTxDone = &I2C_OnRegisterWriteCompleted,
-        .onRxDone = NULL,
+        .onTxDone = NULL,
+        .onRxDone = &OnRegisterRequestCompleted,
+        .onError = &I2C_OnRegisterRequestFailed,
+        .retries = ADXL345_I2C_RETRIES,
         .context = &m_adxlRequest
     };
 
-    I2C_MasterTransmit_IT(&m_i2c, &i2cTransaction);
+    /* register address, repeated START and data in one bus transaction */
+    I2C_MasterTransfer_IT(&m_i2c, &i2cTransaction);
 }
 
 void ADXL_WriteRegisterAsyncI2C(uint8_t address, ADXL_RequestHandler_t callback, void* value)
@@ -283,6 +260,7 @@ void ADXL_WriteRegisterAsyncI2C(uint8_t address, ADXL_RequestHandler_t callback,
         .rxLen = m_adxlRequest.length,
         .onTxDone = &I2C_OnRegisterWriteCompleted,
         .onRxDone = NULL,
+        .onError = &I2C_OnRegisterRequestFailed,
         .context = &m_adxlRequest
     };
 
@@ -301,12 +279,15 @@ void ADXL_ReadVectorAsyncI2C(uint8_t address, ADXL_RequestHandler_t callback, vo
         .txLen = sizeof(uint8_t),
         .rxBuffer = m_adxlRequest.rx,
         .rxLen = m_adxlRequest.length,
-        .onTxDone = &I2C_OnRegisterWriteCompleted,
-        .onRxDone = NULL,
+        .onTxDone = NULL,
+        .onRxDone = &OnRegisterRequestCompleted,
+        .onError = &I2C_OnRegisterRequestFailed,
+        .retries = ADXL345_I2C_RETRIES,
         .context = &m_adxlRequest
     };
 
-    I2C_MasterTransmit_IT(&m_i2c, &i2cTransaction);
+    /* register address, repeated START and data in one bus transaction */
+    I2C_MasterTransfer_IT(&m_i2c, &i2cTransaction);
 }
 
 static void AdxlCreateRequest(  AdxlRequest_t* req,
@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "spi.h"
+
 #define ADXL345_ID              0xE5
 
 typedef void (*ADXL_RequestHandler_t)(void* value, void* context);
@@ -16,10 +18,10 @@ typedef struct
 } Acceleration_t;
 
 /*Brief: ADXL345 initialization over SPI
- * [in] - none
+ * [in] - bus - pointer to initialized SPI bus (CS on PA_0)
  * [out] - none
  * */
-void ADXL_InitSPI(void);
+void ADXL_InitSPI(SPI_Handle_t* const bus);
 
 /*Brief: ADXL345 read single register async
  * [in] - address - register address
@@ -51,6 +53,7 @@ void ADXL_ReadVectorAsyncSPI(uint8_t address, ADXL_RequestHandler_t callback, vo
 void ADXL_InitI2C(void);
 
 /*Brief: ADXL345 read single register async
+ * NOTE: callback gets NULL value if transfer failed after retries
  * [in] - address - register address
  * [in] - callback - callback function on receive done
  * [in] - context - response storage address
@@ -66,6 +69,7 @@ void ADXL_ReadRegisterAsyncI2C(uint8_t address, ADXL_RequestHandler_t callback,
 void ADXL_WriteRegisterAsyncI2C(uint8_t address, ADXL_RequestHandler_t callback, void* value);
 
 /*Brief: ADXL345 read vector async
+ * NOTE: callback gets NULL value if transfer failed after retries
  * [in] - address - register address
  * [in] - callback - callback function on receive done
  * [in] - context - response storage address
@@ -1,3 +1,4 @@
+#include <stdbool.h>
 #include <string.h>
 
 #include "buffer.h"
@@ -5,9 +6,11 @@
 #include "uart.h"
 
 #define ESP_RESPONSE_MAX    128
+#define ESP_COMMAND_MAX     128
 
-static UART_Handle_t m_uart;
-static uint8_t m_rxBuffer[ESP_RESPONSE_MAX];
+UART_HANDLE_DEFINE(m_uart, ESP_COMMAND_MAX, ESP_RESPONSE_MAX);
+/* whole RX ring plus terminator */
+static uint8_t m_rxBuffer[ESP_RESPONSE_MAX + 1];
 static ESP_ResponseHandler_t m_onEspResponse = NULL;
 
 static ESP_RESPONSE ESP_ParseResponse(const char* resp);
@@ -16,35 +19,34 @@ static void OnUartReceiveCompleted(void* context)
 {
     UART_Handle_t* handle = (UART_Handle_t*)context;
 
-    uint16_t count = BufferCount(&handle->rxBuffer);
+    uint16_t count = 0;
 
-    if (count < ESP_RESPONSE_MAX)
+    /* ring holds at most ESP_RESPONSE_MAX bytes, so a full ring is drained too */
+    while ((count < ESP_RESPONSE_MAX) && BufferGet(&handle->rxBuffer, &m_rxBuffer[count], sizeof(uint8_t)))
     {
-        for (uint16_t i = 0; i < count; i++)
-        {
-            BufferGet(&handle->rxBuffer, &m_rxBuffer[i], sizeof(uint8_t));
-        }
+        count++;
+    }
 
-        m_rxBuffer[count] = '\0';
+    m_rxBuffer[count] = '\0';
 
-        ESP_RESPONSE result = ESP_ParseResponse((char*)m_rxBuffer);
+    ESP_RESPONSE result = ESP_ParseResponse((char*)m_rxBuffer);
 
-        if (m_onEspResponse != NULL)
-        {
-            (*m_onEspResponse)(result);
-        }
-    }
-    else
+    if (m_onEspResponse != NULL)
     {
-        /* TODO: */
+        (*m_onEspResponse)(result);
     }
 }
 
-void ESP_Init(void)
+bool ESP_Init(void)
 {
-    UartInit(&m_uart, UART_1, BAUD_115200);
+    if (!UartInit(&m_uart, UART_1, BAUD_115200))
+    {
+        return false;
+    }
 
     UartRegisterReceiveHandler(&m_uart, &OnUartReceiveCompleted);
+
+    return true;
 }
 
 void ESP_SendCommand(const char* const command)
@@ -2,6 +2,7 @@
 #define ESP8266_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef enum
 {
@@ -17,9 +18,9 @@ typedef void (*ESP_ResponseHandler_t)(ESP_RESPONSE result);
 
 /*Brief: ESP initialization
  * [in] - none
- * [out] - none
+ * [out] - true - UART to the module is running; false - baud rate is not reachable from UART clock
  * */
-void ESP_Init(void);
+bool ESP_Init(void);
 
 /*Brief: ESP send commands
  * [in] - command - pointer to command
@@ -5,20 +5,27 @@ extern const GpioOps_t g_GpioOps;
 void LedInit(Led_t* led)
 {
     led->gpio->ops = &g_GpioOps;
+    led->gpio->ops->open(led->gpio,
+                         led->pin,
+                         PIN_MODE_OUTPUT,
+                         PIN_TYPE_NO_PULL,
+                         PIN_STRENGTH_LOW,
+                         PIN_CONFIG_PUSH_PULL,
+                         PIN_STATE_LOW);
 }
 
 void LedOn(Led_t* led)
 {
-    led->gpio->ops->write();
+    led->gpio->ops->write(led->gpio, PIN_STATE_HIGH);
 }
 
 void LedOff(Led_t* led)
 {
-    led->gpio->ops->write();
+    led->gpio->ops->write(led->gpio, PIN_STATE_LOW);
 }
 
 void LedToggle(Led_t* led)
 {
-    led->gpio->ops->toggle();
+    led->gpio->ops->toggle(led->gpio);
 }
 
@@ -6,6 +6,7 @@
 typedef struct
 {
     GpioHandle_t* gpio;
+    uint8_t pin;
 } Led_t;
 
 void LedInit(Led_t* led);
@@ -1,8 +1,8 @@
 #include <string.h>
 
-#include "assert.h"
+#include "custom-assert.h"
 #include "cli.h"
-#include "logger.h"
+#include "log.h"
 #include "uart-service.h"
 
 #define CLI_COMMANDS_MAX  10
@@ -41,13 +41,13 @@ static uint8_t SplitLine(char* line, char** argv, int maxArgs)
     return argc;
 }
 
-static void OnUartRxCompleted(const uint8_t* data, uint8_t len)
+static void OnUartRxCompleted(const uint8_t* data, uint16_t len, void* context)
 {
     ASSERT(data);
 
     uint8_t ch;
 
-    for (uint8_t i = 0; i < len; i++)
+    for (uint16_t i = 0; i < len; i++)
     {
         ch = data[i];
 
@@ -68,9 +68,9 @@ static void OnUartRxCompleted(const uint8_t* data, uint8_t len)
     }
 }
 
-void CliInit(void)
+void CliInit(UartService_t* const service)
 {
-    UartServiceRegisterRxCallback(&OnUartRxCompleted);
+    UartServiceRegisterRxCallback(service, &OnUartRxCompleted, NULL);
 }
 
 void CliProcessLine(const char* buffer)
@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+#include "uart-service.h"
+
 typedef void (*CliCommandHandler_t)(int argc, char** argv);
 
 typedef struct
@@ -12,7 +14,7 @@ typedef struct
     const char* help;
 } CliCommand_t;
 
-void CliInit(void);
+void CliInit(UartService_t* const service);
 void CliProcessLine(const char* buffer);
 void CliRegisterCommand(const char* name, CliCommandHandler_t handler, const char* help);
 
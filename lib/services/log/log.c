@@ -1,11 +1,12 @@
 #include <string.h>
 #include <stdarg.h>
 
-#include "assert.h"
+#include "custom-assert.h"
 #include "log.h"
 #include "uart-service.h"
 
 static LOG_LEVEL m_logLevel = LOG_LEVEL_DEBUG;
+static UartService_t* m_service = NULL;
 
 static const char* const PREFIXES[LOG_LEVEL_NUMBER] = { "[DBG]: ", "[INFO]:", "[WARN]: ", "[ERR]: ", "" };
 
@@ -18,7 +19,7 @@ static void PrintNewLine(void);
 
 static void PrintPrefix(const char* const message, uint8_t len)
 {
-    UartServiceSend((uint8_t*)PREFIXES[m_logLevel], len);
+    UartServiceSend(m_service, (uint8_t*)PREFIXES[m_logLevel], len);
 }
 
 static void PrintMessage(const char* const message)
@@ -32,12 +33,12 @@ static void PrintMessage(const char* const message)
 
     len = strlen(message);
 
-    UartServiceSend((uint8_t*)message, len);
+    UartServiceSend(m_service, (uint8_t*)message, len);
 }
 
 static void PrintChar(char ch)
 {
-    UartServiceSend((uint8_t*)&ch, sizeof(char));
+    UartServiceSend(m_service, (uint8_t*)&ch, sizeof(char));
 }
 
 static void PrintHex(uint32_t value)
@@ -48,11 +49,11 @@ static void PrintHex(uint32_t value)
     char zeros[2] = {'0', '0'};
     uint8_t index = 0;
 
-    UartServiceSend((uint8_t*)hexPrefix, sizeof(hexPrefix));
+    UartServiceSend(m_service, (uint8_t*)hexPrefix, sizeof(hexPrefix));
 
     if (value == 0)
     {
-        UartServiceSend((uint8_t*)zeros, sizeof(zeros));
+        UartServiceSend(m_service, (uint8_t*)zeros, sizeof(zeros));
     }
 
     for (int8_t i = 28; i >= 0; i -= 4)
@@ -62,7 +63,7 @@ static void PrintHex(uint32_t value)
 
         if (symbol != '0')
         {
-            UartServiceSend((uint8_t*)&symbol, sizeof(symbol));
+            UartServiceSend(m_service, (uint8_t*)&symbol, sizeof(symbol));
         }
     }
 }
@@ -75,7 +76,7 @@ static void PrintDec(int32_t value)
 
     if (value < 0)
     {
-        UartServiceSend((uint8_t*)&minus, sizeof(minus));
+        UartServiceSend(m_service, (uint8_t*)&minus, sizeof(minus));
         value = -value;
     }
 
@@ -86,7 +87,7 @@ static void PrintDec(int32_t value)
 
     while (i--)
     {
-        UartServiceSend((uint8_t*)&buff[i], sizeof(char));
+        UartServiceSend(m_service, (uint8_t*)&buff[i], sizeof(char));
     }
 }
 
@@ -96,7 +97,14 @@ static void PrintNewLine(void)
 
     uint8_t len = strlen(NEW_LINE);
 
-    UartServiceSend((uint8_t*)NEW_LINE, len);
+    UartServiceSend(m_service, (uint8_t*)NEW_LINE, len);
+}
+
+void LogInit(UartService_t* const service)
+{
+    ASSERT(service != NULL);
+
+    m_service = service;
 }
 
 void LogLevel(LOG_LEVEL level)
@@ -111,7 +119,7 @@ void LogPrint(const char *fmt, ...)
     va_list args;
     va_start(args, fmt);
 
-    if (m_logLevel == LOG_LEVEL_NONE)
+    if (m_logLevel == LOG_LEVEL_NONE || m_service == NULL)
     {
         return;
     }
@@ -189,6 +197,6 @@ void LogPrint(const char *fmt, ...)
 
 bool LogIdle(void)
 {
-    return UartServiceIdle();
+    return (m_service == NULL) || UartServiceIdle(m_service);
 }
 
@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "uart-service.h"
+
 typedef enum
 {
     LOG_LEVEL_DEBUG = 0,
@@ -14,6 +16,12 @@ typedef enum
     LOG_LEVEL_NUMBER
 } LOG_LEVEL;
 
+/*Brief: Bind logger to UART service instance
+ * [in] - service - pointer to initialized UART service
+ * [out] - none
+ * */
+void LogInit(UartService_t* const service);
+
 /*Brief: Set log level
  * [in] - level - new level
  * [out] - none
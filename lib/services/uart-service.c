@@ -1,69 +1,64 @@
 #include <stddef.h>
-#if 0
+
 #include "custom-assert.h"
 #include "uart-service.h"
 #include "uart.h"
 
-typedef struct
-{
-    UART_Handle_t uart;
-    UartRxCallback_t callback;
-} UartServiceHandle_t;
-
-static UartServiceHandle_t m_uartService;
-
 static void OnUartRxDone(void* context)
 {
-    UART_Handle_t* handle = (UART_Handle_t*)context;
+    /* handle is the first member of service instance */
+    UartService_t* service = (UartService_t*)context;
+    Buffer_t* buffer = &service->uart.rxBuffer;
 
-    uint8_t buffer[64];
-    uint8_t count = 0;
-    uint8_t item = 0;
-    uint8_t bufferSize = sizeof(buffer);
+    uint16_t count = BufferContiguousCount(buffer);
 
-    while (BufferGet(&handle->rxBuffer, &item, sizeof(item)))
+    /* data wrapped around the end of storage is delivered by second pass */
+    while (count != 0)
     {
-        if (count < bufferSize)
+        if (service->callback != NULL)
         {
-            buffer[count++] = item;
+            (*service->callback)((const uint8_t*)BufferFront(buffer), count, service->context);
         }
-        else
-        {
-            ASSERT(false);
-        }
-    }
 
-    if (count > 0)
-    {
-        if (m_uartService.callback != NULL)
-        {
-            (*m_uartService.callback)(buffer, count);
-        }
+        BufferSkip(buffer, count);
+
+        count = BufferContiguousCount(buffer);
     }
 }
 
-void UartServiceInit(void)
+bool UartServiceInit(UartService_t* const service, UART_NAMES uartName, BAUD_RATE baud)
 {
-    UartInit(&m_uartService.uart, UART_1, BAUD_921600);
+    ASSERT(service != NULL);
+
+    if (!UartInit(&service->uart, uartName, baud))
+    {
+        return false;
+    }
 
-    UartRegisterReceiveHandler(&m_uartService.uart, &OnUartRxDone);
+    UartRegisterReceiveHandler(&service->uart, &OnUartRxDone);
+
+    return true;
 }
 
-void UartServiceSend(const uint8_t* const data, uint8_t len)
+uint32_t UartServiceSend(UartService_t* const service, const uint8_t* const data, uint32_t len)
 {
-    ASSERT(data);
+    ASSERT(service != NULL);
+    ASSERT(data != NULL);
 
-    UartWrite_IT(&m_uartService.uart, (uint8_t*)data, len);
+    return UartWrite_IT(&service->uart, data, len);
 }
 
-void UartServiceRegisterRxCallback(UartRxCallback_t callback)
+void UartServiceRegisterRxCallback(UartService_t* const service, UartRxCallback_t callback, void* context)
 {
-    m_uartService.callback = callback;
+    ASSERT(service != NULL);
+
+    service->context = context;
+    service->callback = callback;
 }
 
-bool UartServiceIdle(void)
+bool UartServiceIdle(UartService_t* const service)
 {
-    return UartIdle(&m_uartService.uart);
-}
+    ASSERT(service != NULL);
 
-#endif
+    return UartIdle(&service->uart);
+}
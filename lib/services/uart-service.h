@@ -4,32 +4,60 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-typedef void (*UartRxCallback_t)(const uint8_t* data, uint8_t len);
+#include "uart.h"
+
+/* Received data is passed in place (RX ring storage), valid only during the call */
+typedef void (*UartRxCallback_t)(const uint8_t* data, uint16_t len, void* context);
+
+typedef struct
+{
+    UART_Handle_t uart;         /* must be first, UART callback context is the handle */
+    UartRxCallback_t callback;
+    void* context;
+} UartService_t;
+
+/* Define UART service instance together with its ring storage
+ * [in] - name - service name
+ * [in] - txCapacity - TX buffer capacity in bytes
+ * [in] - rxCapacity - RX buffer capacity in bytes
+ * */
+#define UART_SERVICE_DEFINE(name, txCapacity, rxCapacity)                   \
+    static uint8_t name##TxData[UART_STORAGE_SIZE(txCapacity)];             \
+    static uint8_t name##RxData[UART_STORAGE_SIZE(rxCapacity)];             \
+    static UartService_t name = { .uart = {                                 \
+        .txData = name##TxData, .txSize = sizeof(name##TxData),             \
+        .rxData = name##RxData, .rxSize = sizeof(name##RxData) } }
 
 /*Brief: UART service initialization
- * [in] - none
- * [out] - none
+ * [in] - service - pointer to service instance (see UART_SERVICE_DEFINE)
+ * [in] - uartName - UART port
+ * [in] - baud - baud rate
+ * [out] - true - service started; false - baud rate is not reachable from UART clock
  * */
-void UartServiceInit(void);
+bool UartServiceInit(UartService_t* const service, UART_NAMES uartName, BAUD_RATE baud);
 
 /*Brief: UART service send data
+ * [in] - service - pointer to service instance
  * [in] - data - pointer to data to send
  * [in] - len - data length
- * [out] - none
+ * [out] - number of bytes accepted
  * */
-void UartServiceSend(const uint8_t* const data, uint8_t len);
+uint32_t UartServiceSend(UartService_t* const service, const uint8_t* const data, uint32_t len);
 
 /*Brief: Register receive callback
+ * NOTE: invoked from interrupt context, once per contiguous part of RX ring
+ * (at most twice per event when data wraps around the end of storage)
+ * [in] - service - pointer to service instance
  * [in] - callback - callback
+ * [in] - context - user context passed to callback
  * [out] - none
  * */
-void UartServiceRegisterRxCallback(UartRxCallback_t callback);
+void UartServiceRegisterRxCallback(UartService_t* const service, UartRxCallback_t callback, void* context);
 
 /*Brief: Check UART service state
- * [in] - none
- * [out] - true - busy; false - otherwise
+ * [in] - service - pointer to service instance
+ * [out] - true - idle; false - otherwise (busy)
  * */
-bool UartServiceIdle(void);
+bool UartServiceIdle(UartService_t* const service);
 
 #endif /* UART_SERVICE_H */
-
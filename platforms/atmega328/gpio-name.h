@@ -0,0 +1,14 @@
+#ifndef ATMEGA328_GPIO_NAME_H
+#define ATMEGA328_GPIO_NAME_H
+
+/* pin = (port << 3) | bit, port: 0 - PORTB, 1 - PORTC, 2 - PORTD
+ * PORTC has no bit 7, PC_6 is RESET unless RSTDISBL fuse is programmed */
+typedef enum
+{
+    PB_0 = 0, PB_1, PB_2, PB_3, PB_4, PB_5, PB_6, PB_7,
+    PC_0, PC_1, PC_2, PC_3, PC_4, PC_5, PC_6,
+    PD_0 = 16, PD_1, PD_2, PD_3, PD_4, PD_5, PD_6, PD_7,
+    PIN_GPIO_MAX
+} ATMEGA328_PIN_NAMES;
+
+#endif /* ATMEGA328_GPIO_NAME_H */
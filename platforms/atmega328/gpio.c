@@ -1,6 +1,455 @@
 #include <stddef.h>
 
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
 #include "custom-assert.h"
 #include "gpio.h"
+#include "gpio-name.h"
+#include "ignore.h"
+
+#define GPIO_PORT_MAX           (3U)
+#define GPIO_PIN_PER_PORT       (8U)
+
+typedef struct
+{
+    volatile uint8_t* ddr;
+    volatile uint8_t* port;
+    volatile uint8_t* pinReg;
+    volatile uint8_t* pcmsk;    /* pin change mask of the port */
+    uint8_t pcie;               /* PCICR enable bit of the port */
+    uint8_t pins;               /* bonded out pins of the port */
+} GpioPortMap_t;
+
+static const GpioPortMap_t m_GPIO_PORTS[GPIO_PORT_MAX] = {
+    { &DDRB, &PORTB, &PINB, &PCMSK0, (1 << PCIE0), 0xFF },
+    { &DDRC, &PORTC, &PINC, &PCMSK1, (1 << PCIE1), 0x7F },
+    { &DDRD, &PORTD, &PIND, &PCMSK2, (1 << PCIE2), 0xFF },
+};
+
+static GpioHandle_t* m_GpioIrq[GPIO_PORT_MAX][GPIO_PIN_PER_PORT] = { { NULL } };
+static PIN_IRQ_MODES m_GpioIrqMode[GPIO_PORT_MAX][GPIO_PIN_PER_PORT];
+
+/* last PINx sampled by pin change interrupt, to tell edge direction */
+static uint8_t m_GpioLastLevel[GPIO_PORT_MAX];
+
+static uint8_t GpioGetPortIndex(uint8_t pin)
+{
+    return (uint8_t)(pin >> 3U);
+}
+
+static uint8_t GpioGetPinIndex(uint8_t pin)
+{
+    return (uint8_t)(pin & 0x07U);
+}
+
+static uint8_t GpioGetPortIndexByRegister(volatile uint8_t* port)
+{
+    for (uint8_t i = 0; i < GPIO_PORT_MAX; i++)
+    {
+        if (m_GPIO_PORTS[i].port == port)
+        {
+            return i;
+        }
+    }
+
+    /* should never reach here */
+    ASSERT(false);
+    return 0;
+}
+
+static uint8_t GpioGetPinIndexByMask(uint8_t mask)
+{
+    uint8_t index = 0;
+
+    while ((mask >>= 1) != 0U)
+    {
+        index++;
+    }
+
+    return index;
+}
+
+static void GpioSetState(const GpioHandle_t* const handle, PIN_STATES state)
+{
+    uint8_t bit = handle->gpio.atmega328.bit;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (handle->gpio.atmega328.openDrain)
+        {
+            /* release the line or pull it low */
+            *handle->gpio.atmega328.port &= (uint8_t)~bit;
+
+            if (state == PIN_STATE_HIGH)
+            {
+                *handle->gpio.atmega328.ddr &= (uint8_t)~bit;
+            }
+            else
+            {
+                *handle->gpio.atmega328.ddr |= bit;
+            }
+        }
+        else if (state == PIN_STATE_HIGH)
+        {
+            *handle->gpio.atmega328.port |= bit;
+        }
+        else
+        {
+            *handle->gpio.atmega328.port &= (uint8_t)~bit;
+        }
+    }
+}
+
+static void GpioOpen(GpioHandle_t* const handle,
+              uint8_t pin,
+              PIN_MODES mode,
+              PIN_TYPES pull,
+              PIN_STRENGTH strength,
+              PIN_CONFIGS config,
+              uint32_t value)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (pin == (uint8_t)PIN_NC)
+    {
+        return;
+    }
+
+    ASSERT(pin < PIN_GPIO_MAX);
+
+    /* no pull-down and no drive strength control on this MCU */
+    ASSERT(pull != PIN_TYPE_PULL_DOWN);
+    IGNORE(strength);
+
+    const GpioPortMap_t* map = &m_GPIO_PORTS[GpioGetPortIndex(pin)];
+    uint8_t bit = (uint8_t)(1U << GpioGetPinIndex(pin));
+
+    ASSERT((map->pins & bit) != 0U);
+
+    handle->gpio.atmega328.ddr = map->ddr;
+    handle->gpio.atmega328.port = map->port;
+    handle->gpio.atmega328.pinReg = map->pinReg;
+    handle->gpio.atmega328.bit = bit;
+    handle->gpio.atmega328.openDrain = (mode == PIN_MODE_OUTPUT) && (config == PIN_CONFIG_OPEN_DRAIN);
+    handle->irqHandler = NULL;
+
+    switch (mode)
+    {
+        case PIN_MODE_INPUT:
+        case PIN_MODE_ANALOG:
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                *map->ddr &= (uint8_t)~bit;
+
+                /* PORTx bit of an input enables pull-up */
+                if ((mode == PIN_MODE_INPUT) && (pull == PIN_TYPE_PULL_UP))
+                {
+                    *map->port |= bit;
+                }
+                else
+                {
+                    *map->port &= (uint8_t)~bit;
+                }
+            }
+            break;
+
+        case PIN_MODE_OUTPUT:
+            /* set level first, so the pin does not glitch when it becomes output */
+            GpioSetState(handle, value ? PIN_STATE_HIGH : PIN_STATE_LOW);
+
+            if (!handle->gpio.atmega328.openDrain)
+            {
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+                {
+                    *map->ddr |= bit;
+                }
+            }
+            break;
+
+        case PIN_MODE_ALTERNATE:
+            /* peripherals take over the pin when enabled, nothing to route */
+            break;
+
+        default:
+            ASSERT(false);
+            break;
+    }
+
+    handle->initialized = true;
+}
+
+static void GpioClose(GpioHandle_t* const handle)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return;
+    }
+
+    uint8_t bit = handle->gpio.atmega328.bit;
+
+    /* back to reset state: input, no pull-up */
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        *handle->gpio.atmega328.ddr &= (uint8_t)~bit;
+        *handle->gpio.atmega328.port &= (uint8_t)~bit;
+    }
+
+    handle->initialized = false;
+}
+
+static void GpioWrite(const GpioHandle_t* const handle, PIN_STATES state)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return;
+    }
+
+    GpioSetState(handle, state);
+}
+
+static uint16_t GpioRead(const GpioHandle_t* const handle)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return 0xFF;
+    }
+
+    return (*handle->gpio.atmega328.pinReg & handle->gpio.atmega328.bit) ? 1U : 0U;
+}
+
+static void GpioToggle(const GpioHandle_t* const handle)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return;
+    }
+
+    if (handle->gpio.atmega328.openDrain)
+    {
+        bool released = (*handle->gpio.atmega328.ddr & handle->gpio.atmega328.bit) == 0U;
+
+        GpioSetState(handle, released ? PIN_STATE_LOW : PIN_STATE_HIGH);
+        return;
+    }
+
+    /* writing 1 to PINx toggles PORTx, single store */
+    *handle->gpio.atmega328.pinReg = handle->gpio.atmega328.bit;
+}
+
+static void GpioSetInterrupt(GpioHandle_t* const handle, PIN_IRQ_MODES mode, uint8_t priority, GpioIrqHandler handler)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+    /* event mode needs getEvents, not provided by this backend */
+    ASSERT(handler != NULL);
+
+    /* AVR interrupt priorities are fixed by vector order */
+    IGNORE(priority);
+
+    if (!handle->initialized || (mode == PIN_IRQ_NONE))
+    {
+        return;
+    }
+
+    uint8_t portIndex = GpioGetPortIndexByRegister(handle->gpio.atmega328.port);
+    uint8_t pinIndex = GpioGetPinIndexByMask(handle->gpio.atmega328.bit);
+    const GpioPortMap_t* map = &m_GPIO_PORTS[portIndex];
+
+    handle->irqHandler = handler;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        m_GpioIrq[portIndex][pinIndex] = handle;
+        m_GpioIrqMode[portIndex][pinIndex] = mode;
+
+        /* pin change interrupt fires on any edge, edge is filtered in software;
+         * other bits keep their last sample, so their pending edges are not lost */
+        m_GpioLastLevel[portIndex] = (uint8_t)((m_GpioLastLevel[portIndex] & ~handle->gpio.atmega328.bit) |
+                                               (*map->pinReg & handle->gpio.atmega328.bit));
+
+        *map->pcmsk |= handle->gpio.atmega328.bit;
+
+        PCIFR = map->pcie;
+        PCICR |= map->pcie;
+    }
+}
+
+static void GpioPinChangeHandler(uint8_t portIndex)
+{
+    const GpioPortMap_t* map = &m_GPIO_PORTS[portIndex];
+
+    uint8_t level = *map->pinReg;
+    uint8_t changed = (uint8_t)((level ^ m_GpioLastLevel[portIndex]) & *map->pcmsk);
+
+    m_GpioLastLevel[portIndex] = level;
+
+    for (uint8_t i = 0; changed != 0U; i++, changed >>= 1)
+    {
+        if ((changed & 0x01U) == 0U)
+        {
+            continue;
+        }
+
+        GpioHandle_t* handle = m_GpioIrq[portIndex][i];
+
+        if ((handle == NULL) || (handle->irqHandler == NULL))
+        {
+            continue;
+        }
+
+        bool rising = (level & (1U << i)) != 0U;
+        PIN_IRQ_MODES mode = m_GpioIrqMode[portIndex][i];
+
+        if ((mode == PIN_IRQ_BOTH) || (rising && (mode == PIN_IRQ_RISING)) || (!rising && (mode == PIN_IRQ_FALLING)))
+        {
+            (*handle->irqHandler)();
+        }
+    }
+}
+
+ISR(PCINT0_vect)
+{
+    GpioPinChangeHandler(0);
+}
+
+ISR(PCINT1_vect)
+{
+    GpioPinChangeHandler(1);
+}
+
+ISR(PCINT2_vect)
+{
+    GpioPinChangeHandler(2);
+}
+
+static void GpioPortOpen(GpioPortHandle_t* const handle,
+              uint8_t pin,
+              uint8_t width,
+              PIN_MODES mode,
+              PIN_TYPES pull,
+              PIN_STRENGTH strength,
+              PIN_CONFIGS config,
+              uint32_t value)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+    ASSERT((width > 0) && ((GpioGetPinIndex(pin) + width) <= GPIO_PIN_PER_PORT));
+
+    GpioHandle_t gpio = { .ops = handle->ops };
+
+    for (uint8_t i = 0; i < width; i++)
+    {
+        GpioOpen(&gpio, (uint8_t)(pin + i), mode, pull, strength, config, (value >> i) & 0x01U);
+    }
+
+    const GpioPortMap_t* map = &m_GPIO_PORTS[GpioGetPortIndex(pin)];
+
+    handle->gpio.atmega328.ddr = map->ddr;
+    handle->gpio.atmega328.port = map->port;
+    handle->gpio.atmega328.pinReg = map->pinReg;
+    handle->gpio.atmega328.openDrain = (mode == PIN_MODE_OUTPUT) && (config == PIN_CONFIG_OPEN_DRAIN);
+    handle->shift = GpioGetPinIndex(pin);
+    handle->mask = (uint32_t)(((1U << width) - 1U) << handle->shift);
+    handle->initialized = true;
+}
+
+static void GpioPortWrite(const GpioPortHandle_t* const handle, uint32_t value)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return;
+    }
+
+    uint8_t mask = (uint8_t)handle->mask;
+    uint8_t bits = (uint8_t)((value << handle->shift) & mask);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (handle->gpio.atmega328.openDrain)
+        {
+            /* PORTx bits stay cleared: low - output, high - released input */
+            *handle->gpio.atmega328.ddr = (uint8_t)((*handle->gpio.atmega328.ddr & ~mask) | (~bits & mask));
+        }
+        else
+        {
+            *handle->gpio.atmega328.port = (uint8_t)((*handle->gpio.atmega328.port & ~mask) | bits);
+        }
+    }
+}
+
+static void GpioPortSetReset(const GpioPortHandle_t* const handle, uint32_t set, uint32_t reset)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return;
+    }
+
+    uint8_t setBits = (uint8_t)((set << handle->shift) & handle->mask);
+    uint8_t resetBits = (uint8_t)((reset << handle->shift) & handle->mask);
+
+    /* set wins over reset, same as STM32 BSRR */
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (handle->gpio.atmega328.openDrain)
+        {
+            *handle->gpio.atmega328.ddr = (uint8_t)((*handle->gpio.atmega328.ddr | resetBits) & ~setBits);
+        }
+        else
+        {
+            *handle->gpio.atmega328.port = (uint8_t)((*handle->gpio.atmega328.port & ~resetBits) | setBits);
+        }
+    }
+}
+
+static uint32_t GpioPortRead(const GpioPortHandle_t* const handle)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return 0;
+    }
 
+    return (uint32_t)((*handle->gpio.atmega328.pinReg & handle->mask) >> handle->shift);
+}
 
+/* Gpio operations */
+const GpioOps_t g_GpioOps = {
+    .open = &GpioOpen,
+    .close = &GpioClose,
+    .read = &GpioRead,
+    .write = &GpioWrite,
+    .toggle = &GpioToggle,
+    .interrupt = &GpioSetInterrupt,
+    /* no edge queue: event mode ops are left out (see gpio.h) */
+    .filter = NULL,
+    .getEvent = NULL,
+    .getEvents = NULL,
+    .getEventsLost = NULL,
+    .portOpen = &GpioPortOpen,
+    .portWrite = &GpioPortWrite,
+    .portSetReset = &GpioPortSetReset,
+    .portRead = &GpioPortRead
+};
@@ -14,7 +14,13 @@
 #include <ti/devices/cc32xx/driverlib/prcm.h>
 #include <ti/devices/cc32xx/driverlib/interrupt.h>
 
-static GpioHandle_t* m_GpioIrq[PIN_GPIO_MAX] = { NULL };
+#define GPIO_PORT_MAX           (4U)
+#define GPIO_PIN_PER_PORT       (8U)
+
+static GpioHandle_t* m_GpioIrq[GPIO_PORT_MAX][GPIO_PIN_PER_PORT] = { { NULL } };
+
+/* opened pins per port, the port clock is gated when the last one closes */
+static uint8_t m_GpioOpened[GPIO_PORT_MAX] = { 0 };
 
 typedef struct
 {
@@ -52,10 +58,34 @@ static const GpioMap_t m_GPIO_MAP[PIN_GPIO_MAX] = {
     [PIN_GPIOA3_7] = { GPIOA3_BASE, GPIO_PIN_7, PIN_45 },
 };
 
-static uint8_t GpioGetPinIndex(uint32_t base, uint8_t pinMask)
+static uint8_t GpioGetPinIndex(uint8_t pinMask)
+{
+    ASSERT(pinMask != 0U);
+
+    return (uint8_t)__builtin_ctz(pinMask);
+}
+
+static uint8_t GpioGetPortIndex(uint32_t base)
 {
-    /*TODO:*/
-    return 0;
+    switch (base)
+    {
+        case GPIOA0_BASE:
+            return 0;
+
+        case GPIOA1_BASE:
+            return 1;
+
+        case GPIOA2_BASE:
+            return 2;
+
+        case GPIOA3_BASE:
+            return 3;
+
+        default:
+            /* should never reach here */
+            ASSERT(false);
+            return 0;
+    }
 }
 
 static void GpioDisableClocks(uint32_t base)
@@ -263,20 +293,23 @@ static void GpioOpen(GpioHandle_t* const handle,
 {
     ASSERT(handle != NULL);
     ASSERT(handle->ops != NULL);
-    ASSERT(pin < PIN_GPIO_MAX);
 
     if (pin == PIN_NC)
     {
         return;
     }
 
+    ASSERT(pin < PIN_GPIO_MAX);
+
     const GpioMap_t* map = &m_GPIO_MAP[pin];
 
     handle->gpio.cc3220.base = map->base;
     handle->gpio.cc3220.pinMask = map->mask;
+    handle->gpio.cc3220.pinIndex = GpioGetPinIndex(map->mask);
     handle->irqHandler = NULL;
 
     GpioEnableClocks(map->base);
+    m_GpioOpened[GpioGetPortIndex(map->base)] |= map->mask;
 
     uint32_t pinType = GpioMapPinType(pull, config);
     uint32_t pinStrength = GpioMapStrength(strength);
@@ -292,11 +325,13 @@ static void GpioOpen(GpioHandle_t* const handle,
 
         case PIN_MODE_OUTPUT:
         {
+            /* GPIODATA is address masked, the pin bit carries the level;
+             * level before direction, so the pin does not glitch */
+            uint8_t newValue = (value ? map->mask : 0U);
+            GPIOPinWrite(map->base, map->mask, newValue);
+
             PinModeSet(map->pin, PIN_MODE_0);
             GPIODirModeSet(map->base, map->mask, GPIO_DIR_MODE_OUT);
-
-            uint8_t newValue = (value ? 1 : 0);
-            GPIOPinWrite(map->base, map->mask, newValue);
         }
         break;
 
@@ -321,16 +356,32 @@ static void GpioOpen(GpioHandle_t* const handle,
 
 static void GpioClose(GpioHandle_t* const handle)
 {
-    if ((handle == NULL) || (handle->ops != NULL))
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
     {
         return;
     }
 
+    uint32_t base = handle->gpio.cc3220.base;
+    uint8_t pinMask = handle->gpio.cc3220.pinMask;
+    uint8_t portIndex = GpioGetPortIndex(base);
+
+    GPIOIntDisable(base, pinMask);
+    GPIOIntClear(base, pinMask);
+
+    m_GpioIrq[portIndex][handle->gpio.cc3220.pinIndex] = NULL;
+    handle->irqHandler = NULL;
     handle->initialized = false;
 
-    GpioDisableClocks(handle->gpio.cc3220.base);
+    m_GpioOpened[portIndex] &= (uint8_t)~pinMask;
 
-    /*TODO: disable interrupts */
+    /* other pins of the port may still be in use */
+    if (m_GpioOpened[portIndex] == 0U)
+    {
+        GpioDisableClocks(base);
+    }
 }
 
 static void GpioWrite(const GpioHandle_t* const handle, PIN_STATES state)
@@ -393,20 +444,69 @@ static void GpioToggle(const GpioHandle_t* const handle)
 #endif
 }
 
+static void GpioIrqDispatch(uint8_t portIndex, uint32_t base)
+{
+    /* masked status, only pins with interrupt enabled */
+    uint32_t status = GPIOIntStatus(base, true);
+
+    GPIOIntClear(base, status);
+
+    while (status != 0U)
+    {
+        uint8_t pinIndex = (uint8_t)__builtin_ctz(status);
+        GpioHandle_t* handle = m_GpioIrq[portIndex][pinIndex];
+
+        status &= status - 1U;
+
+        if ((handle != NULL) && (handle->irqHandler != NULL))
+        {
+            (*handle->irqHandler)();
+        }
+    }
+}
+
+static void GpioA0IrqHandler(void)
+{
+    GpioIrqDispatch(0, GPIOA0_BASE);
+}
+
+static void GpioA1IrqHandler(void)
+{
+    GpioIrqDispatch(1, GPIOA1_BASE);
+}
+
+static void GpioA2IrqHandler(void)
+{
+    GpioIrqDispatch(2, GPIOA2_BASE);
+}
+
+static void GpioA3IrqHandler(void)
+{
+    GpioIrqDispatch(3, GPIOA3_BASE);
+}
+
+static void (* const m_GPIO_IRQ_HANDLERS[GPIO_PORT_MAX])(void) = {
+    GpioA0IrqHandler,
+    GpioA1IrqHandler,
+    GpioA2IrqHandler,
+    GpioA3IrqHandler,
+};
+
 static void GpioSetInterrupt(GpioHandle_t* const handle, PIN_IRQ_MODES mode, uint8_t priority, GpioIrqHandler handler)
 {
-    /* TODO: */
     ASSERT(handle != NULL);
     ASSERT(handle->ops != NULL);
+    /* event mode needs getEvents, not provided by this backend */
+    ASSERT(handler != NULL);
 
-    if (mode == PIN_IRQ_NONE)
+    if (!handle->initialized || (mode == PIN_IRQ_NONE))
     {
         return;
     }
 
     uint32_t base = handle->gpio.cc3220.base;
     uint8_t pinMask = handle->gpio.cc3220.pinMask;
-    uint8_t pinIndex = GpioGetPinIndex(base, pinMask);
+    uint8_t portIndex = GpioGetPortIndex(base);
     uint8_t intPriority = GpioMapInterruptPriority(priority);
     uint8_t intNum = GpioMapInterrupt(base);
 
@@ -421,23 +521,101 @@ static void GpioSetInterrupt(GpioHandle_t* const handle, PIN_IRQ_MODES mode, uin
 
     GPIOIntClear(base, pinMask);
 
+    /* one vector per port, the dispatcher calls the handler of each pending pin */
+    m_GpioIrq[portIndex][handle->gpio.cc3220.pinIndex] = handle;
+
     GPIOIntEnable(base, pinMask);
 
     IntPrioritySet(intNum, intPriority);
 
-    IntRegister(intNum, handler);
+    IntRegister(intNum, m_GPIO_IRQ_HANDLERS[portIndex]);
 
     IntEnable(intNum);
+}
 
-#if 0
-    for (uint8_t i = 0; i < PIN_GPIO_MAX; i++)
+static void GpioPortOpen(GpioPortHandle_t* const handle,
+              uint8_t pin,
+              uint8_t width,
+              PIN_MODES mode,
+              PIN_TYPES pull,
+              PIN_STRENGTH strength,
+              PIN_CONFIGS config,
+              uint32_t value)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+    ASSERT((width > 0) && ((pin + width) <= PIN_GPIO_MAX));
+
+    const GpioMap_t* first = &m_GPIO_MAP[pin];
+    GpioHandle_t gpio = { .ops = handle->ops };
+
+    handle->mask = 0;
+
+    for (uint8_t i = 0; i < width; i++)
     {
-        if (m_GpioIrq[i] != NULL && m_GpioIrq[i]->gpio.cc3220.pinIndex == pinIndex)
-        {
-            return;
-        }
+        const GpioMap_t* map = &m_GPIO_MAP[pin + i];
+
+        /* pins must be consecutive bits of one port (GPIOA2/A3 have gaps) */
+        ASSERT((map->base == first->base) && (map->mask == (first->mask << i)));
+
+        uint32_t pinValue = (mode == PIN_MODE_ALTERNATE) ? value : ((value >> i) & 0x01U);
+
+        GpioOpen(&gpio, (uint8_t)(pin + i), mode, pull, strength, config, pinValue);
+
+        handle->mask |= map->mask;
     }
-#endif
+
+    handle->gpio.cc3220.base = first->base;
+    handle->shift = 0;
+
+    while (((first->mask >> handle->shift) & 0x01U) == 0U)
+    {
+        handle->shift++;
+    }
+
+    handle->initialized = true;
+}
+
+static void GpioPortWrite(const GpioPortHandle_t* const handle, uint32_t value)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return;
+    }
+
+    /* GPIODATA is address masked, so only the group pins are written */
+    GPIOPinWrite(handle->gpio.cc3220.base, (uint8_t)handle->mask, (uint8_t)(value << handle->shift));
+}
+
+static void GpioPortSetReset(const GpioPortHandle_t* const handle, uint32_t set, uint32_t reset)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return;
+    }
+
+    uint8_t pins = (uint8_t)(((set | reset) << handle->shift) & handle->mask);
+
+    GPIOPinWrite(handle->gpio.cc3220.base, pins, (uint8_t)(set << handle->shift));
+}
+
+static uint32_t GpioPortRead(const GpioPortHandle_t* const handle)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return 0;
+    }
+
+    return (GPIOPinRead(handle->gpio.cc3220.base, (uint8_t)handle->mask) & handle->mask) >> handle->shift;
 }
 
 /* Gpio operations */
@@ -447,6 +625,15 @@ const GpioOps_t g_GpioOps = {
     .read = &GpioRead,
     .write = &GpioWrite,
     .toggle = &GpioToggle,
-    .interrupt = &GpioSetInterrupt
+    .interrupt = &GpioSetInterrupt,
+    /* no edge queue: event mode ops are left out (see gpio.h) */
+    .filter = NULL,
+    .getEvent = NULL,
+    .getEvents = NULL,
+    .getEventsLost = NULL,
+    .portOpen = &GpioPortOpen,
+    .portWrite = &GpioPortWrite,
+    .portSetReset = &GpioPortSetReset,
+    .portRead = &GpioPortRead
 };
 
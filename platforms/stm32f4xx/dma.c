@@ -0,0 +1,222 @@
+#include <stddef.h>
+
+#include "custom-assert.h"
+#include "dma.h"
+
+#define DMA_1_CLOCK_ENABLE (RCC->AHB1ENR |= (RCC_AHB1ENR_DMA1EN))
+#define DMA_2_CLOCK_ENABLE (RCC->AHB1ENR |= (RCC_AHB1ENR_DMA2EN))
+
+#define DMA_STREAM_MAX      (8U)
+
+/* RM0383 9.5.1: stream flags are packed in LISR (0 - 3) and HISR (4 - 7) */
+static const uint8_t DMA_FLAG_OFFSET[4] = { 0, 6, 16, 22 };
+
+typedef struct
+{
+    DMA_Handler_t handler;
+    void* context;
+} DMA_Irq_t;
+
+/* [0] - DMA1, [1] - DMA2 */
+static DMA_Irq_t m_DmaIrq[2][DMA_STREAM_MAX];
+
+static void DmaOnInterrupt(uint8_t controller, uint8_t index);
+
+void DmaInit(const DMA_Stream_t* const dma, uint32_t config)
+{
+    ASSERT(dma != NULL);
+    ASSERT(dma->index < DMA_STREAM_MAX);
+    ASSERT(dma->channel < 8U);
+
+    if (dma->controller == DMA1)
+    {
+        DMA_1_CLOCK_ENABLE;
+    }
+    else
+    {
+        DMA_2_CLOCK_ENABLE;
+    }
+
+    DmaStop(dma);
+
+    DmaClearFlags(dma, DMA_FLAG_ALL);
+
+    dma->stream->CR = ((uint32_t)dma->channel << DMA_SxCR_CHSEL_Pos) | (config & ~DMA_SxCR_EN);
+
+    /* Direct mode (no FIFO) */
+    dma->stream->FCR = 0;
+}
+
+void DmaStart(const DMA_Stream_t* const dma, volatile const void* peripheral, const void* memory, uint16_t count)
+{
+    ASSERT(dma != NULL);
+    ASSERT(memory != NULL);
+    ASSERT(count != 0);
+
+    dma->stream->PAR = (uint32_t)peripheral;
+    dma->stream->M0AR = (uint32_t)memory;
+    dma->stream->NDTR = count;
+
+    dma->stream->CR |= DMA_SxCR_EN;
+}
+
+void DmaStop(const DMA_Stream_t* const dma)
+{
+    ASSERT(dma != NULL);
+
+    dma->stream->CR &= ~DMA_SxCR_EN;
+
+    /* stream is disabled once the current data item is transferred */
+    while (dma->stream->CR & DMA_SxCR_EN);
+}
+
+uint16_t DmaRemaining(const DMA_Stream_t* const dma)
+{
+    ASSERT(dma != NULL);
+
+    return (uint16_t)dma->stream->NDTR;
+}
+
+uint32_t DmaGetFlags(const DMA_Stream_t* const dma)
+{
+    ASSERT(dma != NULL);
+
+    uint32_t isr = (dma->index < 4U) ? dma->controller->LISR : dma->controller->HISR;
+
+    return (isr >> DMA_FLAG_OFFSET[dma->index % 4U]) & DMA_FLAG_ALL;
+}
+
+void DmaClearFlags(const DMA_Stream_t* const dma, uint32_t flags)
+{
+    ASSERT(dma != NULL);
+
+    uint32_t mask = (flags & DMA_FLAG_ALL) << DMA_FLAG_OFFSET[dma->index % 4U];
+
+    if (dma->index < 4U)
+    {
+        dma->controller->LIFCR = mask;
+    }
+    else
+    {
+        dma->controller->HIFCR = mask;
+    }
+}
+
+void DmaRegisterHandler(const DMA_Stream_t* const dma, DMA_Handler_t handler, void* context)
+{
+    ASSERT(dma != NULL);
+    ASSERT(dma->index < DMA_STREAM_MAX);
+
+    DMA_Irq_t* irq = &m_DmaIrq[(dma->controller == DMA1) ? 0 : 1][dma->index];
+
+    /* stream is taken by another peripheral, completions would be misrouted */
+    ASSERT(irq->handler == NULL || irq->context == context);
+
+    __disable_irq();
+    irq->handler = handler;
+    irq->context = context;
+    __enable_irq();
+}
+
+void DmaUnregisterHandler(const DMA_Stream_t* const dma)
+{
+    ASSERT(dma != NULL);
+    ASSERT(dma->index < DMA_STREAM_MAX);
+
+    DMA_Irq_t* irq = &m_DmaIrq[(dma->controller == DMA1) ? 0 : 1][dma->index];
+
+    __disable_irq();
+    irq->handler = NULL;
+    irq->context = NULL;
+    __enable_irq();
+}
+
+static void DmaOnInterrupt(uint8_t controller, uint8_t index)
+{
+    const DMA_Irq_t* irq = &m_DmaIrq[controller][index];
+
+    if (irq->handler != NULL)
+    {
+        (*irq->handler)(irq->context);
+    }
+}
+
+void DMA1_Stream0_IRQHandler(void)
+{
+    DmaOnInterrupt(0, 0);
+}
+
+void DMA1_Stream1_IRQHandler(void)
+{
+    DmaOnInterrupt(0, 1);
+}
+
+void DMA1_Stream2_IRQHandler(void)
+{
+    DmaOnInterrupt(0, 2);
+}
+
+void DMA1_Stream3_IRQHandler(void)
+{
+    DmaOnInterrupt(0, 3);
+}
+
+void DMA1_Stream4_IRQHandler(void)
+{
+    DmaOnInterrupt(0, 4);
+}
+
+void DMA1_Stream5_IRQHandler(void)
+{
+    DmaOnInterrupt(0, 5);
+}
+
+void DMA1_Stream6_IRQHandler(void)
+{
+    DmaOnInterrupt(0, 6);
+}
+
+void DMA1_Stream7_IRQHandler(void)
+{
+    DmaOnInterrupt(0, 7);
+}
+
+void DMA2_Stream0_IRQHandler(void)
+{
+    DmaOnInterrupt(1, 0);
+}
+
+void DMA2_Stream1_IRQHandler(void)
+{
+    DmaOnInterrupt(1, 1);
+}
+
+void DMA2_Stream2_IRQHandler(void)
+{
+    DmaOnInterrupt(1, 2);
+}
+
+void DMA2_Stream3_IRQHandler(void)
+{
+    DmaOnInterrupt(1, 3);
+}
+
+void DMA2_Stream4_IRQHandler(void)
+{
+    DmaOnInterrupt(1, 4);
+}
+
+void DMA2_Stream5_IRQHandler(void)
+{
+    DmaOnInterrupt(1, 5);
+}
+
+void DMA2_Stream6_IRQHandler(void)
+{
+    DmaOnInterrupt(1, 6);
+}
+
+void DMA2_Stream7_IRQHandler(void)
+{
+    DmaOnInterrupt(1, 7);
+}
@@ -0,0 +1,86 @@
+#ifndef DMA_H
+#define DMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "stm32f411xe.h"
+
+/* Stream event flags (normalized, independent of stream index) */
+#define DMA_FLAG_FE             (1U << 0)
+#define DMA_FLAG_DME            (1U << 2)
+#define DMA_FLAG_TE             (1U << 3)
+#define DMA_FLAG_HT             (1U << 4)
+#define DMA_FLAG_TC             (1U << 5)
+#define DMA_FLAG_ALL            (DMA_FLAG_FE | DMA_FLAG_DME | DMA_FLAG_TE | DMA_FLAG_HT | DMA_FLAG_TC)
+
+typedef void (*DMA_Handler_t)(void* context);
+
+typedef struct
+{
+    DMA_TypeDef* controller;
+    DMA_Stream_TypeDef* stream;
+    uint8_t index;          /* stream number 0 - 7 */
+    uint8_t channel;        /* request channel 0 - 7 (RM0383 9.3.3) */
+    IRQn_Type irq;
+} DMA_Stream_t;
+
+/*Brief: DMA stream initialization
+ * [in] - dma - pointer to DMA stream descriptor
+ * [in] - config - DMA_SxCR bits (direction, increment, priority, interrupts)
+ * [out] - none
+ * */
+void DmaInit(const DMA_Stream_t* const dma, uint32_t config);
+
+/*Brief: Start DMA stream transfer
+ * [in] - dma - pointer to DMA stream descriptor
+ * [in] - peripheral - peripheral data register address
+ * [in] - memory - memory address
+ * [in] - count - number of data items to transfer
+ * [out] - none
+ * */
+void DmaStart(const DMA_Stream_t* const dma, volatile const void* peripheral, const void* memory, uint16_t count);
+
+/*Brief: Stop DMA stream transfer
+ * [in] - dma - pointer to DMA stream descriptor
+ * [out] - none
+ * */
+void DmaStop(const DMA_Stream_t* const dma);
+
+/*Brief: Get number of data items left to transfer
+ * [in] - dma - pointer to DMA stream descriptor
+ * [out] - remaining items
+ * */
+uint16_t DmaRemaining(const DMA_Stream_t* const dma);
+
+/*Brief: Get stream event flags
+ * [in] - dma - pointer to DMA stream descriptor
+ * [out] - DMA_FLAG_x mask
+ * */
+uint32_t DmaGetFlags(const DMA_Stream_t* const dma);
+
+/*Brief: Clear stream event flags
+ * [in] - dma - pointer to DMA stream descriptor
+ * [in] - flags - DMA_FLAG_x mask
+ * [out] - none
+ * */
+void DmaClearFlags(const DMA_Stream_t* const dma, uint32_t flags);
+
+/*Brief: Register stream interrupt handler
+ * NOTE: stream IRQ handlers live in DMA driver; peripherals sharing a stream
+ * (e.g. I2C1 and SPI3 on DMA1 streams 0/7) cannot run at the same time, so
+ * the stream must be free or already owned by the same context (re-init)
+ * [in] - dma - pointer to DMA stream descriptor
+ * [in] - handler - interrupt handler
+ * [in] - context - handler context (peripheral handle)
+ * [out] - none
+ * */
+void DmaRegisterHandler(const DMA_Stream_t* const dma, DMA_Handler_t handler, void* context);
+
+/*Brief: Release stream interrupt handler (peripheral deinitialization)
+ * [in] - dma - pointer to DMA stream descriptor
+ * [out] - none
+ * */
+void DmaUnregisterHandler(const DMA_Stream_t* const dma);
+
+#endif /* DMA_H */
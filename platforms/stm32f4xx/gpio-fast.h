@@ -0,0 +1,75 @@
+#ifndef GPIO_FAST_H
+#define GPIO_FAST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "stm32f411xe.h"
+
+#include "gpio.h"
+#include "gpio-name.h"
+
+/* Fast path for hot pins (chip selects, bit-banging): port and mask are
+ * resolved once, every access is a single BSRR store or IDR load with no
+ * vtable call, ASSERT or initialized check. Pin must be configured through
+ * GpioOps_t open first. */
+typedef struct
+{
+    GPIO_TypeDef* port;
+    uint32_t mask;
+} GpioFast_t;
+
+/* PA..PE are contiguous, PH follows PE in gpio-name.h but sits at GPIOH_BASE */
+#define GPIO_FAST_PORT(pin)     ((GPIO_TypeDef*)((((pin) >> 4U) == 5U) ? GPIOH_BASE : \
+                                (GPIOA_BASE + (((pin) >> 4U) * 0x400U))))
+#define GPIO_FAST_MASK(pin)     (1UL << ((pin) & 0x0FU))
+
+/* compile time binding, folds to constants for constant pin name */
+#define GPIO_FAST_PIN(pin)      ((GpioFast_t){ GPIO_FAST_PORT(pin), GPIO_FAST_MASK(pin) })
+
+/*Brief: Bind fast pin to already opened gpio
+ * [in] - handle - pointer to gpio object
+ * [out] - fast pin
+ * */
+static inline GpioFast_t GpioFastBind(const GpioHandle_t* const handle)
+{
+    GpioFast_t pin = {
+        .port = (GPIO_TypeDef*)handle->gpio.stm32f411.port,
+        .mask = (1UL << handle->gpio.stm32f411.pinIndex),
+    };
+
+    return pin;
+}
+
+static inline void GpioFastSet(GpioFast_t pin)
+{
+    pin.port->BSRR = pin.mask;
+}
+
+static inline void GpioFastReset(GpioFast_t pin)
+{
+    pin.port->BSRR = (pin.mask << 16U);
+}
+
+static inline void GpioFastWrite(GpioFast_t pin, bool high)
+{
+    pin.port->BSRR = high ? pin.mask : (pin.mask << 16U);
+}
+
+static inline bool GpioFastRead(GpioFast_t pin)
+{
+    return (pin.port->IDR & pin.mask) != 0U;
+}
+
+/*Brief: Toggle pin
+ * NOTE: single BSRR store, so pins changed by interrupt on the same port are
+ * not overwritten as with ODR read-modify-write
+ * */
+static inline void GpioFastToggle(GpioFast_t pin)
+{
+    uint32_t odr = pin.port->ODR;
+
+    pin.port->BSRR = ((odr & pin.mask) << 16U) | (~odr & pin.mask);
+}
+
+#endif /* GPIO_FAST_H */
@@ -3,11 +3,22 @@
 
 #include "stm32f411xe.h"
 
+#include "FreeRTOS.h"
+#include "timers.h"
+
 #include "custom-assert.h"
+#include "event.h"
 #include "gpio.h"
+#include "ignore.h"
+#include "timebase.h"
 
 #define GPIO_IRQ_MAX            (16U)
 #define GPIO_PORT_MAX           (8U)
+#define GPIO_EVENT_QUEUE_SIZE   (64U)       /* power of two */
+
+/* EXTI lines served by shared vectors */
+#define GPIO_EXTI_LINES_9_5     (0x03E0U)
+#define GPIO_EXTI_LINES_15_10   (0xFC00U)
 
 /* Port clock enable */
 #define GPIO_CLOCK_ENABLE_PORTA (RCC->AHB1ENR |= (RCC_AHB1ENR_GPIOAEN))
@@ -31,7 +42,33 @@
 /* System configuration controller clock disable */
 #define SYS_CLOCK_DISABLE        (RCC->APB2ENR &= ~(RCC_APB2ENR_SYSCFGEN))
 
+typedef struct
+{
+    uint32_t debounceTicks;     /* 0 - no filter */
+    uint32_t lastEdge;          /* time of last reported edge */
+    uint32_t lastBounce;        /* time of last edge dropped inside window */
+    PIN_IRQ_MODES mode;         /* armed edge */
+    bool stable;                /* last reported level */
+} GpioFilter_t;
+
 static GpioHandle_t* m_GpioIrq[GPIO_IRQ_MAX] = { NULL };
+static GpioFilter_t m_GpioFilter[GPIO_IRQ_MAX];
+
+/* lines with edges dropped inside debounce window, level re-checked by
+ * settle timer once the window ends */
+static volatile uint32_t m_GpioVerify;
+static TimerHandle_t m_GpioSettleTimer;
+static volatile bool m_GpioSettleArmed;
+static volatile uint32_t m_GpioSettleDue;   /* window end the timer is armed for */
+
+/* multi producer single consumer ring, free running indices:
+ * producers (EXTI interrupts of any priority, settle timer of the filter)
+ * push with interrupts disabled, the consumer (getEvents) pops lock-free
+ * since it writes only the tail */
+static GpioEvent_t m_GpioEvents[GPIO_EVENT_QUEUE_SIZE];
+static volatile uint32_t m_GpioEventHead;
+static volatile uint32_t m_GpioEventTail;
+static volatile uint32_t m_GpioEventsLost;
 
 static const GPIO_TypeDef* m_GpioPorts[GPIO_PORT_MAX] = {
     GPIOA,
@@ -265,26 +302,246 @@ static IRQn_Type GpioGetIrqNumber(uint32_t pinIndex)
     }
 }
 
-static void GpioExtiHandler(uint8_t first, uint8_t last)
+static bool GpioLineLevel(const GpioHandle_t* const handle, uint32_t line)
+{
+    const GPIO_TypeDef* port = (const GPIO_TypeDef*)handle->gpio.stm32f411.port;
+
+    return (port->IDR & (1U << line)) ? true : false;
+}
+
+/*Brief: Announce queued edges on the application event queue
+ * NOTE: one EVENT_GPIO_EDGE per batch, consumer drains with getEvents
+ * */
+static void GpioPostEdgeEvent(void)
 {
-    for (uint8_t i = first; i <= last; i++)
+    const Event_t event = { .type = EVENT_GPIO_EDGE, .context = NULL };
+
+    IGNORE(EventQueue_Enqueue(&event));
+}
+
+static void GpioNotify(const GpioHandle_t* const handle, bool level, uint32_t timestamp)
+{
+    if (handle->irqHandler != NULL)
     {
-        uint32_t mask = (1U << i);
+        (*handle->irqHandler)();
+        return;
+    }
 
-        if (EXTI->PR & mask)
-        {
-            /*
-             * (rc_w1) Software can read as well as clear this bit by writing 1.
-             * Writing ‘0’ has no effect on the bit value.
-             * */
-            EXTI->PR = mask;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t head = m_GpioEventHead;
+    uint32_t count = head - m_GpioEventTail;
+
+    /* oldest events are kept when consumer falls behind */
+    if (count >= GPIO_EVENT_QUEUE_SIZE)
+    {
+        m_GpioEventsLost++;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    GpioEvent_t* event = &m_GpioEvents[head & (GPIO_EVENT_QUEUE_SIZE - 1U)];
+
+    event->handle = handle;
+    event->state = level ? PIN_STATE_HIGH : PIN_STATE_LOW;
+    event->timestamp = timestamp;
+
+    /* event must be complete before consumer sees new head */
+    __DMB();
+
+    m_GpioEventHead = head + 1U;
+
+    /* queue was drained: consumer is waiting for the next batch */
+    if (count == 0U)
+    {
+        GpioPostEdgeEvent();
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/*Brief: Settle timer period covering an interval
+ * NOTE: rounded up and one tick more, the timer counts whole RTOS ticks
+ * from the tick in progress
+ * [in] - ticks - interval in time base ticks
+ * [out] - period in RTOS ticks
+ * */
+static TickType_t GpioSettlePeriod(uint32_t ticks)
+{
+    return (TickType_t)((TimebaseTicksToUs(ticks) / (1000000U / configTICK_RATE_HZ)) + 2U);
+}
+
+/*Brief: Schedule settle check of a line at the end of its debounce window
+ * NOTE: interrupts must be disabled; the timer is only moved to an earlier
+ * window end, the check re-arms it for windows still open
+ * [in] - line - EXTI line
+ * [in] - now - current time base ticks
+ * [out] - none
+ * */
+static void GpioArmSettle(uint32_t line, uint32_t now)
+{
+    const GpioFilter_t* filter = &m_GpioFilter[line];
+    uint32_t due = filter->lastEdge + filter->debounceTicks;
+
+    m_GpioVerify |= (1U << line);
+
+    if (m_GpioSettleArmed && ((int32_t)(due - m_GpioSettleDue) >= 0))
+    {
+        return;
+    }
+
+    uint32_t remaining = ((int32_t)(due - now) > 0) ? (due - now) : 0U;
+    BaseType_t woken = pdFALSE;
+    BaseType_t started = xTimerChangePeriodFromISR(m_GpioSettleTimer, GpioSettlePeriod(remaining), &woken);
+
+    /* timer command queue is full: configTIMER_QUEUE_LENGTH is too short */
+    ASSERT(started == pdPASS);
+
+    m_GpioSettleArmed = true;
+    m_GpioSettleDue = due;
+
+    portYIELD_FROM_ISR(woken);
+}
+
+/*Brief: Level a filtered line must have for an edge to be reported
+ * NOTE: single edge modes never see the opposite edge, so the armed edge
+ * decides; both edges alternate around the last reported level
+ * */
+static bool GpioFilterExpected(const GpioFilter_t* const filter)
+{
+    switch (filter->mode)
+    {
+        case PIN_IRQ_RISING:
+            return true;
+
+        case PIN_IRQ_FALLING:
+            return false;
+
+        default:
+            return !filter->stable;
+    }
+}
+
+static void GpioDispatch(uint32_t line, uint32_t now)
+{
+    GpioHandle_t* handle = m_GpioIrq[line];
+
+    if (handle == NULL)
+    {
+        return;
+    }
 
-            if (m_GpioIrq[i] != NULL && m_GpioIrq[i]->irqHandler != NULL)
+    GpioFilter_t* filter = &m_GpioFilter[line];
+    bool level = GpioLineLevel(handle, line);
+
+    if (filter->debounceTicks != 0U)
+    {
+        if ((uint32_t)(now - filter->lastEdge) < filter->debounceTicks)
+        {
+            /* bounce: with both edges armed settle level is checked when window ends */
+            if (filter->mode == PIN_IRQ_BOTH)
             {
-                (*m_GpioIrq[i]->irqHandler)();
+                uint32_t primask = __get_PRIMASK();
+                __disable_irq();
+
+                filter->lastBounce = now;
+                GpioArmSettle(line, now);
+
+                __set_PRIMASK(primask);
             }
+            return;
         }
+
+        if (level != GpioFilterExpected(filter))
+        {
+            /* glitch: pin is back to idle level already */
+            return;
+        }
+
+        filter->stable = level;
+        filter->lastEdge = now;
     }
+
+    GpioNotify(handle, level, now);
+}
+
+/*Brief: Dispatch pending EXTI lines
+ * NOTE: only pending lines are visited, highest first via CLZ
+ * [in] - lines - lines served by the vector
+ * [out] - none
+ * */
+static void GpioExtiHandler(uint32_t lines)
+{
+    /* one timestamp for all lines of this interrupt, taken before any work */
+    uint32_t now = TimebaseNow();
+    uint32_t pending = EXTI->PR & lines;
+
+    /*
+     * (rc_w1) Software can read as well as clear this bit by writing 1.
+     * Writing ‘0’ has no effect on the bit value.
+     * */
+    EXTI->PR = pending;
+
+    while (pending != 0U)
+    {
+        uint32_t line = 31U - __CLZ(pending);
+
+        pending &= ~(1U << line);
+
+        GpioDispatch(line, now);
+    }
+}
+
+/*Brief: Report level changes hidden by debounce window
+ * NOTE: runs in timer service task when the earliest window ends;
+ * only lines with both edges armed are checked, a single edge line
+ * has no level to return to
+ * [in] - timer - settle timer
+ * [out] - none
+ * */
+static void GpioSettleOnTimer(TimerHandle_t timer)
+{
+    IGNORE(timer);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    m_GpioSettleArmed = false;
+
+    uint32_t verify = m_GpioVerify;
+    uint32_t now = TimebaseNow();
+
+    while (verify != 0U)
+    {
+        uint32_t line = 31U - __CLZ(verify);
+
+        verify &= ~(1U << line);
+
+        GpioFilter_t* filter = &m_GpioFilter[line];
+
+        if (!TimebaseElapsed(filter->lastEdge, filter->debounceTicks))
+        {
+            /* window of another line or restarted meanwhile */
+            GpioArmSettle(line, now);
+            continue;
+        }
+
+        m_GpioVerify &= ~(1U << line);
+
+        bool level = GpioLineLevel(m_GpioIrq[line], line);
+
+        if (level != filter->stable)
+        {
+            /* settled at the last bounce */
+            filter->stable = level;
+            filter->lastEdge = filter->lastBounce;
+
+            GpioNotify(m_GpioIrq[line], level, filter->lastBounce);
+        }
+    }
+
+    __set_PRIMASK(primask);
 }
 
 static void GpioOpen(GpioHandle_t* handle,
@@ -315,7 +572,6 @@ static void GpioOpen(GpioHandle_t* handle,
     GpioEnableClocks(port);
     GpioSetSpeed(port, pinIndex, strength);
     GpioSetPull(port, pinIndex, pull);
-    GpioSetMode(port, pinIndex, mode);
 
     /* 0: Output push-pull (reset state) */
     port->OTYPER &= ~(1U << pinIndex);
@@ -326,18 +582,20 @@ static void GpioOpen(GpioHandle_t* handle,
         port->OTYPER |= (1U << pinIndex);
     }
 
-    handle->initialized = true;
-
+    /* function and level before mode: the pad is never driven with stale
+     * ODR/AFR, a low pulse on a bus line is a clock or a START */
     if (mode == PIN_MODE_ALTERNATE)
     {
         GpioSetAlternateFunction(port, pinIndex, value);
-        return;
     }
-
-    if (mode == PIN_MODE_OUTPUT)
+    else if (mode == PIN_MODE_OUTPUT)
     {
         GpioSetState(port, pinIndex, value);
     }
+
+    GpioSetMode(port, pinIndex, mode);
+
+    handle->initialized = true;
 }
 
 static void GpioClose(GpioHandle_t* const handle)
@@ -418,7 +676,6 @@ static void GpioToggle(const GpioHandle_t* const handle)
 static void GpioSetInterrupt(GpioHandle_t* const handle, PIN_IRQ_MODES mode, uint8_t priority, GpioIrqHandler handler)
 {
     ASSERT(handle != NULL);
-    ASSERT(handler != NULL);
     ASSERT(handle->ops != NULL);
 
     if (!handle->initialized)
@@ -430,16 +687,27 @@ static void GpioSetInterrupt(GpioHandle_t* const handle, PIN_IRQ_MODES mode, uin
     uint8_t pinIndex = handle->gpio.stm32f411.pinIndex;
     uint32_t mask = (1U << pinIndex);
 
-    for (uint8_t i = 0; i < GPIO_IRQ_MAX; i++)
+    /* one EXTI line serves pin x of all ports, only one port can own it */
+    if ((m_GpioIrq[pinIndex] != NULL) && (m_GpioIrq[pinIndex] != handle))
     {
-        if (m_GpioIrq[i] != NULL && m_GpioIrq[i]->gpio.stm32f411.pinIndex == pinIndex)
-        {
-            return;
-        }
+        return;
     }
 
+    TimebaseInit();
+
     handle->irqHandler = handler;
 
+    m_GpioFilter[pinIndex].debounceTicks = 0;
+    m_GpioFilter[pinIndex].mode = mode;
+    m_GpioFilter[pinIndex].stable = GpioLineLevel(handle, pinIndex);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    m_GpioVerify &= ~mask;
+
+    __set_PRIMASK(primask);
+
     SYS_CLOCK_ENABLE;
 
     uint8_t extiReg = (pinIndex / 4);
@@ -475,39 +743,185 @@ static void GpioSetInterrupt(GpioHandle_t* const handle, PIN_IRQ_MODES mode, uin
     EXTI->IMR |= mask;
 }
 
+static void GpioPortOpen(GpioPortHandle_t* const handle,
+              uint8_t pin,
+              uint8_t width,
+              PIN_MODES mode,
+              PIN_TYPES pull,
+              PIN_STRENGTH strength,
+              PIN_CONFIGS config,
+              uint32_t value)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+    ASSERT((width > 0) && ((GpioGetPinIndex(pin) + width) <= 16U));
+
+    GpioHandle_t gpio = { .ops = handle->ops };
+
+    for (uint8_t i = 0; i < width; i++)
+    {
+        uint32_t pinValue = (mode == PIN_MODE_ALTERNATE) ? value : ((value >> i) & 0x01U);
+
+        GpioOpen(&gpio, (uint8_t)(pin + i), mode, pull, strength, config, pinValue);
+    }
+
+    handle->gpio.stm32f411.port = GpioGetPort(pin);
+    handle->shift = GpioGetPinIndex(pin);
+    handle->mask = (uint32_t)(((1UL << width) - 1U) << handle->shift);
+    handle->initialized = true;
+}
+
+static void GpioPortWrite(const GpioPortHandle_t* const handle, uint32_t value)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return;
+    }
+
+    GPIO_TypeDef* port = (GPIO_TypeDef*)handle->gpio.stm32f411.port;
+    uint32_t set = (value << handle->shift) & handle->mask;
+
+    /* BSRR: high half resets, low half sets */
+    port->BSRR = ((handle->mask & ~set) << 16U) | set;
+}
+
+static void GpioPortSetReset(const GpioPortHandle_t* const handle, uint32_t set, uint32_t reset)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return;
+    }
+
+    GPIO_TypeDef* port = (GPIO_TypeDef*)handle->gpio.stm32f411.port;
+
+    /* set has priority in BSRR when both bits are written */
+    port->BSRR = (((reset << handle->shift) & handle->mask) << 16U) | ((set << handle->shift) & handle->mask);
+}
+
+static uint32_t GpioPortRead(const GpioPortHandle_t* const handle)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    if (!handle->initialized)
+    {
+        return 0;
+    }
+
+    GPIO_TypeDef* port = (GPIO_TypeDef*)handle->gpio.stm32f411.port;
+
+    return (port->IDR & handle->mask) >> handle->shift;
+}
+
+static void GpioSetFilter(GpioHandle_t* const handle, uint32_t debounceUs)
+{
+    ASSERT(handle != NULL);
+    ASSERT(handle->ops != NULL);
+
+    uint8_t pinIndex = handle->gpio.stm32f411.pinIndex;
+
+    /* corrections are produced by getEvent, so callbacks cannot be filtered */
+    ASSERT(m_GpioIrq[pinIndex] == handle);
+    ASSERT(handle->irqHandler == NULL);
+
+    /* one timer serves all lines, created on first use in task context */
+    if (m_GpioSettleTimer == NULL)
+    {
+        m_GpioSettleTimer = xTimerCreate("gpio", 1, pdFALSE, m_GpioFilter, &GpioSettleOnTimer);
+
+        ASSERT(m_GpioSettleTimer != NULL);
+    }
+
+    GpioFilter_t* filter = &m_GpioFilter[pinIndex];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    filter->debounceTicks = TimebaseUsToTicks(debounceUs);
+    filter->lastEdge = TimebaseNow() - filter->debounceTicks;
+    filter->stable = GpioLineLevel(handle, pinIndex);
+    m_GpioVerify &= ~(1U << pinIndex);
+
+    __set_PRIMASK(primask);
+}
+
+static uint16_t GpioGetEvents(GpioEvent_t* const events, uint16_t max)
+{
+    ASSERT(events != NULL);
+
+    uint32_t tail = m_GpioEventTail;
+    uint32_t count = m_GpioEventHead - tail;
+
+    /* head is read before event data */
+    __DMB();
+
+    if (count > max)
+    {
+        count = max;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        events[i] = m_GpioEvents[(tail + i) & (GPIO_EVENT_QUEUE_SIZE - 1U)];
+    }
+
+    /* slots are copied before producer may reuse them */
+    __DMB();
+
+    m_GpioEventTail = tail + count;
+
+    return (uint16_t)count;
+}
+
+static bool GpioGetEvent(GpioEvent_t* const event)
+{
+    return (GpioGetEvents(event, 1) == 1U);
+}
+
+static uint32_t GpioGetEventsLost(void)
+{
+    return m_GpioEventsLost;
+}
+
 void EXTI0_IRQHandler(void)
 {
-    GpioExtiHandler(0, 0);
+    GpioExtiHandler(1U << 0);
 }
 
 void EXTI1_IRQHandler(void)
 {
-    GpioExtiHandler(1, 1);
+    GpioExtiHandler(1U << 1);
 }
 
 void EXTI2_IRQHandler(void)
 {
-    GpioExtiHandler(2, 2);
+    GpioExtiHandler(1U << 2);
 }
 
 void EXTI3_IRQHandler(void)
 {
-    GpioExtiHandler(3, 3);
+    GpioExtiHandler(1U << 3);
 }
 
 void EXTI4_IRQHandler(void)
 {
-    GpioExtiHandler(4, 4);
+    GpioExtiHandler(1U << 4);
 }
 
 void EXTI9_5_IRQHandler(void)
 {
-    GpioExtiHandler(5, 9);
+    GpioExtiHandler(GPIO_EXTI_LINES_9_5);
 }
 
 void EXTI15_10_IRQHandler(void)
 {
-    GpioExtiHandler(10, 15);
+    GpioExtiHandler(GPIO_EXTI_LINES_15_10);
 }
 
 /* Gpio operations */
@@ -517,5 +931,13 @@ const GpioOps_t g_GpioOps = {
     .read = &GpioRead,
     .write = &GpioWrite,
     .toggle = &GpioToggle,
-    .interrupt = &GpioSetInterrupt
+    .interrupt = &GpioSetInterrupt,
+    .filter = &GpioSetFilter,
+    .getEvent = &GpioGetEvent,
+    .getEvents = &GpioGetEvents,
+    .getEventsLost = &GpioGetEventsLost,
+    .portOpen = &GpioPortOpen,
+    .portWrite = &GpioPortWrite,
+    .portSetReset = &GpioPortSetReset,
+    .portRead = &GpioPortRead
 };
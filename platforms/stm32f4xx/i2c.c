@@ -1,8 +1,27 @@
 #include <stddef.h>
-#if 0
+
 #include "custom-assert.h"
 #include "i2c.h"
+#include "gpio-name.h"
 #include "ignore.h"
+#include "timebase.h"
+
+#define I2C_WAIT_FLAG_TIMEOUT   2000    /* us, covers byte time at 100 kHz and clock stretching */
+#define I2C_RECOVERY_CLOCKS     9       /* slave holding SDA releases it within one byte + ACK */
+#define I2C_RECOVERY_HALF_CLOCK 5       /* us, 100 kHz SCL */
+
+#define I2C_CCR_MAX             0xFFFU
+#define I2C_TRISE_MAX           63U
+#define I2C_FREQ_MIN_SM         2U      /* MHz, PCLK1 minimum for standard mode */
+#define I2C_FREQ_MIN_FM         4U      /* MHz, PCLK1 minimum for fast mode */
+
+#ifndef HSE_VALUE
+#define HSE_VALUE               25000000U   /* Hz, same default as system_stm32f4xx.c */
+#endif
+
+#ifndef HSI_VALUE
+#define HSI_VALUE               16000000U   /* Hz */
+#endif
 
 #define I2C_1_CLOCK_ENABLE (RCC->APB1ENR |= (RCC_APB1ENR_I2C1EN))
 #define I2C_2_CLOCK_ENABLE (RCC->APB1ENR |= (RCC_APB1ENR_I2C2EN))
@@ -12,17 +31,87 @@
 #define I2C_2_CLOCK_DISABLE (RCC->APB1ENR &= ~(RCC_APB1ENR_I2C2EN))
 #define I2C_3_CLOCK_DISABLE (RCC->APB1ENR &= ~(RCC_APB1ENR_I2C3EN))
 
+extern const GpioOps_t g_GpioOps;
+
 static I2C_Handle_t* m_I2CIrq[I2C_COUNT];
+
+/* RM0383 DMA1 request mapping; read phase ends on RX stream interrupt,
+ * write phase on BTF. I2C1 shares streams with SPI3, I2C2 TX with I2C1 TX */
+static const I2C_Dma_t m_I2CDma[I2C_COUNT] = {
+    [I2C_1] = {
+        .rx = { DMA1, DMA1_Stream0, 0, 1, DMA1_Stream0_IRQn },
+        .tx = { DMA1, DMA1_Stream7, 7, 1, DMA1_Stream7_IRQn },
+    },
+    [I2C_2] = {
+        .rx = { DMA1, DMA1_Stream2, 2, 7, DMA1_Stream2_IRQn },
+        .tx = { DMA1, DMA1_Stream7, 7, 7, DMA1_Stream7_IRQn },
+    },
+    [I2C_3] = {
+        .rx = { DMA1, DMA1_Stream1, 1, 1, DMA1_Stream1_IRQn },
+        .tx = { DMA1, DMA1_Stream4, 4, 3, DMA1_Stream4_IRQn },
+    },
+};
+
+typedef struct
+{
+    uint8_t sda;
+    uint8_t scl;
+} I2C_Pins_t;
+
+static const I2C_Pins_t m_I2CPins[I2C_COUNT] = {
+    [I2C_1] = { PB_9, PB_8 },
+    [I2C_2] = { PB_11, PB_10 },
+    [I2C_3] = { PC_9, PA_8 },
+};
+
+typedef struct
+{
+    IRQn_Type event;
+    IRQn_Type error;
+} I2C_Irqn_t;
+
+static const I2C_Irqn_t m_I2CIrqn[I2C_COUNT] = {
+    [I2C_1] = { I2C1_EV_IRQn, I2C1_ER_IRQn },
+    [I2C_2] = { I2C2_EV_IRQn, I2C2_ER_IRQn },
+    [I2C_3] = { I2C3_EV_IRQn, I2C3_ER_IRQn },
+};
+
 static const uint32_t AHB_PRESCALERS[8] = { 2,4,8,16,64,128,256,512 };
 static const uint32_t APB1_PRESCALERS[4] = { 2,4,8,16 };
 
 static void I2C_IrqEventHandler(I2C_Handle_t* const obj);
 static void I2C_IrqErrorHandler(I2C_Handle_t* const obj);
-
-static void I2C_WaitOnBusyFlag(const I2C_Handle_t* const obj);
-static void I2C_WaitOnStartFlag(const I2C_Handle_t* const obj);
-static void I2C_WaitOnAddrFlag(const I2C_Handle_t* const obj);
-static void I2C_WaitOnTrasferFinished(const I2C_Handle_t* const obj);
+static void I2C_DmaRxOnInterrupt(void* context);
+
+static void I2C_DmaStart(I2C_Handle_t* const obj, bool receive);
+static void I2C_WritePhaseDone(I2C_Handle_t* const obj);
+static void I2C_TransactionDone(I2C_Handle_t* const obj, bool holdsBus);
+static void I2C_TransactionFailed(I2C_Handle_t* const obj, I2C_STATUS status);
+static void I2C_StartCurrent(I2C_Handle_t* const obj);
+static void I2C_StartNext(I2C_Handle_t* const obj, bool holdsBus);
+static void I2C_RequestStart(I2C_Handle_t* const obj);
+static void I2C_StartTimer(I2C_Handle_t* const obj);
+static void I2C_DeferredStartOnTimer(TimerHandle_t timer);
+
+static void I2C_SlaveEventHandler(I2C_Handle_t* const obj);
+static void I2C_SlaveAccessEnd(I2C_RegisterMap_t* const map);
+static uint8_t* I2C_SlaveWritable(const I2C_RegisterMap_t* const map, uint16_t reg);
+
+static void I2C_BatchOnDone(void* context);
+static void I2C_BatchOnError(I2C_STATUS status, void* context);
+static void I2C_BatchOnItemError(I2C_STATUS status, void* context);
+
+static void I2C_GpioInit(I2C_Handle_t* const obj, PIN_MODES mode);
+static void I2C_GpioOpen(GpioHandle_t* const gpio, uint8_t pin, PIN_MODES mode, uint32_t value);
+static void I2C_Configure(I2C_Handle_t* const obj);
+static void I2C_Delay(uint32_t ticks);
+static I2C_RESULT I2C_Abort(I2C_Handle_t* const obj);
+
+static bool I2C_WaitOnBusyFlag(const I2C_Handle_t* const obj);
+static bool I2C_WaitOnStartFlag(const I2C_Handle_t* const obj);
+static bool I2C_WaitOnAddrFlag(const I2C_Handle_t* const obj);
+static bool I2C_WaitOnTrasferFinished(const I2C_Handle_t* const obj);
+static bool I2C_WaitOnFlag(const I2C_Handle_t* const obj, uint32_t flag);
 static void I2C_ClearAddrFlag(const I2C_Handle_t* const obj);
 static void I2C_DisableAck(const I2C_Handle_t* const obj);
 static void I2C_EnableAck(const I2C_Handle_t* const obj);
@@ -40,27 +129,59 @@ static void I2C_DisableEventInterrupt(const I2C_Handle_t* const obj);
 static void I2C_DisableErrorInterrupt(const I2C_Handle_t* const obj);
 static void I2C_DisableBufferInterrupt(const I2C_Handle_t* const obj);
 static IRQn_Type GetIrqEventType(const I2C_Handle_t* const obj);
-static bool GetBitState(uint16_t reg, uint16_t bitMask)
+static IRQn_Type GetIrqErrorType(const I2C_Handle_t* const obj);
+
+static bool I2C_WaitOnBusyFlag(const I2C_Handle_t* const obj)
 {
-    return (reg & bitMask) ? true : false;
+    ASSERT(obj);
+    return TimebaseWaitFlag(&obj->instance->SR2, I2C_SR2_BUSY, false, I2C_WAIT_FLAG_TIMEOUT);
 }
 
-static void I2C_WaitOnBusyFlag(const I2C_Handle_t* const obj)
+static bool I2C_WaitOnStartFlag(const I2C_Handle_t* const obj)
 {
     ASSERT(obj);
-    while ((obj->instance->SR2 & I2C_SR2_BUSY));
+    return I2C_WaitOnFlag(obj, I2C_SR1_SB);
 }
 
-static void I2C_WaitOnStartFlag(const I2C_Handle_t* const obj)
+/*Brief: Wait for end of address phase with deadline
+ * NOTE: NACK on address never sets ADDR, so AF ends the wait early
+ * [in] - obj - pointer to I2C object
+ * [out] - true - ADDR is set; false - NACK (AF is set) or timeout
+ * */
+static bool I2C_WaitOnAddrFlag(const I2C_Handle_t* const obj)
 {
     ASSERT(obj);
-    while (!(obj->instance->SR1 & I2C_SR1_SB));
+
+    uint32_t start = TimebaseNow();
+    uint32_t ticks = TimebaseUsToTicks(I2C_WAIT_FLAG_TIMEOUT);
+
+    do
+    {
+        uint32_t sr1 = obj->instance->SR1;
+
+        if (sr1 & I2C_SR1_ADDR)
+        {
+            return true;
+        }
+
+        if (sr1 & I2C_SR1_AF)
+        {
+            return false;
+        }
+    } while (!TimebaseElapsed(start, ticks));
+
+    return false;
 }
 
-static void I2C_WaitOnAddrFlag(const I2C_Handle_t* const obj)
+/*Brief: Wait for SR1 flag set with deadline
+ * [in] - obj - pointer to I2C object
+ * [in] - flag - SR1 flag
+ * [out] - true - flag is set; false - timeout
+ * */
+static bool I2C_WaitOnFlag(const I2C_Handle_t* const obj, uint32_t flag)
 {
     ASSERT(obj);
-    while (!(obj->instance->SR1 & I2C_SR1_ADDR));
+    return TimebaseWaitFlag(&obj->instance->SR1, flag, true, I2C_WAIT_FLAG_TIMEOUT);
 }
 
 static void I2C_ClearAddrFlag(const I2C_Handle_t* const obj)
@@ -85,11 +206,11 @@ static void I2C_Stop(const I2C_Handle_t* const obj)
     obj->instance->CR1 |= (I2C_CR1_STOP);
 }
 
-static void I2C_WaitOnTrasferFinished(const I2C_Handle_t* const obj)
+static bool I2C_WaitOnTrasferFinished(const I2C_Handle_t* const obj)
 {
     ASSERT(obj);
 
-    while (!(obj->instance->SR1 & I2C_SR1_BTF));
+    return I2C_WaitOnFlag(obj, I2C_SR1_BTF);
 }
 
 static void I2C_WriteAddress(const I2C_Handle_t* const obj, uint8_t address)
@@ -130,35 +251,36 @@ static void I2C_Disable(const I2C_Handle_t* const obj)
 static IRQn_Type GetIrqEventType(const I2C_Handle_t* const obj)
 {
     ASSERT(obj != NULL);
+    ASSERT(obj->name < I2C_COUNT);
 
-    IRQn_Type result;
-
-    switch (obj->name)
-    {
-        case I2C_1:
-            result = I2C1_EV_IRQn;
-            break;
-
-        case I2C_2:
-            result = I2C2_EV_IRQn;
-            break;
-
-        case I2C_3:
-            result = I2C3_EV_IRQn;
-            break;
+    return m_I2CIrqn[obj->name].event;
+}
 
-        default:
-            ASSERT(false);
-            break;
-    }
+static IRQn_Type GetIrqErrorType(const I2C_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
+    ASSERT(obj->name < I2C_COUNT);
 
-    return result;
+    return m_I2CIrqn[obj->name].error;
 }
 
+/*Brief: Calculate PLL (P output) frequency
+ * [in] - none
+ * [out] - frequency in Hz
+ * */
 static uint32_t RCC_GetPLLOutputClock(void)
 {
-    /*TODO: not used for now */
-    return 0;
+    const uint32_t pllcfgr = RCC->PLLCFGR;
+
+    uint32_t source = (pllcfgr & RCC_PLLCFGR_PLLSRC) ? HSE_VALUE : HSI_VALUE;
+    uint32_t pllm = (pllcfgr & RCC_PLLCFGR_PLLM) >> RCC_PLLCFGR_PLLM_Pos;
+    uint32_t plln = (pllcfgr & RCC_PLLCFGR_PLLN) >> RCC_PLLCFGR_PLLN_Pos;
+    uint32_t pllp = ((((pllcfgr & RCC_PLLCFGR_PLLP) >> RCC_PLLCFGR_PLLP_Pos) + 1) * 2);
+
+    ASSERT(pllm >= 2);
+
+    /* VCO input is 1..2 MHz, so (source / M) * N does not overflow */
+    return ((source / pllm) * plln) / pllp;
 }
 
 /*Brief: Calculate I2C frequency
@@ -182,11 +304,11 @@ static uint32_t RCC_GetPCLK1Value(void)
     switch (clockSource)
     {
         case RCC_CFGR_SWS_HSI:
-            systemClock = 16000000U;
+            systemClock = HSI_VALUE;
             break;
 
         case RCC_CFGR_SWS_HSE:
-            systemClock = 8000000U;
+            systemClock = HSE_VALUE;
             break;
 
         case RCC_CFGR_SWS_PLL:
@@ -221,45 +343,75 @@ static uint32_t RCC_GetPCLK1Value(void)
     return pclk1;
 }
 
-static void I2C_Frequency(I2C_Handle_t* const obj)
+/*
+ * RM0383
+ * 18.6.8 I2C Clock control register (I2C_CCR)
+ * Sm:          Thigh = Tlow = CCR * Tpclk1
+ * Fm DUTY=0:   Thigh = CCR * Tpclk1, Tlow = 2 * CCR * Tpclk1
+ * Fm DUTY=1:   Thigh = 9 * CCR * Tpclk1, Tlow = 16 * CCR * Tpclk1
+ * CCR is rounded up, so SCL never runs faster than requested
+ * */
+static uint32_t I2C_CalculateCcr(uint32_t pclk1, uint32_t speed, bool duty)
 {
-    ASSERT(obj);
+    uint32_t ticksPerPeriod = 2;
+    uint32_t ccrMin = 4;
 
-    /* clock frequency derived from APB bus */
-    uint32_t rccFreq = RCC_GetPCLK1Value() / 1000000U;
+    if (speed > I2C_SPEED_STANDARD_MODE)
+    {
+        ticksPerPeriod = duty ? 25 : 3;
+        ccrMin = 1;
+    }
 
-    obj->instance->CR2 = (rccFreq & I2C_CR2_FREQ);
+    uint32_t divisor = ticksPerPeriod * speed;
+    uint32_t ccr = (pclk1 + divisor - 1) / divisor;
+
+    if (ccr < ccrMin)
+    {
+        ccr = ccrMin;
+    }
+
+    ASSERT(ccr <= I2C_CCR_MAX);
+
+    return ccr;
 }
 
-static void I2C_RiseTime(I2C_Handle_t* const obj)
+/*
+ * RM0383
+ * 18.6.9 I2C TRISE register (I2C_TRISE)
+ * TRISE = max SCL rise time / Tpclk1 + 1, 1000 ns for Sm, 300 ns for Fm
+ * */
+static uint32_t I2C_CalculateTrise(uint32_t pclk1, uint32_t speed)
 {
-    ASSERT(obj);
+    uint32_t riseTimeNs = (speed > I2C_SPEED_STANDARD_MODE) ? 300 : 1000;
 
-    uint32_t rccFreq = RCC_GetPCLK1Value() / 1000000U;
-    uint32_t trise = 0;
+    /* kHz keeps the product in 32 bits */
+    uint32_t trise = (((pclk1 / 1000U) * riseTimeNs) / 1000000U) + 1;
 
-    switch (obj->config.speed)
+    if (trise > I2C_TRISE_MAX)
     {
-        case I2C_SPEED_STANDARD_MODE:
-            trise = (rccFreq + 1);
-            break;
+        trise = I2C_TRISE_MAX;
+    }
+
+    return trise;
+}
 
-        case I2C_SPEED_FAST_MODE:
-            trise = ((rccFreq * 300) / 1000) + 1;
+static void I2C_Frequency(I2C_Handle_t* const obj)
+{
+    ASSERT(obj);
 
-            if (trise > 63)
-            {
-                trise = 63;
-            }
+    /* clock frequency derived from APB bus */
+    uint32_t rccFreq = RCC_GetPCLK1Value() / 1000000U;
 
-            break;
+    ASSERT(rccFreq >= ((obj->config.speed > I2C_SPEED_STANDARD_MODE) ? I2C_FREQ_MIN_FM : I2C_FREQ_MIN_SM));
 
-        default:
-            ASSERT(false);
-            break;
-    }
+    obj->instance->CR2 = (rccFreq & I2C_CR2_FREQ);
+}
+
+static void I2C_RiseTime(I2C_Handle_t* const obj)
+{
+    ASSERT(obj);
 
-    obj->instance->TRISE = trise;
+    obj->instance->TRISE = I2C_CalculateTrise(RCC_GetPCLK1Value(), obj->config.speed);
 }
 
 static void I2C_EnableACK(I2C_Handle_t* const obj)
@@ -276,89 +428,77 @@ static void I2C_DisableACK(I2C_Handle_t* const obj)
     obj->instance->CR1 &= ~I2C_CR1_ACK;
 }
 
-static void I2C_Mode(I2C_Handle_t* const obj)
+/*Brief: Program SCL speed, mode and duty cycle
+ * NOTE: any speed up to 400 kHz, above 100 kHz fast mode is used
+ * */
+static void I2C_Clock(I2C_Handle_t* const obj)
 {
     ASSERT(obj);
+    ASSERT(obj->config.speed > 0);
+    ASSERT(obj->config.speed <= I2C_SPEED_FAST_MODE);
+
+    bool fastMode = (obj->config.speed > I2C_SPEED_STANDARD_MODE);
+    bool duty = fastMode && obj->config.dutyCycle;
 
-    switch (obj->config.speed)
+    uint32_t ccrValue = I2C_CalculateCcr(RCC_GetPCLK1Value(), obj->config.speed, duty);
+
+    if (fastMode)
     {
-        case I2C_SPEED_STANDARD_MODE:
+        ccrValue |= I2C_CCR_FS;
+    }
 
-            obj->instance->CCR &= ~(I2C_CCR_FS);
+    if (duty)
+    {
+        ccrValue |= I2C_CCR_DUTY;
+    }
 
-            break;
+    /* CCR is written only while PE = 0 */
+    obj->instance->CCR = ccrValue;
+}
 
-        case I2C_SPEED_FAST_MODE:
+static void I2C_GpioInit(I2C_Handle_t* const obj, PIN_MODES mode)
+{
+    ASSERT(obj);
 
-            obj->instance->CCR |= (I2C_CCR_FS);
+    const I2C_Pins_t* pins = &m_I2CPins[obj->name];
 
-            break;
+    /* output mode is used by bus recovery, lines are released (high) */
+    uint32_t value = (mode == PIN_MODE_ALTERNATE) ? PIN_AF_4 : PIN_STATE_HIGH;
 
-        default:
-            ASSERT(false);
-            break;
-    }
+    I2C_GpioOpen(&obj->sda, pins->sda, mode, value);
+    I2C_GpioOpen(&obj->scl, pins->scl, mode, value);
 }
 
-static void I2C_Duty(I2C_Handle_t* const obj)
+static void I2C_GpioOpen(GpioHandle_t* const gpio, uint8_t pin, PIN_MODES mode, uint32_t value)
 {
-    ASSERT(obj);
+    ASSERT(gpio != NULL);
 
-    if (obj->config.dutyCycle)
-    {
-        obj->instance->CCR |= I2C_CCR_DUTY;
-    }
-    else
-    {
-        obj->instance->CCR &= ~(I2C_CCR_DUTY);
-    }
+    /* bus lines are open-drain in both peripheral and recovery modes */
+    gpio->ops = &g_GpioOps;
+    gpio->ops->open(gpio, pin, mode, PIN_TYPE_NO_PULL, PIN_STRENGTH_HIGH, PIN_CONFIG_OPEN_DRAIN, value);
 }
 
-/*
- * RM0383
- * 18.6.8 I2C Clock control register (I2C_CCR)
+/*Brief: Program timing and ACK from obj->config
+ * NOTE: also used to restore registers after software reset
  * */
-static void I2C_Clock(I2C_Handle_t* const obj)
+static void I2C_Configure(I2C_Handle_t* const obj)
 {
     ASSERT(obj);
 
-    uint32_t ccrValue = 0;
-    uint32_t rccFreq = RCC_GetPCLK1Value();
-
-    switch (obj->config.speed)
-    {
-        case I2C_SPEED_STANDARD_MODE:
-            ccrValue = (rccFreq / (2 * obj->config.speed));
-            if (ccrValue < 4)
-            {
-                ccrValue = 4;
-            }
-            break;
-
-        case I2C_SPEED_FAST_MODE:
-            if (obj->config.dutyCycle)
-            {
-                ccrValue = (rccFreq / (25 * obj->config.speed));
-            }
-            else
-            {
-                ccrValue = (rccFreq / (3 * obj->config.speed));
-            }
+    I2C_Frequency(obj);
 
-            if (ccrValue < 1)
-            {
-                ccrValue = 1;
-            }
-            break;
+    I2C_Clock(obj);
 
-        default:
-            ASSERT(false);
-            break;
+    if (obj->config.ackControl)
+    {
+        I2C_EnableACK(obj);
+    }
+    else
+    {
+        I2C_DisableACK(obj);
     }
 
-    ccrValue = ccrValue & I2C_CCR_CCR;
-
-    obj->instance->CCR = ccrValue;
+    I2C_RiseTime(obj);
 }
 
 void I2C_Init(I2C_Handle_t* const obj, I2C_NAMES name)
@@ -366,6 +506,10 @@ void I2C_Init(I2C_Handle_t* const obj, I2C_NAMES name)
     ASSERT(obj);
     ASSERT(name < I2C_COUNT);
 
+    /* I2C1 and I2C2 share DMA1 stream 7, which raises no interrupt to register */
+    ASSERT(!(name == I2C_1 && m_I2CIrq[I2C_2] != NULL));
+    ASSERT(!(name == I2C_2 && m_I2CIrq[I2C_1] != NULL));
+
     obj->initialized = false;
     obj->name = name;
 
@@ -373,9 +517,6 @@ void I2C_Init(I2C_Handle_t* const obj, I2C_NAMES name)
     {
         case I2C_1:
 
-            GpioInit(&obj->sda, PB_9, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_OPEN_DRAIN, PIN_AF_4);
-            GpioInit(&obj->scl, PB_8, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_OPEN_DRAIN, PIN_AF_4);
-
             obj->instance = I2C1;
 
             m_I2CIrq[I2C_1] = obj;
@@ -386,22 +527,20 @@ void I2C_Init(I2C_Handle_t* const obj, I2C_NAMES name)
 
         case I2C_2:
 
-            GpioInit(&obj->sda, PB_11, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_OPEN_DRAIN, PIN_AF_4);
-            GpioInit(&obj->scl, PB_10, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_OPEN_DRAIN, PIN_AF_4);
-
             obj->instance = I2C2;
 
+            m_I2CIrq[I2C_2] = obj;
+
             I2C_2_CLOCK_ENABLE;
 
             break;
 
         case I2C_3:
 
-            GpioInit(&obj->sda, PC_9, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_OPEN_DRAIN, PIN_AF_4);
-            GpioInit(&obj->scl, PA_8, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_OPEN_DRAIN, PIN_AF_4);
-
             obj->instance = I2C3;
 
+            m_I2CIrq[I2C_3] = obj;
+
             I2C_3_CLOCK_ENABLE;
 
             break;
@@ -411,30 +550,35 @@ void I2C_Init(I2C_Handle_t* const obj, I2C_NAMES name)
             break;
     }
 
-    I2C_Frequency(obj);
+    I2C_GpioInit(obj, PIN_MODE_ALTERNATE);
 
-    I2C_Clock(obj);
+    I2C_Configure(obj);
 
-    if (obj->config.ackControl)
-    {
-        I2C_EnableACK(obj);
-    }
-    else
-    {
-        I2C_DisableACK(obj);
-    }
+    NVIC_EnableIRQ(GetIrqEventType(obj));
+    NVIC_EnableIRQ(GetIrqErrorType(obj));
 
-    I2C_Mode(obj);
+    TimebaseInit();
 
-    I2C_Duty(obj);
+    BufferCreate(&obj->queue, obj->transactions, sizeof(obj->transactions), sizeof(I2C_Transaction_t), false);
 
-    I2C_RiseTime(obj);
+    obj->busy = false;
+    obj->startRequested = false;
+    obj->startDeferred = false;
 
-    NVIC_EnableIRQ(GetIrqEventType(obj));
+    obj->slave = NULL;
 
-    BufferCreate(&obj->queue, obj->transactions, sizeof(obj->transactions), sizeof(I2C_Transaction_t), false);
+    if (obj->startTimer == NULL)
+    {
+        obj->startTimer = xTimerCreate("i2c", 1, pdFALSE, obj, &I2C_DeferredStartOnTimer);
+
+        ASSERT(obj->startTimer != NULL);
+    }
+
+    obj->dma = &m_I2CDma[name];
 
-    obj->currentTransaction = NULL;
+    DmaRegisterHandler(&obj->dma->rx, &I2C_DmaRxOnInterrupt, obj);
+
+    NVIC_EnableIRQ(obj->dma->rx.irq);
 
     I2C_Enable(obj);
 
@@ -464,8 +608,23 @@ void I2C_Deinit(I2C_Handle_t* const obj)
             break;
     }
 
+    NVIC_DisableIRQ(obj->dma->rx.irq);
+    NVIC_DisableIRQ(GetIrqErrorType(obj));
+
+    DmaStop(&obj->dma->tx);
+    DmaStop(&obj->dma->rx);
+
+    DmaUnregisterHandler(&obj->dma->rx);
+
+    BufferClear(&obj->queue);
+
+    obj->busy = false;
+    obj->startDeferred = false;
+
     I2C_Disable(obj);
 
+    m_I2CIrq[obj->name] = NULL;
+
     obj->initialized = false;
 }
 
@@ -474,43 +633,113 @@ void I2C1_EV_IRQHandler(void)
     I2C_IrqEventHandler(m_I2CIrq[I2C_1]);
 }
 
-void I2C2_ER_IRQHandler(void)
+void I2C2_EV_IRQHandler(void)
+{
+    I2C_IrqEventHandler(m_I2CIrq[I2C_2]);
+}
+
+void I2C3_EV_IRQHandler(void)
+{
+    I2C_IrqEventHandler(m_I2CIrq[I2C_3]);
+}
+
+void I2C1_ER_IRQHandler(void)
 {
     I2C_IrqErrorHandler(m_I2CIrq[I2C_1]);
 }
 
+void I2C2_ER_IRQHandler(void)
+{
+    I2C_IrqErrorHandler(m_I2CIrq[I2C_2]);
+}
+
+void I2C3_ER_IRQHandler(void)
+{
+    I2C_IrqErrorHandler(m_I2CIrq[I2C_3]);
+}
+
 static void I2C_IrqErrorHandler(I2C_Handle_t* const obj)
 {
-/* TODO: */
+    ASSERT(obj);
+
+    uint32_t sr1 = obj->instance->SR1;
+
+    /* error flags are rc_w0 */
+    obj->instance->SR1 &= ~(sr1 & (I2C_SR1_AF | I2C_SR1_ARLO | I2C_SR1_BERR | I2C_SR1_OVR | I2C_SR1_TIMEOUT));
+
+    if (obj->slave != NULL)
+    {
+        /* NACK from host ends a read, the byte preloaded into DR is not sent;
+         * TXE stays set until STOP, so buffer interrupt waits for next ADDR */
+        if (sr1 & I2C_SR1_AF)
+        {
+            I2C_DisableBufferInterrupt(obj);
+
+            if (obj->slave->transmit && (obj->slave->pointer > obj->slave->start))
+            {
+                obj->slave->pointer--;
+            }
+        }
+
+        I2C_SlaveAccessEnd(obj->slave);
+
+        return;
+    }
+
+    if (!obj->busy)
+    {
+        return;
+    }
+
+    I2C_STATUS status = I2C_STATUS_BUS_ERROR;
+
+    if (sr1 & I2C_SR1_AF)
+    {
+        status = I2C_STATUS_NACK;
+    }
+    else if (sr1 & I2C_SR1_ARLO)
+    {
+        status = I2C_STATUS_ARBITRATION_LOST;
+    }
+    else if (sr1 & I2C_SR1_OVR)
+    {
+        status = I2C_STATUS_OVERRUN;
+    }
+
+    I2C_TransactionFailed(obj, status);
 }
 
 #if 0
-NOTE: refer to RM0383 18.3.3 I2C master mode
+NOTE: refer to RM0383 18.3.3 I2C master mode, data phases are served by DMA
 #endif
 static void I2C_IrqEventHandler(I2C_Handle_t* const obj)
 {
     ASSERT(obj);
 
-    if (obj->currentTransaction == NULL)
+    if (obj->slave != NULL)
     {
-        /* get address (pointer) to the current transaction */
-        obj->currentTransaction = (I2C_Transaction_t*)BufferFront(&obj->queue);
+        I2C_SlaveEventHandler(obj);
 
-        if (obj->currentTransaction == NULL)
-        {
-            return;
-        }
+        return;
     }
 
-    I2C_Transaction_t* t = obj->currentTransaction;
+    if (!obj->busy)
+    {
+        return;
+    }
+
+    /* START is requested by startTimer once STOP is on the bus */
+    if (obj->startDeferred)
+    {
+        return;
+    }
 
-    bool eventInterruptEnable = GetBitState(obj->instance->CR2, I2C_CR2_ITEVTEN);
-    bool bufferInterruptEnable = GetBitState(obj->instance->CR2, I2C_CR2_ITBUFEN);
+    I2C_Transaction_t* t = &obj->current;
 
-    bool eventFlag = GetBitState(obj->instance->SR1, I2C_SR1_SB);
+    uint32_t sr1 = obj->instance->SR1;
 
-    /* handle SB flag */
-    if (eventInterruptEnable && eventFlag)
+    /* handle SB flag: address with direction of the current phase */
+    if (sr1 & I2C_SR1_SB)
     {
         if (t->TxRxState == I2C_BUSY_TX)
         {
@@ -520,231 +749,443 @@ static void I2C_IrqEventHandler(I2C_Handle_t* const obj)
         {
             I2C_WriteAddress(obj, ((t->devAddress << 1) | (1 << 0)));
         }
-    }
 
-    eventFlag = GetBitState(obj->instance->SR1, I2C_SR1_ADDR);
+        return;
+    }
 
-    /* handle ADDR flag */
-    if (eventInterruptEnable && eventFlag)
+    /* handle ADDR flag: DMA must be armed before ADDR is cleared */
+    if (sr1 & I2C_SR1_ADDR)
     {
         if (t->TxRxState == I2C_BUSY_TX)
         {
-            /* ADDR flag is set */
-            I2C_ClearAddrFlag(obj);
-        }
-        else if (t->TxRxState == I2C_BUSY_RX)
-        {
-            /* master receiver: setup ACK/POS according to remaining bytes */
-            if (t->rxLen == 0)
+            if (t->txLen == 0)
             {
+                /* address only (probe) */
                 I2C_ClearAddrFlag(obj);
-                I2C_Stop(obj);
+                I2C_WritePhaseDone(obj);
             }
-            else if (t->rxLen == 1)
+            else
             {
-                /* disable ACK, clear ADDR, STOP must be set after clearing ADDR */
-                I2C_DisableAck(obj);
-
-                /* clear ADDR */
+                I2C_DmaStart(obj, false);
                 I2C_ClearAddrFlag(obj);
-
-                /* generate STOP as RM suggests for 1 byte */
-                I2C_Stop(obj);
             }
-            else if (t->rxLen == 2)
-            {
-                I2C_DisableAck(obj);
+        }
+        else if (t->rxLen == 1)
+        {
+            /* single byte: NACK and STOP (or repeated START of the next
+             * queued transaction) right after ADDR, data by RXNE */
+            I2C_DisableAck(obj);
 
-                /* POS = 1, clear ACK, clear ADDR */
-                obj->instance->CR1 |= I2C_CR1_POS;
+            obj->startRequested = (BufferCount(&obj->queue) != 0);
 
-                I2C_ClearAddrFlag(obj);
-                /* now wait for BTF in subsequent events */
+            __disable_irq();
+            I2C_ClearAddrFlag(obj);
+            if (obj->startRequested)
+            {
+                I2C_Start(obj);
             }
             else
             {
-                /* number of bytes > 2 */
-                I2C_EnableAck(obj);
-                I2C_ClearAddrFlag(obj);
-                /* will read by RXNE until only 3 remain, then handle via BTF */
+                I2C_Stop(obj);
             }
+            __enable_irq();
+
+            I2C_EnableBufferInterrupt(obj);
         }
-    }
+        else
+        {
+            /* LAST: NACK is generated on the last byte received by DMA */
+            I2C_EnableAck(obj);
+            obj->instance->CR2 |= I2C_CR2_LAST;
 
-    eventFlag = GetBitState(obj->instance->SR1, I2C_SR1_BTF);
+            I2C_DmaStart(obj, true);
+            I2C_ClearAddrFlag(obj);
+        }
+
+        return;
+    }
 
-    /* handle BTF flag */
-    if (eventInterruptEnable && eventFlag)
+    /* handle BTF flag: last byte of write phase is shifted out */
+    if ((sr1 & I2C_SR1_BTF) && (t->TxRxState == I2C_BUSY_TX) && (DmaRemaining(&obj->dma->tx) == 0))
     {
-        if (t->TxRxState == I2C_BUSY_TX)
-        {
-            if (t->txLen == 0)
-            {
-                __disable_irq();
-                I2C_Stop(obj);
-                __enable_irq();
-
-                /* TX transaction finished
-                 * - set state IDLE
-                 * - clear current transaction
-                 * - extract current transaction from the transaction queue
-                 * - disable interrupts
-                 * - invoke callback on transaction done */
-                t->TxRxState = I2C_IDLE;
-                obj->currentTransaction = NULL;
-                I2C_DisableEventInterrupt(obj);
-                I2C_DisableErrorInterrupt(obj);
-                I2C_DisableBufferInterrupt(obj);
-                I2C_Transaction_t transaction;
-                BufferGet(&obj->queue, &transaction, sizeof(I2C_Transaction_t));
-                if (t->onTxDone != NULL)
-                {
-                    (*t->onTxDone)(t->context);
-                }
-            }
-            /*TODO: else
-            {
+        obj->instance->CR2 &= ~(I2C_CR2_DMAEN);
+
+        I2C_WritePhaseDone(obj);
+
+        return;
+    }
+
+    /* handle RXNE flag: single byte read */
+    if ((sr1 & I2C_SR1_RXNE) && (obj->instance->CR2 & I2C_CR2_ITBUFEN) && (t->TxRxState == I2C_BUSY_RX))
+    {
+        *t->rxBuffer = (uint8_t)obj->instance->DR;
+
+        I2C_DisableBufferInterrupt(obj);
+
+        /* STOP or START is already requested at ADDR */
+        I2C_TransactionDone(obj, false);
+    }
+}
+
+static void I2C_DmaRxOnInterrupt(void* context)
+{
+    I2C_Handle_t* obj = (I2C_Handle_t*)context;
+
+    ASSERT(obj);
+
+    uint32_t flags = DmaGetFlags(&obj->dma->rx);
+
+    DmaClearFlags(&obj->dma->rx, flags);
 
-            }*/
+    if (flags & DMA_FLAG_TE)
+    {
+        I2C_TransactionFailed(obj, I2C_STATUS_DMA_ERROR);
+    }
+    else if (flags & DMA_FLAG_TC)
+    {
+        /* RM0383: in master receiver STOP (or repeated START) is set on DMA
+         * end of transfer, last byte is already NACKed */
+        obj->instance->CR2 &= ~(I2C_CR2_DMAEN | I2C_CR2_LAST);
+
+        I2C_TransactionDone(obj, true);
+    }
+}
+
+static void I2C_DmaStart(I2C_Handle_t* const obj, bool receive)
+{
+    ASSERT(obj);
+
+    I2C_Transaction_t* t = &obj->current;
+
+    if (receive)
+    {
+        DmaInit(&obj->dma->rx, DMA_SxCR_PL_1            /* High priority */
+                               | DMA_SxCR_MINC          /* Increment memory */
+                               | DMA_SxCR_TCIE          /* Transfer complete interrupt */
+                               | DMA_SxCR_TEIE);        /* Transfer error interrupt */
+
+        DmaStart(&obj->dma->rx, &obj->instance->DR, t->rxBuffer, t->rxLen);
+    }
+    else
+    {
+        DmaInit(&obj->dma->tx, DMA_SxCR_PL_1            /* High priority */
+                               | DMA_SxCR_DIR_0         /* Memory to peripheral */
+                               | DMA_SxCR_MINC);        /* Increment memory */
+
+        DmaStart(&obj->dma->tx, &obj->instance->DR, t->txBuffer, t->txLen);
+    }
+
+    obj->instance->CR2 |= I2C_CR2_DMAEN;
+}
+
+static void I2C_WritePhaseDone(I2C_Handle_t* const obj)
+{
+    ASSERT(obj);
+
+    I2C_Transaction_t* t = &obj->current;
+
+    if (t->rxLen != 0)
+    {
+        /* repeated START keeps the bus for read phase */
+        t->TxRxState = I2C_BUSY_RX;
+
+        I2C_Start(obj);
+    }
+    else
+    {
+        /* devices commit a write on STOP, so the bus is not handed on by
+         * repeated START; next START waits for STOP, see I2C_RequestStart */
+        I2C_Stop(obj);
+
+        I2C_TransactionDone(obj, false);
+    }
+}
+
+/*Brief: Finish current transaction and start the next queued one
+ * [in] - obj - pointer to I2C object
+ * [in] - holdsBus - true - bus is still held, see I2C_StartNext; false - STOP or START is requested by caller
+ * [out] - none
+ * */
+static void I2C_TransactionDone(I2C_Handle_t* const obj, bool holdsBus)
+{
+    ASSERT(obj);
+
+    I2C_Transaction_t* t = &obj->current;
+
+    t->TxRxState = I2C_IDLE;
+
+    if (obj->config.ackControl)
+    {
+        I2C_EnableAck(obj);
+    }
+
+    if (t->status != NULL)
+    {
+        *t->status = I2C_STATUS_DONE;
+    }
+
+    if (t->rxLen != 0)
+    {
+        if (t->onRxDone != NULL)
+        {
+            (*t->onRxDone)(t->context);
         }
-        else if (t->TxRxState == I2C_BUSY_RX)
+    }
+    else
+    {
+        if (t->onTxDone != NULL)
         {
-            if (t->rxLen == 3)
-            {
-                I2C_DisableAck(obj);
+            (*t->onTxDone)(t->context);
+        }
+    }
 
-                *t->rxBuffer++ = (uint8_t)obj->instance->DR;
-                t->rxLen--;
-            }
-            else if (t->rxLen == 2)
-            {
-                __disable_irq();
-                I2C_Stop(obj);
+    I2C_StartNext(obj, holdsBus);
+}
 
-                *t->rxBuffer++ = (uint8_t)obj->instance->DR;
-                t->rxLen--;
-                *t->rxBuffer++ = (uint8_t)obj->instance->DR;
-                t->rxLen--;
-
-                __enable_irq();
-
-                t->TxRxState = I2C_IDLE;
-                obj->currentTransaction = NULL;
-                I2C_DisableEventInterrupt(obj);
-                I2C_DisableErrorInterrupt(obj);
-                I2C_DisableBufferInterrupt(obj);
-                I2C_Transaction_t transaction;
-                BufferGet(&obj->queue, &transaction, sizeof(I2C_Transaction_t));
-                if (t->onRxDone != NULL)
-                {
-                    (*t->onRxDone)(t->context);
-                }
-            }
-            else
-            {
-                /* For other cases BTF may be spurious or due to double buffering - ignore here */
-            }
-        }
+/*Brief: Abort current transaction, retry it or report error and go on
+ * [in] - obj - pointer to I2C object
+ * [in] - status - failure reason
+ * [out] - none
+ * */
+static void I2C_TransactionFailed(I2C_Handle_t* const obj, I2C_STATUS status)
+{
+    ASSERT(obj);
+
+    I2C_Transaction_t* t = &obj->current;
+
+    DmaStop(&obj->dma->tx);
+    DmaStop(&obj->dma->rx);
+
+    obj->instance->CR2 &= ~(I2C_CR2_DMAEN | I2C_CR2_LAST);
+    I2C_DisableBufferInterrupt(obj);
+
+    obj->startDeferred = false;
+
+    if (obj->startRequested)
+    {
+        obj->instance->CR1 &= ~I2C_CR1_START;
+        obj->startRequested = false;
     }
 
-/* NOTE: use in slave mode only */
-#if 0
-    eventFlag = GetBitState(obj->instance->SR1, I2C_SR1_STOPF);
+    /* after NACK the bus is still held, so retry or next transaction goes
+     * by repeated START; after arbitration loss the peripheral is already
+     * back in slave mode; any other error releases the bus */
+    bool holdsBus = (status == I2C_STATUS_NACK);
 
-    if (eventInterruptEnable && eventFlag)
+    if (!holdsBus && (status != I2C_STATUS_ARBITRATION_LOST))
     {
-        /* STOPF flag is set */
-        I2C_ClearAddrFlag(obj);
+        I2C_Stop(obj);
+    }
 
-        obj->instance->CR1 |= 0;
-        /*notify appl. that master competes transaction */
+    obj->instance->CR1 &= ~I2C_CR1_POS;
+
+    if (obj->config.ackControl)
+    {
+        I2C_EnableAck(obj);
+    }
+
+    if (t->retries > 0)
+    {
+        t->retries--;
+
+        I2C_StartCurrent(obj);
+
+        return;
     }
-#endif
 
-    eventFlag = GetBitState(obj->instance->SR1, I2C_SR1_TXE);
+    t->TxRxState = I2C_IDLE;
 
-    /* handle TXE flag */
-    if (eventInterruptEnable && bufferInterruptEnable && eventFlag)
+    if (t->status != NULL)
     {
-        if (t->TxRxState == I2C_BUSY_TX)
+        *t->status = status;
+    }
+
+    if (t->onError != NULL)
+    {
+        (*t->onError)(status, t->context);
+    }
+
+    I2C_StartNext(obj, holdsBus);
+}
+
+/*Brief: Start next queued transaction or go idle
+ * NOTE: called with interrupts disabled or from I2C/DMA interrupt
+ * [in] - obj - pointer to I2C object
+ * [in] - holdsBus - true - bus is held after previous transaction: next one
+ *                   goes by repeated START, STOP only if queue is empty
+ * [out] - none
+ * */
+static void I2C_StartNext(I2C_Handle_t* const obj, bool holdsBus)
+{
+    ASSERT(obj);
+
+    /* transaction is copied into handle, so it outlives the queue slot */
+    if (!BufferGet(&obj->queue, &obj->current, sizeof(I2C_Transaction_t)))
+    {
+        if (holdsBus)
         {
-            if (t->txLen > 0)
-            {
-                obj->instance->DR = *t->txBuffer++;
-                t->txLen--;
-            }
-            /* else nothing to write; BTF handler will generate STOP when transfer truly finished */
+            I2C_Stop(obj);
         }
+
+        I2C_DisableEventInterrupt(obj);
+        I2C_DisableErrorInterrupt(obj);
+
+        obj->busy = false;
+
+        return;
+    }
+
+    I2C_StartCurrent(obj);
+}
+
+/*Brief: (Re)start transaction stored in obj->current from its first phase
+ * */
+static void I2C_StartCurrent(I2C_Handle_t* const obj)
+{
+    ASSERT(obj);
+
+    obj->current.TxRxState = ((obj->current.txLen != 0) || (obj->current.rxLen == 0)) ? I2C_BUSY_TX : I2C_BUSY_RX;
+
+    I2C_EnableEventInterrupt(obj);
+    I2C_EnableErrorInterrupt(obj);
+
+    if (obj->startRequested)
+    {
+        /* repeated START is already requested at ADDR of previous read */
+        obj->startRequested = false;
+
+        return;
     }
 
-    eventFlag = GetBitState(obj->instance->SR1, I2C_SR1_RXNE);
+    I2C_RequestStart(obj);
+}
 
-    /* handle RNXE flag */
-    if (eventInterruptEnable && bufferInterruptEnable && eventFlag)
+/*Brief: Request START, or defer it while previous STOP is still pending
+ * NOTE: START must not be set before STOP is on the bus and master STOP
+ * raises no event, so instead of waiting here (interrupt context) startTimer
+ * requests it one tick later, see I2C_DeferredStartOnTimer
+ * [in] - obj - pointer to I2C object
+ * [out] - none
+ * */
+static void I2C_RequestStart(I2C_Handle_t* const obj)
+{
+    ASSERT(obj);
+
+    if (obj->instance->CR1 & I2C_CR1_STOP)
     {
-        if (t->TxRxState == I2C_BUSY_RX)
+        obj->startDeferred = true;
+        obj->deferredSince = TimebaseNow();
+
+        /* BTF/TXE of the previous write stay set until STOP is on the bus */
+        I2C_DisableEventInterrupt(obj);
+
+        I2C_StartTimer(obj);
+
+        return;
+    }
+
+    I2C_Start(obj);
+}
+
+/*Brief: Arm one tick timer of deferred START
+ * NOTE: called with interrupts disabled or from interrupt
+ * [in] - obj - pointer to I2C object
+ * [out] - none
+ * */
+static void I2C_StartTimer(I2C_Handle_t* const obj)
+{
+    ASSERT(obj);
+
+    BaseType_t woken = pdFALSE;
+    BaseType_t started = xTimerStartFromISR(obj->startTimer, &woken);
+
+    /* timer command queue is full: configTIMER_QUEUE_LENGTH is too short */
+    ASSERT(started == pdPASS);
+
+    portYIELD_FROM_ISR(woken);
+}
+
+/*Brief: Request deferred START once previous STOP is on the bus
+ * NOTE: runs in timer service task; STOP normally leaves the bus within one
+ * SCL period, so the first expiry starts; STOP stuck longer than
+ * I2C_WAIT_FLAG_TIMEOUT fails the transaction
+ * [in] - timer - startTimer of I2C object
+ * [out] - none
+ * */
+static void I2C_DeferredStartOnTimer(TimerHandle_t timer)
+{
+    I2C_Handle_t* obj = (I2C_Handle_t*)pvTimerGetTimerID(timer);
+
+    ASSERT(obj);
+
+    /* driver state is shared with I2C and DMA interrupts */
+    __disable_irq();
+
+    if (obj->startDeferred)
+    {
+        if (!(obj->instance->CR1 & I2C_CR1_STOP))
         {
-            /* if > 3 bytes, rely on RXNE */
-            if (t->rxLen > 3)
-            {
-                *t->rxBuffer++ = (uint8_t)obj->instance->DR;
-                t->rxLen--;
-            }
-            else if (t->rxLen == 1)
-            {
-                *t->rxBuffer++ = (uint8_t)obj->instance->DR;
-                t->rxLen--;
-
-                /* RX transaction finished
-                 * - set state IDLE
-                 * - clear current transaction
-                 * - extract current transaction from the transaction queue
-                 * - disable interrupts
-                 * - invoke callback on transaction done */
-                t->TxRxState = I2C_IDLE;
-                obj->currentTransaction = NULL;
-                I2C_DisableEventInterrupt(obj);
-                I2C_DisableErrorInterrupt(obj);
-                I2C_DisableBufferInterrupt(obj);
-                I2C_Transaction_t transaction;
-                BufferGet(&obj->queue, &transaction, sizeof(I2C_Transaction_t));
-                if (t->onRxDone != NULL)
-                {
-                    (*t->onRxDone)(t->context);
-                }
-            }
+            obj->startDeferred = false;
+
+            I2C_EnableEventInterrupt(obj);
+            I2C_Start(obj);
+        }
+        else if (TimebaseElapsed(obj->deferredSince, TimebaseUsToTicks(I2C_WAIT_FLAG_TIMEOUT)))
+        {
+            I2C_TransactionFailed(obj, I2C_STATUS_BUS_ERROR);
+        }
+        else
+        {
+            I2C_StartTimer(obj);
         }
     }
+
+    __enable_irq();
 }
 
-void I2C_MasterTransmit(I2C_Handle_t* const obj, const uint8_t* txBuffer, uint8_t len, uint8_t slaveAddr)
+I2C_RESULT I2C_MasterTransmit(I2C_Handle_t* const obj, const uint8_t* txBuffer, uint8_t len, uint8_t slaveAddr)
 {
     ASSERT(obj);
     ASSERT(txBuffer != NULL);
     ASSERT(obj->initialized);
     ASSERT(len > 0);
 
-    /* 1. wait until bus is idle */
-    I2C_WaitOnBusyFlag(obj);
+    /* 1. wait until bus is idle, BUSY stuck by a slave is recovered once */
+    if (!I2C_WaitOnBusyFlag(obj))
+    {
+        if (!I2C_Recovery(obj) || !I2C_WaitOnBusyFlag(obj))
+        {
+            return I2C_BUSY;
+        }
+    }
 
     /* 2. start condition */
     I2C_Start(obj);
 
     /* 3. wait for SB flag. Read SR1 register */
-    I2C_WaitOnStartFlag(obj);
+    if (!I2C_WaitOnStartFlag(obj))
+    {
+        goto timeout;
+    }
 
     /* 4. address phase (send slave address) read/write bit = 0 */
     slaveAddr = (slaveAddr << 1) & ~(1 << 0);
     I2C_WriteAddress(obj, slaveAddr);
 
     /* 5. confirm address phase completed, clear ADDR flag */
-    I2C_WaitOnAddrFlag(obj);
+    if (!I2C_WaitOnAddrFlag(obj))
+    {
+        goto timeout;
+    }
     I2C_ClearAddrFlag(obj);
 
     /* 6. send data */
     while (len > 0)
     {
-        while (!(obj->instance->SR1 & I2C_SR1_TXE));
+        if (!I2C_WaitOnFlag(obj, I2C_SR1_TXE))
+        {
+            goto timeout;
+        }
         obj->instance->DR = *txBuffer++;
         len--;
 
@@ -756,33 +1197,53 @@ void I2C_MasterTransmit(I2C_Handle_t* const obj, const uint8_t* txBuffer, uint8_
     }
 
     /* 7. wait the last byte transmitted */
-    I2C_WaitOnTrasferFinished(obj);
+    if (!I2C_WaitOnTrasferFinished(obj))
+    {
+        goto timeout;
+    }
 
     /* 8. stop condition */
     I2C_Stop(obj);
+
+    return I2C_OK;
+
+timeout:
+    return I2C_Abort(obj);
 }
 
-void I2C_MasterReceive(I2C_Handle_t* const obj, uint8_t* rxBuffer, uint8_t len, uint8_t slaveAddr)
+I2C_RESULT I2C_MasterReceive(I2C_Handle_t* const obj, uint8_t* rxBuffer, uint8_t len, uint8_t slaveAddr)
 {
     ASSERT(obj);
     ASSERT(rxBuffer != NULL);
     ASSERT(obj->initialized);
 
-    /* 1. wait until bus is idle */
-    I2C_WaitOnBusyFlag(obj);
+    /* 1. wait until bus is idle, BUSY stuck by a slave is recovered once */
+    if (!I2C_WaitOnBusyFlag(obj))
+    {
+        if (!I2C_Recovery(obj) || !I2C_WaitOnBusyFlag(obj))
+        {
+            return I2C_BUSY;
+        }
+    }
 
     /* 2. start condition */
     I2C_Start(obj);
 
     /* 3. wait for SB flag. Read SR1 register */
-    I2C_WaitOnStartFlag(obj);
+    if (!I2C_WaitOnStartFlag(obj))
+    {
+        goto timeout;
+    }
 
     /* 4. address phase (send slave address) read/write bit = 1 */
     slaveAddr = (slaveAddr << 1) | (1 << 0);
     I2C_WriteAddress(obj, slaveAddr);
 
     /* 5. confirm address phase completed */
-    I2C_WaitOnAddrFlag(obj);
+    if (!I2C_WaitOnAddrFlag(obj))
+    {
+        goto timeout;
+    }
 
     /* case 0: nothing to receive */
     if (len == 0)
@@ -808,7 +1269,10 @@ void I2C_MasterReceive(I2C_Handle_t* const obj, uint8_t* rxBuffer, uint8_t len,
         __enable_irq();
 
         /* wait RXNE */
-        while (!(obj->instance->SR1 & I2C_SR1_RXNE));
+        if (!I2C_WaitOnFlag(obj, I2C_SR1_RXNE))
+        {
+            goto timeout;
+        }
 
         /* read data */
         *rxBuffer++ = obj->instance->DR;
@@ -828,7 +1292,10 @@ void I2C_MasterReceive(I2C_Handle_t* const obj, uint8_t* rxBuffer, uint8_t len,
         I2C_ClearAddrFlag(obj);
         __enable_irq();
 
-        I2C_WaitOnTrasferFinished(obj);
+        if (!I2C_WaitOnTrasferFinished(obj))
+        {
+            goto timeout;
+        }
 
         __disable_irq();
         I2C_Stop(obj);
@@ -852,13 +1319,19 @@ void I2C_MasterReceive(I2C_Handle_t* const obj, uint8_t* rxBuffer, uint8_t len,
 
         while (len > 3)
         {
-            while (!(obj->instance->SR1 & I2C_SR1_RXNE));
+            if (!I2C_WaitOnFlag(obj, I2C_SR1_RXNE))
+            {
+                goto timeout;
+            }
             *rxBuffer++ = obj->instance->DR;
             len--;
         }
 
         /* 3 bytes left to receive */
-        I2C_WaitOnTrasferFinished(obj);
+        if (!I2C_WaitOnTrasferFinished(obj))
+        {
+            goto timeout;
+        }
 
         __disable_irq();
         /* disable ACK */
@@ -868,7 +1341,10 @@ void I2C_MasterReceive(I2C_Handle_t* const obj, uint8_t* rxBuffer, uint8_t len,
         len--;
         __enable_irq();
 
-        I2C_WaitOnTrasferFinished(obj);
+        if (!I2C_WaitOnTrasferFinished(obj))
+        {
+            goto timeout;
+        }
 
         __disable_irq();
         I2C_Stop(obj);
@@ -882,66 +1358,434 @@ void I2C_MasterReceive(I2C_Handle_t* const obj, uint8_t* rxBuffer, uint8_t len,
 
     /* enable ACK */
     I2C_EnableAck(obj);
+
+    return I2C_OK;
+
+timeout:
+    return I2C_Abort(obj);
+}
+
+/*Brief: Release the bus after failed blocking transfer
+ * NOTE: NACK only needs STOP, any other stall is cleared by bus recovery
+ * [in] - obj - pointer to I2C object
+ * [out] - I2C_NACK or I2C_TIMEOUT
+ * */
+static I2C_RESULT I2C_Abort(I2C_Handle_t* const obj)
+{
+    ASSERT(obj);
+
+    /* restore receiver defaults */
+    obj->instance->CR1 &= ~I2C_CR1_POS;
+    I2C_EnableAck(obj);
+
+    if (obj->instance->SR1 & I2C_SR1_AF)
+    {
+        obj->instance->SR1 &= ~(I2C_SR1_AF);
+
+        I2C_Stop(obj);
+
+        return I2C_NACK;
+    }
+
+    I2C_Stop(obj);
+
+    IGNORE(I2C_Recovery(obj));
+
+    return I2C_TIMEOUT;
+}
+
+static void I2C_Delay(uint32_t ticks)
+{
+    uint32_t start = TimebaseNow();
+
+    while (!TimebaseElapsed(start, ticks))
+    {
+    }
 }
 
-void I2C_Recovery(I2C_Handle_t* const obj)
+bool I2C_Recovery(I2C_Handle_t* const obj)
 {
     ASSERT(obj);
     ASSERT(obj->initialized);
+    ASSERT(!obj->busy);
+
+    uint32_t halfClock = TimebaseUsToTicks(I2C_RECOVERY_HALF_CLOCK);
+
+    /* take the lines from peripheral, both released */
+    I2C_Disable(obj);
+    I2C_GpioInit(obj, PIN_MODE_OUTPUT);
+    I2C_Delay(halfClock);
+
+    /* clock out the byte slave is sending until it releases SDA */
+    for (uint8_t i = 0; (i < I2C_RECOVERY_CLOCKS) && (obj->sda.ops->read(&obj->sda) == 0); i++)
+    {
+        obj->scl.ops->write(&obj->scl, PIN_STATE_LOW);
+        I2C_Delay(halfClock);
+        obj->scl.ops->write(&obj->scl, PIN_STATE_HIGH);
+        I2C_Delay(halfClock);
+    }
 
-    /*TODO:*/
+    /* STOP: SDA low to high while SCL is high */
+    obj->scl.ops->write(&obj->scl, PIN_STATE_LOW);
+    I2C_Delay(halfClock);
+    obj->sda.ops->write(&obj->sda, PIN_STATE_LOW);
+    I2C_Delay(halfClock);
+    obj->scl.ops->write(&obj->scl, PIN_STATE_HIGH);
+    I2C_Delay(halfClock);
+    obj->sda.ops->write(&obj->sda, PIN_STATE_HIGH);
+    I2C_Delay(halfClock);
+
+    bool released = (obj->sda.ops->read(&obj->sda) != 0) && (obj->scl.ops->read(&obj->scl) != 0);
+
+    /* software reset clears BUSY latched by the glitches, then restore registers */
+    I2C_GpioInit(obj, PIN_MODE_ALTERNATE);
+
+    obj->instance->CR1 |= I2C_CR1_SWRST;
+    obj->instance->CR1 &= ~I2C_CR1_SWRST;
+
+    I2C_Configure(obj);
+
+    I2C_Enable(obj);
+
+    return released;
 }
 
-I2C_RESULT I2C_MasterTransmit_IT(I2C_Handle_t* const obj, I2C_Transaction_t* transaction)
+I2C_RESULT I2C_MasterTransfer_IT(I2C_Handle_t* const obj, I2C_Transaction_t* transaction)
 {
     ASSERT(obj != NULL);
     ASSERT(transaction != NULL);
+    ASSERT(transaction->txLen == 0 || transaction->txBuffer != NULL);
+    ASSERT(transaction->rxLen == 0 || transaction->rxBuffer != NULL);
+    ASSERT(transaction->txLen <= UINT16_MAX && transaction->rxLen <= UINT16_MAX);
+    ASSERT(obj->slave == NULL);
 
     if (!obj->initialized)
     {
         return I2C_ERROR;
     }
 
-    transaction->TxRxState = I2C_BUSY_TX;
+    /* completion callbacks may queue from interrupt as well */
+    __disable_irq();
 
-    if (!BufferPut(&obj->queue, transaction, sizeof(I2C_Transaction_t)))
+    bool queued = BufferPut(&obj->queue, transaction, sizeof(I2C_Transaction_t));
+
+    if (queued && (transaction->status != NULL))
     {
-        return I2C_QUEUE_FULL;
+        *transaction->status = I2C_STATUS_PENDING;
     }
 
-    I2C_EnableEventInterrupt(obj);
-    I2C_EnableErrorInterrupt(obj);
-    I2C_EnableBufferInterrupt(obj);
+    if (queued && !obj->busy)
+    {
+        obj->busy = true;
 
-    I2C_Start(obj);
+        I2C_StartNext(obj, false);
+    }
 
-    return I2C_OK;
+    __enable_irq();
+
+    return queued ? I2C_OK : I2C_QUEUE_FULL;
+}
+
+I2C_RESULT I2C_MasterTransmit_IT(I2C_Handle_t* const obj, I2C_Transaction_t* transaction)
+{
+    ASSERT(transaction != NULL);
+
+    I2C_Transaction_t write = *transaction;
+
+    write.rxLen = 0;
+
+    return I2C_MasterTransfer_IT(obj, &write);
 }
 
 I2C_RESULT I2C_MasterReceive_IT(I2C_Handle_t* const obj, I2C_Transaction_t* transaction)
 {
-    ASSERT(obj != NULL);
     ASSERT(transaction != NULL);
 
+    I2C_Transaction_t read = *transaction;
+
+    read.txLen = 0;
+
+    return I2C_MasterTransfer_IT(obj, &read);
+}
+
+I2C_RESULT I2C_ReadBatch_IT(I2C_Handle_t* const obj, I2C_Batch_t* batch)
+{
+    ASSERT(obj != NULL);
+    ASSERT(batch != NULL);
+    ASSERT(batch->reads != NULL);
+    ASSERT((batch->count > 0) && (batch->count <= I2C_TRANSACTION_QUEUE_SIZE));
+    ASSERT(obj->slave == NULL);
+
     if (!obj->initialized)
     {
         return I2C_ERROR;
     }
 
-    transaction->TxRxState = I2C_BUSY_RX;
+    batch->failed = 0;
 
-    if (!BufferPut(&obj->queue, transaction, sizeof(I2C_Transaction_t)))
+    __disable_irq();
+
+    /* all or nothing, so onDone always closes the batch */
+    if ((BufferCapacity(&obj->queue) - BufferCount(&obj->queue)) < batch->count)
     {
+        __enable_irq();
+
         return I2C_QUEUE_FULL;
     }
 
+    for (uint8_t i = 0; i < batch->count; i++)
+    {
+        I2C_Read_t* read = &batch->reads[i];
+        bool last = (i == (batch->count - 1));
+
+        ASSERT((read->rxBuffer != NULL) && (read->rxLen > 0));
+
+        /* only the last read calls back, earlier ones just count failures */
+        I2C_Transaction_t transaction = {
+            .devAddress = read->devAddress,
+            .txBuffer = &read->reg,
+            .txLen = sizeof(read->reg),
+            .rxBuffer = read->rxBuffer,
+            .rxLen = read->rxLen,
+            .onTxDone = NULL,
+            .onRxDone = last ? &I2C_BatchOnDone : NULL,
+            .onError = last ? &I2C_BatchOnError : &I2C_BatchOnItemError,
+            .status = &read->status,
+            .retries = batch->retries,
+            .context = batch,
+        };
+
+        read->status = I2C_STATUS_PENDING;
+
+        IGNORE(BufferPut(&obj->queue, &transaction, sizeof(I2C_Transaction_t)));
+    }
+
+    if (!obj->busy)
+    {
+        obj->busy = true;
+
+        I2C_StartNext(obj, false);
+    }
+
+    __enable_irq();
+
+    return I2C_OK;
+}
+
+static void I2C_BatchOnDone(void* context)
+{
+    I2C_Batch_t* batch = (I2C_Batch_t*)context;
+
+    if (batch->onDone != NULL)
+    {
+        (*batch->onDone)(batch->context);
+    }
+}
+
+static void I2C_BatchOnError(I2C_STATUS status, void* context)
+{
+    I2C_BatchOnItemError(status, context);
+    I2C_BatchOnDone(context);
+}
+
+static void I2C_BatchOnItemError(I2C_STATUS status, void* context)
+{
+    I2C_Batch_t* batch = (I2C_Batch_t*)context;
+
+    IGNORE(status);
+
+    batch->failed++;
+}
+
+void I2C_SlaveInit(I2C_Handle_t* const obj, uint8_t ownAddress, I2C_RegisterMap_t* map)
+{
+    ASSERT(obj != NULL);
+    ASSERT(obj->initialized);
+    ASSERT(!obj->busy);
+    ASSERT(map != NULL);
+    ASSERT((map->pages[0] != NULL) && (map->pages[1] != NULL));
+    ASSERT((map->size > 0) && (map->size <= 256));
+    ASSERT((map->writable == NULL) || ((map->writableStart + map->writableSize) <= map->size));
+
+    map->front = 0;
+    map->swapPending = false;
+    map->active = false;
+    map->pointerSet = false;
+    map->transmit = false;
+    map->start = 0;
+    map->pointer = 0;
+
+    obj->slave = map;
+
+    /* 7 bit address; RM0383: bit 14 must be kept at 1 by software */
+    obj->instance->OAR1 = (1 << 14) | (((uint32_t)ownAddress << I2C_OAR1_ADD1_Pos) & I2C_OAR1_ADD1_7);
+
+    I2C_EnableAck(obj);
+
     I2C_EnableEventInterrupt(obj);
     I2C_EnableErrorInterrupt(obj);
     I2C_EnableBufferInterrupt(obj);
+}
 
-    I2C_Start(obj);
+uint8_t* I2C_SlaveBackPage(I2C_RegisterMap_t* map)
+{
+    ASSERT(map != NULL);
 
-    return I2C_OK;
+    return map->pages[map->front ^ 1];
+}
+
+void I2C_SlavePublish(I2C_RegisterMap_t* map)
+{
+    ASSERT(map != NULL);
+
+    __disable_irq();
+
+    if (map->active)
+    {
+        map->swapPending = true;
+    }
+    else
+    {
+        map->front ^= 1;
+    }
+
+    __enable_irq();
+}
+
+#if 0
+NOTE: refer to RM0383 18.3.2 I2C slave mode
+#endif
+static void I2C_SlaveEventHandler(I2C_Handle_t* const obj)
+{
+    I2C_RegisterMap_t* map = obj->slave;
+
+    uint32_t sr1 = obj->instance->SR1;
+
+    /* handle ADDR flag: new access, or repeated START after pointer write */
+    if (sr1 & I2C_SR1_ADDR)
+    {
+        /* reading SR2 after SR1 clears ADDR */
+        uint32_t sr2 = obj->instance->SR2;
+
+        if (map->active && !map->transmit)
+        {
+            I2C_SlaveAccessEnd(map);
+        }
+
+        map->active = true;
+        map->transmit = (sr2 & I2C_SR2_TRA) ? true : false;
+        map->pointerSet = map->transmit;
+        map->start = map->pointer;
+
+        I2C_EnableBufferInterrupt(obj);
+
+        return;
+    }
+
+    /* handle RXNE flag: register pointer, then data */
+    if (sr1 & I2C_SR1_RXNE)
+    {
+        uint8_t data = (uint8_t)obj->instance->DR;
+
+        if (!map->pointerSet)
+        {
+            map->pointer = data;
+            map->start = data;
+            map->pointerSet = true;
+        }
+        else
+        {
+            uint8_t* reg = I2C_SlaveWritable(map, map->pointer);
+
+            /* read only registers ignore host writes */
+            if (reg != NULL)
+            {
+                *reg = data;
+            }
+
+            map->pointer++;
+        }
+    }
+
+    /* handle TXE flag: served from front page (or writable block) without copy */
+    if ((sr1 & I2C_SR1_TXE) && map->transmit)
+    {
+        uint8_t* reg = I2C_SlaveWritable(map, map->pointer);
+
+        if (reg != NULL)
+        {
+            obj->instance->DR = *reg;
+        }
+        else
+        {
+            obj->instance->DR = (map->pointer < map->size) ? map->pages[map->front][map->pointer] : 0xFF;
+        }
+
+        map->pointer++;
+    }
+
+    /* handle STOPF flag: cleared by SR1 read followed by CR1 write */
+    if (sr1 & I2C_SR1_STOPF)
+    {
+        obj->instance->CR1 |= 0;
+
+        I2C_SlaveAccessEnd(map);
+    }
+}
+
+/*Brief: Report finished host access and apply deferred page swap
+ * */
+static void I2C_SlaveAccessEnd(I2C_RegisterMap_t* const map)
+{
+    if (map->active && (map->pointer > map->start) && (map->start < map->size))
+    {
+        uint16_t end = (map->pointer < map->size) ? map->pointer : map->size;
+
+        if (map->transmit)
+        {
+            if (map->onRead != NULL)
+            {
+                (*map->onRead)((uint8_t)map->start, &map->pages[map->front][map->start], end - map->start, map->context);
+            }
+        }
+        else if ((map->onWrite != NULL) && (map->writable != NULL))
+        {
+            /* only the part that landed in writable block is reported */
+            uint16_t first = (map->start > map->writableStart) ? map->start : map->writableStart;
+            uint16_t last = map->writableStart + map->writableSize;
+
+            last = (end < last) ? end : last;
+
+            if (last > first)
+            {
+                (*map->onWrite)((uint8_t)first, &map->writable[first - map->writableStart], last - first, map->context);
+            }
+        }
+    }
+
+    map->active = false;
+    map->start = map->pointer;
+
+    if (map->swapPending)
+    {
+        map->swapPending = false;
+        map->front ^= 1;
+    }
+}
+
+/*Brief: Host writable storage of register
+ * [in] - map - pointer to register map
+ * [in] - reg - register address
+ * [out] - pointer into writable block; NULL - register is read only
+ * */
+static uint8_t* I2C_SlaveWritable(const I2C_RegisterMap_t* const map, uint16_t reg)
+{
+    if ((map->writable == NULL) || (reg < map->writableStart) || (reg >= (map->writableStart + map->writableSize)))
+    {
+        return NULL;
+    }
+
+    return &map->writable[reg - map->writableStart];
 }
 
 static void I2C_EnableEventInterrupt(const I2C_Handle_t* const obj)
@@ -985,5 +1829,3 @@ static void I2C_DisableBufferInterrupt(const I2C_Handle_t* const obj)
 
     obj->instance->CR2 &= ~(I2C_CR2_ITBUFEN);
 }
-#endif
-
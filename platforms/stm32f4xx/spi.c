@@ -1,11 +1,14 @@
 #include <stddef.h>
-#if 0
+
 #include "custom-assert.h"
-#include "delay.h"
+#include "timebase.h"
 #include "spi.h"
 #include "ignore.h"
 
-#define WAIT_FLAG_TIMEOUT_MAX   100 /* us */
+#define WAIT_FLAG_TIMEOUT_MIN   100 /* us, floor of waits derived from SPI clock */
+#define SPI_TIMEOUT_FRAMES      4   /* 16-bit frame times a wait may last */
+#define SPI_WIDE_FRAME_MIN      8   /* bytes, shorter transfers are not worth DFF switch */
+#define SPI_FRAMES_IN_FLIGHT    2   /* shift register + TX buffer */
 
 #define SPI_1_CLOCK_ENABLE (RCC->APB2ENR |= (RCC_APB2ENR_SPI1EN))
 #define SPI_2_CLOCK_ENABLE (RCC->APB1ENR |= (RCC_APB1ENR_SPI2EN))
@@ -13,7 +16,10 @@
 #define SPI_4_CLOCK_ENABLE (RCC->APB2ENR |= (RCC_APB2ENR_SPI4EN))
 #define SPI_5_CLOCK_ENABLE (RCC->APB2ENR |= (RCC_APB2ENR_SPI5EN))
 
-static void SpiGpioInit(SPI_Handle_t* const obj, PIN_NAMES miso, PIN_NAMES mosi, PIN_NAMES sck);
+extern const GpioOps_t g_GpioOps;
+
+static void SpiGpioInit(SPI_Handle_t* const obj, uint8_t miso, uint8_t mosi, uint8_t sck);
+static void SpiGpioOpen(GpioHandle_t* const gpio, uint8_t pin, PIN_MODES mode, uint32_t value);
 
 static void SpiMode(const SPI_Handle_t* const obj, SPI_POLARITY polarity, SPI_PHASE phase);
 static void SpiFormat(const SPI_Handle_t* const obj);
@@ -24,24 +30,70 @@ static void SpiFormat(const SPI_Handle_t* const obj);
  * [out] - uint32_t value - actual SPI frequency in Hz
  * */
 static uint32_t SpiSpeed(const SPI_Handle_t* const obj, uint32_t deriredFrequencyHz);
+
+/*Brief: SPI baud rate prescaler
+ * [in] - obj - pointer to SPI object
+ * [in] - deriredFrequencyHz - desired SPI frequency in Hz
+ * [out] - brBits - CR1 BR field value
+ * [out] - uint32_t value - actual SPI frequency in Hz
+ * */
+static uint32_t SpiBaudRate(const SPI_Handle_t* const obj, uint32_t deriredFrequencyHz, uint32_t* const brBits);
+static uint32_t SpiGetClock(const SPI_Handle_t* const obj);
+static uint32_t SpiTimeoutUs(const SPI_Handle_t* const obj);
 static void SpiClockEnable(const SPI_Handle_t* const obj);
 static void SpiEnable(const SPI_Handle_t* const obj);
 static void SpiDisable(const SPI_Handle_t* const obj);
 
-static void SpiEnableTxInterrupt(const SPI_Handle_t* const obj);
-static void SpiDisableTxInterrupt(const SPI_Handle_t* const obj);
-static void SpiEnableRxInterrupt(const SPI_Handle_t* const obj);
-static void SpiDisableRxInterrupt(const SPI_Handle_t* const obj);
-
-static bool WaitFlagTimeout(volatile uint32_t* reg, uint32_t flag, bool state, uint32_t timeoutUs);
+static bool SpiTransferPipelined(SPI_Handle_t* const obj, const uint8_t* const txBuffer, uint8_t* const rxBuffer,
+                                 uint32_t frames, bool wide);
 static void SpiClearOverrun(const SPI_Handle_t* const obj);
 
-static void SpiIrqHandler(SPI_Handle_t* const obj);
-
-static IRQn_Type GetIrqType(const SPI_Handle_t* const obj);
+static void SpiDmaConfig(SPI_Handle_t* const obj);
+static void SpiDmaStart(SPI_Handle_t* const obj);
+static void SpiDmaOnInterrupt(void* context);
+static bool SpiNextSegment(SPI_Handle_t* const obj);
+static void SpiStartNext(SPI_Handle_t* const obj);
+static bool SpiStartCurrent(SPI_Handle_t* const obj);
+static bool SpiClaimNext(SPI_Handle_t* const obj);
+static void SpiFinishTransaction(SPI_Handle_t* const obj, SPI_STATUS status);
+static bool SpiDequeue(SPI_Handle_t* const obj);
+static void SpiUpdateStats(SPI_Handle_t* const obj);
+static bool SpiClaim(SPI_Handle_t* const obj);
+static void SpiRelease(SPI_Handle_t* const obj);
+static bool SpiApplyDevice(SPI_Handle_t* const obj, SPI_Device_t* const device);
+static bool SpiTransferLocked(SPI_Handle_t* const obj, const uint8_t* const txBuffer, uint8_t* const rxBuffer, uint32_t size);
 
 static SPI_Handle_t* m_SpiIrq[SPI_COUNT];
 
+/* RM0383 DMA request mapping; RX stream completes last, so only RX raises interrupt.
+ * SPI4 and SPI5 share DMA2 streams 3/4 and cannot run at the same time */
+static const SPI_Dma_t m_SpiDma[SPI_COUNT] = {
+    [SPI_1] = {
+        .rx = { DMA2, DMA2_Stream0, 0, 3, DMA2_Stream0_IRQn },
+        .tx = { DMA2, DMA2_Stream5, 5, 3, DMA2_Stream5_IRQn },
+    },
+    [SPI_2] = {
+        .rx = { DMA1, DMA1_Stream3, 3, 0, DMA1_Stream3_IRQn },
+        .tx = { DMA1, DMA1_Stream4, 4, 0, DMA1_Stream4_IRQn },
+    },
+    [SPI_3] = {
+        .rx = { DMA1, DMA1_Stream0, 0, 0, DMA1_Stream0_IRQn },
+        .tx = { DMA1, DMA1_Stream7, 7, 0, DMA1_Stream7_IRQn },
+    },
+    [SPI_4] = {
+        .rx = { DMA2, DMA2_Stream3, 3, 5, DMA2_Stream3_IRQn },
+        .tx = { DMA2, DMA2_Stream4, 4, 5, DMA2_Stream4_IRQn },
+    },
+    [SPI_5] = {
+        .rx = { DMA2, DMA2_Stream3, 3, 2, DMA2_Stream3_IRQn },
+        .tx = { DMA2, DMA2_Stream4, 4, 2, DMA2_Stream4_IRQn },
+    },
+};
+
+/* DMA source/sink for segments without TX or RX buffer */
+static uint8_t m_SpiDummyTx = 0xFF;
+static uint8_t m_SpiDummyRx;
+
 uint32_t SpiInit(SPI_Handle_t* const obj, SPI_NAMES name, SPI_POLARITY polarity, SPI_PHASE phase, uint32_t deriredFrequencyHz)
 {
     ASSERT(obj != NULL);
@@ -116,11 +168,20 @@ uint32_t SpiInit(SPI_Handle_t* const obj, SPI_NAMES name, SPI_POLARITY polarity,
 
     SpiClearOverrun(obj);
 
-    NVIC_EnableIRQ(GetIrqType(obj));
+    for (uint8_t i = 0; i < SPI_PRIORITY_COUNT; i++)
+    {
+        BufferCreate(&obj->queue[i], obj->transactions[i], sizeof(obj->transactions[i]), sizeof(SPI_Transaction_t), false);
+    }
+
+    SpiResetStats(obj);
+
+    /* time stamps queue latency and bounds blocking waits */
+    TimebaseInit();
 
-    BufferCreate(&obj->queue, obj->transactions, sizeof(obj->transactions), sizeof(SPI_Transaction_t), false);
+    obj->busy = false;
+    obj->activeDevice = NULL;
 
-    obj->currentTransaction = NULL;
+    SpiDmaConfig(obj);
 
     obj->initialized = true;
 
@@ -133,98 +194,264 @@ void SpiDeinit(SPI_Handle_t* const obj)
 
     obj->initialized = false;
 
-    obj->currentTransaction = NULL;
+    NVIC_DisableIRQ(obj->dma->rx.irq);
+
+    DmaStop(&obj->dma->tx);
+    DmaStop(&obj->dma->rx);
+
+    DmaUnregisterHandler(&obj->dma->rx);
+
+    obj->instance->CR2 &= ~(SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN);
+
+    for (uint8_t i = 0; i < SPI_PRIORITY_COUNT; i++)
+    {
+        BufferClear(&obj->queue[i]);
+    }
+
+    obj->busy = false;
 
     SpiDisable(obj);
+
+    /* frees the DMA streams SPI4 and SPI5 share */
+    m_SpiIrq[obj->name] = NULL;
 }
 
-bool SpiTransfer(SPI_Handle_t* const obj, const uint8_t* const txBuffer, uint8_t* const rxBuffer, uint8_t size)
+bool SpiTransfer(SPI_Handle_t* const obj, const uint8_t* const txBuffer, uint8_t* const rxBuffer, uint32_t size)
 {
     ASSERT(obj != NULL);
 
-    if (!obj->initialized)
+    if (!obj->initialized || !SpiClaim(obj))
     {
         return false;
     }
 
-    uint32_t dummy = 0;
+    bool result = SpiTransferLocked(obj, txBuffer, rxBuffer, size);
 
-    for (uint8_t i = 0; i < size; i++)
-    {
-        if (!WaitFlagTimeout(&obj->instance->SR, SPI_SR_TXE, 1, WAIT_FLAG_TIMEOUT_MAX))
-        {
-            goto timeout;
-        }
+    SpiRelease(obj);
 
-        obj->instance->DR = (txBuffer != NULL) ? txBuffer[i] : 0xFF;
+    return result;
+}
 
-        if (!WaitFlagTimeout(&obj->instance->SR, SPI_SR_RXNE, 1, WAIT_FLAG_TIMEOUT_MAX))
-        {
-            goto timeout;
-        }
+uint32_t SpiDeviceInit(SPI_Device_t* const device, SPI_Handle_t* const bus, SPI_POLARITY polarity, SPI_PHASE phase,
+                       uint32_t deriredFrequencyHz, uint8_t cs)
+{
+    ASSERT(device != NULL);
+    ASSERT(bus != NULL);
+    ASSERT(bus->initialized);
+    ASSERT(deriredFrequencyHz != 0);
 
-        if (rxBuffer != NULL)
-        {
-            rxBuffer[i] = obj->instance->DR;
-        }
-        else
-        {
-            dummy = obj->instance->DR;
-            IGNORE(dummy);
-        }
+    uint32_t brBits = 0;
+    uint32_t actualFreq = SpiBaudRate(bus, deriredFrequencyHz, &brBits);
+
+    device->bus = bus;
+    device->cr1 = (brBits << SPI_CR1_BR_Pos)
+                  | ((polarity == CPOL_1) ? SPI_CR1_CPOL : 0)
+                  | ((phase == CPHA_1) ? SPI_CR1_CPHA : 0);
+
+    SpiGpioOpen(&device->cs, cs, PIN_MODE_OUTPUT, PIN_STATE_HIGH);
+
+    device->csPin = GpioFastBind(&device->cs);
+
+    return actualFreq;
+}
+
+bool SpiDeviceTransfer(SPI_Device_t* const device, const uint8_t* const txBuffer, uint8_t* const rxBuffer, uint32_t size)
+{
+    ASSERT(device != NULL);
+
+    SPI_Handle_t* bus = device->bus;
+
+    if (!bus->initialized || !SpiClaim(bus))
+    {
+        return false;
     }
 
-    if (!WaitFlagTimeout(&obj->instance->SR, SPI_SR_BSY, 0, WAIT_FLAG_TIMEOUT_MAX))
+    if (!SpiApplyDevice(bus, device))
     {
-        goto timeout;
+        SpiRelease(bus);
+        return false;
     }
 
-    return true;
+    GpioFastReset(device->csPin);
 
-timeout:
-    SpiClearOverrun(obj);
+    bool result = SpiTransferLocked(bus, txBuffer, rxBuffer, size);
 
-    return false;
+    GpioFastSet(device->csPin);
+
+    SpiRelease(bus);
+
+    return result;
+}
+
+SPI_RESULT SpiDeviceTransfer_IT(SPI_Device_t* const device, SPI_Transaction_t* transaction)
+{
+    ASSERT(device != NULL);
+    ASSERT(transaction != NULL);
+
+    transaction->device = device;
+
+    return SpiTransfer_IT(device->bus, transaction);
+}
+
+static bool SpiTransferLocked(SPI_Handle_t* const obj, const uint8_t* const txBuffer, uint8_t* const rxBuffer, uint32_t size)
+{
+    ASSERT(obj != NULL);
+
+    bool result = false;
+
+    if ((size >= SPI_WIDE_FRAME_MIN) && ((size & 1U) == 0))
+    {
+        /* data frame format can be changed only while SPI is disabled */
+        SpiDisable(obj);
+        obj->instance->CR1 |= (SPI_CR1_DFF);
+        SpiEnable(obj);
+
+        result = SpiTransferPipelined(obj, txBuffer, rxBuffer, size / 2U, true);
+
+        SpiDisable(obj);
+        obj->instance->CR1 &= ~(SPI_CR1_DFF);
+        SpiEnable(obj);
+    }
+    else
+    {
+        result = SpiTransferPipelined(obj, txBuffer, rxBuffer, size, false);
+    }
+
+    return result;
 }
 
 SPI_RESULT SpiTransfer_IT(SPI_Handle_t* const obj, SPI_Transaction_t* transaction)
 {
     ASSERT(obj != NULL);
     ASSERT(transaction != NULL);
+    ASSERT(transaction->segments != NULL || transaction->txLen == 0 || transaction->rxLen == 0
+           || transaction->txLen == transaction->rxLen);
+    ASSERT(transaction->priority < SPI_PRIORITY_COUNT);
 
     if (!obj->initialized)
     {
         return SPI_ERROR;
     }
 
-    if (!BufferPut(&obj->queue, transaction, sizeof(SPI_Transaction_t)))
+    transaction->queuedAt = TimebaseNow();
+
+    if (transaction->status != NULL)
     {
-        return SPI_QUEUE_FULL;
+        *transaction->status = SPI_STATUS_PENDING;
     }
 
-    SpiEnableRxInterrupt(obj);
+    /* completion callbacks may queue from interrupt as well */
+    __disable_irq();
+    bool queued = BufferPut(&obj->queue[transaction->priority], transaction, sizeof(SPI_Transaction_t));
+    __enable_irq();
+
+    if (!queued)
+    {
+        return SPI_QUEUE_FULL;
+    }
 
-    SpiEnableTxInterrupt(obj);
+    if (SpiClaim(obj))
+    {
+        SpiRelease(obj);
+    }
 
     return SPI_OK;
 }
 
-static void SpiGpioInit(SPI_Handle_t* const obj, PIN_NAMES miso, PIN_NAMES mosi, PIN_NAMES sck)
+/*Brief: Take bus for exclusive use (blocking transfer or DMA engine)
+ * [in] - obj - pointer to SPI object
+ * [out] - true - bus taken; false - bus is busy
+ * */
+static bool SpiClaim(SPI_Handle_t* const obj)
 {
     ASSERT(obj != NULL);
 
-    if (obj->name == SPI_3 || obj->name == SPI_5)
+    bool claimed = false;
+
+    __disable_irq();
+
+    if (!obj->busy)
     {
-        GpioInit(&obj->gpio.miso, miso, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, PIN_AF_6);
-        GpioInit(&obj->gpio.mosi, mosi, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, PIN_AF_6);
-        GpioInit(&obj->gpio.sck, sck, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, PIN_AF_6);
+        obj->busy = true;
+        claimed = true;
     }
-    else
+
+    __enable_irq();
+
+    return claimed;
+}
+
+/*Brief: Release bus, transactions queued meanwhile are started
+ * NOTE: only the queue access runs with interrupts disabled, callbacks
+ * and bus switch of the started transaction run with interrupts enabled
+ * [in] - obj - pointer to SPI object
+ * [out] - none
+ * */
+static void SpiRelease(SPI_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
+
+    SpiStartNext(obj);
+}
+
+/*Brief: Switch bus to device mode and clock, only when device changes
+ * [in] - obj - pointer to SPI object
+ * [in] - device - pointer to device
+ * [out] - true - bus is set up for device; false - bus stayed busy, nothing changed
+ * */
+static bool SpiApplyDevice(SPI_Handle_t* const obj, SPI_Device_t* const device)
+{
+    ASSERT(obj != NULL);
+    ASSERT(device != NULL);
+    ASSERT(device->bus == obj);
+
+    if (obj->activeDevice == device)
     {
-        GpioInit(&obj->gpio.miso, miso, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, PIN_AF_5);
-        GpioInit(&obj->gpio.mosi, mosi, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, PIN_AF_5);
-        GpioInit(&obj->gpio.sck, sck, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, PIN_AF_5);
+        return true;
     }
+
+    /* CPOL, CPHA and BR may be changed only while SPI is disabled and idle,
+     * bound is derived from the clock of the previous device */
+    if (!TimebaseWaitFlag(&obj->instance->SR, SPI_SR_BSY, false, SpiTimeoutUs(obj)))
+    {
+        return false;
+    }
+
+    SpiDisable(obj);
+
+    obj->instance->CR1 = (obj->instance->CR1 & ~(SPI_CR1_CPOL | SPI_CR1_CPHA | SPI_CR1_BR_Msk)) | device->cr1;
+
+    SpiEnable(obj);
+
+    obj->activeDevice = device;
+
+    return true;
+}
+
+static void SpiGpioInit(SPI_Handle_t* const obj, uint8_t miso, uint8_t mosi, uint8_t sck)
+{
+    ASSERT(obj != NULL);
+
+    uint32_t af = (obj->name == SPI_3 || obj->name == SPI_5) ? PIN_AF_6 : PIN_AF_5;
+
+    SpiGpioOpen(&obj->gpio.miso, miso, PIN_MODE_ALTERNATE, af);
+    SpiGpioOpen(&obj->gpio.mosi, mosi, PIN_MODE_ALTERNATE, af);
+    SpiGpioOpen(&obj->gpio.sck, sck, PIN_MODE_ALTERNATE, af);
+}
+
+/*Brief: Open SPI pin through platform gpio operations
+ * [in] - gpio - pointer to gpio handle
+ * [in] - pin - pin name
+ * [in] - mode - gpio mode
+ * [in] - value - alternate function or initial output level
+ * [out] - none
+ * */
+static void SpiGpioOpen(GpioHandle_t* const gpio, uint8_t pin, PIN_MODES mode, uint32_t value)
+{
+    ASSERT(gpio != NULL);
+
+    gpio->ops = &g_GpioOps;
+    gpio->ops->open(gpio, pin, mode, PIN_TYPE_NO_PULL, PIN_STRENGTH_HIGH, PIN_CONFIG_PUSH_PULL, value);
 }
 
 static void SpiMode(const SPI_Handle_t* const obj, SPI_POLARITY polarity, SPI_PHASE phase)
@@ -284,9 +511,41 @@ static uint32_t SpiSpeed(const SPI_Handle_t* const obj, uint32_t deriredFrequenc
 {
     ASSERT(obj != NULL);
 
-    uint32_t pclk = 0;
-    uint32_t prescaler = 0;
     uint32_t brBits = 0;
+    uint32_t actualFreq = SpiBaudRate(obj, deriredFrequencyHz, &brBits);
+
+    obj->instance->CR1 &= ~SPI_CR1_BR_Msk;
+    obj->instance->CR1 |= (brBits << SPI_CR1_BR_Pos);
+
+    return actualFreq;
+}
+
+static uint32_t SpiBaudRate(const SPI_Handle_t* const obj, uint32_t deriredFrequencyHz, uint32_t* const brBits)
+{
+    ASSERT(obj != NULL);
+    ASSERT(brBits != NULL);
+
+    uint32_t pclk = SpiGetClock(obj);
+    uint32_t prescaler = pclk / deriredFrequencyHz;
+
+    while ((prescaler > 2) && (*brBits < 7))
+    {
+        prescaler >>= 1;
+        (*brBits)++;
+    }
+
+    return pclk / (1U << (*brBits + 1));
+}
+
+/*Brief: Get SPI kernel clock (APB2 for SPI1/4/5, APB1 for SPI2/3)
+ * [in] - obj - pointer to SPI object
+ * [out] - clock in Hz
+ * */
+static uint32_t SpiGetClock(const SPI_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
+
+    uint32_t pclk = 0;
 
     if (obj->name == SPI_1 || obj->name == SPI_4 || obj->name == SPI_5)
     {
@@ -319,18 +578,25 @@ static uint32_t SpiSpeed(const SPI_Handle_t* const obj, uint32_t deriredFrequenc
         pclk = hclk / apb1Prescaler;
     }
 
-    prescaler = pclk / deriredFrequencyHz;
+    return pclk;
+}
 
-    while ((prescaler > 2) && (brBits < 7))
-    {
-        prescaler >>= 1;
-        brBits++;
-    }
+/*Brief: Bound of flag waits for the programmed SPI clock
+ * NOTE: a 16-bit frame at fPCLK/256 is 4096 PCLK cycles, i.e. 256 us at 16 MHz
+ * [in] - obj - pointer to SPI object
+ * [out] - timeout in microseconds
+ * */
+static uint32_t SpiTimeoutUs(const SPI_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
 
-    obj->instance->CR1 &= ~SPI_CR1_BR_Msk;
-    obj->instance->CR1 |= (brBits << SPI_CR1_BR_Pos);
+    uint32_t br = (obj->instance->CR1 & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos;
+    uint32_t frameCycles = 16UL << (br + 1U);
+    uint32_t pclkKHz = SpiGetClock(obj) / 1000U;
+    uint32_t frameUs = (frameCycles * 1000U + pclkKHz - 1U) / pclkKHz;
+    uint32_t timeout = SPI_TIMEOUT_FRAMES * frameUs;
 
-    return pclk / (1U << (brBits + 1));
+    return (timeout > WAIT_FLAG_TIMEOUT_MIN) ? timeout : WAIT_FLAG_TIMEOUT_MIN;
 }
 
 static void SpiClockEnable(const SPI_Handle_t* const obj)
@@ -374,18 +640,94 @@ static void SpiDisable(const SPI_Handle_t* const obj)
     obj->instance->CR1 &= ~SPI_CR1_SPE;
 }
 
-static bool WaitFlagTimeout(volatile uint32_t* reg, uint32_t flag, bool state, uint32_t timeoutUs)
+/*Brief: Full duplex transfer keeping the shift register busy
+ * NOTE: next frame is written before the previous one is read, so there are
+ * no gaps between frames; a read delayed by more than one frame time (long
+ * interrupt) ends in overrun and the transfer fails
+ * [in] - obj - pointer to SPI object
+ * [in] - txBuffer - buffer to transmit (NULL - 0xFF is sent)
+ * [in] - rxBuffer - buffer to receive (NULL - received data is discarded)
+ * [in] - frames - number of frames
+ * [in] - wide - true - 16-bit frames (two bytes each, MSB first); false - 8-bit frames
+ * [out] - true - transfer successful; false - otherwise
+ * */
+static bool SpiTransferPipelined(SPI_Handle_t* const obj, const uint8_t* const txBuffer, uint8_t* const rxBuffer,
+                                 uint32_t frames, bool wide)
 {
-    while (((*reg & flag) ? 1 : 0) != (state ? 1 : 0))
+    ASSERT(obj != NULL);
+
+    uint32_t txCount = 0;
+    uint32_t rxCount = 0;
+    uint32_t frame = 0;
+    uint32_t status = 0;
+
+    /* timeout is counted from the last frame moved, not from the start */
+    const uint32_t timeoutUs = SpiTimeoutUs(obj);
+    const uint32_t timeout = TimebaseUsToTicks(timeoutUs);
+    uint32_t progress = TimebaseNow();
+
+    while (rxCount < frames)
     {
-        if (timeoutUs == 0)
+        status = obj->instance->SR;
+
+        if ((status & SPI_SR_TXE) && (txCount < frames) && ((txCount - rxCount) < SPI_FRAMES_IN_FLIGHT))
         {
-            return false;
+            if (txBuffer == NULL)
+            {
+                frame = wide ? 0xFFFFU : 0xFFU;
+            }
+            else if (wide)
+            {
+                frame = ((uint32_t)txBuffer[2U * txCount] << 8) | txBuffer[2U * txCount + 1U];
+            }
+            else
+            {
+                frame = txBuffer[txCount];
+            }
+
+            obj->instance->DR = frame;
+            txCount++;
+            progress = TimebaseNow();
+        }
+
+        if (status & SPI_SR_RXNE)
+        {
+            frame = obj->instance->DR;
+
+            if (rxBuffer != NULL)
+            {
+                if (wide)
+                {
+                    rxBuffer[2U * rxCount] = (uint8_t)(frame >> 8);
+                    rxBuffer[2U * rxCount + 1U] = (uint8_t)frame;
+                }
+                else
+                {
+                    rxBuffer[rxCount] = (uint8_t)frame;
+                }
+            }
+
+            rxCount++;
+            progress = TimebaseNow();
+        }
+
+        if ((status & SPI_SR_OVR) || TimebaseElapsed(progress, timeout))
+        {
+            goto error;
         }
-        DelayUs(1);
-        timeoutUs--;
     }
+
+    if (!TimebaseWaitFlag(&obj->instance->SR, SPI_SR_BSY, false, timeoutUs))
+    {
+        goto error;
+    }
+
     return true;
+
+error:
+    SpiClearOverrun(obj);
+
+    return false;
 }
 
 static void SpiClearOverrun(const SPI_Handle_t* const obj)
@@ -400,164 +742,333 @@ static void SpiClearOverrun(const SPI_Handle_t* const obj)
     IGNORE(dummy);
 }
 
-static void SpiIrqHandler(SPI_Handle_t* const obj)
+static void SpiDmaConfig(SPI_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
+
+    /* SPI4 and SPI5 share DMA streams */
+    ASSERT(!(obj->name == SPI_4 && m_SpiIrq[SPI_5] != NULL));
+    ASSERT(!(obj->name == SPI_5 && m_SpiIrq[SPI_4] != NULL));
+
+    obj->dma = &m_SpiDma[obj->name];
+
+    obj->instance->CR2 &= ~(SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN);
+
+    DmaRegisterHandler(&obj->dma->rx, &SpiDmaOnInterrupt, obj);
+
+    NVIC_EnableIRQ(obj->dma->rx.irq);
+}
+
+static void SpiDmaStart(SPI_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
+
+    const SPI_Segment_t* segment = &obj->segment;
+
+    /* memory increment only when there is a buffer, otherwise single dummy byte */
+    DmaInit(&obj->dma->rx, DMA_SxCR_PL_1                                    /* High priority */
+                           | ((segment->rxBuffer != NULL) ? DMA_SxCR_MINC : 0)
+                           | DMA_SxCR_TCIE                                  /* Transfer complete interrupt */
+                           | DMA_SxCR_TEIE);                                /* Transfer error interrupt */
+
+    DmaInit(&obj->dma->tx, DMA_SxCR_PL_1                                    /* High priority */
+                           | DMA_SxCR_DIR_0                                 /* Memory to peripheral */
+                           | ((segment->txBuffer != NULL) ? DMA_SxCR_MINC : 0));
+
+    /* RM0383 SPI with DMA: enable RX DMA first, then streams, then TX DMA */
+    obj->instance->CR2 |= SPI_CR2_RXDMAEN;
+
+    DmaStart(&obj->dma->rx, &obj->instance->DR,
+             (segment->rxBuffer != NULL) ? segment->rxBuffer : &m_SpiDummyRx, segment->len);
+    DmaStart(&obj->dma->tx, &obj->instance->DR,
+             (segment->txBuffer != NULL) ? segment->txBuffer : &m_SpiDummyTx, segment->len);
+
+    obj->instance->CR2 |= SPI_CR2_TXDMAEN;
+}
+
+/*Brief: Load next non-empty segment of current transaction
+ * [in] - obj - pointer to SPI object
+ * [out] - true - segment loaded; false - transaction is done
+ * */
+static bool SpiNextSegment(SPI_Handle_t* const obj)
 {
     ASSERT(obj != NULL);
 
-    if (obj->currentTransaction == NULL)
+    const SPI_Transaction_t* t = &obj->current;
+
+    do
     {
-        SPI_Transaction_t next;
+        if (t->segments != NULL)
+        {
+            if (obj->segmentIndex >= t->segmentCount)
+            {
+                return false;
+            }
 
-        if (!BufferGet(&obj->queue, &next, sizeof(SPI_Transaction_t)))
+            obj->segment = t->segments[obj->segmentIndex++];
+        }
+        else
         {
-            SpiDisableTxInterrupt(obj);
-            SpiDisableRxInterrupt(obj);
-            return;
+            /* plain transaction is a single segment */
+            if (obj->segmentIndex != 0)
+            {
+                return false;
+            }
+
+            obj->segmentIndex++;
+
+            obj->segment.txBuffer = (t->txLen != 0) ? t->txBuffer : NULL;
+            obj->segment.rxBuffer = (t->rxLen != 0) ? t->rxBuffer : NULL;
+            obj->segment.len = (t->txLen > t->rxLen) ? t->txLen : t->rxLen;
         }
+    } while (obj->segment.len == 0);
 
-        obj->currentTransaction = &next;
+    return true;
+}
 
-        if (obj->currentTransaction->preTransaction != NULL)
+/*Brief: Start next queued transaction or go idle
+ * NOTE: called by bus owner (SpiRelease or DMA interrupt)
+ * */
+static void SpiStartNext(SPI_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
+
+    while (SpiClaimNext(obj))
+    {
+        if (SpiStartCurrent(obj))
         {
-            (*obj->currentTransaction->preTransaction)(obj->currentTransaction->context);
+            return;
         }
     }
+}
 
-    SPI_Transaction_t* t = obj->currentTransaction;
+/*Brief: Take next queued transaction or release bus in one atomic step
+ * NOTE: transaction queued meanwhile is either taken here or finds the bus free
+ * [in] - obj - pointer to SPI object
+ * [out] - true - transaction taken into handle; false - bus released
+ * */
+static bool SpiClaimNext(SPI_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
 
-    if ((obj->instance->SR & SPI_SR_RXNE) && (obj->instance->CR2 & SPI_CR2_RXNEIE))
+    __disable_irq();
+
+    /* transaction is copied into handle, so it outlives the queue slot */
+    bool taken = SpiDequeue(obj);
+
+    if (!taken)
     {
-        if (t->rxBuffer != NULL)
+        obj->busy = false;
+    }
+
+    __enable_irq();
+
+    return taken;
+}
+
+/*Brief: Start transaction taken into handle
+ * [in] - obj - pointer to SPI object
+ * [out] - true - DMA started; false - transaction is finished already (empty or failed)
+ * */
+static bool SpiStartCurrent(SPI_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
+
+    obj->segmentIndex = 0;
+
+    if (!SpiNextSegment(obj))
+    {
+        if (obj->current.status != NULL)
         {
-            *(t->rxBuffer++) = (uint8_t)obj->instance->DR;
-            t->rxLen--;
+            *obj->current.status = SPI_STATUS_DONE;
         }
-        else
+
+        if (obj->current.onTransactionDone != NULL)
         {
-            IGNORE(obj->instance->DR);
+            (*obj->current.onTransactionDone)(obj->current.context);
         }
 
-        if (t->rxLen == 0 && t->txLen == 0)
-        {
-            SpiDisableTxInterrupt(obj);
-            SpiDisableRxInterrupt(obj);
+        return false;
+    }
 
-            if (t->postTransaction != NULL)
+    if (obj->current.device != NULL)
+    {
+        if (!SpiApplyDevice(obj, obj->current.device))
+        {
+            /* CS was not asserted, so only status is reported */
+            if (obj->current.status != NULL)
             {
-                (*t->postTransaction)(NULL);
+                *obj->current.status = SPI_STATUS_TIMEOUT;
             }
 
-            obj->currentTransaction = NULL;
-
-            if (t->onTransactionDone != NULL)
+            if (obj->current.onError != NULL)
             {
-                (*t->onTransactionDone)(t->context);
+                (*obj->current.onError)(SPI_STATUS_TIMEOUT, obj->current.context);
             }
-        }
-    }
 
-    if ((obj->instance->SR & SPI_SR_TXE) && (obj->instance->CR2 & SPI_CR2_TXEIE))
-    {
-        if (t->txLen > 0)
-        {
-            obj->instance->DR = *(t->txBuffer++);
-            t->txLen--;
+            return false;
         }
+
+        GpioFastReset(obj->current.device->csPin);
     }
 
-    if ((obj->instance->SR & SPI_SR_OVR) && (obj->instance->CR2 & SPI_CR2_ERRIE))
+    if (obj->current.preTransaction != NULL)
     {
-        IGNORE(obj->instance->DR);
-        IGNORE(obj->instance->SR);
+        (*obj->current.preTransaction)(obj->current.context);
     }
+
+    SpiUpdateStats(obj);
+
+    SpiDmaStart(obj);
+
+    return true;
 }
 
-static IRQn_Type GetIrqType(const SPI_Handle_t* const obj)
+/*Brief: Take highest priority queued transaction into handle
+ * [in] - obj - pointer to SPI object
+ * [out] - true - transaction taken; false - all queues are empty
+ * */
+static bool SpiDequeue(SPI_Handle_t* const obj)
 {
     ASSERT(obj != NULL);
 
-    IRQn_Type result;
+    static const SPI_PRIORITY ORDER[SPI_PRIORITY_COUNT] = { SPI_PRIORITY_HIGH, SPI_PRIORITY_NORMAL, SPI_PRIORITY_LOW };
 
-    switch (obj->name)
+    for (uint8_t i = 0; i < SPI_PRIORITY_COUNT; i++)
     {
-        case SPI_1:
-            result = SPI1_IRQn;
-            break;
+        if (BufferGet(&obj->queue[ORDER[i]], &obj->current, sizeof(SPI_Transaction_t)))
+        {
+            return true;
+        }
+    }
 
-        case SPI_2:
-            result = SPI2_IRQn;
-            break;
+    return false;
+}
 
-        case SPI_3:
-            result = SPI3_IRQn;
-            break;
+static void SpiUpdateStats(SPI_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
 
-        case SPI_4:
-            result = SPI4_IRQn;
-            break;
+    SPI_Stats_t* stats = &obj->stats[obj->current.priority];
+    uint32_t latency = TimebaseNow() - obj->current.queuedAt;
 
-        case SPI_5:
-            result = SPI5_IRQn;
-            break;
+    if (latency < stats->latencyMin)
+    {
+        stats->latencyMin = latency;
+    }
 
-        default:
-            ASSERT(false);
-            break;
+    if (latency > stats->latencyMax)
+    {
+        stats->latencyMax = latency;
     }
 
-    return result;
+    stats->latencySum += latency;
+    stats->count++;
 }
 
-static void SpiEnableTxInterrupt(const SPI_Handle_t* const obj)
+void SpiGetStats(SPI_Handle_t* const obj, SPI_PRIORITY priority, SPI_Stats_t* const stats)
 {
     ASSERT(obj != NULL);
+    ASSERT(priority < SPI_PRIORITY_COUNT);
+    ASSERT(stats != NULL);
 
-    obj->instance->CR2 |= SPI_CR2_TXEIE;
+    __disable_irq();
+    *stats = obj->stats[priority];
+    __enable_irq();
 }
 
-static void SpiDisableTxInterrupt(const SPI_Handle_t* const obj)
+void SpiResetStats(SPI_Handle_t* const obj)
 {
     ASSERT(obj != NULL);
 
-    obj->instance->CR2 &= ~SPI_CR2_TXEIE;
+    __disable_irq();
+
+    for (uint8_t i = 0; i < SPI_PRIORITY_COUNT; i++)
+    {
+        obj->stats[i].count = 0;
+        obj->stats[i].latencyMin = UINT32_MAX;
+        obj->stats[i].latencyMax = 0;
+        obj->stats[i].latencySum = 0;
+    }
+
+    __enable_irq();
 }
 
-static void SpiEnableRxInterrupt(const SPI_Handle_t* const obj)
+/*Brief: Release CS and report transaction result
+ * [in] - obj - pointer to SPI object
+ * [in] - status - final status of current transaction
+ * [out] - none
+ * */
+static void SpiFinishTransaction(SPI_Handle_t* const obj, SPI_STATUS status)
 {
     ASSERT(obj != NULL);
 
-    obj->instance->CR2 |= SPI_CR2_RXNEIE;
+    if (obj->current.postTransaction != NULL)
+    {
+        (*obj->current.postTransaction)(obj->current.context);
+    }
+
+    if (obj->current.device != NULL)
+    {
+        GpioFastSet(obj->current.device->csPin);
+    }
+
+    if (obj->current.status != NULL)
+    {
+        *obj->current.status = status;
+    }
+
+    if (status == SPI_STATUS_DONE)
+    {
+        if (obj->current.onTransactionDone != NULL)
+        {
+            (*obj->current.onTransactionDone)(obj->current.context);
+        }
+    }
+    else if (obj->current.onError != NULL)
+    {
+        (*obj->current.onError)(status, obj->current.context);
+    }
 }
 
-static void SpiDisableRxInterrupt(const SPI_Handle_t* const obj)
+static void SpiDmaOnInterrupt(void* context)
 {
+    SPI_Handle_t* obj = (SPI_Handle_t*)context;
+
     ASSERT(obj != NULL);
 
-    obj->instance->CR2 &= ~SPI_CR2_RXNEIE;
-}
+    uint32_t flags = DmaGetFlags(&obj->dma->rx);
 
-void SPI1_IRQHandler(void)
-{
-    SpiIrqHandler(m_SpiIrq[SPI_1]);
-}
+    DmaClearFlags(&obj->dma->rx, flags);
 
-void SPI2_IRQHandler(void)
-{
-    SpiIrqHandler(m_SpiIrq[SPI_2]);
-}
+    if (!(flags & (DMA_FLAG_TC | DMA_FLAG_TE)))
+    {
+        return;
+    }
 
-void SPI3_IRQHandler(void)
-{
-    SpiIrqHandler(m_SpiIrq[SPI_3]);
-}
+    obj->instance->CR2 &= ~(SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN);
 
-void SPI4_IRQHandler(void)
-{
-    SpiIrqHandler(m_SpiIrq[SPI_4]);
-}
+    if (flags & DMA_FLAG_TE)
+    {
+        /* bus error, the rest of transaction is dropped; frames still in the
+         * TX buffer and shift register finish first, otherwise the last one
+         * is left in RXNE and taken by RX DMA of the next transaction */
+        DmaStop(&obj->dma->tx);
+        IGNORE(TimebaseWaitFlag(&obj->instance->SR, SPI_SR_BSY, false, SpiTimeoutUs(obj)));
+        SpiClearOverrun(obj);
+
+        SpiFinishTransaction(obj, SPI_STATUS_DMA_ERROR);
+    }
+    else if (SpiNextSegment(obj))
+    {
+        /* last RX byte is in, CS stays asserted between segments */
+        SpiDmaStart(obj);
+        return;
+    }
+    else
+    {
+        SpiFinishTransaction(obj, SPI_STATUS_DONE);
+    }
 
-void SPI5_IRQHandler(void)
-{
-    SpiIrqHandler(m_SpiIrq[SPI_5]);
+    SpiStartNext(obj);
 }
-#endif
@@ -1,38 +1,91 @@
 #include <stdbool.h>
 #include <stddef.h>
-#if 0
+
 #include "custom-assert.h"
+#include "timebase.h"
 #include "uart.h"
+#include "ignore.h"
 
-#define UART_1_CLOCK_ENABLE (RCC->APB2ENR |= (RCC_APB2ENR_USART1EN))
-#define UART_2_CLOCK_ENABLE (RCC->APB1ENR |= (RCC_APB1ENR_USART2EN))
-#define UART_6_CLOCK_ENABLE (RCC->APB2ENR |= (RCC_APB2ENR_USART6EN))
-
-#define DMA_1_CLOCK_ENABLE (RCC->AHB1ENR |= (RCC_AHB1ENR_DMA1EN))
-#define DMA_2_CLOCK_ENABLE (RCC->AHB1ENR |= (RCC_AHB1ENR_DMA2EN))
+#define UART_OVER8_THRESHOLD    1000000     /* baud */
 
-#define UART_RX_TIMEOUT     50     /* ms */
+/* lowest priority number allowed to call FreeRTOS FromISR API */
+#define UART_IRQ_PRIORITY       configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
 
-#define TIM_2_CLOCK_ENABLE  (RCC->APB1ENR |= (RCC_APB1ENR_TIM2EN))
-#define TIM_3_CLOCK_ENABLE  (RCC->APB1ENR |= (RCC_APB1ENR_TIM3EN))
-#define TIM_4_CLOCK_ENABLE  (RCC->APB1ENR |= (RCC_APB1ENR_TIM4EN))
+extern const GpioOps_t g_GpioOps;
 
 static UART_Handle_t* m_UartIrq[UART_COUNT];
 
-static void TxInterruptEnable(UART_Handle_t* const obj);
-static void TxInterruptDisable(UART_Handle_t* const obj);
-
-static void RxInterruptEnable(UART_Handle_t* const obj);
-static void RxInterruptDisable(UART_Handle_t* const obj);
+static const uint32_t m_BaudRates[BAUD_COUNT] = {
+    [BAUD_1200] = 1200,
+    [BAUD_2400] = 2400,
+    [BAUD_9600] = 9600,
+    [BAUD_19200] = 19200,
+    [BAUD_38400] = 38400,
+    [BAUD_57600] = 57600,
+    [BAUD_115200] = 115200,
+    [BAUD_230400] = 230400,
+    [BAUD_460800] = 460800,
+    [BAUD_921600] = 921600,
+};
+
+static const UART_Config_t m_UartConfig[UART_COUNT] = {
+    [UART_1] = {
+        .name = UART_1,
+        .instance = USART1,
+        .txPin = PA_9,
+        .rxPin = PA_10,
+        .rtsPin = PA_12,
+        .ctsPin = PA_11,
+        .dePin = PIN_NC,
+        .af = PIN_AF_7,
+        .flowControl = UART_FLOW_NONE,
+        .clockEnableReg = &RCC->APB2ENR,
+        .clockEnableMask = RCC_APB2ENR_USART1EN,
+        .irq = USART1_IRQn,
+        .txDma = { DMA2, DMA2_Stream7, 7, 4, DMA2_Stream7_IRQn },
+        .rxDma = { DMA2, DMA2_Stream2, 2, 4, DMA2_Stream2_IRQn },
+    },
+    [UART_2] = {
+        .name = UART_2,
+        .instance = USART2,
+        .txPin = PD_5,
+        .rxPin = PD_6,
+        .rtsPin = PD_4,
+        .ctsPin = PD_3,
+        .dePin = PIN_NC,
+        .af = PIN_AF_7,
+        .flowControl = UART_FLOW_NONE,
+        .clockEnableReg = &RCC->APB1ENR,
+        .clockEnableMask = RCC_APB1ENR_USART2EN,
+        .irq = USART2_IRQn,
+        .txDma = { DMA1, DMA1_Stream6, 6, 4, DMA1_Stream6_IRQn },
+        .rxDma = { DMA1, DMA1_Stream5, 5, 4, DMA1_Stream5_IRQn },
+    },
+    [UART_6] = {
+        .name = UART_6,
+        .instance = USART6,
+        .txPin = PA_11,         /* shared with USART1 CTS/RTS: with UART_1 flow */
+        .rxPin = PA_12,         /* control remap to PC_6/PC_7 via UartInitConfig */
+        .rtsPin = PIN_NC,       /* not bonded out on STM32F411 */
+        .ctsPin = PIN_NC,
+        .dePin = PIN_NC,
+        .af = PIN_AF_8,
+        .flowControl = UART_FLOW_NONE,
+        .clockEnableReg = &RCC->APB2ENR,
+        .clockEnableMask = RCC_APB2ENR_USART6EN,
+        .irq = USART6_IRQn,
+        .txDma = { DMA2, DMA2_Stream6, 6, 5, DMA2_Stream6_IRQn },
+        .rxDma = { DMA2, DMA2_Stream1, 1, 5, DMA2_Stream1_IRQn },
+    },
+};
+
+static void IdleInterruptEnable(UART_Handle_t* const obj);
+static void ErrorInterruptEnable(UART_Handle_t* const obj);
 
 static void TcInterruptEnable(UART_Handle_t* const obj);
 static void TcInterruptDisable(UART_Handle_t* const obj);
 
-static IRQn_Type UartGetIrqType(const UART_Handle_t* const obj);
-static IRQn_Type TimerGetIrqType(const UART_Handle_t* const obj);
-
 static void UartOnInterrupt(UART_Handle_t* const obj);
-static void UartRxTimeout(UART_Handle_t* const obj);
 
 static void TransmitterEnable(UART_Handle_t* const obj);
 static void ReceiverEnable(UART_Handle_t* const obj);
@@ -41,125 +94,163 @@ static void SetFormat(UART_Handle_t* const obj);
 
 static void UartEnable(UART_Handle_t* const obj);
 
-static void DMA_Config(UART_Handle_t* const obj, UART_NAMES uartName);
+static void DriverEnable(UART_Handle_t* const obj, bool enable);
+static void TransmitComplete(UART_Handle_t* const obj);
 
-static void TimerInit(UART_Handle_t* const obj, UART_NAMES uartName, uint32_t timeoutMs);
-static void TimerStart(UART_Handle_t* const obj);
+static void UartGpioOpen(GpioHandle_t* const gpio, uint8_t pin, PIN_MODES mode, uint32_t value);
 
-/*Brief: Converts baud rate in to register value */
-static uint16_t ComputeBaudRate(uint32_t pclk, BAUD_RATE baud)
-{
-    uint32_t baudrate = 0;
+static void DmaTxConfig(UART_Handle_t* const obj);
+static void DmaTxStart(UART_Handle_t* const obj);
+static void DmaTxOnInterrupt(void* context);
 
-    switch (baud)
-    {
-        case BAUD_1200:
-            baudrate = 1200;
-            break;
+static void DmaRxConfig(UART_Handle_t* const obj);
+static void DmaRxUpdate(UART_Handle_t* const obj);
+static void DmaRxOnInterrupt(void* context);
 
-        case BAUD_2400:
-            baudrate = 2400;
-            break;
+/*Brief: Get UART kernel clock (APB1 for USART2, APB2 for USART1/6)
+ * [in] - obj - pointer to UART handle
+ * [out] - clock in Hz
+ * */
+static uint32_t UartGetClock(const UART_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
 
-        case BAUD_9600:
-            baudrate = 9600;
-            break;
+    uint32_t hclk = SystemCoreClock;
+    uint32_t apbPrescaler = 0;
 
-        case BAUD_38400:
-            baudrate = 38400;
-            break;
+    /* peripheral sits on the bus whose enable register gates its clock */
+    if (obj->config->clockEnableReg == &RCC->APB1ENR)
+    {
+        apbPrescaler = ((RCC->CFGR >> RCC_CFGR_PPRE1_Pos) & 0x7);
+    }
+    else
+    {
+        apbPrescaler = ((RCC->CFGR >> RCC_CFGR_PPRE2_Pos) & 0x7);
+    }
 
-        case BAUD_57600:
-            baudrate = 57600;
-            break;
+    if (apbPrescaler < 4)
+    {
+        return hclk;
+    }
 
-        case BAUD_115200:
-            baudrate = 115200;
-            break;
+    return hclk >> (apbPrescaler - 3);
+}
 
-        case BAUD_230400:
-            baudrate = 230400;
-            break;
+/*Brief: Converts baud rate in to register value
+ * RM0383 19.3.4: baud = pclk / (8 * (2 - OVER8) * USARTDIV).
+ * With d = round(pclk / baud) the divider in units of 1/16 (OVER8 = 0)
+ * or 1/8 (OVER8 = 1) of a bit is exactly d, so:
+ *  OVER8 = 0: BRR = d, 16 <= d <= 0xFFFF
+ *  OVER8 = 1: BRR = ((d & ~7) << 1) | (d & 7), BRR[3] must be kept cleared,
+ *             8 <= d <= 0x7FFF (12 bit mantissa, 3 bit fraction)
+ * [in] - pclk - UART kernel clock in Hz
+ * [in] - baudrate - baud rate
+ * [in] - over8 - true - oversampling by 8; false - oversampling by 16
+ * [out] - BRR register value; 0 - baud rate is not reachable from pclk
+ * */
+static uint16_t ComputeBaudRate(uint32_t pclk, uint32_t baudrate, bool over8)
+{
+    ASSERT(baudrate != 0);
 
-        case BAUD_460800:
-            baudrate = 460800;
-            break;
+    uint32_t div = (pclk + (baudrate / 2)) / baudrate;
 
-        case BAUD_921600:
-            baudrate = 921600;
-            break;
+    if (over8)
+    {
+        if ((div < 8) || (div > 0x7FFF))
+        {
+            return 0;
+        }
 
-        default:
-            break;
+        return (uint16_t)(((div & ~0x07U) << 1) | (div & 0x07U));
     }
 
-    float usartDiv = (float)pclk / (16.0f * baudrate);
-
-    uint32_t mantissa = (uint32_t)usartDiv;
-    uint32_t fraction = (uint32_t)((usartDiv - mantissa) * 16.0f + 0.5f);
-
-    if (fraction > 15)
+    if ((div < 16) || (div > 0xFFFF))
     {
-        mantissa += 1;
-        fraction = 0;
+        return 0;
     }
 
-    return (mantissa << 4) | (fraction & 0x0F);
+    return (uint16_t)div;
 }
 
-void UartInit(UART_Handle_t* const obj, UART_NAMES uartName, BAUD_RATE baud)
+/*Brief: Select oversampling for baud rate
+ * [in] - pclk - UART kernel clock in Hz
+ * [in] - baudrate - baud rate
+ * [out] - true - oversampling by 8; false - oversampling by 16
+ * */
+static bool UartUseOver8(uint32_t pclk, uint32_t baudrate)
 {
-    ASSERT(obj != NULL);
-    ASSERT(uartName < UART_COUNT);
-    ASSERT(baud < BAUD_COUNT);
-
-    obj->isTransmitting = false;
-    obj->uartName = uartName;
-    obj->isTransmitCompeted = true;
-    obj->initialized = false;
-
-    switch (uartName)
-    {
-        case UART_1:
-            GpioInit(&obj->gpio.tx, PA_9, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, PIN_AF_7);
-            GpioInit(&obj->gpio.rx, PA_10, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, PIN_AF_7);
+    /* oversampling by 8 trades noise immunity for the higher rates */
+    return (baudrate > UART_OVER8_THRESHOLD) || ((pclk / baudrate) < 16);
+}
 
-            UART_1_CLOCK_ENABLE;
+bool UartInit(UART_Handle_t* const obj, UART_NAMES uartName, BAUD_RATE baud)
+{
+    ASSERT(uartName < UART_COUNT);
 
-            obj->instance = USART1;
+    return UartInitConfig(obj, &m_UartConfig[uartName], baud);
+}
 
-            obj->instance->BRR = ComputeBaudRate(SystemCoreClock, baud);
+void UartSetStorage(UART_Handle_t* const obj, uint8_t* const txData, uint16_t txSize,
+                    uint8_t* const rxData, uint16_t rxSize)
+{
+    ASSERT(obj != NULL);
+    ASSERT(txData != NULL && txSize > 1);
+    ASSERT(rxData != NULL && rxSize > 1);
 
-            obj->timer = TIM2;
+    obj->txData = txData;
+    obj->txSize = txSize;
+    obj->rxData = rxData;
+    obj->rxSize = rxSize;
+}
 
-            break;
+bool UartInitConfig(UART_Handle_t* const obj, const UART_Config_t* const config, BAUD_RATE baud)
+{
+    ASSERT(obj != NULL);
+    ASSERT(config != NULL);
+    ASSERT(config->name < UART_COUNT);
+    ASSERT(baud < BAUD_COUNT);
+    ASSERT(obj->txData != NULL && obj->txSize > 1);
+    ASSERT(obj->rxData != NULL && obj->rxSize > 1);
 
-        case UART_2:
-            GpioInit(&obj->gpio.tx, PD_5, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, PIN_AF_7);
-            GpioInit(&obj->gpio.rx, PD_6, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, PIN_AF_7);
+    obj->config = config;
 
-            UART_2_CLOCK_ENABLE;
+    uint32_t pclk = UartGetClock(obj);
+    uint32_t baudrate = m_BaudRates[baud];
 
-            obj->instance = USART2;
+    /* e.g. 1200 baud needs a divider above 0xFFFF on 84/100 MHz APB2 */
+    if (ComputeBaudRate(pclk, baudrate, UartUseOver8(pclk, baudrate)) == 0)
+    {
+        return false;
+    }
 
-            obj->instance->BRR = ComputeBaudRate(SystemCoreClock, baud);
+    obj->isTransmitting = false;
+    obj->txDmaCount = 0;
+    obj->txWaiter = NULL;
+    obj->uartName = config->name;
+    obj->instance = config->instance;
+    obj->isTransmitCompeted = true;
+    obj->initialized = false;
 
-            obj->timer = TIM3;
+    UartGpioOpen(&obj->gpio.tx, config->txPin, PIN_MODE_ALTERNATE, config->af);
+    UartGpioOpen(&obj->gpio.rx, config->rxPin, PIN_MODE_ALTERNATE, config->af);
 
+    switch (config->flowControl)
+    {
+        case UART_FLOW_NONE:
             break;
 
-        case UART_6:
-            GpioInit(&obj->gpio.tx, PA_11, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, PIN_AF_8);
-            GpioInit(&obj->gpio.rx, PA_12, PIN_MODE_ALTERNATE, PIN_TYPE_NO_PULL_UP_PULL_DOWN, PIN_SPEED_FAST, PIN_CONFIG_PUSH_PULL, PIN_AF_8);
-
-            UART_6_CLOCK_ENABLE;
-
-            obj->instance = USART6;
+        case UART_FLOW_RTS_CTS:
+            ASSERT(config->rtsPin != PIN_NC && config->ctsPin != PIN_NC);
 
-            obj->instance->BRR = ComputeBaudRate(SystemCoreClock, baud);
+            UartGpioOpen(&obj->gpio.rts, config->rtsPin, PIN_MODE_ALTERNATE, config->af);
+            UartGpioOpen(&obj->gpio.cts, config->ctsPin, PIN_MODE_ALTERNATE, config->af);
+            break;
 
-            obj->timer = TIM4;
+        case UART_FLOW_RS485:
+            ASSERT(config->dePin != PIN_NC);
 
+            /* transceiver starts in receive mode */
+            UartGpioOpen(&obj->gpio.de, config->dePin, PIN_MODE_OUTPUT, PIN_STATE_LOW);
             break;
 
         default:
@@ -167,203 +258,314 @@ void UartInit(UART_Handle_t* const obj, UART_NAMES uartName, BAUD_RATE baud)
             break;
     }
 
+    *config->clockEnableReg |= config->clockEnableMask;
+
+    IGNORE(UartSetBaudRate(obj, baudrate));
+
     TransmitterEnable(obj);
 
+    DmaTxConfig(obj);
+
     ReceiverEnable(obj);
-    RxInterruptEnable(obj);
 
     SetFormat(obj);
 
     UartEnable(obj);
 
-    BufferCreate(&obj->txBuffer, &obj->txData, sizeof(obj->txData), sizeof(uint8_t), true);
-    BufferCreate(&obj->rxBuffer, &obj->rxData, sizeof(obj->rxData), sizeof(uint8_t), true);
+    /* TX data is read in place by DMA, so pending data must never be overwritten;
+     * RX ring is filled from the DMA staging buffer and keeps its oldest data */
+    BufferCreate(&obj->txBuffer, obj->txData, obj->txSize, sizeof(uint8_t), false);
+    BufferCreate(&obj->rxBuffer, obj->rxData, obj->rxSize, sizeof(uint8_t), false);
+
+    UartResetStats(obj);
+
+    TimebaseInit();
 
-    NVIC_EnableIRQ(UartGetIrqType(obj));
-    NVIC_SetPriority(UartGetIrqType(obj), 1);
+    DmaRxConfig(obj);
+    IdleInterruptEnable(obj);
+    ErrorInterruptEnable(obj);
 
     m_UartIrq[obj->uartName] = obj;
 
-    TimerInit(obj, uartName, UART_RX_TIMEOUT);
+    NVIC_SetPriority(config->irq, UART_IRQ_PRIORITY);
+    NVIC_EnableIRQ(config->irq);
 
     obj->initialized = true;
+
+    return true;
 }
 
-void UartWrite_IT(UART_Handle_t* const obj, const uint8_t* const buffer, uint8_t size)
+uint32_t UartSetBaudRate(UART_Handle_t* const obj, uint32_t baudrate)
 {
     ASSERT(obj != NULL);
+    ASSERT(baudrate != 0 && baudrate <= UART_BAUD_MAX);
+
+    uint32_t pclk = UartGetClock(obj);
+    bool over8 = UartUseOver8(pclk, baudrate);
+    uint16_t brr = ComputeBaudRate(pclk, baudrate, over8);
 
-    for (uint8_t i = 0; i < size; i++)
+    if (brr == 0)
     {
-        BufferPut(&obj->txBuffer, &buffer[i], sizeof(uint8_t));
+        return 0;
     }
 
-    if (!obj->isTransmitting)
+    bool enabled = (obj->instance->CR1 & USART_CR1_UE) ? true : false;
+
+    obj->instance->CR1 &= ~(USART_CR1_UE);
+
+    if (over8)
     {
-        obj->isTransmitting = true;
-        obj->isTransmitCompeted = false;
+        obj->instance->CR1 |= (USART_CR1_OVER8);
+    }
+    else
+    {
+        obj->instance->CR1 &= ~(USART_CR1_OVER8);
+    }
+
+    obj->instance->BRR = brr;
 
-        TxInterruptEnable(obj);
+    if (enabled)
+    {
+        obj->instance->CR1 |= (USART_CR1_UE);
     }
+
+    return pclk / ((pclk + (baudrate / 2)) / baudrate);
 }
 
-void UartRegisterReceiveHandler(UART_Handle_t* const obj, UART_EventHandler_t callback)
+const UART_Config_t* UartGetDefaultConfig(UART_NAMES uartName)
 {
-    ASSERT(obj != NULL);
+    ASSERT(uartName < UART_COUNT);
 
-    obj->onRxDone = callback;
+    return &m_UartConfig[uartName];
 }
 
-bool UartIdle(UART_Handle_t* const obj)
+uint32_t UartWrite_IT(UART_Handle_t* const obj, const uint8_t* const buffer, uint32_t size)
 {
     ASSERT(obj != NULL);
+    ASSERT(buffer != NULL);
 
-    return obj->isTransmitCompeted;
-}
+    uint32_t accepted = 0;
 
-void USART1_IRQHandler(void)
-{
-    UartOnInterrupt(m_UartIrq[UART_1]);
-}
+    while (accepted < size)
+    {
+        if (!BufferPut(&obj->txBuffer, &buffer[accepted], sizeof(uint8_t)))
+        {
+            break;
+        }
 
-void USART2_IRQHandler(void)
-{
-    UartOnInterrupt(m_UartIrq[UART_2]);
-}
+        accepted++;
+    }
 
-void USART6_IRQHandler(void)
-{
-    UartOnInterrupt(m_UartIrq[UART_6]);
-}
+    if (accepted == 0)
+    {
+        return 0;
+    }
 
-static void TxInterruptEnable(UART_Handle_t* const obj)
-{
-    ASSERT(obj != NULL);
+    __disable_irq();
+
+    if (!obj->isTransmitting)
+    {
+        obj->isTransmitting = true;
+        obj->isTransmitCompeted = false;
 
-    obj->instance->CR1 |= (USART_CR1_TXEIE);
+        DriverEnable(obj, true);
+
+        DmaTxStart(obj);
+    }
+
+    __enable_irq();
+
+    return accepted;
 }
 
-static void TxInterruptDisable(UART_Handle_t* const obj)
+uint32_t UartWriteTimeout(UART_Handle_t* const obj, const uint8_t* const buffer, uint32_t size, uint32_t timeoutUs)
 {
     ASSERT(obj != NULL);
+    ASSERT(buffer != NULL);
+
+    uint32_t start = TimebaseNow();
+    uint32_t timeout = TimebaseUsToTicks(timeoutUs);
 
-    obj->instance->CR1 &= ~(USART_CR1_TXEIE);
+    uint32_t accepted = UartWrite_IT(obj, buffer, size);
+
+    while ((accepted < size) && !TimebaseElapsed(start, timeout))
+    {
+        accepted += UartWrite_IT(obj, &buffer[accepted], size - accepted);
+    }
+
+    return accepted;
 }
 
-static void RxInterruptEnable(UART_Handle_t* const obj)
+uint32_t UartWriteNotify(UART_Handle_t* const obj, const uint8_t* const buffer, uint32_t size, uint32_t timeoutMs)
 {
     ASSERT(obj != NULL);
+    ASSERT(buffer != NULL);
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeoutMs);
+    TickType_t elapsed = 0;
+
+    __disable_irq();
+
+    /* one waiter per port: DMA interrupt notifies a single task */
+    bool claimed = (obj->txWaiter == NULL);
+
+    if (claimed)
+    {
+        obj->txWaiter = xTaskGetCurrentTaskHandle();
+    }
+
+    __enable_irq();
+
+    if (!claimed)
+    {
+        return 0;
+    }
 
-    obj->instance->CR1 |= (USART_CR1_RXNEIE);
+    uint32_t accepted = UartWrite_IT(obj, buffer, size);
+
+    while (accepted < size)
+    {
+        elapsed = xTaskGetTickCount() - start;
+
+        if (elapsed >= timeout)
+        {
+            break;
+        }
+
+        /* notification is latched, so a segment completed meanwhile is not missed */
+        ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+
+        accepted += UartWrite_IT(obj, &buffer[accepted], size - accepted);
+    }
+
+    obj->txWaiter = NULL;
+
+    return accepted;
 }
 
-static void RxInterruptDisable(UART_Handle_t* const obj)
+void UartRegisterReceiveHandler(UART_Handle_t* const obj, UART_EventHandler_t callback)
 {
     ASSERT(obj != NULL);
 
-    obj->instance->CR1 &= ~(USART_CR1_RXNEIE);
+    obj->onRxDone = callback;
 }
 
-static void TcInterruptEnable(UART_Handle_t* const obj)
+bool UartIdle(UART_Handle_t* const obj)
 {
     ASSERT(obj != NULL);
 
-    obj->instance->CR1 |= (USART_CR1_TCIE);
+    return obj->isTransmitCompeted;
 }
 
-static void TcInterruptDisable(UART_Handle_t* const obj)
+void UartGetStats(UART_Handle_t* const obj, UART_Stats_t* const stats)
 {
     ASSERT(obj != NULL);
-
-    obj->instance->CR1 &= ~(USART_CR1_TCIE);
+    ASSERT(stats != NULL);
+
+    __disable_irq();
+    stats->txBytes = obj->stats.txBytes;
+    stats->rxBytes = obj->stats.rxBytes;
+    stats->overrunErrors = obj->stats.overrunErrors;
+    stats->framingErrors = obj->stats.framingErrors;
+    stats->noiseErrors = obj->stats.noiseErrors;
+    stats->rxDropped = obj->stats.rxDropped;
+    stats->dmaErrors = obj->stats.dmaErrors;
+    __enable_irq();
 }
 
-static IRQn_Type UartGetIrqType(const UART_Handle_t* const obj)
+void UartResetStats(UART_Handle_t* const obj)
 {
     ASSERT(obj != NULL);
 
-    IRQn_Type result;
+    __disable_irq();
+    obj->stats.txBytes = 0;
+    obj->stats.rxBytes = 0;
+    obj->stats.overrunErrors = 0;
+    obj->stats.framingErrors = 0;
+    obj->stats.noiseErrors = 0;
+    obj->stats.rxDropped = 0;
+    obj->stats.dmaErrors = 0;
+    __enable_irq();
+}
 
-    switch (obj->uartName)
-    {
-        case UART_1:
-            result = USART1_IRQn;
-            break;
+void USART1_IRQHandler(void)
+{
+    UartOnInterrupt(m_UartIrq[UART_1]);
+}
 
-        case UART_2:
-            result = USART2_IRQn;
-            break;
+void USART2_IRQHandler(void)
+{
+    UartOnInterrupt(m_UartIrq[UART_2]);
+}
 
-        case UART_6:
-            result = USART6_IRQn;
-            break;
+void USART6_IRQHandler(void)
+{
+    UartOnInterrupt(m_UartIrq[UART_6]);
+}
 
-        default:
-            ASSERT(false);
-            break;
-    }
+static void IdleInterruptEnable(UART_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
 
-    return result;
+    obj->instance->CR1 |= (USART_CR1_IDLEIE);
 }
 
-static IRQn_Type TimerGetIrqType(const UART_Handle_t* const obj)
+static void ErrorInterruptEnable(UART_Handle_t* const obj)
 {
     ASSERT(obj != NULL);
 
-    IRQn_Type result;
-
-    switch (obj->uartName)
-    {
-        case UART_1:
-            result = TIM2_IRQn;
-            break;
+    /* ORE, FE and NE raise interrupt while RX is served by DMA */
+    obj->instance->CR3 |= (USART_CR3_EIE);
+}
 
-        case UART_2:
-            result = TIM3_IRQn;
-            break;
+static void TcInterruptEnable(UART_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
 
-        case UART_6:
-            result = TIM4_IRQn;
-            break;
+    obj->instance->CR1 |= (USART_CR1_TCIE);
+}
 
-        default:
-            ASSERT(false);
-            break;
-    }
+static void TcInterruptDisable(UART_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
 
-    return result;
+    obj->instance->CR1 &= ~(USART_CR1_TCIE);
 }
 
 static void UartOnInterrupt(UART_Handle_t* const obj)
 {
-    uint8_t item = 0;
+    uint32_t status = obj->instance->SR;
 
-    /* TX handle */
-    if ((obj->instance->SR & (USART_SR_TXE)) && (obj->instance->CR1 & (USART_CR1_TXEIE)))
+    /* RX error handle */
+    if (status & (USART_SR_ORE | USART_SR_FE | USART_SR_NE))
     {
-        if (BufferGet(&obj->txBuffer, &item, sizeof(item)))
-        {
-            obj->instance->DR = item;
-        }
-        else
+        if (status & USART_SR_ORE)
         {
-            TxInterruptDisable(obj);
-            TcInterruptEnable(obj);
+            obj->stats.overrunErrors++;
         }
-    }
-    /* RX handle */
-    if ((obj->instance->SR & (USART_SR_RXNE)) && (obj->instance->CR1 & (USART_CR1_RXNEIE)))
-    {
-        item = obj->instance->DR;
 
-        if (BufferPut(&obj->rxBuffer, &item, sizeof(item)))
+        if (status & USART_SR_FE)
         {
-            TimerStart(obj);
+            obj->stats.framingErrors++;
         }
-        else
+
+        if (status & USART_SR_NE)
         {
-            RxInterruptDisable(obj);
+            obj->stats.noiseErrors++;
         }
+
+        /* cleared by SR read followed by DR read, DMA keeps receiving */
+        IGNORE(obj->instance->DR);
+    }
+
+    /* RX line idle handle */
+    if ((status & (USART_SR_IDLE)) && (obj->instance->CR1 & (USART_CR1_IDLEIE)))
+    {
+        /* IDLE is cleared by SR read followed by DR read */
+        IGNORE(obj->instance->DR);
+
+        DmaRxUpdate(obj);
     }
 
     /* TX complete handle */
@@ -373,24 +575,15 @@ static void UartOnInterrupt(UART_Handle_t* const obj)
 
         TcInterruptDisable(obj);
 
-        obj->isTransmitting = false;
-        obj->isTransmitCompeted = true;
-    }
-}
-
-static void UartRxTimeout(UART_Handle_t* const obj)
-{
-    ASSERT(obj != NULL);
-
-    /* Update interrupt pending */
-    if (obj->timer->SR & TIM_SR_UIF)
-    {
-        /* read-clear-write-0 */
-        obj->timer->SR &= ~TIM_SR_UIF;
-
-        if (obj->onRxDone != NULL)
+        if (BufferCount(&obj->txBuffer) != 0)
+        {
+            /* data queued while the last segment was shifted out */
+            DmaTxStart(obj);
+        }
+        else
         {
-            (*obj->onRxDone)(obj);
+            /* last stop bit is on the line, release the bus */
+            TransmitComplete(obj);
         }
     }
 }
@@ -422,8 +615,18 @@ static void SetFormat(UART_Handle_t* const obj)
     /* 1 Stop bit */
     obj->instance->CR2 &= ~(USART_CR2_STOP);
 
-    /* oversampling by 16 */
-    obj->instance->CR1 &= ~(USART_CR1_OVER8);
+    /* NOTE: oversampling is selected by UartSetBaudRate */
+
+    if (obj->config->flowControl == UART_FLOW_RTS_CTS)
+    {
+        /* RTS: request data only if there is space in receive register,
+         * CTS: transmit only when peer asserts nCTS */
+        obj->instance->CR3 |= (USART_CR3_RTSE | USART_CR3_CTSE);
+    }
+    else
+    {
+        obj->instance->CR3 &= ~(USART_CR3_RTSE | USART_CR3_CTSE);
+    }
 }
 
 static void UartEnable(UART_Handle_t* const obj)
@@ -433,139 +636,222 @@ static void UartEnable(UART_Handle_t* const obj)
     obj->instance->CR1 |= USART_CR1_UE;
 }
 
-static void TimerInit(UART_Handle_t* const obj, UART_NAMES uartName, uint32_t timeoutMs)
+static void DriverEnable(UART_Handle_t* const obj, bool enable)
 {
     ASSERT(obj != NULL);
 
-    switch (uartName)
+    if (obj->config->flowControl == UART_FLOW_RS485)
     {
-        case UART_1:
-            TIM_2_CLOCK_ENABLE;
-            break;
+        obj->gpio.de.ops->write(&obj->gpio.de, enable ? PIN_STATE_HIGH : PIN_STATE_LOW);
+    }
+}
 
-        case UART_2:
-            TIM_3_CLOCK_ENABLE;
-            break;
+static void TransmitComplete(UART_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
 
-        case UART_6:
-            TIM_4_CLOCK_ENABLE;
-            break;
+    DriverEnable(obj, false);
 
-        default:
-            break;
-    }
+    obj->isTransmitting = false;
+    obj->isTransmitCompeted = true;
+}
 
-    obj->timer->CR1 = 0;
+/*Brief: Open UART pin through platform gpio operations
+ * [in] - gpio - pointer to gpio handle
+ * [in] - pin - pin name
+ * [in] - mode - gpio mode
+ * [in] - value - alternate function or initial output level
+ * [out] - none
+ * */
+static void UartGpioOpen(GpioHandle_t* const gpio, uint8_t pin, PIN_MODES mode, uint32_t value)
+{
+    ASSERT(gpio != NULL);
 
-    /* Prescaler value 16 Mhz / 16 = 1 khz (1 ms) */
-    obj->timer->PSC = 16000 - 1;
+    gpio->ops = &g_GpioOps;
+    gpio->ops->open(gpio, pin, mode, PIN_TYPE_NO_PULL, PIN_STRENGTH_HIGH, PIN_CONFIG_PUSH_PULL, value);
+}
 
-    /* Auto-reload value */
-    obj->timer->ARR = timeoutMs - 1;
+static void DmaTxConfig(UART_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
 
-    obj->timer->EGR = TIM_EGR_UG;
+    DmaInit(&obj->config->txDma, DMA_SxCR_PL_1          /* High priority */
+                                 | DMA_SxCR_DIR_0       /* Memory -> Peripheral */
+                                 | DMA_SxCR_MINC        /* Increment memory */
+                                 | DMA_SxCR_TCIE        /* Transfer complete interrupt */
+                                 | DMA_SxCR_TEIE);      /* Transfer error interrupt */
 
-    /* One-pulse mode */
-    obj->timer->CR1 |= TIM_CR1_OPM;
+    obj->instance->CR3 |= USART_CR3_DMAT;
 
-    /* Update interrupt enabled */
-    obj->timer->DIER |= TIM_DIER_UIE;
+    DmaRegisterHandler(&obj->config->txDma, &DmaTxOnInterrupt, obj);
 
-    NVIC_EnableIRQ(TimerGetIrqType(obj));
-    NVIC_SetPriority(TimerGetIrqType(obj), 5);
+    NVIC_SetPriority(obj->config->txDma.irq, UART_IRQ_PRIORITY);
+    NVIC_EnableIRQ(obj->config->txDma.irq);
 }
 
-static void TimerStart(UART_Handle_t* const obj)
+/*Brief: Start DMA transfer of the contiguous segment at the head of TX buffer.
+ * If nothing is left, wait for the last byte to leave the shift register.
+ * */
+static void DmaTxStart(UART_Handle_t* const obj)
 {
     ASSERT(obj != NULL);
 
-    obj->timer->CR1 &= ~TIM_CR1_CEN;
+    uint16_t count = BufferContiguousCount(&obj->txBuffer);
 
-    obj->timer->SR &= ~TIM_SR_UIF;
+    if (count == 0)
+    {
+        TcInterruptEnable(obj);
+        return;
+    }
 
-    obj->timer->CNT = 0;
+    obj->txDmaCount = count;
 
-    /* Counter enabled */
-    obj->timer->CR1 |= TIM_CR1_CEN;
-}
+    /* RM0383 19.3.13: TC is still set from reset or the previous transfer,
+     * clear it so the TC interrupt marks the end of this one (rc_w0, writing
+     * ones leaves the other flags untouched) */
+    obj->instance->SR = (uint32_t)~(USART_SR_TC);
 
-void TIM2_IRQHandler(void)
-{
-    UartRxTimeout(m_UartIrq[UART_1]);
+    DmaStart(&obj->config->txDma, &obj->instance->DR, BufferFront(&obj->txBuffer), count);
 }
 
-void TIM3_IRQHandler(void)
+static void DmaTxOnInterrupt(void* context)
 {
-    UartRxTimeout(m_UartIrq[UART_2]);
-}
+    UART_Handle_t* obj = (UART_Handle_t*)context;
 
-void TIM4_IRQHandler(void)
-{
-    UartRxTimeout(m_UartIrq[UART_6]);
+    ASSERT(obj != NULL);
+
+    uint32_t flags = DmaGetFlags(&obj->config->txDma);
+
+    DmaClearFlags(&obj->config->txDma, flags);
+
+    if (flags & DMA_FLAG_TC)
+    {
+        obj->stats.txBytes += obj->txDmaCount;
+    }
+
+    if (flags & DMA_FLAG_TE)
+    {
+        obj->stats.dmaErrors++;
+    }
+
+    if (flags & (DMA_FLAG_TC | DMA_FLAG_TE))
+    {
+        /* segment is done (or dropped on bus error), release it and re-arm */
+        BufferSkip(&obj->txBuffer, obj->txDmaCount);
+        obj->txDmaCount = 0;
+
+        if ((flags & DMA_FLAG_TE) && (BufferCount(&obj->txBuffer) == 0))
+        {
+            /* TC was cleared at segment start and a dropped segment may
+             * never raise it again, so do not wait for it */
+            TransmitComplete(obj);
+        }
+        else
+        {
+            DmaTxStart(obj);
+        }
+
+        if (obj->txWaiter != NULL)
+        {
+            BaseType_t woken = pdFALSE;
+
+            vTaskNotifyGiveFromISR(obj->txWaiter, &woken);
+
+            portYIELD_FROM_ISR(woken);
+        }
+    }
 }
 
-#if 0
-static void DMA_Config(UART_Handle_t* const obj, UART_NAMES uartName)
+static void DmaRxConfig(UART_Handle_t* const obj)
 {
     ASSERT(obj != NULL);
 
-    switch (uartName)
-    {
-        case UART_1:
-            DMA_2_CLOCK_ENABLE;
+    DmaInit(&obj->config->rxDma, DMA_SxCR_PL_1          /* High priority */
+                                 | DMA_SxCR_MINC        /* Increment memory */
+                                 | DMA_SxCR_CIRC        /* Circular mode */
+                                 | DMA_SxCR_HTIE        /* Half transfer interrupt */
+                                 | DMA_SxCR_TCIE        /* Transfer complete interrupt */
+                                 | DMA_SxCR_TEIE);      /* Transfer error interrupt */
 
-            DMA2_Stream7->CR &= ~DMA_SxCR_EN;
+    obj->rxDmaPosition = 0;
 
-            while (DMA2_Stream7->CR & DMA_SxCR_EN);
+    obj->instance->CR3 |= USART_CR3_DMAR;
 
-            DMA2_Stream7->PAR = obj->instance->DR;
-            DMA2_Stream7->CR = (4U << DMA_SxCR_CHSEL_Pos)  /* Channel 4 */
-                               | DMA_SxCR_PL_1             /* High priority */
-                               | DMA_SxCR_DIR_0            /* Memory -> Peripheral */
-                               | DMA_SxCR_MINC;            /* Increment memory */
+    DmaRegisterHandler(&obj->config->rxDma, &DmaRxOnInterrupt, obj);
 
-            DMA2_Stream7->FCR = 0;  /* Direct mode (no FIFO) */
+    NVIC_SetPriority(obj->config->rxDma.irq, UART_IRQ_PRIORITY);
+    NVIC_EnableIRQ(obj->config->rxDma.irq);
 
-            break;
+    /* DMA never touches the ring: unread bytes cannot be overwritten */
+    DmaStart(&obj->config->rxDma, &obj->instance->DR, obj->rxDmaData, UART_RX_DMA_SIZE);
+}
 
-        case UART_2:
-            DMA_1_CLOCK_ENABLE;
+/*Brief: Copy bytes written by DMA since the last update into RX ring and notify receiver
+ * NOTE: called on line idle, half and full transfer, so data is delivered
+ * as soon as a frame ends or half of the staging buffer is filled; a full
+ * ring drops the new bytes and counts them
+ * */
+static void DmaRxUpdate(UART_Handle_t* const obj)
+{
+    ASSERT(obj != NULL);
 
-            DMA2_Stream6->CR &= ~DMA_SxCR_EN;
+    uint16_t position = UART_RX_DMA_SIZE - DmaRemaining(&obj->config->rxDma);
 
-            while (DMA2_Stream6->CR & DMA_SxCR_EN);
+    if (position == UART_RX_DMA_SIZE)
+    {
+        position = 0;
+    }
 
-            DMA2_Stream6->PAR = obj->instance->DR;
-            DMA2_Stream6->CR = (4U << DMA_SxCR_CHSEL_Pos)  /* Channel 4 */
-                               | DMA_SxCR_PL_1             /* High priority */
-                               | DMA_SxCR_DIR_0            /* Memory -> Peripheral */
-                               | DMA_SxCR_MINC;            /* Increment memory */
+    if (position == obj->rxDmaPosition)
+    {
+        return;
+    }
 
-            DMA2_Stream6->FCR = 0;  /* Direct mode (no FIFO) */
+    uint16_t index = obj->rxDmaPosition;
 
-            break;
+    while (index != position)
+    {
+        if (!BufferPut(&obj->rxBuffer, &obj->rxDmaData[index], sizeof(uint8_t)))
+        {
+            obj->stats.rxDropped++;
+        }
 
-        case UART_6:
-            DMA_2_CLOCK_ENABLE;
+        obj->stats.rxBytes++;
 
-            DMA2_Stream7->CR &= ~DMA_SxCR_EN;
+        index = (index + 1U) % UART_RX_DMA_SIZE;
+    }
 
-            while (DMA2_Stream7->CR & DMA_SxCR_EN);
+    obj->rxDmaPosition = position;
 
-            DMA2_Stream7->PAR = obj->instance->DR;
-            DMA2_Stream7->CR = (5U << DMA_SxCR_CHSEL_Pos)  /* Channel 5 */
-                               | DMA_SxCR_PL_1             /* High priority */
-                               | DMA_SxCR_DIR_0            /* Memory -> Peripheral */
-                               | DMA_SxCR_MINC;            /* Increment memory */
+    if (obj->onRxDone != NULL)
+    {
+        (*obj->onRxDone)(obj);
+    }
+}
 
-            DMA2_Stream7->FCR = 0;  /* Direct mode (no FIFO) */
+static void DmaRxOnInterrupt(void* context)
+{
+    UART_Handle_t* obj = (UART_Handle_t*)context;
 
-            break;
+    ASSERT(obj != NULL);
 
-        default:
-            ASSERT(false);
-            break;
+    uint32_t flags = DmaGetFlags(&obj->config->rxDma);
+
+    DmaClearFlags(&obj->config->rxDma, flags);
+
+    if (flags & DMA_FLAG_TE)
+    {
+        /* stream is disabled by hardware on error, restart reception;
+         * bytes already copied to the ring stay there */
+        obj->stats.dmaErrors++;
+        obj->rxDmaPosition = 0;
+
+        DmaStart(&obj->config->rxDma, &obj->instance->DR, obj->rxDmaData, UART_RX_DMA_SIZE);
+        return;
+    }
+
+    if (flags & (DMA_FLAG_HT | DMA_FLAG_TC))
+    {
+        DmaRxUpdate(obj);
     }
 }
-#endif
-#endif
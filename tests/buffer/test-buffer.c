@@ -0,0 +1,149 @@
+#include <string.h>
+
+#include "test.h"
+#include "buffer.h"
+
+#define TEST_STORAGE            (9U)    /* 8 items, one slot kept free */
+
+static Buffer_t m_Buffer;
+static uint8_t m_Storage[TEST_STORAGE];
+
+static void Setup(void)
+{
+    memset(m_Storage, 0, sizeof(m_Storage));
+}
+
+static void PutRange(uint8_t first, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint8_t value = (uint8_t)(first + i);
+
+        CHECK(BufferPut(&m_Buffer, &value, sizeof(value)));
+    }
+}
+
+static void TestPutGetKeepsOrder(void)
+{
+    BufferCreate(&m_Buffer, m_Storage, sizeof(m_Storage), sizeof(uint8_t), false);
+
+    CHECK_EQ(BufferCapacity(&m_Buffer), 8);
+    CHECK_EQ(BufferCount(&m_Buffer), 0);
+
+    PutRange(10, 5);
+    CHECK_EQ(BufferCount(&m_Buffer), 5);
+
+    for (uint8_t i = 0; i < 5U; i++)
+    {
+        uint8_t value = 0;
+
+        CHECK(BufferGet(&m_Buffer, &value, sizeof(value)));
+        CHECK_EQ(value, 10 + i);
+    }
+
+    uint8_t value;
+
+    CHECK(!BufferGet(&m_Buffer, &value, sizeof(value)));
+    CHECK(BufferFront(&m_Buffer) == NULL);
+}
+
+static void TestFullRejectsNewData(void)
+{
+    BufferCreate(&m_Buffer, m_Storage, sizeof(m_Storage), sizeof(uint8_t), false);
+
+    PutRange(0, 8);
+
+    uint8_t value = 0xAA;
+
+    CHECK(!BufferPut(&m_Buffer, &value, sizeof(value)));
+    CHECK_EQ(BufferCount(&m_Buffer), 8);
+    CHECK_EQ(*(uint8_t*)BufferFront(&m_Buffer), 0);
+}
+
+static void TestFullOverwritesOldest(void)
+{
+    BufferCreate(&m_Buffer, m_Storage, sizeof(m_Storage), sizeof(uint8_t), true);
+
+    PutRange(0, 10);
+
+    CHECK_EQ(BufferCount(&m_Buffer), 8);
+    CHECK_EQ(*(uint8_t*)BufferFront(&m_Buffer), 2);
+}
+
+static void TestContiguousCountStopsAtWrap(void)
+{
+    BufferCreate(&m_Buffer, m_Storage, sizeof(m_Storage), sizeof(uint8_t), false);
+
+    PutRange(0, 6);
+    BufferSkip(&m_Buffer, 6);
+
+    /* 3 slots up to the end of storage, 3 from its start */
+    PutRange(6, 6);
+
+    CHECK_EQ(BufferCount(&m_Buffer), 6);
+    CHECK_EQ(BufferContiguousCount(&m_Buffer), 3);
+    CHECK_EQ(*(uint8_t*)BufferFront(&m_Buffer), 6);
+
+    BufferSkip(&m_Buffer, 3);
+
+    CHECK_EQ(BufferContiguousCount(&m_Buffer), 3);
+    CHECK_EQ(*(uint8_t*)BufferFront(&m_Buffer), 9);
+}
+
+static void TestSkipPastCountAsserts(void)
+{
+    BufferCreate(&m_Buffer, m_Storage, sizeof(m_Storage), sizeof(uint8_t), false);
+
+    PutRange(0, 2);
+
+    TEST_EXPECT_ASSERT(BufferSkip(&m_Buffer, 3));
+}
+
+static void TestCommitAppendsWrittenData(void)
+{
+    BufferCreate(&m_Buffer, m_Storage, sizeof(m_Storage), sizeof(uint8_t), false);
+
+    /* producer (DMA) writes in place, then publishes */
+    for (uint8_t i = 0; i < 4U; i++)
+    {
+        m_Storage[i] = (uint8_t)(0x40U + i);
+    }
+
+    CHECK(BufferCommit(&m_Buffer, 4));
+    CHECK_EQ(BufferCount(&m_Buffer), 4);
+
+    uint8_t value = 0;
+
+    CHECK(BufferGet(&m_Buffer, &value, sizeof(value)));
+    CHECK_EQ(value, 0x40);
+}
+
+static void TestCommitOverflowKeepsHead(void)
+{
+    BufferCreate(&m_Buffer, m_Storage, sizeof(m_Storage), sizeof(uint8_t), true);
+
+    PutRange(0, 5);
+
+    /* head belongs to the reader, even in overwrite mode */
+    CHECK(!BufferCommit(&m_Buffer, 6));
+    CHECK_EQ(BufferCount(&m_Buffer), 8);
+    CHECK_EQ(*(uint8_t*)BufferFront(&m_Buffer), 0);
+
+    CHECK(!BufferCommit(&m_Buffer, 1));
+    CHECK_EQ(BufferCount(&m_Buffer), 8);
+}
+
+static const Test_t m_Tests[] = {
+    TEST(TestPutGetKeepsOrder),
+    TEST(TestFullRejectsNewData),
+    TEST(TestFullOverwritesOldest),
+    TEST(TestContiguousCountStopsAtWrap),
+    TEST(TestSkipPastCountAsserts),
+    TEST(TestCommitAppendsWrittenData),
+    TEST(TestCommitOverflowKeepsHead),
+};
+
+int main(void)
+{
+    return TestRun("buffer", m_Tests, TEST_COUNT(m_Tests), &Setup);
+}
@@ -0,0 +1,26 @@
+#ifndef AVR_SIM_H
+#define AVR_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+
+#include "sim.h"
+#include "sim-gpio.h"
+
+/*Brief: Reset simulated ATmega328P: registers, models, vectors
+ * NOTE: call before every test, trapping is enabled on return; the I bit is
+ * cleared as after a CPU reset, the test enables interrupts with sei()
+ * [in] - hz - CPU clock
+ * [out] - none
+ * */
+void AvrSimReset(uint32_t hz);
+
+/*Brief: Attach I/O port and pin change interrupt model (called by AvrSimReset)
+ * [in] - none
+ * [out] - none
+ * */
+void AvrGpioModelInit(void);
+
+#endif /* AVR_SIM_H */
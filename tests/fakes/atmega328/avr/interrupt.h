@@ -0,0 +1,15 @@
+#ifndef AVR_INTERRUPT_H
+#define AVR_INTERRUPT_H
+
+/* Host stand-in for avr-libc <avr/interrupt.h>: the I bit of SREG is the
+ * global mask of the simulated interrupt controller (see sim.h), vectors are
+ * plain functions dispatched by sim-core.c */
+
+#include "sim.h"
+
+#define sei()               SimIrqMask(false)
+#define cli()               SimIrqMask(true)
+
+#define ISR(vector)         void vector(void)
+
+#endif /* AVR_INTERRUPT_H */
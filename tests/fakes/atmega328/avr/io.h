@@ -0,0 +1,53 @@
+#ifndef AVR_IO_H
+#define AVR_IO_H
+
+/* Host stand-in for avr-libc <avr/io.h> of the ATmega328P: same register,
+ * bit and vector names, data space addresses 0x00 - 0xFF sit in the trapped
+ * register space g_AvrMmio (see mmio.h). Only the registers used by the
+ * drivers are declared */
+
+#include <stdint.h>
+
+#define AVR_MMIO_SIZE       (0x1000U)
+
+extern uint8_t g_AvrMmio[AVR_MMIO_SIZE];
+
+#define _SFR_MEM8(address)  (*(volatile uint8_t*)&g_AvrMmio[(address)])
+#define _SFR_MEM_ADDR(sfr)  ((uintptr_t)&(sfr) - (uintptr_t)g_AvrMmio)
+
+/* I/O ports */
+#define PINB                _SFR_MEM8(0x23)
+#define DDRB                _SFR_MEM8(0x24)
+#define PORTB               _SFR_MEM8(0x25)
+#define PINC                _SFR_MEM8(0x26)
+#define DDRC                _SFR_MEM8(0x27)
+#define PORTC               _SFR_MEM8(0x28)
+#define PIND                _SFR_MEM8(0x29)
+#define DDRD                _SFR_MEM8(0x2A)
+#define PORTD               _SFR_MEM8(0x2B)
+
+/* pin change interrupts */
+#define PCIFR               _SFR_MEM8(0x3B)
+#define PCICR               _SFR_MEM8(0x68)
+#define PCMSK0              _SFR_MEM8(0x6B)
+#define PCMSK1              _SFR_MEM8(0x6C)
+#define PCMSK2              _SFR_MEM8(0x6D)
+
+#define PCIF0               (0)
+#define PCIF1               (1)
+#define PCIF2               (2)
+
+#define PCIE0               (0)
+#define PCIE1               (1)
+#define PCIE2               (2)
+
+/* interrupt vectors, number is the vector table slot */
+#define PCINT0_vect_num     (3)
+#define PCINT1_vect_num     (4)
+#define PCINT2_vect_num     (5)
+
+#define PCINT0_vect         __vector_3
+#define PCINT1_vect         __vector_4
+#define PCINT2_vect         __vector_5
+
+#endif /* AVR_IO_H */
@@ -0,0 +1,80 @@
+#include <stddef.h>
+
+#include <avr/io.h>
+
+#include "mmio.h"
+#include "sim.h"
+#include "avr-sim.h"
+
+/* page aligned, so the whole data space can be trapped */
+uint8_t g_AvrMmio[AVR_MMIO_SIZE] __attribute__((aligned(4096)));
+
+/* vectors are weak: a test links only the drivers it needs */
+#define SIM_VECTOR(name)    extern void name(void) __attribute__((weak))
+
+SIM_VECTOR(PCINT0_vect);
+SIM_VECTOR(PCINT1_vect);
+SIM_VECTOR(PCINT2_vect);
+
+/*Brief: Take pin change vector, flag is cleared by hardware on entry
+ * [in] - flag - PCIFR bit
+ * [in] - vector - ISR of the driver, may be NULL
+ * [out] - none
+ * */
+static void AvrSimPinChange(uint8_t flag, void (*vector)(void))
+{
+    MmioOpen();
+    PCIFR &= (uint8_t)~(1U << flag);
+    MmioClose();
+
+    if (vector != NULL)
+    {
+        (*vector)();
+    }
+}
+
+static void AvrSimPcint0(void)
+{
+    AvrSimPinChange(PCIF0, PCINT0_vect);
+}
+
+static void AvrSimPcint1(void)
+{
+    AvrSimPinChange(PCIF1, PCINT1_vect);
+}
+
+static void AvrSimPcint2(void)
+{
+    AvrSimPinChange(PCIF2, PCINT2_vect);
+}
+
+static const struct
+{
+    uint32_t irq;
+    SimIrqHandler_t handler;
+} m_AvrVectors[] = {
+    { PCINT0_vect_num, &AvrSimPcint0 },
+    { PCINT1_vect_num, &AvrSimPcint1 },
+    { PCINT2_vect_num, &AvrSimPcint2 },
+};
+
+void AvrSimReset(uint32_t hz)
+{
+    MmioRegion(g_AvrMmio, sizeof(g_AvrMmio));
+    MmioReset();
+
+    SimReset(hz);
+
+    /* no per vector enable on AVR: the peripheral enable bits and the I bit gate them */
+    for (uint32_t i = 0; i < sizeof(m_AvrVectors) / sizeof(m_AvrVectors[0]); i++)
+    {
+        SimIrqSetHandler(m_AvrVectors[i].irq, m_AvrVectors[i].handler);
+        SimIrqEnable(m_AvrVectors[i].irq, true);
+    }
+
+    SimIrqMask(true);
+
+    AvrGpioModelInit();
+
+    MmioTrap(true);
+}
@@ -0,0 +1,216 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "mmio.h"
+#include "avr-sim.h"
+
+#define SIM_GPIO_PORTS          (3U)
+#define SIM_GPIO_PINS           (8U)
+
+typedef enum
+{
+    SIM_GPIO_EXT_NONE = 0,
+    SIM_GPIO_EXT_LOW,
+    SIM_GPIO_EXT_HIGH
+} SIM_GPIO_EXT;
+
+typedef struct
+{
+    volatile uint8_t* pinReg;
+    volatile uint8_t* ddr;
+    volatile uint8_t* port;
+    volatile uint8_t* pcmsk;
+    uint8_t pcif;               /* PCIFR flag of the port */
+    uint8_t pins;               /* bonded out pins */
+} SimGpioPort_t;
+
+/* ATmega328P datasheet 14.4 and 13.2: port B - PCINT0, C - PCINT1, D - PCINT2 */
+static const SimGpioPort_t m_SimGpioPorts[SIM_GPIO_PORTS] = {
+    { &PINB, &DDRB, &PORTB, &PCMSK0, PCIF0, 0xFF },
+    { &PINC, &DDRC, &PORTC, &PCMSK1, PCIF1, 0x7F },
+    { &PIND, &DDRD, &PORTD, &PCMSK2, PCIF2, 0xFF },
+};
+
+static uint8_t m_SimGpioExternal[SIM_GPIO_PORTS][SIM_GPIO_PINS];
+
+/*Brief: Resolve pad level of one pin, register space must be open
+ * */
+static bool SimGpioPad(uint32_t portIndex, uint32_t pin, bool* driven)
+{
+    const SimGpioPort_t* map = &m_SimGpioPorts[portIndex];
+    uint8_t bit = (uint8_t)(1U << pin);
+    bool out = (*map->port & bit) != 0U;
+
+    *driven = false;
+
+    if ((*map->ddr & bit) != 0U)
+    {
+        *driven = true;
+        return out;
+    }
+
+    switch (m_SimGpioExternal[portIndex][pin])
+    {
+        case SIM_GPIO_EXT_LOW:
+            return false;
+
+        case SIM_GPIO_EXT_HIGH:
+            return true;
+
+        default:
+            /* PORTx bit of an input is the pull-up */
+            return out;
+    }
+}
+
+/*Brief: Recompute PINx of all ports and latch pin change flags, register space must be open
+ * */
+static void SimGpioUpdate(void)
+{
+    for (uint32_t p = 0; p < SIM_GPIO_PORTS; p++)
+    {
+        const SimGpioPort_t* map = &m_SimGpioPorts[p];
+        uint8_t level = 0;
+
+        for (uint32_t i = 0; i < SIM_GPIO_PINS; i++)
+        {
+            bool driven;
+
+            if (((map->pins >> i) & 0x01U) && SimGpioPad(p, i, &driven))
+            {
+                level |= (uint8_t)(1U << i);
+            }
+        }
+
+        uint8_t changed = (uint8_t)(*map->pinReg ^ level);
+
+        *map->pinReg = level;
+
+        /* any edge of a masked pin, direction is up to the ISR */
+        if ((changed & *map->pcmsk) != 0U)
+        {
+            PCIFR |= (uint8_t)(1U << map->pcif);
+        }
+    }
+}
+
+/*Brief: Byte of the register before the access
+ * */
+static uint8_t SimGpioOldByte(const MmioAccess_t* const access)
+{
+    return (uint8_t)(access->old >> ((access->address & 0x03U) * 8U));
+}
+
+static void SimGpioOnPort(const MmioAccess_t* const access)
+{
+    if (!access->write)
+    {
+        return;
+    }
+
+    for (uint32_t p = 0; p < SIM_GPIO_PORTS; p++)
+    {
+        const SimGpioPort_t* map = &m_SimGpioPorts[p];
+
+        if (access->address == (uintptr_t)map->pinReg)
+        {
+            /* writing 1 to PINx toggles PORTx, PINx itself is read only */
+            *map->port ^= *map->pinReg;
+            *map->pinReg = SimGpioOldByte(access);
+        }
+    }
+
+    SimGpioUpdate();
+}
+
+static void SimGpioOnFlags(const MmioAccess_t* const access)
+{
+    if (access->write)
+    {
+        /* flags are cleared by writing 1 */
+        PCIFR = (uint8_t)(SimGpioOldByte(access) & ~PCIFR);
+    }
+}
+
+static bool SimGpioPinChangeLevel(uint8_t flag)
+{
+    return ((PCIFR & PCICR) & (1U << flag)) != 0U;
+}
+
+static bool SimGpioPcint0(void)
+{
+    return SimGpioPinChangeLevel(PCIF0);
+}
+
+static bool SimGpioPcint1(void)
+{
+    return SimGpioPinChangeLevel(PCIF1);
+}
+
+static bool SimGpioPcint2(void)
+{
+    return SimGpioPinChangeLevel(PCIF2);
+}
+
+void AvrGpioModelInit(void)
+{
+    memset(m_SimGpioExternal, 0, sizeof(m_SimGpioExternal));
+
+    /* PINB .. PORTD */
+    MmioHook(&PINB, 9U, NULL, &SimGpioOnPort);
+    MmioHook(&PCIFR, 1U, NULL, &SimGpioOnFlags);
+
+    SimIrqSetLevel(PCINT0_vect_num, &SimGpioPcint0);
+    SimIrqSetLevel(PCINT1_vect_num, &SimGpioPcint1);
+    SimIrqSetLevel(PCINT2_vect_num, &SimGpioPcint2);
+}
+
+static void SimGpioSetExternal(uint8_t pin, uint8_t state)
+{
+    uint32_t portIndex = (pin >> 3U);
+
+    if (portIndex >= SIM_GPIO_PORTS)
+    {
+        return;
+    }
+
+    m_SimGpioExternal[portIndex][pin & 0x07U] = state;
+
+    MmioOpen();
+    SimGpioUpdate();
+    MmioClose();
+}
+
+void SimGpioDrive(uint8_t pin, bool level)
+{
+    SimGpioSetExternal(pin, level ? SIM_GPIO_EXT_HIGH : SIM_GPIO_EXT_LOW);
+    SimIrqPoll();
+}
+
+void SimGpioRelease(uint8_t pin)
+{
+    SimGpioSetExternal(pin, SIM_GPIO_EXT_NONE);
+    SimIrqPoll();
+}
+
+bool SimGpioLevel(uint8_t pin)
+{
+    bool driven;
+
+    MmioOpen();
+    bool level = SimGpioPad(pin >> 3U, pin & 0x07U, &driven);
+    MmioClose();
+
+    return level;
+}
+
+bool SimGpioDriven(uint8_t pin)
+{
+    bool driven;
+
+    MmioOpen();
+    (void)SimGpioPad(pin >> 3U, pin & 0x07U, &driven);
+    MmioClose();
+
+    return driven;
+}
@@ -0,0 +1,37 @@
+#ifndef UTIL_ATOMIC_H
+#define UTIL_ATOMIC_H
+
+/* Host stand-in for avr-libc <util/atomic.h>: the block runs once with
+ * interrupts masked, the I bit is restored (ATOMIC_RESTORESTATE) or set
+ * (ATOMIC_FORCEON) on exit. Unlike avr-libc, leaving the block by return
+ * or break skips the restore */
+
+#include <stdint.h>
+
+#include "sim.h"
+
+#define ATOMIC_RESTORESTATE     (0U)
+#define ATOMIC_FORCEON          (1U)
+
+static inline uint8_t AvrAtomicEnter(void)
+{
+    uint8_t masked = SimIrqMasked() ? 1U : 0U;
+
+    SimIrqMask(true);
+
+    return masked;
+}
+
+static inline uint8_t AvrAtomicExit(uint8_t type, uint8_t masked)
+{
+    SimIrqMask((type == ATOMIC_RESTORESTATE) && (masked != 0U));
+
+    return 0;
+}
+
+#define ATOMIC_BLOCK(type) \
+    for (uint8_t avrAtomicMasked = AvrAtomicEnter(), avrAtomicOnce = 1U; \
+         avrAtomicOnce != 0U; \
+         avrAtomicOnce = AvrAtomicExit((type), avrAtomicMasked))
+
+#endif /* UTIL_ATOMIC_H */
@@ -0,0 +1,35 @@
+#ifndef CC32XX_SIM_H
+#define CC32XX_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <ti/devices/cc32xx/inc/hw_types.h>
+#include <ti/devices/cc32xx/driverlib/prcm.h>
+
+#include "sim.h"
+#include "sim-gpio.h"
+
+/* Simulated CC32xx at driverlib level: the drivers call the SDK driverlib,
+ * so the models implement its functions instead of trapping registers */
+
+/*Brief: Reset simulated CC32xx: clock gates, models, interrupt controller
+ * NOTE: call before every test
+ * [in] - hz - core clock
+ * [out] - none
+ * */
+void Cc32xxSimReset(uint32_t hz);
+
+/*Brief: Check run mode clock of peripheral
+ * [in] - peripheral - PRCM_xxx
+ * [out] - true - clocked
+ * */
+bool Cc32xxSimClocked(unsigned long peripheral);
+
+/*Brief: Reset GPIO ports and pad configuration (called by Cc32xxSimReset)
+ * [in] - none
+ * [out] - none
+ * */
+void Cc32xxGpioModelInit(void);
+
+#endif /* CC32XX_SIM_H */
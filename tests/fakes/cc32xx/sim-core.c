@@ -0,0 +1,80 @@
+#include <string.h>
+
+#include <ti/devices/cc32xx/inc/hw_ints.h>
+#include <ti/devices/cc32xx/driverlib/interrupt.h>
+
+#include "sim.h"
+#include "cc32xx-sim.h"
+
+#define SIM_PRCM_PERIPHERALS    (32U)
+
+static bool m_SimClocked[SIM_PRCM_PERIPHERALS];
+
+void Cc32xxSimReset(uint32_t hz)
+{
+    SimReset(hz);
+
+    memset(m_SimClocked, 0, sizeof(m_SimClocked));
+
+    Cc32xxGpioModelInit();
+}
+
+bool Cc32xxSimClocked(unsigned long peripheral)
+{
+    return (peripheral < SIM_PRCM_PERIPHERALS) && m_SimClocked[peripheral];
+}
+
+void PRCMPeripheralClkEnable(unsigned long ulPeripheral, unsigned long ulClkFlags)
+{
+    if ((ulPeripheral < SIM_PRCM_PERIPHERALS) && (ulClkFlags & PRCM_RUN_MODE_CLK))
+    {
+        m_SimClocked[ulPeripheral] = true;
+    }
+}
+
+void PRCMPeripheralClkDisable(unsigned long ulPeripheral, unsigned long ulClkFlags)
+{
+    if ((ulPeripheral < SIM_PRCM_PERIPHERALS) && (ulClkFlags & PRCM_RUN_MODE_CLK))
+    {
+        m_SimClocked[ulPeripheral] = false;
+    }
+}
+
+tBoolean IntMasterEnable(void)
+{
+    bool masked = SimIrqMasked();
+
+    SimIrqMask(false);
+
+    return masked;
+}
+
+tBoolean IntMasterDisable(void)
+{
+    bool masked = SimIrqMasked();
+
+    SimIrqMask(true);
+
+    return masked;
+}
+
+void IntRegister(unsigned long ulInterrupt, void (*pfnHandler)(void))
+{
+    /* vector table in RAM */
+    SimIrqSetHandler(ulInterrupt, pfnHandler);
+}
+
+void IntPrioritySet(unsigned long ulInterrupt, unsigned char ucPriority)
+{
+    SimIrqSetPriority(ulInterrupt, ucPriority & INT_PRIORITY_MASK);
+}
+
+void IntEnable(unsigned long ulInterrupt)
+{
+    SimIrqEnable(ulInterrupt, true);
+}
+
+void IntDisable(unsigned long ulInterrupt)
+{
+    SimIrqEnable(ulInterrupt, false);
+}
@@ -0,0 +1,323 @@
+#include <stddef.h>
+#include <string.h>
+
+#include <ti/devices/cc32xx/inc/hw_types.h>
+#include <ti/devices/cc32xx/inc/hw_memmap.h>
+#include <ti/devices/cc32xx/inc/hw_ints.h>
+#include <ti/devices/cc32xx/driverlib/gpio.h>
+#include <ti/devices/cc32xx/driverlib/pin.h>
+#include <ti/devices/cc32xx/driverlib/prcm.h>
+
+#include "custom-assert.h"
+#include "cc32xx-sim.h"
+#include "gpio-name.h"
+
+#define SIM_GPIO_PORTS          (4U)
+#define SIM_GPIO_PINS           (8U)
+#define SIM_GPIO_PADS           (64U)
+#define SIM_GPIO_NO_PAD         (0xFFU)
+
+typedef enum
+{
+    SIM_GPIO_EXT_NONE = 0,
+    SIM_GPIO_EXT_LOW,
+    SIM_GPIO_EXT_HIGH
+} SIM_GPIO_EXT;
+
+/* GPIODATA, GPIODIR and the interrupt registers of one port */
+typedef struct
+{
+    uint8_t data;
+    uint8_t dir;
+    uint8_t is;             /* 1 - level sensitive */
+    uint8_t ibe;            /* 1 - both edges */
+    uint8_t iev;            /* 1 - rising edge / high level */
+    uint8_t im;
+    uint8_t ris;
+    uint8_t level;          /* pad levels at last update */
+} SimGpioPort_t;
+
+typedef struct
+{
+    unsigned long mode;
+    unsigned long strength;
+    unsigned long type;
+} SimGpioPad_t;
+
+/* CC3220 datasheet 4.2: package pin of GPIO 0 - 31, GPIO 18 - 21, 26, 27 are not bonded out */
+static const uint8_t m_SimGpioPadOf[SIM_GPIO_PORTS * SIM_GPIO_PINS] = {
+    PIN_50, PIN_55, PIN_57, PIN_58, PIN_59, PIN_60, PIN_61, PIN_62,
+    PIN_63, PIN_64, PIN_01, PIN_02, PIN_03, PIN_04, PIN_05, PIN_06,
+    PIN_07, PIN_08, SIM_GPIO_NO_PAD, SIM_GPIO_NO_PAD, SIM_GPIO_NO_PAD, SIM_GPIO_NO_PAD, PIN_15, PIN_16,
+    PIN_17, PIN_21, SIM_GPIO_NO_PAD, SIM_GPIO_NO_PAD, PIN_18, PIN_20, PIN_53, PIN_45,
+};
+
+/* GPIO number of the pin names in gpio-name.h */
+static const uint8_t m_SimGpioNumber[PIN_GPIO_MAX] = {
+    [PIN_GPIOA0_0] = 0, [PIN_GPIOA0_1] = 1, [PIN_GPIOA0_2] = 2, [PIN_GPIOA0_3] = 3,
+    [PIN_GPIOA0_4] = 4, [PIN_GPIOA0_5] = 5, [PIN_GPIOA0_6] = 6, [PIN_GPIOA0_7] = 7,
+    [PIN_GPIOA1_0] = 8, [PIN_GPIOA1_1] = 9, [PIN_GPIOA1_2] = 10, [PIN_GPIOA1_3] = 11,
+    [PIN_GPIOA1_4] = 12, [PIN_GPIOA1_5] = 13, [PIN_GPIOA1_6] = 14, [PIN_GPIOA1_7] = 15,
+    [PIN_GPIOA2_0] = 16, [PIN_GPIOA2_1] = 17, [PIN_GPIOA2_6] = 22, [PIN_GPIOA2_7] = 23,
+    [PIN_GPIOA3_0] = 24, [PIN_GPIOA3_1] = 25, [PIN_GPIOA3_4] = 28, [PIN_GPIOA3_5] = 29,
+    [PIN_GPIOA3_6] = 30, [PIN_GPIOA3_7] = 31,
+};
+
+static const unsigned long m_SimGpioClock[SIM_GPIO_PORTS] = {
+    PRCM_GPIOA0, PRCM_GPIOA1, PRCM_GPIOA2, PRCM_GPIOA3
+};
+
+static SimGpioPort_t m_SimGpioPorts[SIM_GPIO_PORTS];
+static SimGpioPad_t m_SimGpioPads[SIM_GPIO_PADS];
+static uint8_t m_SimGpioExternal[SIM_GPIO_PORTS * SIM_GPIO_PINS];
+
+/*Brief: Port of GPIO base address, the port must be clocked
+ * NOTE: access to a gated port is a bus fault on the target
+ * */
+static SimGpioPort_t* SimGpioGetPort(unsigned long base)
+{
+    uint32_t index = (uint32_t)((base - GPIOA0_BASE) >> 12U);
+
+    ASSERT((base >= GPIOA0_BASE) && (index < SIM_GPIO_PORTS) && ((base & 0x0FFFU) == 0U));
+    ASSERT(Cc32xxSimClocked(m_SimGpioClock[index]));
+
+    return &m_SimGpioPorts[index];
+}
+
+/*Brief: Resolve pad level of GPIO
+ * */
+static bool SimGpioPad(uint32_t gpio, bool* driven)
+{
+    const SimGpioPort_t* port = &m_SimGpioPorts[gpio / SIM_GPIO_PINS];
+    uint8_t bit = (uint8_t)(1U << (gpio % SIM_GPIO_PINS));
+    uint8_t padIndex = m_SimGpioPadOf[gpio];
+
+    *driven = false;
+
+    if (padIndex == SIM_GPIO_NO_PAD)
+    {
+        return false;
+    }
+
+    const SimGpioPad_t* pad = &m_SimGpioPads[padIndex];
+    bool openDrain = (pad->type & PIN_TYPE_OD) != 0U;
+    bool out = (port->data & bit) != 0U;
+
+    /* peripheral functions are not modelled, only mode 0 connects the GPIO */
+    if ((pad->mode == PIN_MODE_0) && (port->dir & bit) && (!openDrain || !out))
+    {
+        *driven = true;
+        return out;
+    }
+
+    switch (m_SimGpioExternal[gpio])
+    {
+        case SIM_GPIO_EXT_LOW:
+            return false;
+
+        case SIM_GPIO_EXT_HIGH:
+            return true;
+
+        default:
+            return (pad->type & PIN_TYPE_STD_PU) != 0U;
+    }
+}
+
+/*Brief: Recompute pad levels and latch interrupt status
+ * */
+static void SimGpioUpdate(void)
+{
+    for (uint32_t p = 0; p < SIM_GPIO_PORTS; p++)
+    {
+        SimGpioPort_t* port = &m_SimGpioPorts[p];
+        uint8_t level = 0;
+
+        for (uint32_t i = 0; i < SIM_GPIO_PINS; i++)
+        {
+            bool driven;
+
+            if (SimGpioPad(p * SIM_GPIO_PINS + i, &driven))
+            {
+                level |= (uint8_t)(1U << i);
+            }
+        }
+
+        uint8_t rising = (uint8_t)(level & ~port->level);
+        uint8_t falling = (uint8_t)(~level & port->level);
+
+        uint8_t edges = (uint8_t)((port->ibe & (rising | falling)) |
+                                  (~port->ibe & ((port->iev & rising) | (~port->iev & falling))));
+
+        /* level sensitive pins follow the pad, edges are latched */
+        uint8_t levels = (uint8_t)((port->iev & level) | (~port->iev & ~level));
+
+        port->ris = (uint8_t)((port->ris & ~port->is) | (edges & ~port->is) | (levels & port->is));
+        port->level = level;
+    }
+}
+
+static bool SimGpioIrqLevel(uint32_t port)
+{
+    return (m_SimGpioPorts[port].ris & m_SimGpioPorts[port].im) != 0U;
+}
+
+static bool SimGpioA0(void)
+{
+    return SimGpioIrqLevel(0);
+}
+
+static bool SimGpioA1(void)
+{
+    return SimGpioIrqLevel(1);
+}
+
+static bool SimGpioA2(void)
+{
+    return SimGpioIrqLevel(2);
+}
+
+static bool SimGpioA3(void)
+{
+    return SimGpioIrqLevel(3);
+}
+
+void Cc32xxGpioModelInit(void)
+{
+    memset(m_SimGpioPorts, 0, sizeof(m_SimGpioPorts));
+    memset(m_SimGpioPads, 0, sizeof(m_SimGpioPads));
+    memset(m_SimGpioExternal, 0, sizeof(m_SimGpioExternal));
+
+    SimIrqSetLevel(INT_GPIOA0, &SimGpioA0);
+    SimIrqSetLevel(INT_GPIOA1, &SimGpioA1);
+    SimIrqSetLevel(INT_GPIOA2, &SimGpioA2);
+    SimIrqSetLevel(INT_GPIOA3, &SimGpioA3);
+}
+
+void PinModeSet(unsigned long ulPin, unsigned long ulPinMode)
+{
+    ASSERT(ulPin < SIM_GPIO_PADS);
+
+    m_SimGpioPads[ulPin].mode = ulPinMode;
+
+    SimGpioUpdate();
+}
+
+void PinConfigSet(unsigned long ulPin, unsigned long ulPinStrength, unsigned long ulPinType)
+{
+    ASSERT(ulPin < SIM_GPIO_PADS);
+
+    m_SimGpioPads[ulPin].strength = ulPinStrength;
+    m_SimGpioPads[ulPin].type = ulPinType;
+
+    SimGpioUpdate();
+}
+
+void GPIODirModeSet(unsigned long ulPort, unsigned char ucPins, unsigned long ulPinIO)
+{
+    SimGpioPort_t* port = SimGpioGetPort(ulPort);
+
+    port->dir = (ulPinIO == GPIO_DIR_MODE_OUT) ? (uint8_t)(port->dir | ucPins) : (uint8_t)(port->dir & ~ucPins);
+
+    SimGpioUpdate();
+}
+
+void GPIOIntTypeSet(unsigned long ulPort, unsigned char ucPins, unsigned long ulIntType)
+{
+    SimGpioPort_t* port = SimGpioGetPort(ulPort);
+
+    port->ibe = (ulIntType & 0x01U) ? (uint8_t)(port->ibe | ucPins) : (uint8_t)(port->ibe & ~ucPins);
+    port->is = (ulIntType & 0x02U) ? (uint8_t)(port->is | ucPins) : (uint8_t)(port->is & ~ucPins);
+    port->iev = (ulIntType & 0x04U) ? (uint8_t)(port->iev | ucPins) : (uint8_t)(port->iev & ~ucPins);
+}
+
+void GPIOIntEnable(unsigned long ulPort, unsigned long ulIntFlags)
+{
+    SimGpioPort_t* port = SimGpioGetPort(ulPort);
+
+    port->im |= (uint8_t)ulIntFlags;
+}
+
+void GPIOIntDisable(unsigned long ulPort, unsigned long ulIntFlags)
+{
+    SimGpioPort_t* port = SimGpioGetPort(ulPort);
+
+    port->im &= (uint8_t)~ulIntFlags;
+}
+
+long GPIOIntStatus(unsigned long ulPort, tBoolean bMasked)
+{
+    SimGpioPort_t* port = SimGpioGetPort(ulPort);
+
+    return bMasked ? (port->ris & port->im) : port->ris;
+}
+
+void GPIOIntClear(unsigned long ulPort, unsigned long ulIntFlags)
+{
+    SimGpioPort_t* port = SimGpioGetPort(ulPort);
+
+    /* a level sensitive pin asserts again while the level lasts */
+    port->ris &= (uint8_t)~ulIntFlags;
+
+    SimGpioUpdate();
+}
+
+long GPIOPinRead(unsigned long ulPort, unsigned char ucPins)
+{
+    SimGpioPort_t* port = SimGpioGetPort(ulPort);
+
+    /* input buffers stay enabled: output pins read back the pad */
+    return port->level & ucPins;
+}
+
+void GPIOPinWrite(unsigned long ulPort, unsigned char ucPins, unsigned char ucVal)
+{
+    SimGpioPort_t* port = SimGpioGetPort(ulPort);
+
+    /* GPIODATA is address masked: only ucPins are written */
+    port->data = (uint8_t)((port->data & ~ucPins) | (ucVal & ucPins));
+
+    SimGpioUpdate();
+}
+
+static void SimGpioSetExternal(uint8_t pin, uint8_t state)
+{
+    if (pin >= PIN_GPIO_MAX)
+    {
+        return;
+    }
+
+    m_SimGpioExternal[m_SimGpioNumber[pin]] = state;
+
+    SimGpioUpdate();
+}
+
+void SimGpioDrive(uint8_t pin, bool level)
+{
+    SimGpioSetExternal(pin, level ? SIM_GPIO_EXT_HIGH : SIM_GPIO_EXT_LOW);
+    SimIrqPoll();
+}
+
+void SimGpioRelease(uint8_t pin)
+{
+    SimGpioSetExternal(pin, SIM_GPIO_EXT_NONE);
+    SimIrqPoll();
+}
+
+bool SimGpioLevel(uint8_t pin)
+{
+    bool driven;
+
+    return (pin < PIN_GPIO_MAX) && SimGpioPad(m_SimGpioNumber[pin], &driven);
+}
+
+bool SimGpioDriven(uint8_t pin)
+{
+    bool driven = false;
+
+    if (pin < PIN_GPIO_MAX)
+    {
+        (void)SimGpioPad(m_SimGpioNumber[pin], &driven);
+    }
+
+    return driven;
+}
@@ -0,0 +1,16 @@
+#ifndef __INTERRUPT_H__
+#define __INTERRUPT_H__
+
+/* Host stand-in for driverlib/interrupt.h, served by tests/fakes/cc32xx/sim-core.c
+ * on the simulated interrupt controller (see sim.h) */
+
+#include "../inc/hw_types.h"
+
+extern tBoolean IntMasterEnable(void);
+extern tBoolean IntMasterDisable(void);
+extern void IntRegister(unsigned long ulInterrupt, void (*pfnHandler)(void));
+extern void IntPrioritySet(unsigned long ulInterrupt, unsigned char ucPriority);
+extern void IntEnable(unsigned long ulInterrupt);
+extern void IntDisable(unsigned long ulInterrupt);
+
+#endif /* __INTERRUPT_H__ */
@@ -0,0 +1,106 @@
+#ifndef __PIN_H__
+#define __PIN_H__
+
+/* Host stand-in for driverlib/pin.h, served by tests/fakes/cc32xx/sim-gpio.c */
+
+#include "../inc/hw_types.h"
+
+/* package pins */
+#define PIN_01                  0x00000000
+#define PIN_02                  0x00000001
+#define PIN_03                  0x00000002
+#define PIN_04                  0x00000003
+#define PIN_05                  0x00000004
+#define PIN_06                  0x00000005
+#define PIN_07                  0x00000006
+#define PIN_08                  0x00000007
+#define PIN_09                  0x00000008
+#define PIN_10                  0x00000009
+#define PIN_11                  0x0000000A
+#define PIN_12                  0x0000000B
+#define PIN_13                  0x0000000C
+#define PIN_14                  0x0000000D
+#define PIN_15                  0x0000000E
+#define PIN_16                  0x0000000F
+#define PIN_17                  0x00000010
+#define PIN_18                  0x00000011
+#define PIN_19                  0x00000012
+#define PIN_20                  0x00000013
+#define PIN_21                  0x00000014
+#define PIN_22                  0x00000015
+#define PIN_23                  0x00000016
+#define PIN_24                  0x00000017
+#define PIN_25                  0x00000018
+#define PIN_26                  0x00000019
+#define PIN_27                  0x0000001A
+#define PIN_28                  0x0000001B
+#define PIN_29                  0x0000001C
+#define PIN_30                  0x0000001D
+#define PIN_31                  0x0000001E
+#define PIN_32                  0x0000001F
+#define PIN_33                  0x00000020
+#define PIN_34                  0x00000021
+#define PIN_35                  0x00000022
+#define PIN_36                  0x00000023
+#define PIN_37                  0x00000024
+#define PIN_38                  0x00000025
+#define PIN_39                  0x00000026
+#define PIN_40                  0x00000027
+#define PIN_41                  0x00000028
+#define PIN_42                  0x00000029
+#define PIN_43                  0x0000002A
+#define PIN_44                  0x0000002B
+#define PIN_45                  0x0000002C
+#define PIN_46                  0x0000002D
+#define PIN_47                  0x0000002E
+#define PIN_48                  0x0000002F
+#define PIN_49                  0x00000030
+#define PIN_50                  0x00000031
+#define PIN_51                  0x00000032
+#define PIN_52                  0x00000033
+#define PIN_53                  0x00000034
+#define PIN_54                  0x00000035
+#define PIN_55                  0x00000036
+#define PIN_56                  0x00000037
+#define PIN_57                  0x00000038
+#define PIN_58                  0x00000039
+#define PIN_59                  0x0000003A
+#define PIN_60                  0x0000003B
+#define PIN_61                  0x0000003C
+#define PIN_62                  0x0000003D
+#define PIN_63                  0x0000003E
+#define PIN_64                  0x0000003F
+
+#define PIN_MODE_0              0x00000000
+#define PIN_MODE_1              0x00000001
+#define PIN_MODE_2              0x00000002
+#define PIN_MODE_3              0x00000003
+#define PIN_MODE_4              0x00000004
+#define PIN_MODE_5              0x00000005
+#define PIN_MODE_6              0x00000006
+#define PIN_MODE_7              0x00000007
+#define PIN_MODE_8              0x00000008
+#define PIN_MODE_9              0x00000009
+#define PIN_MODE_10             0x0000000A
+#define PIN_MODE_11             0x0000000B
+#define PIN_MODE_12             0x0000000C
+#define PIN_MODE_13             0x0000000D
+#define PIN_MODE_14             0x0000000E
+#define PIN_MODE_15             0x0000000F
+
+#define PIN_STRENGTH_2MA        0x00000020
+#define PIN_STRENGTH_4MA        0x00000040
+#define PIN_STRENGTH_6MA        0x00000060
+
+#define PIN_TYPE_STD            0x00000000
+#define PIN_TYPE_STD_PU         0x00000100
+#define PIN_TYPE_STD_PD         0x00000200
+#define PIN_TYPE_OD             0x00000010
+#define PIN_TYPE_OD_PU          0x00000110
+#define PIN_TYPE_OD_PD          0x00000210
+#define PIN_TYPE_ANALOG         0x10000000
+
+extern void PinModeSet(unsigned long ulPin, unsigned long ulPinMode);
+extern void PinConfigSet(unsigned long ulPin, unsigned long ulPinStrength, unsigned long ulPinType);
+
+#endif /* __PIN_H__ */
@@ -0,0 +1,20 @@
+#ifndef __PRCM_H__
+#define __PRCM_H__
+
+/* Host stand-in for driverlib/prcm.h, served by tests/fakes/cc32xx/sim-core.c */
+
+#include "../inc/hw_types.h"
+
+#define PRCM_RUN_MODE_CLK       0x00000001
+#define PRCM_SLP_MODE_CLK       0x00000100
+#define PRCM_DSLP_MODE_CLK      0x00010000
+
+#define PRCM_GPIOA0             0x00000007
+#define PRCM_GPIOA1             0x00000008
+#define PRCM_GPIOA2             0x00000009
+#define PRCM_GPIOA3             0x0000000A
+
+extern void PRCMPeripheralClkEnable(unsigned long ulPeripheral, unsigned long ulClkFlags);
+extern void PRCMPeripheralClkDisable(unsigned long ulPeripheral, unsigned long ulClkFlags);
+
+#endif /* __PRCM_H__ */
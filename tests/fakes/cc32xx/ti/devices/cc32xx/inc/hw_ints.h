@@ -0,0 +1,22 @@
+#ifndef __HW_INTS_H__
+#define __HW_INTS_H__
+
+#define INT_GPIOA0              16
+#define INT_GPIOA1              17
+#define INT_GPIOA2              18
+#define INT_GPIOA3              19
+
+#define NUM_INTERRUPTS          83
+
+/* 3 priority bits, lower value wins */
+#define INT_PRIORITY_MASK       0x000000E0
+#define INT_PRIORITY_LVL_0      0x00000000
+#define INT_PRIORITY_LVL_1      0x00000020
+#define INT_PRIORITY_LVL_2      0x00000040
+#define INT_PRIORITY_LVL_3      0x00000060
+#define INT_PRIORITY_LVL_4      0x00000080
+#define INT_PRIORITY_LVL_5      0x000000A0
+#define INT_PRIORITY_LVL_6      0x000000C0
+#define INT_PRIORITY_LVL_7      0x000000E0
+
+#endif /* __HW_INTS_H__ */
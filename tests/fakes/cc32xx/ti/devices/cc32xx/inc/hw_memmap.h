@@ -0,0 +1,9 @@
+#ifndef __HW_MEMMAP_H__
+#define __HW_MEMMAP_H__
+
+#define GPIOA0_BASE             0x40004000
+#define GPIOA1_BASE             0x40005000
+#define GPIOA2_BASE             0x40006000
+#define GPIOA3_BASE             0x40007000
+
+#endif /* __HW_MEMMAP_H__ */
@@ -0,0 +1,14 @@
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+
+/* Host stand-in for the CC32xx SDK inc/ headers: names and values of the
+ * definitions used by the drivers. There is no register space behind the
+ * base addresses, driverlib calls are served by the models in
+ * tests/fakes/cc32xx */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef unsigned char tBoolean;
+
+#endif /* __HW_TYPES_H__ */
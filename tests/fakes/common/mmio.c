@@ -0,0 +1,265 @@
+#define _GNU_SOURCE
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#include "mmio.h"
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "register traps need x86-64 Linux (page faults + trap flag single step)"
+#endif
+
+#define MMIO_REGION_MAX     (4U)
+#define MMIO_HOOK_MAX       (96U)
+
+#define MMIO_PAGE_SIZE      (4096U)
+
+/* x86 page fault error code: access was a write */
+#define MMIO_PF_WRITE       (1UL << 1)
+
+/* x86 EFLAGS trap flag: single step */
+#define MMIO_EFLAGS_TF      (1UL << 8)
+
+typedef struct
+{
+    uint8_t* base;
+    size_t size;
+} MmioRegion_t;
+
+typedef struct
+{
+    uintptr_t start;
+    uintptr_t end;
+    MmioHook_t before;
+    MmioHook_t after;
+} MmioHookEntry_t;
+
+static MmioRegion_t m_MmioRegions[MMIO_REGION_MAX];
+static uint32_t m_MmioRegionCount;
+
+static MmioHookEntry_t m_MmioHooks[MMIO_HOOK_MAX];
+static uint32_t m_MmioHookCount;
+
+static void (*m_MmioAccessHook)(void);
+
+static volatile bool m_MmioTrap;
+static volatile uint32_t m_MmioDepth;
+static volatile uint64_t m_MmioAccesses;
+
+/* access being single stepped */
+static MmioAccess_t m_MmioPending;
+static volatile bool m_MmioStepping;
+
+static bool m_MmioInstalled;
+
+static void MmioProtect(int protection)
+{
+    for (uint32_t i = 0; i < m_MmioRegionCount; i++)
+    {
+        mprotect(m_MmioRegions[i].base, m_MmioRegions[i].size, protection);
+    }
+}
+
+static bool MmioContains(uintptr_t address)
+{
+    for (uint32_t i = 0; i < m_MmioRegionCount; i++)
+    {
+        uintptr_t base = (uintptr_t)m_MmioRegions[i].base;
+
+        if ((address >= base) && (address < (base + m_MmioRegions[i].size)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void MmioRunHooks(const MmioAccess_t* const access, bool before)
+{
+    for (uint32_t i = 0; i < m_MmioHookCount; i++)
+    {
+        const MmioHookEntry_t* hook = &m_MmioHooks[i];
+
+        if ((access->address < hook->start) || (access->address >= hook->end))
+        {
+            continue;
+        }
+
+        MmioHook_t function = before ? hook->before : hook->after;
+
+        if (function != NULL)
+        {
+            (*function)(access);
+        }
+    }
+}
+
+static void MmioOnFault(int signal, siginfo_t* info, void* context)
+{
+    ucontext_t* uc = (ucontext_t*)context;
+    uintptr_t address = (uintptr_t)info->si_addr;
+
+    (void)signal;
+
+    if (!MmioContains(address) || m_MmioStepping)
+    {
+        /* real crash: let it happen with the default action */
+        struct sigaction action = { .sa_handler = SIG_DFL };
+
+        sigaction(SIGSEGV, &action, NULL);
+        return;
+    }
+
+    MmioOpen();
+
+    m_MmioPending.address = address;
+    m_MmioPending.write = (uc->uc_mcontext.gregs[REG_ERR] & MMIO_PF_WRITE) != 0;
+    m_MmioPending.old = *(volatile uint32_t*)(address & ~(uintptr_t)3U);
+    m_MmioStepping = true;
+
+    MmioRunHooks(&m_MmioPending, true);
+
+    /* execute the faulting instruction only, then trap back */
+    uc->uc_mcontext.gregs[REG_EFL] |= MMIO_EFLAGS_TF;
+}
+
+static void MmioOnStep(int signal, siginfo_t* info, void* context)
+{
+    ucontext_t* uc = (ucontext_t*)context;
+
+    (void)signal;
+    (void)info;
+
+    if (!m_MmioStepping)
+    {
+        return;
+    }
+
+    uc->uc_mcontext.gregs[REG_EFL] &= ~MMIO_EFLAGS_TF;
+
+    m_MmioStepping = false;
+    m_MmioAccesses++;
+
+    MmioRunHooks(&m_MmioPending, false);
+
+    if (m_MmioAccessHook != NULL)
+    {
+        (*m_MmioAccessHook)();
+    }
+
+    MmioClose();
+}
+
+static void MmioInstall(void)
+{
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_SIGINFO;
+
+    action.sa_sigaction = &MmioOnFault;
+    sigaction(SIGSEGV, &action, NULL);
+
+    action.sa_sigaction = &MmioOnStep;
+    sigaction(SIGTRAP, &action, NULL);
+
+    m_MmioInstalled = true;
+}
+
+void MmioRegion(void* base, size_t size)
+{
+    if (!m_MmioInstalled)
+    {
+        MmioInstall();
+    }
+
+    for (uint32_t i = 0; i < m_MmioRegionCount; i++)
+    {
+        if (m_MmioRegions[i].base == base)
+        {
+            return;
+        }
+    }
+
+    if ((((uintptr_t)base % MMIO_PAGE_SIZE) != 0U) || ((size % MMIO_PAGE_SIZE) != 0U)
+        || (m_MmioRegionCount >= MMIO_REGION_MAX))
+    {
+        abort();
+    }
+
+    m_MmioRegions[m_MmioRegionCount].base = base;
+    m_MmioRegions[m_MmioRegionCount].size = size;
+    m_MmioRegionCount++;
+}
+
+void MmioHook(volatile const void* reg, size_t size, MmioHook_t before, MmioHook_t after)
+{
+    if (m_MmioHookCount >= MMIO_HOOK_MAX)
+    {
+        abort();
+    }
+
+    m_MmioHooks[m_MmioHookCount].start = (uintptr_t)reg;
+    m_MmioHooks[m_MmioHookCount].end = (uintptr_t)reg + size;
+    m_MmioHooks[m_MmioHookCount].before = before;
+    m_MmioHooks[m_MmioHookCount].after = after;
+    m_MmioHookCount++;
+}
+
+void MmioSetAccessHook(void (*hook)(void))
+{
+    m_MmioAccessHook = hook;
+}
+
+void MmioTrap(bool enable)
+{
+    m_MmioTrap = enable;
+
+    if (m_MmioDepth == 0U)
+    {
+        MmioProtect(enable ? PROT_NONE : (PROT_READ | PROT_WRITE));
+    }
+}
+
+void MmioOpen(void)
+{
+    if (m_MmioDepth++ == 0U)
+    {
+        MmioProtect(PROT_READ | PROT_WRITE);
+    }
+}
+
+void MmioClose(void)
+{
+    if ((--m_MmioDepth == 0U) && m_MmioTrap)
+    {
+        MmioProtect(PROT_NONE);
+    }
+}
+
+void MmioReset(void)
+{
+    m_MmioTrap = false;
+    m_MmioDepth = 0;
+    m_MmioStepping = false;
+    m_MmioAccesses = 0;
+    m_MmioHookCount = 0;
+    m_MmioAccessHook = NULL;
+
+    MmioProtect(PROT_READ | PROT_WRITE);
+
+    for (uint32_t i = 0; i < m_MmioRegionCount; i++)
+    {
+        memset(m_MmioRegions[i].base, 0, m_MmioRegions[i].size);
+    }
+}
+
+uint64_t MmioAccessCount(void)
+{
+    return m_MmioAccesses;
+}
@@ -0,0 +1,80 @@
+#ifndef MMIO_H
+#define MMIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Trapped register space for peripheral models (x86-64 Linux only).
+ * Register blocks live in page aligned arrays that are kept inaccessible;
+ * every load or store of the code under test faults, the access is single
+ * stepped with the page opened and the hooks of the touched register run
+ * around it. Read-to-clear flags, write-1-to-clear flags, data registers
+ * feeding shift registers and DMA requests are modelled this way without
+ * touching the driver sources.
+ * Hooks run in signal context: they may change registers and model state and
+ * pend interrupts (see sim.h), but must never call the code under test. */
+
+typedef struct
+{
+    uintptr_t address;      /* accessed byte address */
+    uint32_t old;           /* aligned 32-bit word before the access */
+    bool write;
+} MmioAccess_t;
+
+typedef void (*MmioHook_t)(const MmioAccess_t* const access);
+
+/*Brief: Register page aligned array as trapped register space
+ * [in] - base - array start, page aligned
+ * [in] - size - array size, multiple of page size
+ * [out] - none
+ * */
+void MmioRegion(void* base, size_t size);
+
+/*Brief: Attach hooks to register range
+ * [in] - reg - first register
+ * [in] - size - range size in bytes
+ * [in] - before - called before the access executes (e.g. to latch read value), may be NULL
+ * [in] - after - called after the access executed, may be NULL
+ * [out] - none
+ * */
+void MmioHook(volatile const void* reg, size_t size, MmioHook_t before, MmioHook_t after);
+
+/*Brief: Callback run after every trapped access (time accounting)
+ * [in] - hook - callback, NULL - none
+ * [out] - none
+ * */
+void MmioSetAccessHook(void (*hook)(void));
+
+/*Brief: Enable or disable trapping (disabled - registers are plain memory)
+ * [in] - enable - true - accesses are trapped
+ * [out] - none
+ * */
+void MmioTrap(bool enable);
+
+/*Brief: Open register space for direct model access (nests)
+ * [in] - none
+ * [out] - none
+ * */
+void MmioOpen(void);
+
+/*Brief: Close register space opened by MmioOpen
+ * [in] - none
+ * [out] - none
+ * */
+void MmioClose(void);
+
+/*Brief: Drop all hooks and regions contents (between tests)
+ * NOTE: regions are zeroed, trapping is disabled
+ * [in] - none
+ * [out] - none
+ * */
+void MmioReset(void);
+
+/*Brief: Number of trapped accesses since reset
+ * [in] - none
+ * [out] - access count
+ * */
+uint64_t MmioAccessCount(void);
+
+#endif /* MMIO_H */
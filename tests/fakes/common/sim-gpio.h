@@ -0,0 +1,38 @@
+#ifndef SIM_GPIO_H
+#define SIM_GPIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Board side of the simulated pads, implemented by every platform model.
+ * Pins are the platform names from gpio-name.h. The external driver is
+ * weaker than the MCU: a pin driven by the MCU keeps the MCU level, a
+ * released open-drain or input pin follows the external driver, then the
+ * internal pull, and reads low when floating. */
+
+/*Brief: Drive pad from outside (other device, button, scope probe)
+ * [in] - pin - pin name
+ * [in] - level - true - high
+ * [out] - none
+ * */
+void SimGpioDrive(uint8_t pin, bool level);
+
+/*Brief: Stop driving pad from outside
+ * [in] - pin - pin name
+ * [out] - none
+ * */
+void SimGpioRelease(uint8_t pin);
+
+/*Brief: Level on the pad
+ * [in] - pin - pin name
+ * [out] - true - high
+ * */
+bool SimGpioLevel(uint8_t pin);
+
+/*Brief: Check if MCU drives the pad
+ * [in] - pin - pin name
+ * [out] - true - pad is an output driven by MCU (open-drain only when low)
+ * */
+bool SimGpioDriven(uint8_t pin);
+
+#endif /* SIM_GPIO_H */
@@ -0,0 +1,61 @@
+#include <stddef.h>
+
+#include "custom-assert.h"
+#include "sim.h"
+#include "timebase.h"
+
+/* timebase/timebase.c on the simulated core: ticks are core cycles of the
+ * virtual clock, every read costs time and is an interrupt window, so
+ * bounded waits make progress and see interrupts as on the target */
+
+void TimebaseInit(void)
+{
+}
+
+uint32_t TimebaseNow(void)
+{
+    SimClockAdvance(SimClockPollCost());
+    SimIrqPoll();
+
+    return (uint32_t)SimClockNow();
+}
+
+uint32_t TimebaseUsToTicks(uint32_t usec)
+{
+    uint32_t ticksInUs = SimClockHz() / 1000000U;
+
+    if (usec > (UINT32_MAX / ticksInUs))
+    {
+        return UINT32_MAX;
+    }
+
+    return usec * ticksInUs;
+}
+
+uint32_t TimebaseTicksToUs(uint32_t ticks)
+{
+    return ticks / (SimClockHz() / 1000000U);
+}
+
+bool TimebaseElapsed(uint32_t start, uint32_t ticks)
+{
+    return (uint32_t)(TimebaseNow() - start) >= ticks;
+}
+
+bool TimebaseWaitFlag(volatile const uint32_t* const reg, uint32_t flag, bool state, uint32_t timeoutUs)
+{
+    ASSERT(reg != NULL);
+
+    uint32_t start = TimebaseNow();
+    uint32_t ticks = TimebaseUsToTicks(timeoutUs);
+
+    while (((*reg & flag) != 0) != state)
+    {
+        if (TimebaseElapsed(start, ticks))
+        {
+            return ((*reg & flag) != 0) == state;
+        }
+    }
+
+    return true;
+}
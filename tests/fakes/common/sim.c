@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mmio.h"
+#include "sim.h"
+
+#define SIM_MODEL_MAX           (16U)
+
+/* handler runs in one poll before the line is considered stuck */
+#define SIM_IRQ_STORM           (1000000U)
+
+/* time slice of SimClockRun */
+#define SIM_RUN_STEP            (16U)
+
+typedef struct
+{
+    SimIrqHandler_t handler;
+    SimIrqLevel_t level;
+    uint32_t priority;
+    uint32_t count;
+    bool enabled;
+    volatile bool pending;
+} SimIrq_t;
+
+static uint32_t m_SimHz;
+static volatile uint64_t m_SimNow;
+static uint32_t m_SimAccessCycles;
+static uint32_t m_SimPollCycles;
+
+static SimModel_t m_SimModels[SIM_MODEL_MAX];
+static uint32_t m_SimModelCount;
+static bool m_SimStepping;
+
+static SimIrq_t m_SimIrq[SIM_IRQ_MAX];
+static volatile bool m_SimIrqMasked;
+static bool m_SimIrqActive;
+
+static void SimOnAccess(void)
+{
+    SimClockAdvance(m_SimAccessCycles);
+}
+
+void SimReset(uint32_t hz)
+{
+    m_SimHz = hz;
+    m_SimNow = 0;
+    m_SimAccessCycles = SIM_ACCESS_CYCLES;
+    m_SimPollCycles = SIM_POLL_CYCLES;
+    m_SimModelCount = 0;
+    m_SimStepping = false;
+
+    memset(m_SimIrq, 0, sizeof(m_SimIrq));
+    m_SimIrqMasked = false;
+    m_SimIrqActive = false;
+
+    MmioSetAccessHook(&SimOnAccess);
+}
+
+uint32_t SimClockHz(void)
+{
+    return m_SimHz;
+}
+
+uint64_t SimClockNow(void)
+{
+    return m_SimNow;
+}
+
+uint64_t SimClockUs(uint32_t usec)
+{
+    return (uint64_t)usec * (m_SimHz / 1000000U);
+}
+
+void SimClockAdvance(uint64_t cycles)
+{
+    m_SimNow += cycles;
+
+    /* models touching registers may trap back here */
+    if (m_SimStepping)
+    {
+        return;
+    }
+
+    m_SimStepping = true;
+    MmioOpen();
+
+    for (uint32_t i = 0; i < m_SimModelCount; i++)
+    {
+        (*m_SimModels[i])(m_SimNow);
+    }
+
+    MmioClose();
+    m_SimStepping = false;
+}
+
+void SimClockRun(uint64_t cycles)
+{
+    uint64_t end = m_SimNow + cycles;
+
+    SimIrqPoll();
+
+    while (m_SimNow < end)
+    {
+        uint64_t step = end - m_SimNow;
+
+        SimClockAdvance((step < SIM_RUN_STEP) ? step : SIM_RUN_STEP);
+        SimIrqPoll();
+    }
+}
+
+bool SimClockRunUntil(bool (*done)(void* context), void* context, uint64_t maxCycles)
+{
+    uint64_t end = m_SimNow + maxCycles;
+
+    SimIrqPoll();
+
+    while (!(*done)(context))
+    {
+        if (m_SimNow >= end)
+        {
+            return false;
+        }
+
+        SimClockAdvance(SIM_RUN_STEP);
+        SimIrqPoll();
+    }
+
+    return true;
+}
+
+void SimClockSetCost(uint32_t access, uint32_t poll)
+{
+    m_SimAccessCycles = access;
+    m_SimPollCycles = poll;
+}
+
+uint32_t SimClockPollCost(void)
+{
+    return m_SimPollCycles;
+}
+
+void SimClockAddModel(SimModel_t model)
+{
+    if (m_SimModelCount >= SIM_MODEL_MAX)
+    {
+        abort();
+    }
+
+    m_SimModels[m_SimModelCount++] = model;
+}
+
+void SimIrqSetHandler(uint32_t irq, SimIrqHandler_t handler)
+{
+    if (irq < SIM_IRQ_MAX)
+    {
+        m_SimIrq[irq].handler = handler;
+    }
+}
+
+void SimIrqSetLevel(uint32_t irq, SimIrqLevel_t level)
+{
+    if (irq < SIM_IRQ_MAX)
+    {
+        m_SimIrq[irq].level = level;
+    }
+}
+
+void SimIrqEnable(uint32_t irq, bool enable)
+{
+    if (irq < SIM_IRQ_MAX)
+    {
+        m_SimIrq[irq].enabled = enable;
+    }
+
+    if (enable)
+    {
+        SimIrqPoll();
+    }
+}
+
+bool SimIrqEnabled(uint32_t irq)
+{
+    return (irq < SIM_IRQ_MAX) && m_SimIrq[irq].enabled;
+}
+
+void SimIrqSetPriority(uint32_t irq, uint32_t priority)
+{
+    if (irq < SIM_IRQ_MAX)
+    {
+        m_SimIrq[irq].priority = priority;
+    }
+}
+
+uint32_t SimIrqPriority(uint32_t irq)
+{
+    return (irq < SIM_IRQ_MAX) ? m_SimIrq[irq].priority : 0;
+}
+
+void SimIrqPend(uint32_t irq)
+{
+    if (irq < SIM_IRQ_MAX)
+    {
+        m_SimIrq[irq].pending = true;
+    }
+}
+
+void SimIrqUnpend(uint32_t irq)
+{
+    if (irq < SIM_IRQ_MAX)
+    {
+        m_SimIrq[irq].pending = false;
+    }
+}
+
+void SimIrqMask(bool masked)
+{
+    m_SimIrqMasked = masked;
+
+    if (!masked)
+    {
+        SimIrqPoll();
+    }
+}
+
+bool SimIrqMasked(void)
+{
+    return m_SimIrqMasked;
+}
+
+bool SimIrqActive(void)
+{
+    return m_SimIrqActive;
+}
+
+/*Brief: Find the interrupt to serve next
+ * [in] - none
+ * [out] - interrupt number; SIM_IRQ_MAX - nothing to serve
+ * */
+static uint32_t SimIrqNext(void)
+{
+    uint32_t next = SIM_IRQ_MAX;
+
+    MmioOpen();
+
+    for (uint32_t i = 0; i < SIM_IRQ_MAX; i++)
+    {
+        SimIrq_t* irq = &m_SimIrq[i];
+
+        if (!irq->enabled || (irq->handler == NULL))
+        {
+            continue;
+        }
+
+        if (!irq->pending && ((irq->level == NULL) || !(*irq->level)()))
+        {
+            continue;
+        }
+
+        if ((next == SIM_IRQ_MAX) || (irq->priority < m_SimIrq[next].priority))
+        {
+            next = i;
+        }
+    }
+
+    MmioClose();
+
+    return next;
+}
+
+void SimIrqPoll(void)
+{
+    if (m_SimIrqMasked || m_SimIrqActive)
+    {
+        return;
+    }
+
+    m_SimIrqActive = true;
+
+    for (uint32_t runs = 0; ; runs++)
+    {
+        uint32_t next = SimIrqNext();
+
+        if (next == SIM_IRQ_MAX)
+        {
+            break;
+        }
+
+        if (runs >= SIM_IRQ_STORM)
+        {
+            /* flag is never cleared by the handler: the target would hang as well */
+            fprintf(stderr, "interrupt %u is stuck\n", next);
+            abort();
+        }
+
+        m_SimIrq[next].pending = false;
+        m_SimIrq[next].count++;
+
+        (*m_SimIrq[next].handler)();
+
+        /* handler returns with interrupts enabled (exception return) */
+        m_SimIrqMasked = false;
+    }
+
+    m_SimIrqActive = false;
+}
+
+uint32_t SimIrqCount(uint32_t irq)
+{
+    return (irq < SIM_IRQ_MAX) ? m_SimIrq[irq].count : 0;
+}
@@ -0,0 +1,172 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulated MCU core shared by the platform fakes: virtual cycle clock that
+ * drives the peripheral models and an interrupt controller with level
+ * sensitive lines.
+ * Interrupts are served at safe points only: when interrupts get unmasked,
+ * on interrupt enable or software pend, whenever the code under test reads
+ * the time base (every bounded wait does) and when a test lets time pass.
+ * Models never run code under test, so driver state is only touched by
+ * driver code, as on the target. */
+
+#define SIM_IRQ_MAX             (128U)
+
+/* default cost of a register access and of a time base read in core cycles */
+#define SIM_ACCESS_CYCLES       (2U)
+#define SIM_POLL_CYCLES         (4U)
+
+typedef void (*SimIrqHandler_t)(void);
+typedef bool (*SimIrqLevel_t)(void);
+typedef void (*SimModel_t)(uint64_t now);
+
+/*Brief: Reset clock, interrupt controller and model list
+ * [in] - hz - core clock
+ * [out] - none
+ * */
+void SimReset(uint32_t hz);
+
+/*Brief: Core clock
+ * [in] - none
+ * [out] - Hz
+ * */
+uint32_t SimClockHz(void);
+
+/*Brief: Current virtual time
+ * [in] - none
+ * [out] - core cycles since reset
+ * */
+uint64_t SimClockNow(void);
+
+/*Brief: Convert microseconds to core cycles
+ * [in] - usec - microseconds
+ * [out] - cycles
+ * */
+uint64_t SimClockUs(uint32_t usec);
+
+/*Brief: Advance virtual time and step models (no interrupts are served)
+ * [in] - cycles - cycles to advance
+ * [out] - none
+ * */
+void SimClockAdvance(uint64_t cycles);
+
+/*Brief: Let time pass in the test thread while interrupts are served
+ * [in] - cycles - cycles to run
+ * [out] - none
+ * */
+void SimClockRun(uint64_t cycles);
+
+/*Brief: Run until condition is met
+ * [in] - done - condition
+ * [in] - context - condition context
+ * [in] - maxCycles - time limit
+ * [out] - true - condition met; false - time limit reached
+ * */
+bool SimClockRunUntil(bool (*done)(void* context), void* context, uint64_t maxCycles);
+
+/*Brief: Set cost of register access and time base read
+ * [in] - access - cycles per trapped register access
+ * [in] - poll - cycles per time base read
+ * [out] - none
+ * */
+void SimClockSetCost(uint32_t access, uint32_t poll);
+
+/*Brief: Cost of time base read
+ * [in] - none
+ * [out] - cycles
+ * */
+uint32_t SimClockPollCost(void);
+
+/*Brief: Add peripheral model stepped on every clock advance
+ * [in] - model - step function, gets current time
+ * [out] - none
+ * */
+void SimClockAddModel(SimModel_t model);
+
+/*Brief: Set interrupt handler
+ * [in] - irq - interrupt number
+ * [in] - handler - handler
+ * [out] - none
+ * */
+void SimIrqSetHandler(uint32_t irq, SimIrqHandler_t handler);
+
+/*Brief: Set level of interrupt line (peripheral flags AND enables)
+ * NOTE: evaluated with register space open, must not have side effects
+ * [in] - irq - interrupt number
+ * [in] - level - line level function
+ * [out] - none
+ * */
+void SimIrqSetLevel(uint32_t irq, SimIrqLevel_t level);
+
+/*Brief: Enable or disable interrupt
+ * [in] - irq - interrupt number
+ * [in] - enable - true - enabled
+ * [out] - none
+ * */
+void SimIrqEnable(uint32_t irq, bool enable);
+
+/*Brief: Check if interrupt is enabled
+ * [in] - irq - interrupt number
+ * [out] - true - enabled
+ * */
+bool SimIrqEnabled(uint32_t irq);
+
+/*Brief: Set interrupt priority (lower number wins)
+ * [in] - irq - interrupt number
+ * [in] - priority - priority
+ * [out] - none
+ * */
+void SimIrqSetPriority(uint32_t irq, uint32_t priority);
+
+/*Brief: Get interrupt priority
+ * [in] - irq - interrupt number
+ * [out] - priority
+ * */
+uint32_t SimIrqPriority(uint32_t irq);
+
+/*Brief: Pend interrupt (signal safe)
+ * [in] - irq - interrupt number
+ * [out] - none
+ * */
+void SimIrqPend(uint32_t irq);
+
+/*Brief: Clear pending interrupt
+ * [in] - irq - interrupt number
+ * [out] - none
+ * */
+void SimIrqUnpend(uint32_t irq);
+
+/*Brief: Mask or unmask all interrupts (PRIMASK, cli/sei)
+ * [in] - masked - true - masked
+ * [out] - none
+ * */
+void SimIrqMask(bool masked);
+
+/*Brief: Check global interrupt mask
+ * [in] - none
+ * [out] - true - masked
+ * */
+bool SimIrqMasked(void);
+
+/*Brief: Check if an interrupt handler is running
+ * [in] - none
+ * [out] - true - handler context
+ * */
+bool SimIrqActive(void);
+
+/*Brief: Serve pending interrupts unless masked or already in handler
+ * [in] - none
+ * [out] - none
+ * */
+void SimIrqPoll(void);
+
+/*Brief: Number of handler runs since reset
+ * [in] - irq - interrupt number
+ * [out] - count
+ * */
+uint32_t SimIrqCount(uint32_t irq);
+
+#endif /* SIM_H */
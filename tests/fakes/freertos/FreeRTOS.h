@@ -0,0 +1,30 @@
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+
+/* Minimal FreeRTOS kernel surface used by the drivers, backed by the
+ * simulated core (see sim-freertos.c): one task, 1 kHz tick, software
+ * timers served from the lowest priority interrupt line */
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef struct tskTaskControlBlock* TaskHandle_t;
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdPASS                  (pdTRUE)
+#define pdFAIL                  (pdFALSE)
+
+#define configTICK_RATE_HZ      (1000U)
+
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY    (5U)
+
+#define portMAX_DELAY           ((TickType_t)0xFFFFFFFFUL)
+
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#define portYIELD_FROM_ISR(woken)   ((void)(woken))
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,191 @@
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include "sim.h"
+
+/* the only task: test thread */
+static struct tskTaskControlBlock
+{
+    volatile uint32_t notifications;
+} m_SimTask;
+
+static bool SimTaskNotified(void* context)
+{
+    (void)context;
+
+    return m_SimTask.notifications != 0U;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(SimClockNow() / (SimClockHz() / configTICK_RATE_HZ));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return &m_SimTask;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait)
+{
+    uint64_t cycles = (uint64_t)ticksToWait * (SimClockHz() / configTICK_RATE_HZ);
+
+    if (!SimClockRunUntil(&SimTaskNotified, NULL, cycles))
+    {
+        return 0;
+    }
+
+    uint32_t value = m_SimTask.notifications;
+
+    m_SimTask.notifications = (clearCountOnExit != pdFALSE) ? 0U : (value - 1U);
+
+    return value;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken)
+{
+    if (task != NULL)
+    {
+        task->notifications++;
+    }
+
+    if (higherPriorityTaskWoken != NULL)
+    {
+        *higherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+/* timer service task: served as the lowest priority interrupt line */
+#define SIM_TIMER_MAX           (8U)
+#define SIM_TIMER_IRQ           (SIM_IRQ_MAX - 1U)
+#define SIM_TIMER_PRIORITY      (0xFFU)
+
+struct tmrTimerControl
+{
+    TimerCallbackFunction_t callback;
+    void* id;
+    TickType_t period;
+    uint64_t expiry;            /* core cycles */
+    bool active;
+};
+
+static struct tmrTimerControl m_SimTimers[SIM_TIMER_MAX];
+
+static uint64_t SimTickCycles(void)
+{
+    return SimClockHz() / configTICK_RATE_HZ;
+}
+
+static bool SimTimerExpired(void)
+{
+    uint64_t now = SimClockNow();
+
+    for (uint32_t i = 0; i < SIM_TIMER_MAX; i++)
+    {
+        if (m_SimTimers[i].active && (m_SimTimers[i].expiry <= now))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void SimTimerTask(void)
+{
+    uint64_t now = SimClockNow();
+
+    for (uint32_t i = 0; i < SIM_TIMER_MAX; i++)
+    {
+        struct tmrTimerControl* timer = &m_SimTimers[i];
+
+        if (timer->active && (timer->expiry <= now))
+        {
+            timer->active = false;
+
+            (*timer->callback)(timer);
+        }
+    }
+}
+
+TimerHandle_t xTimerCreate(const char* const pcTimerName, const TickType_t xTimerPeriodInTicks,
+                           const UBaseType_t uxAutoReload, void* const pvTimerID,
+                           TimerCallbackFunction_t pxCallbackFunction)
+{
+    (void)pcTimerName;
+    (void)uxAutoReload;
+
+    struct tmrTimerControl* timer = NULL;
+
+    for (uint32_t i = 0; i < SIM_TIMER_MAX; i++)
+    {
+        if (m_SimTimers[i].id == pvTimerID)
+        {
+            timer = &m_SimTimers[i];
+            break;
+        }
+
+        if ((timer == NULL) && (m_SimTimers[i].callback == NULL))
+        {
+            timer = &m_SimTimers[i];
+        }
+    }
+
+    if (timer != NULL)
+    {
+        timer->callback = pxCallbackFunction;
+        timer->id = pvTimerID;
+        timer->period = xTimerPeriodInTicks;
+        timer->active = false;
+    }
+
+    return timer;
+}
+
+BaseType_t xTimerStartFromISR(TimerHandle_t xTimer, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    if (xTimer == NULL)
+    {
+        return pdFAIL;
+    }
+
+    /* interrupt controller is cleared by every simulator reset */
+    SimIrqSetHandler(SIM_TIMER_IRQ, &SimTimerTask);
+    SimIrqSetLevel(SIM_TIMER_IRQ, &SimTimerExpired);
+    SimIrqSetPriority(SIM_TIMER_IRQ, SIM_TIMER_PRIORITY);
+
+    /* expires once the tick count has advanced by the period */
+    xTimer->expiry = ((uint64_t)xTaskGetTickCount() + xTimer->period) * SimTickCycles();
+    xTimer->active = true;
+
+    if (pxHigherPriorityTaskWoken != NULL)
+    {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+
+    SimIrqEnable(SIM_TIMER_IRQ, true);
+
+    return pdPASS;
+}
+
+BaseType_t xTimerChangePeriodFromISR(TimerHandle_t xTimer, TickType_t xNewPeriod,
+                                     BaseType_t* pxHigherPriorityTaskWoken)
+{
+    if (xTimer == NULL)
+    {
+        return pdFAIL;
+    }
+
+    xTimer->period = xNewPeriod;
+
+    return xTimerStartFromISR(xTimer, pxHigherPriorityTaskWoken);
+}
+
+void* pvTimerGetTimerID(const TimerHandle_t xTimer)
+{
+    return xTimer->id;
+}
@@ -0,0 +1,26 @@
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include "FreeRTOS.h"
+
+typedef struct tmrTimerControl* TimerHandle_t;
+
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t xTimer);
+
+/* timers are kept in a fixed pool, creating a timer again with the same ID
+ * (driver handle initialized once per test) reuses its slot */
+TimerHandle_t xTimerCreate(const char* const pcTimerName, const TickType_t xTimerPeriodInTicks,
+                           const UBaseType_t uxAutoReload, void* const pvTimerID,
+                           TimerCallbackFunction_t pxCallbackFunction);
+
+/* callback runs in the timer service task: lowest priority interrupt line
+ * of the simulated core, so it preempts the test thread only */
+BaseType_t xTimerStartFromISR(TimerHandle_t xTimer, BaseType_t* pxHigherPriorityTaskWoken);
+
+/* sets the period and (re)starts the timer, like the kernel */
+BaseType_t xTimerChangePeriodFromISR(TimerHandle_t xTimer, TickType_t xNewPeriod,
+                                     BaseType_t* pxHigherPriorityTaskWoken);
+
+void* pvTimerGetTimerID(const TimerHandle_t xTimer);
+
+#endif /* TIMERS_H */
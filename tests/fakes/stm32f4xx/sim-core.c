@@ -0,0 +1,252 @@
+#include <stddef.h>
+
+#include "stm32f411xe.h"
+
+#include "mmio.h"
+#include "sim.h"
+#include "stm32-sim.h"
+
+/* page aligned, so the whole map can be trapped */
+uint8_t g_Stm32Mmio[STM32_MMIO_SIZE] __attribute__((aligned(4096)));
+
+uint32_t SystemCoreClock;
+
+/* handlers are weak: a test links only the drivers it needs */
+#define SIM_VECTOR(name)    extern void name(void) __attribute__((weak))
+
+SIM_VECTOR(EXTI0_IRQHandler);
+SIM_VECTOR(EXTI1_IRQHandler);
+SIM_VECTOR(EXTI2_IRQHandler);
+SIM_VECTOR(EXTI3_IRQHandler);
+SIM_VECTOR(EXTI4_IRQHandler);
+SIM_VECTOR(EXTI9_5_IRQHandler);
+SIM_VECTOR(EXTI15_10_IRQHandler);
+SIM_VECTOR(DMA1_Stream0_IRQHandler);
+SIM_VECTOR(DMA1_Stream1_IRQHandler);
+SIM_VECTOR(DMA1_Stream2_IRQHandler);
+SIM_VECTOR(DMA1_Stream3_IRQHandler);
+SIM_VECTOR(DMA1_Stream4_IRQHandler);
+SIM_VECTOR(DMA1_Stream5_IRQHandler);
+SIM_VECTOR(DMA1_Stream6_IRQHandler);
+SIM_VECTOR(DMA1_Stream7_IRQHandler);
+SIM_VECTOR(DMA2_Stream0_IRQHandler);
+SIM_VECTOR(DMA2_Stream1_IRQHandler);
+SIM_VECTOR(DMA2_Stream2_IRQHandler);
+SIM_VECTOR(DMA2_Stream3_IRQHandler);
+SIM_VECTOR(DMA2_Stream4_IRQHandler);
+SIM_VECTOR(DMA2_Stream5_IRQHandler);
+SIM_VECTOR(DMA2_Stream6_IRQHandler);
+SIM_VECTOR(DMA2_Stream7_IRQHandler);
+SIM_VECTOR(TIM2_IRQHandler);
+SIM_VECTOR(TIM3_IRQHandler);
+SIM_VECTOR(TIM4_IRQHandler);
+SIM_VECTOR(I2C1_EV_IRQHandler);
+SIM_VECTOR(I2C1_ER_IRQHandler);
+SIM_VECTOR(I2C2_EV_IRQHandler);
+SIM_VECTOR(I2C2_ER_IRQHandler);
+SIM_VECTOR(I2C3_EV_IRQHandler);
+SIM_VECTOR(I2C3_ER_IRQHandler);
+SIM_VECTOR(SPI1_IRQHandler);
+SIM_VECTOR(SPI2_IRQHandler);
+SIM_VECTOR(SPI3_IRQHandler);
+SIM_VECTOR(SPI4_IRQHandler);
+SIM_VECTOR(SPI5_IRQHandler);
+SIM_VECTOR(USART1_IRQHandler);
+SIM_VECTOR(USART2_IRQHandler);
+SIM_VECTOR(USART6_IRQHandler);
+
+static const struct
+{
+    IRQn_Type irq;
+    SimIrqHandler_t handler;
+} m_Stm32Vectors[] = {
+    { EXTI0_IRQn, EXTI0_IRQHandler },
+    { EXTI1_IRQn, EXTI1_IRQHandler },
+    { EXTI2_IRQn, EXTI2_IRQHandler },
+    { EXTI3_IRQn, EXTI3_IRQHandler },
+    { EXTI4_IRQn, EXTI4_IRQHandler },
+    { EXTI9_5_IRQn, EXTI9_5_IRQHandler },
+    { EXTI15_10_IRQn, EXTI15_10_IRQHandler },
+    { DMA1_Stream0_IRQn, DMA1_Stream0_IRQHandler },
+    { DMA1_Stream1_IRQn, DMA1_Stream1_IRQHandler },
+    { DMA1_Stream2_IRQn, DMA1_Stream2_IRQHandler },
+    { DMA1_Stream3_IRQn, DMA1_Stream3_IRQHandler },
+    { DMA1_Stream4_IRQn, DMA1_Stream4_IRQHandler },
+    { DMA1_Stream5_IRQn, DMA1_Stream5_IRQHandler },
+    { DMA1_Stream6_IRQn, DMA1_Stream6_IRQHandler },
+    { DMA1_Stream7_IRQn, DMA1_Stream7_IRQHandler },
+    { DMA2_Stream0_IRQn, DMA2_Stream0_IRQHandler },
+    { DMA2_Stream1_IRQn, DMA2_Stream1_IRQHandler },
+    { DMA2_Stream2_IRQn, DMA2_Stream2_IRQHandler },
+    { DMA2_Stream3_IRQn, DMA2_Stream3_IRQHandler },
+    { DMA2_Stream4_IRQn, DMA2_Stream4_IRQHandler },
+    { DMA2_Stream5_IRQn, DMA2_Stream5_IRQHandler },
+    { DMA2_Stream6_IRQn, DMA2_Stream6_IRQHandler },
+    { DMA2_Stream7_IRQn, DMA2_Stream7_IRQHandler },
+    { TIM2_IRQn, TIM2_IRQHandler },
+    { TIM3_IRQn, TIM3_IRQHandler },
+    { TIM4_IRQn, TIM4_IRQHandler },
+    { I2C1_EV_IRQn, I2C1_EV_IRQHandler },
+    { I2C1_ER_IRQn, I2C1_ER_IRQHandler },
+    { I2C2_EV_IRQn, I2C2_EV_IRQHandler },
+    { I2C2_ER_IRQn, I2C2_ER_IRQHandler },
+    { I2C3_EV_IRQn, I2C3_EV_IRQHandler },
+    { I2C3_ER_IRQn, I2C3_ER_IRQHandler },
+    { SPI1_IRQn, SPI1_IRQHandler },
+    { SPI2_IRQn, SPI2_IRQHandler },
+    { SPI3_IRQn, SPI3_IRQHandler },
+    { SPI4_IRQn, SPI4_IRQHandler },
+    { SPI5_IRQn, SPI5_IRQHandler },
+    { USART1_IRQn, USART1_IRQHandler },
+    { USART2_IRQn, USART2_IRQHandler },
+    { USART6_IRQn, USART6_IRQHandler },
+};
+
+void Stm32SimReset(uint32_t hclk, uint32_t apb1Divider, uint32_t apb2Divider)
+{
+    MmioRegion(g_Stm32Mmio, sizeof(g_Stm32Mmio));
+    MmioReset();
+
+    SimReset(hclk);
+
+    SystemCoreClock = hclk;
+
+    for (uint32_t i = 0; i < sizeof(m_Stm32Vectors) / sizeof(m_Stm32Vectors[0]); i++)
+    {
+        SimIrqSetHandler(m_Stm32Vectors[i].irq, m_Stm32Vectors[i].handler);
+    }
+
+    Stm32SimSetClocks(hclk, apb1Divider, apb2Divider);
+
+    Stm32GpioModelInit();
+    Stm32DmaModelInit();
+    Stm32UsartModelInit();
+    Stm32SpiModelInit();
+    Stm32I2cModelInit();
+
+    MmioTrap(true);
+}
+
+/*Brief: Encode APB divider as RCC_CFGR PPREx field
+ * [in] - divider - 1, 2, 4, 8 or 16
+ * [out] - field value
+ * */
+static uint32_t Stm32SimPpre(uint32_t divider)
+{
+    switch (divider)
+    {
+        case 2:
+            return 4;
+
+        case 4:
+            return 5;
+
+        case 8:
+            return 6;
+
+        case 16:
+            return 7;
+
+        default:
+            return 0;
+    }
+}
+
+void Stm32SimSetClocks(uint32_t hclk, uint32_t apb1Divider, uint32_t apb2Divider)
+{
+    /* PLL from 25 MHz HSE: VCO = 25 / 25 * 2 * hclk / 1 MHz, PLLP = 2 */
+    uint32_t plln = (hclk / 1000000U) * 2U;
+
+    MmioOpen();
+
+    RCC->PLLCFGR = RCC_PLLCFGR_PLLSRC | (25U << RCC_PLLCFGR_PLLM_Pos) | (plln << RCC_PLLCFGR_PLLN_Pos);
+    RCC->CFGR = RCC_CFGR_SWS_PLL
+                | (Stm32SimPpre(apb1Divider) << RCC_CFGR_PPRE1_Pos)
+                | (Stm32SimPpre(apb2Divider) << RCC_CFGR_PPRE2_Pos);
+
+    MmioClose();
+
+    SystemCoreClock = hclk;
+}
+
+uint32_t Stm32SimPclk(bool apb2)
+{
+    MmioOpen();
+    uint32_t ppre = (RCC->CFGR >> (apb2 ? RCC_CFGR_PPRE2_Pos : RCC_CFGR_PPRE1_Pos)) & 0x7U;
+    MmioClose();
+
+    return (ppre < 4U) ? SystemCoreClock : (SystemCoreClock >> (ppre - 3U));
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    SimIrqEnable((uint32_t)irq, true);
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq)
+{
+    SimIrqEnable((uint32_t)irq, false);
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)
+{
+    SimIrqSetPriority((uint32_t)irq, priority);
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq)
+{
+    SimIrqUnpend((uint32_t)irq);
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irq)
+{
+    SimIrqPend((uint32_t)irq);
+    SimIrqPoll();
+}
+
+void __disable_irq(void)
+{
+    SimIrqMask(true);
+}
+
+void __enable_irq(void)
+{
+    SimIrqMask(false);
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return SimIrqMasked() ? 1U : 0U;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+    SimIrqMask((primask & 0x01U) != 0U);
+}
+
+uint32_t __CLZ(uint32_t value)
+{
+    return (value == 0U) ? 32U : (uint32_t)__builtin_clz(value);
+}
+
+uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+
+    for (uint32_t i = 0; i < 32U; i++)
+    {
+        result = (result << 1) | ((value >> i) & 0x01U);
+    }
+
+    return result;
+}
+
+void __DSB(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void __DMB(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
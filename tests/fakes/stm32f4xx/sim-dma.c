@@ -0,0 +1,393 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "mmio.h"
+#include "stm32-sim.h"
+
+#define SIM_DMA_STREAMS         (8U)
+
+#define SIM_DMA_TEIF            (1U << 3)
+#define SIM_DMA_HTIF            (1U << 4)
+#define SIM_DMA_TCIF            (1U << 5)
+
+/* RM0383 9.5.1: stream flags in LISR/HISR */
+static const uint8_t m_SimDmaFlagOffset[4] = { 0, 6, 16, 22 };
+
+/* RM0383 tables 27 and 28: request to stream and channel mapping */
+static const struct
+{
+    STM32_DMA_REQUEST request;
+    uint8_t controller;     /* 0 - DMA1, 1 - DMA2 */
+    uint8_t stream;
+    uint8_t channel;
+} m_SimDmaMap[] = {
+    { STM32_DMA_USART1_RX, 1, 2, 4 },
+    { STM32_DMA_USART1_RX, 1, 5, 4 },
+    { STM32_DMA_USART1_TX, 1, 7, 4 },
+    { STM32_DMA_USART2_RX, 0, 5, 4 },
+    { STM32_DMA_USART2_TX, 0, 6, 4 },
+    { STM32_DMA_USART6_RX, 1, 1, 5 },
+    { STM32_DMA_USART6_RX, 1, 2, 5 },
+    { STM32_DMA_USART6_TX, 1, 6, 5 },
+    { STM32_DMA_USART6_TX, 1, 7, 5 },
+    { STM32_DMA_SPI1_RX, 1, 0, 3 },
+    { STM32_DMA_SPI1_RX, 1, 2, 3 },
+    { STM32_DMA_SPI1_TX, 1, 3, 3 },
+    { STM32_DMA_SPI1_TX, 1, 5, 3 },
+    { STM32_DMA_SPI2_RX, 0, 3, 0 },
+    { STM32_DMA_SPI2_TX, 0, 4, 0 },
+    { STM32_DMA_SPI3_RX, 0, 0, 0 },
+    { STM32_DMA_SPI3_RX, 0, 2, 0 },
+    { STM32_DMA_SPI3_TX, 0, 5, 0 },
+    { STM32_DMA_SPI3_TX, 0, 7, 0 },
+    { STM32_DMA_SPI4_RX, 1, 0, 4 },
+    { STM32_DMA_SPI4_RX, 1, 3, 5 },
+    { STM32_DMA_SPI4_TX, 1, 1, 4 },
+    { STM32_DMA_SPI4_TX, 1, 4, 5 },
+    { STM32_DMA_SPI5_RX, 1, 3, 2 },
+    { STM32_DMA_SPI5_RX, 1, 5, 7 },
+    { STM32_DMA_SPI5_TX, 1, 4, 2 },
+    { STM32_DMA_SPI5_TX, 1, 6, 7 },
+};
+
+typedef struct
+{
+    uint32_t starts;
+    uint32_t reload;        /* NDTR at enable, circular mode reload */
+    bool injectError;
+} SimDmaStream_t;
+
+static SimDmaStream_t m_SimDma[2][SIM_DMA_STREAMS];
+
+static DMA_TypeDef* SimDmaController(uint32_t controller)
+{
+    return (controller == 0U) ? DMA1 : DMA2;
+}
+
+static DMA_Stream_TypeDef* SimDmaStream(uint32_t controller, uint32_t stream)
+{
+    return (DMA_Stream_TypeDef*)((uintptr_t)SimDmaController(controller) + 0x10U + 0x18U * stream);
+}
+
+/*Brief: Locate stream registers
+ * [in] - address - address inside stream register block
+ * [out] - controller - 0 - DMA1, 1 - DMA2
+ * [out] - stream - stream number
+ * [out] - true - address belongs to a stream
+ * */
+static bool SimDmaLocate(uintptr_t address, uint32_t* controller, uint32_t* stream)
+{
+    for (uint32_t c = 0; c < 2U; c++)
+    {
+        uintptr_t first = (uintptr_t)SimDmaStream(c, 0);
+
+        if ((address >= first) && (address < first + SIM_DMA_STREAMS * 0x18U))
+        {
+            *controller = c;
+            *stream = (uint32_t)(address - first) / 0x18U;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static volatile uint32_t* SimDmaIsr(uint32_t controller, uint32_t stream)
+{
+    DMA_TypeDef* dma = SimDmaController(controller);
+
+    return (stream < 4U) ? &dma->LISR : &dma->HISR;
+}
+
+static void SimDmaSetFlags(uint32_t controller, uint32_t stream, uint32_t flags)
+{
+    *SimDmaIsr(controller, stream) |= flags << m_SimDmaFlagOffset[stream % 4U];
+}
+
+static uint32_t SimDmaFlags(uint32_t controller, uint32_t stream)
+{
+    return (*SimDmaIsr(controller, stream) >> m_SimDmaFlagOffset[stream % 4U]) & 0x3DU;
+}
+
+static void SimDmaOnStream(const MmioAccess_t* const access)
+{
+    uint32_t controller;
+    uint32_t stream;
+
+    if (!access->write || !SimDmaLocate(access->address, &controller, &stream))
+    {
+        return;
+    }
+
+    DMA_Stream_TypeDef* regs = SimDmaStream(controller, stream);
+    volatile uint32_t* reg = (volatile uint32_t*)(access->address & ~(uintptr_t)3U);
+    bool wasEnabled = (reg == &regs->CR) ? ((access->old & DMA_SxCR_EN) != 0U) : ((regs->CR & DMA_SxCR_EN) != 0U);
+
+    if (reg == &regs->CR)
+    {
+        if (!wasEnabled && (regs->CR & DMA_SxCR_EN))
+        {
+            m_SimDma[controller][stream].starts++;
+            m_SimDma[controller][stream].reload = regs->NDTR & 0xFFFFU;
+        }
+        else if (wasEnabled && !(regs->CR & DMA_SxCR_EN))
+        {
+            /* RM0383 9.3.17: disabling an active stream sets TCIF, EN reads
+             * back cleared at once as no item is ever in flight here */
+            SimDmaSetFlags(controller, stream, SIM_DMA_TCIF);
+        }
+    }
+    else if ((reg == &regs->NDTR) || (reg == &regs->PAR) || (reg == &regs->M0AR))
+    {
+        /* read only while the stream is enabled */
+        if (wasEnabled)
+        {
+            *reg = access->old;
+        }
+    }
+}
+
+static void SimDmaOnController(const MmioAccess_t* const access)
+{
+    if (!access->write)
+    {
+        return;
+    }
+
+    for (uint32_t c = 0; c < 2U; c++)
+    {
+        DMA_TypeDef* dma = SimDmaController(c);
+        volatile uint32_t* reg = (volatile uint32_t*)(access->address & ~(uintptr_t)3U);
+
+        if ((reg == &dma->LISR) || (reg == &dma->HISR))
+        {
+            /* read only */
+            *reg = access->old;
+        }
+        else if (reg == &dma->LIFCR)
+        {
+            dma->LISR &= ~dma->LIFCR;
+            dma->LIFCR = 0;
+        }
+        else if (reg == &dma->HIFCR)
+        {
+            dma->HISR &= ~dma->HIFCR;
+            dma->HIFCR = 0;
+        }
+    }
+}
+
+static bool SimDmaLevel(uint32_t controller, uint32_t stream)
+{
+    uint32_t flags = SimDmaFlags(controller, stream);
+    uint32_t cr = SimDmaStream(controller, stream)->CR;
+
+    return ((flags & SIM_DMA_TCIF) && (cr & DMA_SxCR_TCIE))
+           || ((flags & SIM_DMA_HTIF) && (cr & DMA_SxCR_HTIE))
+           || ((flags & SIM_DMA_TEIF) && (cr & DMA_SxCR_TEIE));
+}
+
+#define SIM_DMA_LEVEL(c, s)                                 \
+    static bool SimDmaLevel##c##_##s(void)                  \
+    {                                                       \
+        return SimDmaLevel((c) - 1U, (s));                  \
+    }
+
+SIM_DMA_LEVEL(1, 0)
+SIM_DMA_LEVEL(1, 1)
+SIM_DMA_LEVEL(1, 2)
+SIM_DMA_LEVEL(1, 3)
+SIM_DMA_LEVEL(1, 4)
+SIM_DMA_LEVEL(1, 5)
+SIM_DMA_LEVEL(1, 6)
+SIM_DMA_LEVEL(1, 7)
+SIM_DMA_LEVEL(2, 0)
+SIM_DMA_LEVEL(2, 1)
+SIM_DMA_LEVEL(2, 2)
+SIM_DMA_LEVEL(2, 3)
+SIM_DMA_LEVEL(2, 4)
+SIM_DMA_LEVEL(2, 5)
+SIM_DMA_LEVEL(2, 6)
+SIM_DMA_LEVEL(2, 7)
+
+static const struct
+{
+    IRQn_Type irq;
+    SimIrqLevel_t level;
+} m_SimDmaIrq[2][SIM_DMA_STREAMS] = {
+    {
+        { DMA1_Stream0_IRQn, &SimDmaLevel1_0 }, { DMA1_Stream1_IRQn, &SimDmaLevel1_1 },
+        { DMA1_Stream2_IRQn, &SimDmaLevel1_2 }, { DMA1_Stream3_IRQn, &SimDmaLevel1_3 },
+        { DMA1_Stream4_IRQn, &SimDmaLevel1_4 }, { DMA1_Stream5_IRQn, &SimDmaLevel1_5 },
+        { DMA1_Stream6_IRQn, &SimDmaLevel1_6 }, { DMA1_Stream7_IRQn, &SimDmaLevel1_7 },
+    },
+    {
+        { DMA2_Stream0_IRQn, &SimDmaLevel2_0 }, { DMA2_Stream1_IRQn, &SimDmaLevel2_1 },
+        { DMA2_Stream2_IRQn, &SimDmaLevel2_2 }, { DMA2_Stream3_IRQn, &SimDmaLevel2_3 },
+        { DMA2_Stream4_IRQn, &SimDmaLevel2_4 }, { DMA2_Stream5_IRQn, &SimDmaLevel2_5 },
+        { DMA2_Stream6_IRQn, &SimDmaLevel2_6 }, { DMA2_Stream7_IRQn, &SimDmaLevel2_7 },
+    },
+};
+
+void Stm32DmaModelInit(void)
+{
+    memset(m_SimDma, 0, sizeof(m_SimDma));
+
+    MmioHook(DMA1, sizeof(DMA_TypeDef), NULL, &SimDmaOnController);
+    MmioHook(DMA2, sizeof(DMA_TypeDef), NULL, &SimDmaOnController);
+    MmioHook(SimDmaStream(0, 0), SIM_DMA_STREAMS * 0x18U, NULL, &SimDmaOnStream);
+    MmioHook(SimDmaStream(1, 0), SIM_DMA_STREAMS * 0x18U, NULL, &SimDmaOnStream);
+
+    for (uint32_t c = 0; c < 2U; c++)
+    {
+        for (uint32_t s = 0; s < SIM_DMA_STREAMS; s++)
+        {
+            SimIrqSetLevel(m_SimDmaIrq[c][s].irq, m_SimDmaIrq[c][s].level);
+        }
+    }
+}
+
+/*Brief: Find enabled stream serving the request in the given direction
+ * [in] - request - request line
+ * [in] - direction - DMA_SxCR_DIR field value
+ * [out] - controller - 0 - DMA1, 1 - DMA2
+ * [out] - stream - stream number
+ * [out] - true - found
+ * */
+static bool SimDmaFind(STM32_DMA_REQUEST request, uint32_t direction, uint32_t* controller, uint32_t* stream)
+{
+    for (uint32_t i = 0; i < sizeof(m_SimDmaMap) / sizeof(m_SimDmaMap[0]); i++)
+    {
+        if (m_SimDmaMap[i].request != request)
+        {
+            continue;
+        }
+
+        uint32_t cr = SimDmaStream(m_SimDmaMap[i].controller, m_SimDmaMap[i].stream)->CR;
+
+        if (((cr & DMA_SxCR_EN) != 0U)
+            && (((cr & DMA_SxCR_CHSEL) >> DMA_SxCR_CHSEL_Pos) == m_SimDmaMap[i].channel)
+            && ((cr & DMA_SxCR_DIR) == direction))
+        {
+            *controller = m_SimDmaMap[i].controller;
+            *stream = m_SimDmaMap[i].stream;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*Brief: Move one item between peripheral and memory
+ * [in] - controller - 0 - DMA1, 1 - DMA2
+ * [in] - stream - stream number
+ * [in] - dr - peripheral data register
+ * [in] - data - item (peripheral to memory)
+ * [out] - data - item (memory to peripheral)
+ * [in] - toMemory - true - peripheral to memory
+ * [out] - true - transferred; false - transfer error, stream disabled
+ * */
+static bool SimDmaItem(uint32_t controller, uint32_t stream, volatile const uint32_t* dr, uint32_t* data, bool toMemory)
+{
+    DMA_Stream_TypeDef* regs = SimDmaStream(controller, stream);
+    SimDmaStream_t* state = &m_SimDma[controller][stream];
+
+    if ((regs->PAR != (uint32_t)(uintptr_t)dr) || state->injectError)
+    {
+        /* RM0383 9.3.19: bus error disables the stream */
+        state->injectError = false;
+        regs->CR &= ~DMA_SxCR_EN;
+        SimDmaSetFlags(controller, stream, SIM_DMA_TEIF);
+        return false;
+    }
+
+    uint32_t size = 1U << ((regs->CR >> 13U) & 0x03U);
+    uint32_t index = (regs->CR & DMA_SxCR_MINC) ? (state->reload - regs->NDTR) : 0U;
+    uint8_t* memory = (uint8_t*)(uintptr_t)regs->M0AR + index * size;
+
+    if (toMemory)
+    {
+        memcpy(memory, data, size);
+    }
+    else
+    {
+        *data = 0;
+        memcpy(data, memory, size);
+    }
+
+    regs->NDTR--;
+
+    if (regs->NDTR == (state->reload / 2U))
+    {
+        SimDmaSetFlags(controller, stream, SIM_DMA_HTIF);
+    }
+
+    if (regs->NDTR == 0U)
+    {
+        SimDmaSetFlags(controller, stream, SIM_DMA_TCIF);
+
+        if (regs->CR & DMA_SxCR_CIRC)
+        {
+            regs->NDTR = state->reload;
+        }
+        else
+        {
+            regs->CR &= ~DMA_SxCR_EN;
+        }
+    }
+
+    return true;
+}
+
+bool Stm32DmaPeripheralWrite(STM32_DMA_REQUEST request, volatile const uint32_t* dr, uint32_t data)
+{
+    uint32_t controller;
+    uint32_t stream;
+
+    if (!SimDmaFind(request, 0, &controller, &stream))
+    {
+        return false;
+    }
+
+    /* a failed item is lost, the request is still consumed */
+    (void)SimDmaItem(controller, stream, dr, &data, true);
+
+    return true;
+}
+
+bool Stm32DmaPeripheralRead(STM32_DMA_REQUEST request, volatile const uint32_t* dr, uint32_t* data)
+{
+    uint32_t controller;
+    uint32_t stream;
+
+    if (!SimDmaFind(request, DMA_SxCR_DIR_0, &controller, &stream))
+    {
+        return false;
+    }
+
+    return SimDmaItem(controller, stream, dr, data, false);
+}
+
+uint32_t Stm32DmaStarts(const DMA_Stream_TypeDef* stream)
+{
+    uint32_t controller;
+    uint32_t index;
+
+    if (!SimDmaLocate((uintptr_t)stream, &controller, &index))
+    {
+        return 0;
+    }
+
+    return m_SimDma[controller][index].starts;
+}
+
+void Stm32DmaInjectError(const DMA_Stream_TypeDef* stream)
+{
+    uint32_t controller;
+    uint32_t index;
+
+    if (SimDmaLocate((uintptr_t)stream, &controller, &index))
+    {
+        m_SimDma[controller][index].injectError = true;
+    }
+}
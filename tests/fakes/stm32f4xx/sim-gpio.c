@@ -0,0 +1,265 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "mmio.h"
+#include "stm32-sim.h"
+
+#define SIM_GPIO_PORTS          (6U)
+#define SIM_GPIO_PINS           (16U)
+
+/* SYSCFG_EXTICR port codes (RM0383 7.2.3) */
+static const uint8_t m_SimGpioExtiCode[SIM_GPIO_PORTS] = { 0, 1, 2, 3, 4, 7 };
+
+typedef enum
+{
+    SIM_GPIO_EXT_NONE = 0,
+    SIM_GPIO_EXT_LOW,
+    SIM_GPIO_EXT_HIGH
+} SIM_GPIO_EXT;
+
+static uint8_t m_SimGpioExternal[SIM_GPIO_PORTS][SIM_GPIO_PINS];
+
+static GPIO_TypeDef* SimGpioPort(uint32_t index)
+{
+    return (index == 5U) ? GPIOH : (GPIO_TypeDef*)(GPIOA_BASE + index * 0x400U);
+}
+
+/*Brief: Resolve pad level of one pin, register space must be open
+ * */
+static bool SimGpioPad(uint32_t portIndex, uint32_t pin, bool* driven)
+{
+    GPIO_TypeDef* port = SimGpioPort(portIndex);
+    uint32_t mode = (port->MODER >> (pin * 2U)) & 0x03U;
+    uint32_t pull = (port->PUPDR >> (pin * 2U)) & 0x03U;
+    bool openDrain = (port->OTYPER & (1U << pin)) != 0U;
+    bool out = (port->ODR & (1U << pin)) != 0U;
+
+    *driven = false;
+
+    if (mode == 1U)
+    {
+        if (!openDrain || !out)
+        {
+            *driven = true;
+            return out;
+        }
+    }
+
+    switch (m_SimGpioExternal[portIndex][pin])
+    {
+        case SIM_GPIO_EXT_LOW:
+            return false;
+
+        case SIM_GPIO_EXT_HIGH:
+            return true;
+
+        default:
+            /* pulls are active in input, alternate and open-drain output mode */
+            return (mode != 3U) && (pull == 1U);
+    }
+}
+
+/*Brief: Recompute IDR of all ports and latch EXTI edges, register space must be open
+ * */
+static void SimGpioUpdate(void)
+{
+    for (uint32_t p = 0; p < SIM_GPIO_PORTS; p++)
+    {
+        GPIO_TypeDef* port = SimGpioPort(p);
+        uint32_t idr = 0;
+
+        for (uint32_t i = 0; i < SIM_GPIO_PINS; i++)
+        {
+            bool driven;
+
+            if (SimGpioPad(p, i, &driven))
+            {
+                idr |= (1U << i);
+            }
+        }
+
+        uint32_t changed = (port->IDR ^ idr) & 0xFFFFU;
+
+        port->IDR = idr;
+
+        for (uint32_t i = 0; i < SIM_GPIO_PINS; i++)
+        {
+            uint32_t bit = (1U << i);
+
+            if ((changed & bit) == 0U)
+            {
+                continue;
+            }
+
+            /* EXTI line i listens to one port only */
+            uint32_t code = (SYSCFG->EXTICR[i / 4U] >> ((i % 4U) * 4U)) & 0x0FU;
+
+            if (code != m_SimGpioExtiCode[p])
+            {
+                continue;
+            }
+
+            bool rising = (idr & bit) != 0U;
+
+            if ((rising && (EXTI->RTSR & bit)) || (!rising && (EXTI->FTSR & bit)))
+            {
+                if (EXTI->IMR & bit)
+                {
+                    EXTI->PR |= bit;
+                }
+            }
+        }
+    }
+}
+
+static void SimGpioOnPort(const MmioAccess_t* const access)
+{
+    if (!access->write)
+    {
+        return;
+    }
+
+    uintptr_t offset = (access->address - GPIOA_BASE) % 0x400U;
+    GPIO_TypeDef* port = (GPIO_TypeDef*)(access->address - offset);
+
+    if (offset == offsetof(GPIO_TypeDef, BSRR))
+    {
+        uint32_t bsrr = port->BSRR;
+
+        /* set wins over reset, register reads as zero */
+        port->ODR = (port->ODR & ~(bsrr >> 16U)) | (bsrr & 0xFFFFU);
+        port->BSRR = 0;
+    }
+    else if (offset == offsetof(GPIO_TypeDef, IDR))
+    {
+        /* read only */
+        port->IDR = access->old;
+    }
+
+    SimGpioUpdate();
+}
+
+static void SimGpioOnExti(const MmioAccess_t* const access)
+{
+    if (access->write && (access->address == (uintptr_t)&EXTI->PR))
+    {
+        /* rc_w1 */
+        EXTI->PR = access->old & ~EXTI->PR;
+    }
+}
+
+static bool SimGpioExtiLevel(uint32_t lines)
+{
+    return (EXTI->PR & EXTI->IMR & lines) != 0U;
+}
+
+static bool SimGpioExti0(void)
+{
+    return SimGpioExtiLevel(1U << 0);
+}
+
+static bool SimGpioExti1(void)
+{
+    return SimGpioExtiLevel(1U << 1);
+}
+
+static bool SimGpioExti2(void)
+{
+    return SimGpioExtiLevel(1U << 2);
+}
+
+static bool SimGpioExti3(void)
+{
+    return SimGpioExtiLevel(1U << 3);
+}
+
+static bool SimGpioExti4(void)
+{
+    return SimGpioExtiLevel(1U << 4);
+}
+
+static bool SimGpioExti9_5(void)
+{
+    return SimGpioExtiLevel(0x03E0U);
+}
+
+static bool SimGpioExti15_10(void)
+{
+    return SimGpioExtiLevel(0xFC00U);
+}
+
+void Stm32GpioModelInit(void)
+{
+    memset(m_SimGpioExternal, 0, sizeof(m_SimGpioExternal));
+
+    for (uint32_t p = 0; p < SIM_GPIO_PORTS; p++)
+    {
+        MmioHook(SimGpioPort(p), sizeof(GPIO_TypeDef), NULL, &SimGpioOnPort);
+    }
+
+    MmioHook(EXTI, sizeof(EXTI_TypeDef), NULL, &SimGpioOnExti);
+
+    SimIrqSetLevel(EXTI0_IRQn, &SimGpioExti0);
+    SimIrqSetLevel(EXTI1_IRQn, &SimGpioExti1);
+    SimIrqSetLevel(EXTI2_IRQn, &SimGpioExti2);
+    SimIrqSetLevel(EXTI3_IRQn, &SimGpioExti3);
+    SimIrqSetLevel(EXTI4_IRQn, &SimGpioExti4);
+    SimIrqSetLevel(EXTI9_5_IRQn, &SimGpioExti9_5);
+    SimIrqSetLevel(EXTI15_10_IRQn, &SimGpioExti15_10);
+}
+
+static void SimGpioSetExternal(uint8_t pin, uint8_t state)
+{
+    uint32_t portIndex = (pin >> 4U) & 0x0FU;
+
+    if (portIndex >= SIM_GPIO_PORTS)
+    {
+        return;
+    }
+
+    m_SimGpioExternal[portIndex][pin & 0x0FU] = state;
+
+    MmioOpen();
+    SimGpioUpdate();
+    MmioClose();
+}
+
+void SimGpioDrive(uint8_t pin, bool level)
+{
+    SimGpioSetExternal(pin, level ? SIM_GPIO_EXT_HIGH : SIM_GPIO_EXT_LOW);
+    SimIrqPoll();
+}
+
+void SimGpioRelease(uint8_t pin)
+{
+    SimGpioSetExternal(pin, SIM_GPIO_EXT_NONE);
+    SimIrqPoll();
+}
+
+void Stm32GpioModelDrive(uint8_t pin, bool level)
+{
+    /* no interrupt window: models must not run the code under test */
+    SimGpioSetExternal(pin, level ? SIM_GPIO_EXT_HIGH : SIM_GPIO_EXT_LOW);
+}
+
+bool SimGpioLevel(uint8_t pin)
+{
+    bool driven;
+
+    MmioOpen();
+    bool level = SimGpioPad((pin >> 4U) & 0x0FU, pin & 0x0FU, &driven);
+    MmioClose();
+
+    return level;
+}
+
+bool SimGpioDriven(uint8_t pin)
+{
+    bool driven;
+
+    MmioOpen();
+    (void)SimGpioPad((pin >> 4U) & 0x0FU, pin & 0x0FU, &driven);
+    MmioClose();
+
+    return driven;
+}
@@ -0,0 +1,741 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "mmio.h"
+#include "stm32-sim.h"
+#include "gpio-name.h"
+
+#define SIM_I2C_COUNT           (3U)
+#define SIM_I2C_DEVICES         (4U)
+#define SIM_I2C_BYTE_CLOCKS     (9U)    /* 8 data bits and ACK */
+
+/* cleared by writing 0, other SR1 bits are read only */
+#define SIM_I2C_SR1_RC_W0       (I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_AF | I2C_SR1_OVR \
+                                 | I2C_SR1_PECERR | I2C_SR1_TIMEOUT | I2C_SR1_SMBALERT)
+
+typedef enum
+{
+    SIM_I2C_IDLE = 0,       /* not master */
+    SIM_I2C_START,          /* START condition on the bus */
+    SIM_I2C_SB,             /* SB set, SCL held low until address is written */
+    SIM_I2C_ADDRESS,        /* address byte on the bus */
+    SIM_I2C_ADDR,           /* ADDR set, SCL held low until it is cleared */
+    SIM_I2C_TX,             /* data byte shifted out */
+    SIM_I2C_RX,             /* data byte shifted in */
+    SIM_I2C_HOLD,           /* SCL held low: waits for data, STOP or START */
+    SIM_I2C_STOP            /* STOP condition on the bus */
+} SIM_I2C_PHASE;
+
+typedef struct
+{
+    SIM_I2C_PHASE phase;
+    uint64_t phaseEnd;
+    bool sr1Read;           /* SR1 read, SR2 or DR access completes flag clearing */
+    bool read;              /* R/W bit of the address */
+    uint8_t address;
+    Stm32I2cDevice_t* device;
+    uint32_t byteIndex;     /* data bytes of the access */
+    uint8_t shifter;        /* received byte held in the shift register (BTF) */
+    bool held;
+    bool ackLatched;        /* ACK at the end of the previous byte, used with POS */
+    bool nacked;            /* master NACKed, no more bytes are clocked */
+    bool master;            /* bus taken by START, released by STOP */
+    bool busyLatched;       /* SDA seen low, cleared by STOP or software reset */
+    Stm32I2cDevice_t* devices[SIM_I2C_DEVICES];
+    bool populated;         /* bus pull-ups on the pads */
+    bool sdaHeld;
+    uint32_t sdaClocks;     /* SCL clocks until SDA is released */
+    bool sclLevel;
+    uint32_t sclClocks;     /* by software, peripheral disabled */
+    bool stretchArmed;
+    uint32_t stretchByte;
+    uint64_t stretchCycles;
+    bool stretching;
+    uint64_t stretchEnd;
+} SimI2c_t;
+
+static SimI2c_t m_SimI2c[SIM_I2C_COUNT];
+
+static I2C_TypeDef* const m_SimI2cInstance[SIM_I2C_COUNT] = { I2C1, I2C2, I2C3 };
+static const IRQn_Type m_SimI2cEvIrq[SIM_I2C_COUNT] = { I2C1_EV_IRQn, I2C2_EV_IRQn, I2C3_EV_IRQn };
+static const IRQn_Type m_SimI2cErIrq[SIM_I2C_COUNT] = { I2C1_ER_IRQn, I2C2_ER_IRQn, I2C3_ER_IRQn };
+
+/* pads of the board, same as the driver */
+static const uint8_t m_SimI2cSda[SIM_I2C_COUNT] = { PB_9, PB_11, PC_9 };
+static const uint8_t m_SimI2cScl[SIM_I2C_COUNT] = { PB_8, PB_10, PA_8 };
+
+static int32_t SimI2cIndex(const I2C_TypeDef* i2c)
+{
+    for (uint32_t i = 0; i < SIM_I2C_COUNT; i++)
+    {
+        if (m_SimI2cInstance[i] == i2c)
+        {
+            return (int32_t)i;
+        }
+    }
+
+    return -1;
+}
+
+/*Brief: SCL period from CCR, register space must be open
+ * [in] - index - I2C index
+ * [out] - core cycles per SCL period; 0 - clock not programmed
+ * */
+static uint64_t SimI2cPeriod(uint32_t index)
+{
+    I2C_TypeDef* i2c = m_SimI2cInstance[index];
+    uint64_t ccr = i2c->CCR & I2C_CCR_CCR;
+    uint64_t pclk = Stm32SimPclk(false);
+    uint64_t ticks = 2;
+
+    if (pclk == 0U)
+    {
+        return 0;
+    }
+
+    /* RM0383 18.6.8: Thigh + Tlow in CCR units */
+    if (i2c->CCR & I2C_CCR_FS)
+    {
+        ticks = (i2c->CCR & I2C_CCR_DUTY) ? 25U : 3U;
+    }
+
+    return (ticks * ccr * SystemCoreClock) / pclk;
+}
+
+static void SimI2cReset(uint32_t index)
+{
+    I2C_TypeDef* i2c = m_SimI2cInstance[index];
+    SimI2c_t* state = &m_SimI2c[index];
+
+    i2c->CR1 = 0;
+    i2c->CR2 = 0;
+    i2c->OAR1 = 0;
+    i2c->OAR2 = 0;
+    i2c->DR = 0;
+    i2c->SR1 = 0;
+    i2c->SR2 = 0;
+    i2c->CCR = 0;
+    i2c->TRISE = 2;
+
+    state->phase = SIM_I2C_IDLE;
+    state->sr1Read = false;
+    state->device = NULL;
+    state->held = false;
+    state->nacked = false;
+    state->master = false;
+    state->busyLatched = false;
+}
+
+static Stm32I2cDevice_t* SimI2cFind(uint32_t index, uint8_t address)
+{
+    for (uint32_t i = 0; i < SIM_I2C_DEVICES; i++)
+    {
+        Stm32I2cDevice_t* device = m_SimI2c[index].devices[i];
+
+        if ((device != NULL) && (device->address == address))
+        {
+            return device;
+        }
+    }
+
+    return NULL;
+}
+
+/*Brief: Put next data byte on the bus, slave may stretch SCL before it
+ * [in] - index - I2C index
+ * [in] - phase - SIM_I2C_TX or SIM_I2C_RX
+ * [in] - start - byte start time
+ * [out] - none
+ * */
+static void SimI2cByte(uint32_t index, SIM_I2C_PHASE phase, uint64_t start)
+{
+    SimI2c_t* state = &m_SimI2c[index];
+
+    state->phase = phase;
+    state->phaseEnd = start + SIM_I2C_BYTE_CLOCKS * SimI2cPeriod(index);
+
+    if (state->stretchArmed && (state->byteIndex == state->stretchByte))
+    {
+        state->stretchArmed = false;
+        state->stretching = true;
+        state->stretchEnd = start + state->stretchCycles;
+        state->phaseEnd += state->stretchCycles;
+
+        Stm32GpioModelDrive(m_SimI2cScl[index], false);
+    }
+}
+
+/*Brief: Slave takes written byte
+ * [out] - true - ACK; false - NACK
+ * */
+static bool SimI2cWrite(SimI2c_t* state, uint8_t data)
+{
+    Stm32I2cDevice_t* device = state->device;
+
+    if ((device->nackAfter != 0U) && (state->byteIndex >= device->nackAfter))
+    {
+        return false;
+    }
+
+    /* first byte of a write sets register pointer */
+    if (state->byteIndex == 0U)
+    {
+        device->pointer = data;
+    }
+    else
+    {
+        device->regs[device->pointer++] = data;
+        device->written++;
+    }
+
+    return true;
+}
+
+static void SimI2cByteEnd(uint32_t index, uint64_t end)
+{
+    I2C_TypeDef* i2c = m_SimI2cInstance[index];
+    SimI2c_t* state = &m_SimI2c[index];
+
+    if (state->phase == SIM_I2C_ADDRESS)
+    {
+        state->device = SimI2cFind(index, state->address);
+        state->byteIndex = 0;
+        state->nacked = false;
+        state->ackLatched = (i2c->CR1 & I2C_CR1_ACK) != 0U;
+
+        if (state->device == NULL)
+        {
+            i2c->SR1 |= I2C_SR1_AF;
+            state->phase = SIM_I2C_HOLD;
+            return;
+        }
+
+        i2c->SR1 |= I2C_SR1_ADDR;
+
+        if (!state->read)
+        {
+            i2c->SR2 |= I2C_SR2_TRA;
+        }
+
+        state->phase = SIM_I2C_ADDR;
+        return;
+    }
+
+    if (state->phase == SIM_I2C_TX)
+    {
+        bool ack = SimI2cWrite(state, state->shifter);
+
+        state->byteIndex++;
+
+        if (!ack)
+        {
+            i2c->SR1 |= I2C_SR1_AF;
+            state->phase = SIM_I2C_HOLD;
+            return;
+        }
+
+        if (!(i2c->SR1 & I2C_SR1_TXE) && !(i2c->CR1 & (I2C_CR1_STOP | I2C_CR1_START)))
+        {
+            /* DR full: next byte follows back to back */
+            state->shifter = (uint8_t)i2c->DR;
+            i2c->SR1 |= I2C_SR1_TXE;
+            SimI2cByte(index, SIM_I2C_TX, end);
+            return;
+        }
+
+        if (i2c->SR1 & I2C_SR1_TXE)
+        {
+            i2c->SR1 |= I2C_SR1_BTF;
+        }
+
+        state->phase = SIM_I2C_HOLD;
+        return;
+    }
+
+    /* RM0383 18.3.3: with POS the ACK bit applies to the next byte */
+    bool ack = (i2c->CR1 & I2C_CR1_POS) ? state->ackLatched : ((i2c->CR1 & I2C_CR1_ACK) != 0U);
+    uint8_t data = state->device->regs[state->device->pointer++];
+
+    state->ackLatched = (i2c->CR1 & I2C_CR1_ACK) != 0U;
+    state->device->read++;
+    state->byteIndex++;
+    state->nacked = !ack;
+
+    if (i2c->SR1 & I2C_SR1_RXNE)
+    {
+        /* DR not read: byte waits in the shift register, SCL held low */
+        state->shifter = data;
+        state->held = true;
+        i2c->SR1 |= I2C_SR1_BTF;
+    }
+    else
+    {
+        i2c->DR = data;
+        i2c->SR1 |= I2C_SR1_RXNE;
+    }
+
+    if (ack && !state->held && !(i2c->CR1 & (I2C_CR1_STOP | I2C_CR1_START)))
+    {
+        SimI2cByte(index, SIM_I2C_RX, end);
+        return;
+    }
+
+    state->phase = SIM_I2C_HOLD;
+}
+
+/*Brief: Board side of the bus: slave holding SDA, clock stretching
+ * [in] - index - I2C index
+ * [in] - now - current time
+ * [out] - none
+ * */
+static void SimI2cPads(uint32_t index, uint64_t now)
+{
+    SimI2c_t* state = &m_SimI2c[index];
+
+    if (state->stretching && (now >= state->stretchEnd))
+    {
+        state->stretching = false;
+        Stm32GpioModelDrive(m_SimI2cScl[index], true);
+    }
+
+    bool scl = SimGpioLevel(m_SimI2cScl[index]);
+
+    if (scl && !state->sclLevel)
+    {
+        /* peripheral is off while software clocks the bus */
+        if (!(m_SimI2cInstance[index]->CR1 & I2C_CR1_PE))
+        {
+            state->sclClocks++;
+        }
+
+        /* slave shifts its bit out on every clock, SDA is free after the byte */
+        if (state->sdaHeld && (state->sdaClocks != STM32_I2C_HOLD_FOREVER) && (--state->sdaClocks == 0U))
+        {
+            state->sdaHeld = false;
+            Stm32GpioModelDrive(m_SimI2cSda[index], true);
+        }
+    }
+
+    state->sclLevel = scl;
+
+    if ((m_SimI2cInstance[index]->CR1 & I2C_CR1_PE) && !SimGpioLevel(m_SimI2cSda[index]))
+    {
+        state->busyLatched = true;
+    }
+}
+
+static void SimI2cStepIndex(uint32_t index, uint64_t now)
+{
+    I2C_TypeDef* i2c = m_SimI2cInstance[index];
+    SimI2c_t* state = &m_SimI2c[index];
+
+    if (state->populated)
+    {
+        SimI2cPads(index, now);
+    }
+
+    if (!(i2c->CR1 & I2C_CR1_PE))
+    {
+        return;
+    }
+
+    bool progress = true;
+
+    while (progress)
+    {
+        progress = false;
+
+        switch (state->phase)
+        {
+            case SIM_I2C_IDLE:
+            case SIM_I2C_SB:
+            case SIM_I2C_ADDR:
+            case SIM_I2C_HOLD:
+
+                if (i2c->CR1 & I2C_CR1_STOP)
+                {
+                    if (state->master)
+                    {
+                        state->phase = SIM_I2C_STOP;
+                        state->phaseEnd = now + SimI2cPeriod(index);
+                        progress = true;
+                    }
+                    else
+                    {
+                        i2c->CR1 &= ~I2C_CR1_STOP;
+                    }
+                }
+                else if ((i2c->CR1 & I2C_CR1_START) && (state->master || !state->busyLatched))
+                {
+                    /* repeated START by the owner, or START on a free bus */
+                    state->phase = SIM_I2C_START;
+                    state->phaseEnd = now + SimI2cPeriod(index);
+                    state->master = true;
+                    progress = true;
+                }
+
+                break;
+
+            case SIM_I2C_START:
+
+                if (now >= state->phaseEnd)
+                {
+                    i2c->CR1 &= ~I2C_CR1_START;
+                    i2c->SR1 |= I2C_SR1_SB;
+                    i2c->SR2 = (i2c->SR2 & ~I2C_SR2_TRA) | I2C_SR2_MSL;
+                    state->phase = SIM_I2C_SB;
+                }
+
+                break;
+
+            case SIM_I2C_ADDRESS:
+            case SIM_I2C_TX:
+            case SIM_I2C_RX:
+
+                if (now >= state->phaseEnd)
+                {
+                    SimI2cByteEnd(index, state->phaseEnd);
+                    progress = true;
+                }
+
+                break;
+
+            case SIM_I2C_STOP:
+
+                if (now >= state->phaseEnd)
+                {
+                    i2c->CR1 &= ~I2C_CR1_STOP;
+                    i2c->SR1 &= ~(I2C_SR1_TXE | I2C_SR1_BTF);
+                    i2c->SR2 &= ~(I2C_SR2_MSL | I2C_SR2_TRA);
+                    state->phase = SIM_I2C_IDLE;
+                    state->master = false;
+                    state->busyLatched = false;
+
+                    if (state->device != NULL)
+                    {
+                        state->device->stops++;
+                    }
+
+                    state->device = NULL;
+                }
+
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if (state->master || state->busyLatched)
+    {
+        i2c->SR2 |= I2C_SR2_BUSY;
+    }
+    else
+    {
+        i2c->SR2 &= ~I2C_SR2_BUSY;
+    }
+}
+
+static void SimI2cStep(uint64_t now)
+{
+    for (uint32_t i = 0; i < SIM_I2C_COUNT; i++)
+    {
+        SimI2cStepIndex(i, now);
+    }
+}
+
+static void SimI2cOnDr(uint32_t index, const MmioAccess_t* const access)
+{
+    I2C_TypeDef* i2c = m_SimI2cInstance[index];
+    SimI2c_t* state = &m_SimI2c[index];
+
+    if (access->write)
+    {
+        if (state->phase == SIM_I2C_SB)
+        {
+            /* RM0383 18.3.3: SB is cleared by SR1 read then DR write */
+            i2c->SR1 &= ~I2C_SR1_SB;
+            state->address = (uint8_t)((i2c->DR & 0xFFU) >> 1U);
+            state->read = (i2c->DR & 0x01U) != 0U;
+            state->phase = SIM_I2C_ADDRESS;
+            state->phaseEnd = SimClockNow() + SIM_I2C_BYTE_CLOCKS * SimI2cPeriod(index);
+            return;
+        }
+
+        if (!(i2c->SR2 & I2C_SR2_TRA))
+        {
+            return;
+        }
+
+        i2c->SR1 &= ~I2C_SR1_BTF;
+
+        if ((state->phase == SIM_I2C_HOLD) && !(i2c->SR1 & I2C_SR1_AF))
+        {
+            state->shifter = (uint8_t)i2c->DR;
+            i2c->SR1 |= I2C_SR1_TXE;
+            SimI2cByte(index, SIM_I2C_TX, SimClockNow());
+        }
+        else
+        {
+            i2c->SR1 &= ~I2C_SR1_TXE;
+        }
+
+        return;
+    }
+
+    if (!(i2c->SR1 & I2C_SR1_RXNE))
+    {
+        return;
+    }
+
+    i2c->SR1 &= ~I2C_SR1_RXNE;
+
+    if (state->held)
+    {
+        /* RM0383 18.3.3: BTF is cleared by SR1 read then DR read */
+        i2c->DR = state->shifter;
+        i2c->SR1 = (i2c->SR1 & ~I2C_SR1_BTF) | I2C_SR1_RXNE;
+        state->held = false;
+
+        if ((state->phase == SIM_I2C_HOLD) && !state->nacked && !(i2c->CR1 & (I2C_CR1_STOP | I2C_CR1_START)))
+        {
+            SimI2cByte(index, SIM_I2C_RX, SimClockNow());
+        }
+    }
+}
+
+static void SimI2cOnAccess(const MmioAccess_t* const access)
+{
+    uintptr_t offset = (access->address - (uintptr_t)I2C1) % 0x400U;
+    I2C_TypeDef* i2c = (I2C_TypeDef*)(access->address - offset);
+    int32_t index = SimI2cIndex(i2c);
+
+    if (index < 0)
+    {
+        return;
+    }
+
+    SimI2c_t* state = &m_SimI2c[index];
+
+    if (offset == offsetof(I2C_TypeDef, SR1))
+    {
+        if (access->write)
+        {
+            i2c->SR1 = (access->old & ~SIM_I2C_SR1_RC_W0) | (access->old & i2c->SR1 & SIM_I2C_SR1_RC_W0);
+        }
+        else
+        {
+            state->sr1Read = true;
+        }
+    }
+    else if (offset == offsetof(I2C_TypeDef, SR2))
+    {
+        if (access->write)
+        {
+            i2c->SR2 = access->old;
+        }
+        else if (state->sr1Read && (i2c->SR1 & I2C_SR1_ADDR))
+        {
+            /* RM0383 18.3.3: ADDR is cleared by SR1 read then SR2 read */
+            i2c->SR1 &= ~I2C_SR1_ADDR;
+            state->sr1Read = false;
+
+            if (i2c->SR2 & I2C_SR2_TRA)
+            {
+                i2c->SR1 |= I2C_SR1_TXE;
+                state->phase = SIM_I2C_HOLD;
+            }
+            else
+            {
+                SimI2cByte((uint32_t)index, SIM_I2C_RX, SimClockNow());
+            }
+        }
+    }
+    else if (offset == offsetof(I2C_TypeDef, DR))
+    {
+        SimI2cOnDr((uint32_t)index, access);
+        state->sr1Read = false;
+    }
+    else if ((offset == offsetof(I2C_TypeDef, CR1)) && access->write)
+    {
+        if (i2c->CR1 & I2C_CR1_SWRST)
+        {
+            /* RM0383 18.6.1: all registers are reset, BUSY included */
+            SimI2cReset((uint32_t)index);
+            i2c->CR1 = I2C_CR1_SWRST;
+        }
+        else if ((access->old & I2C_CR1_PE) && !(i2c->CR1 & I2C_CR1_PE))
+        {
+            /* transfer is cut, BUSY latched from the lines stays */
+            i2c->CR1 &= ~(I2C_CR1_START | I2C_CR1_STOP);
+            i2c->SR1 = 0;
+            i2c->SR2 &= I2C_SR2_BUSY;
+            state->phase = SIM_I2C_IDLE;
+            state->master = false;
+            state->held = false;
+            state->device = NULL;
+        }
+    }
+}
+
+static bool SimI2cEvLevel(uint32_t index)
+{
+    I2C_TypeDef* i2c = m_SimI2cInstance[index];
+    uint32_t sr1 = i2c->SR1;
+    uint32_t cr2 = i2c->CR2;
+
+    if (!(cr2 & I2C_CR2_ITEVTEN))
+    {
+        return false;
+    }
+
+    return (sr1 & (I2C_SR1_SB | I2C_SR1_ADDR | I2C_SR1_BTF | I2C_SR1_STOPF | I2C_SR1_ADD10))
+           || ((sr1 & (I2C_SR1_TXE | I2C_SR1_RXNE)) && (cr2 & I2C_CR2_ITBUFEN));
+}
+
+static bool SimI2cErLevel(uint32_t index)
+{
+    I2C_TypeDef* i2c = m_SimI2cInstance[index];
+
+    return (i2c->CR2 & I2C_CR2_ITERREN) && (i2c->SR1 & SIM_I2C_SR1_RC_W0);
+}
+
+static bool SimI2cEvLevel1(void)
+{
+    return SimI2cEvLevel(0);
+}
+
+static bool SimI2cEvLevel2(void)
+{
+    return SimI2cEvLevel(1);
+}
+
+static bool SimI2cEvLevel3(void)
+{
+    return SimI2cEvLevel(2);
+}
+
+static bool SimI2cErLevel1(void)
+{
+    return SimI2cErLevel(0);
+}
+
+static bool SimI2cErLevel2(void)
+{
+    return SimI2cErLevel(1);
+}
+
+static bool SimI2cErLevel3(void)
+{
+    return SimI2cErLevel(2);
+}
+
+void Stm32I2cModelInit(void)
+{
+    static const SimIrqLevel_t EV_LEVELS[SIM_I2C_COUNT] = { &SimI2cEvLevel1, &SimI2cEvLevel2, &SimI2cEvLevel3 };
+    static const SimIrqLevel_t ER_LEVELS[SIM_I2C_COUNT] = { &SimI2cErLevel1, &SimI2cErLevel2, &SimI2cErLevel3 };
+
+    memset(m_SimI2c, 0, sizeof(m_SimI2c));
+
+    for (uint32_t i = 0; i < SIM_I2C_COUNT; i++)
+    {
+        SimI2cReset(i);
+
+        MmioHook(m_SimI2cInstance[i], sizeof(I2C_TypeDef), NULL, &SimI2cOnAccess);
+        SimIrqSetLevel(m_SimI2cEvIrq[i], EV_LEVELS[i]);
+        SimIrqSetLevel(m_SimI2cErIrq[i], ER_LEVELS[i]);
+    }
+
+    SimClockAddModel(&SimI2cStep);
+}
+
+/*Brief: Put pull-ups on the bus lines on first use of the bus
+ * [in] - index - I2C index
+ * [out] - none
+ * */
+static void SimI2cPopulate(uint32_t index)
+{
+    SimI2c_t* state = &m_SimI2c[index];
+
+    if (!state->populated)
+    {
+        state->populated = true;
+        state->sclLevel = true;
+
+        Stm32GpioModelDrive(m_SimI2cSda[index], true);
+        Stm32GpioModelDrive(m_SimI2cScl[index], true);
+    }
+}
+
+void Stm32I2cAttach(I2C_TypeDef* i2c, Stm32I2cDevice_t* device)
+{
+    int32_t index = SimI2cIndex(i2c);
+
+    if (index < 0)
+    {
+        return;
+    }
+
+    SimI2cPopulate((uint32_t)index);
+
+    for (uint32_t i = 0; i < SIM_I2C_DEVICES; i++)
+    {
+        if (m_SimI2c[index].devices[i] == NULL)
+        {
+            m_SimI2c[index].devices[i] = device;
+            return;
+        }
+    }
+}
+
+void Stm32I2cHoldSda(I2C_TypeDef* i2c, uint32_t clocks)
+{
+    int32_t index = SimI2cIndex(i2c);
+
+    if ((index < 0) || (clocks == 0U))
+    {
+        return;
+    }
+
+    SimI2cPopulate((uint32_t)index);
+
+    m_SimI2c[index].sdaHeld = true;
+    m_SimI2c[index].sdaClocks = clocks;
+
+    Stm32GpioModelDrive(m_SimI2cSda[index], false);
+}
+
+void Stm32I2cStretch(I2C_TypeDef* i2c, uint32_t byte, uint64_t cycles)
+{
+    int32_t index = SimI2cIndex(i2c);
+
+    if (index >= 0)
+    {
+        m_SimI2c[index].stretchArmed = true;
+        m_SimI2c[index].stretchByte = byte;
+        m_SimI2c[index].stretchCycles = cycles;
+    }
+}
+
+uint32_t Stm32I2cSclClocks(I2C_TypeDef* i2c)
+{
+    int32_t index = SimI2cIndex(i2c);
+
+    return (index < 0) ? 0U : m_SimI2c[index].sclClocks;
+}
+
+uint64_t Stm32I2cByteCycles(I2C_TypeDef* i2c)
+{
+    int32_t index = SimI2cIndex(i2c);
+
+    if (index < 0)
+    {
+        return 0;
+    }
+
+    MmioOpen();
+    uint64_t period = SimI2cPeriod((uint32_t)index);
+    MmioClose();
+
+    return SIM_I2C_BYTE_CLOCKS * period;
+}
@@ -0,0 +1,332 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "mmio.h"
+#include "stm32-sim.h"
+
+#define SIM_SPI_COUNT           (5U)
+
+/* cleared by writing 0, other SR bits are read only */
+#define SIM_SPI_SR_RC_W0        (SPI_SR_CRCERR)
+
+typedef struct
+{
+    uint16_t tdr;
+    uint16_t shifter;
+    bool shifting;
+    bool wide;              /* frame format latched when the frame started */
+    uint64_t shiftEnd;
+    bool ovrRead;           /* DR read since OVR, SR read completes clearing */
+    Stm32SpiSlave_t slave;
+    void* context;
+} SimSpi_t;
+
+static SimSpi_t m_SimSpi[SIM_SPI_COUNT];
+
+static SPI_TypeDef* const m_SimSpiInstance[SIM_SPI_COUNT] = { SPI1, SPI2, SPI3, SPI4, SPI5 };
+static const bool m_SimSpiApb2[SIM_SPI_COUNT] = { true, false, false, true, true };
+static const IRQn_Type m_SimSpiIrq[SIM_SPI_COUNT] = { SPI1_IRQn, SPI2_IRQn, SPI3_IRQn, SPI4_IRQn, SPI5_IRQn };
+
+static const STM32_DMA_REQUEST m_SimSpiRxRequest[SIM_SPI_COUNT] = {
+    STM32_DMA_SPI1_RX, STM32_DMA_SPI2_RX, STM32_DMA_SPI3_RX, STM32_DMA_SPI4_RX, STM32_DMA_SPI5_RX
+};
+
+static const STM32_DMA_REQUEST m_SimSpiTxRequest[SIM_SPI_COUNT] = {
+    STM32_DMA_SPI1_TX, STM32_DMA_SPI2_TX, STM32_DMA_SPI3_TX, STM32_DMA_SPI4_TX, STM32_DMA_SPI5_TX
+};
+
+static int32_t SimSpiIndex(const SPI_TypeDef* spi)
+{
+    for (uint32_t i = 0; i < SIM_SPI_COUNT; i++)
+    {
+        if (m_SimSpiInstance[i] == spi)
+        {
+            return (int32_t)i;
+        }
+    }
+
+    return -1;
+}
+
+/*Brief: Frame time from BR and DFF, register space must be open
+ * [in] - index - SPI index
+ * [in] - wide - true - 16-bit frame
+ * [out] - core cycles per frame; 0 - bus clock not running
+ * */
+static uint64_t SimSpiFrame(uint32_t index, bool wide)
+{
+    SPI_TypeDef* spi = m_SimSpiInstance[index];
+    uint32_t br = (spi->CR1 & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos;
+    uint64_t pclk = Stm32SimPclk(m_SimSpiApb2[index]);
+
+    if (pclk == 0U)
+    {
+        return 0;
+    }
+
+    /* RM0383 20.5.1: fPCLK / 2^(BR + 1) */
+    return ((wide ? 16ULL : 8ULL) * (2ULL << br) * SystemCoreClock) / pclk;
+}
+
+/*Brief: Hand received frame to DMA or to the RX buffer
+ * [in] - index - SPI index
+ * [in] - data - received frame
+ * [out] - none
+ * */
+static void SimSpiReceive(uint32_t index, uint16_t data)
+{
+    SPI_TypeDef* spi = m_SimSpiInstance[index];
+
+    if ((spi->CR2 & SPI_CR2_RXDMAEN) && !(spi->SR & SPI_SR_RXNE)
+        && Stm32DmaPeripheralWrite(m_SimSpiRxRequest[index], &spi->DR, data))
+    {
+        return;
+    }
+
+    if (spi->SR & SPI_SR_RXNE)
+    {
+        /* RM0383 20.4.8: previous frame not read, new frame is lost */
+        spi->SR |= SPI_SR_OVR;
+        m_SimSpi[index].ovrRead = false;
+    }
+    else
+    {
+        spi->DR = data;
+        spi->SR |= SPI_SR_RXNE;
+    }
+}
+
+/*Brief: Load TX buffer into the shift register, fetch next item by DMA
+ * [in] - index - SPI index
+ * [in] - start - frame start time
+ * [out] - none
+ * */
+static void SimSpiLoad(uint32_t index, uint64_t start)
+{
+    SPI_TypeDef* spi = m_SimSpiInstance[index];
+    SimSpi_t* state = &m_SimSpi[index];
+
+    if (!(spi->SR & SPI_SR_TXE) && !state->shifting)
+    {
+        state->shifter = state->tdr;
+        state->shifting = true;
+        state->wide = (spi->CR1 & SPI_CR1_DFF) != 0U;
+        state->shiftEnd = start + SimSpiFrame(index, state->wide);
+        spi->SR |= SPI_SR_TXE | SPI_SR_BSY;
+    }
+
+    if ((spi->SR & SPI_SR_TXE) && (spi->CR2 & SPI_CR2_TXDMAEN))
+    {
+        uint32_t data;
+
+        if (Stm32DmaPeripheralRead(m_SimSpiTxRequest[index], &spi->DR, &data))
+        {
+            state->tdr = (uint16_t)data;
+            spi->SR &= ~SPI_SR_TXE;
+
+            if (!state->shifting)
+            {
+                SimSpiLoad(index, start);
+            }
+        }
+    }
+}
+
+static void SimSpiStepIndex(uint32_t index, uint64_t now)
+{
+    SPI_TypeDef* spi = m_SimSpiInstance[index];
+    SimSpi_t* state = &m_SimSpi[index];
+
+    /* RM0383 20.3.9: RXNE raises the DMA request when RXDMAEN gets set later */
+    if ((spi->SR & SPI_SR_RXNE) && (spi->CR2 & SPI_CR2_RXDMAEN)
+        && Stm32DmaPeripheralWrite(m_SimSpiRxRequest[index], &spi->DR, spi->DR & 0xFFFFU))
+    {
+        spi->SR &= ~SPI_SR_RXNE;
+    }
+
+    SimSpiLoad(index, now);
+
+    while (state->shifting && (now >= state->shiftEnd))
+    {
+        uint64_t end = state->shiftEnd;
+        uint16_t mosi = state->wide ? state->shifter : (uint16_t)(state->shifter & 0xFFU);
+        uint16_t miso = state->wide ? 0xFFFFU : 0xFFU;
+
+        /* MISO idles high when no slave drives it */
+        if (state->slave != NULL)
+        {
+            miso = (*state->slave)(mosi, state->wide, state->context);
+        }
+
+        state->shifting = false;
+
+        SimSpiReceive(index, state->wide ? miso : (uint16_t)(miso & 0xFFU));
+
+        /* next frame follows back to back when TX buffer is full */
+        SimSpiLoad(index, end);
+
+        if (!state->shifting)
+        {
+            spi->SR &= ~SPI_SR_BSY;
+        }
+    }
+}
+
+static void SimSpiStep(uint64_t now)
+{
+    for (uint32_t i = 0; i < SIM_SPI_COUNT; i++)
+    {
+        SPI_TypeDef* spi = m_SimSpiInstance[i];
+
+        if ((spi->CR1 & (SPI_CR1_SPE | SPI_CR1_MSTR)) != (SPI_CR1_SPE | SPI_CR1_MSTR))
+        {
+            continue;
+        }
+
+        SimSpiStepIndex(i, now);
+    }
+}
+
+static void SimSpiOnAccess(const MmioAccess_t* const access)
+{
+    uintptr_t offset = (access->address - (uintptr_t)SPI1) % 0x40U;
+    SPI_TypeDef* spi = (SPI_TypeDef*)(access->address - offset);
+    int32_t index = SimSpiIndex(spi);
+
+    if (index < 0)
+    {
+        return;
+    }
+
+    SimSpi_t* state = &m_SimSpi[index];
+
+    if (offset == offsetof(SPI_TypeDef, SR))
+    {
+        if (access->write)
+        {
+            spi->SR = (access->old & ~SIM_SPI_SR_RC_W0) | (access->old & spi->SR & SIM_SPI_SR_RC_W0);
+        }
+        else if (state->ovrRead)
+        {
+            /* RM0383 20.4.8: OVR is cleared by a DR read followed by an SR read */
+            spi->SR &= ~SPI_SR_OVR;
+            state->ovrRead = false;
+        }
+    }
+    else if (offset == offsetof(SPI_TypeDef, DR))
+    {
+        if (access->write)
+        {
+            /* TX and RX buffers share the address: keep RX buffer readable */
+            state->tdr = (uint16_t)(spi->DR & 0xFFFFU);
+            spi->DR = access->old;
+
+            if (spi->CR1 & SPI_CR1_SPE)
+            {
+                spi->SR &= ~SPI_SR_TXE;
+                SimSpiLoad((uint32_t)index, SimClockNow());
+            }
+        }
+        else
+        {
+            spi->SR &= ~SPI_SR_RXNE;
+
+            if (spi->SR & SPI_SR_OVR)
+            {
+                state->ovrRead = true;
+            }
+        }
+    }
+    else if (offset == offsetof(SPI_TypeDef, CR1))
+    {
+        if (access->write && (access->old & SPI_CR1_SPE) && !(spi->CR1 & SPI_CR1_SPE))
+        {
+            /* a frame in progress is cut, TX buffer is flushed */
+            state->shifting = false;
+            spi->SR = (spi->SR & ~SPI_SR_BSY) | SPI_SR_TXE;
+        }
+    }
+}
+
+static bool SimSpiLevel(uint32_t index)
+{
+    SPI_TypeDef* spi = m_SimSpiInstance[index];
+    uint32_t sr = spi->SR;
+    uint32_t cr2 = spi->CR2;
+
+    return ((sr & SPI_SR_RXNE) && (cr2 & SPI_CR2_RXNEIE))
+           || ((sr & SPI_SR_TXE) && (cr2 & SPI_CR2_TXEIE))
+           || ((sr & (SPI_SR_OVR | SPI_SR_MODF | SPI_SR_CRCERR)) && (cr2 & SPI_CR2_ERRIE));
+}
+
+static bool SimSpiLevel1(void)
+{
+    return SimSpiLevel(0);
+}
+
+static bool SimSpiLevel2(void)
+{
+    return SimSpiLevel(1);
+}
+
+static bool SimSpiLevel3(void)
+{
+    return SimSpiLevel(2);
+}
+
+static bool SimSpiLevel4(void)
+{
+    return SimSpiLevel(3);
+}
+
+static bool SimSpiLevel5(void)
+{
+    return SimSpiLevel(4);
+}
+
+void Stm32SpiModelInit(void)
+{
+    static const SimIrqLevel_t LEVELS[SIM_SPI_COUNT] = {
+        &SimSpiLevel1, &SimSpiLevel2, &SimSpiLevel3, &SimSpiLevel4, &SimSpiLevel5
+    };
+
+    memset(m_SimSpi, 0, sizeof(m_SimSpi));
+
+    for (uint32_t i = 0; i < SIM_SPI_COUNT; i++)
+    {
+        /* reset value: TXE set */
+        m_SimSpiInstance[i]->SR = SPI_SR_TXE;
+
+        MmioHook(m_SimSpiInstance[i], sizeof(SPI_TypeDef), NULL, &SimSpiOnAccess);
+        SimIrqSetLevel(m_SimSpiIrq[i], LEVELS[i]);
+    }
+
+    SimClockAddModel(&SimSpiStep);
+}
+
+void Stm32SpiAttach(SPI_TypeDef* spi, Stm32SpiSlave_t slave, void* context)
+{
+    int32_t index = SimSpiIndex(spi);
+
+    if (index >= 0)
+    {
+        m_SimSpi[index].slave = slave;
+        m_SimSpi[index].context = context;
+    }
+}
+
+uint64_t Stm32SpiFrameCycles(SPI_TypeDef* spi, bool wide)
+{
+    int32_t index = SimSpiIndex(spi);
+
+    if (index < 0)
+    {
+        return 0;
+    }
+
+    MmioOpen();
+    uint64_t frame = SimSpiFrame((uint32_t)index, wide);
+    MmioClose();
+
+    return frame;
+}
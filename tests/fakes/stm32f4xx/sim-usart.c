@@ -0,0 +1,417 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "mmio.h"
+#include "stm32-sim.h"
+
+#define SIM_USART_COUNT         (3U)
+#define SIM_USART_QUEUE         (4096U)
+
+#define SIM_USART_RX_ERRORS     (USART_SR_PE | USART_SR_FE | USART_SR_NE | USART_SR_ORE)
+
+/* cleared by writing 0, other SR bits are read only */
+#define SIM_USART_SR_RC_W0      (USART_SR_RXNE | USART_SR_TC | USART_SR_LBD | USART_SR_CTS)
+
+typedef struct
+{
+    uint8_t data[SIM_USART_QUEUE];
+    uint32_t head;
+    uint32_t tail;
+} SimUsartQueue_t;
+
+typedef struct
+{
+    uint16_t tdr;
+    uint16_t shifter;
+    bool shifting;
+    uint64_t shiftEnd;
+    SimUsartQueue_t txLog;
+
+    SimUsartQueue_t rx;
+    uint8_t rxErrors[SIM_USART_QUEUE];
+    uint32_t nextErrors;
+    uint64_t rxNext;
+    bool idlePending;
+    uint64_t idleAt;
+
+    bool srRead;            /* first half of the SR read, DR access sequence */
+} SimUsart_t;
+
+static SimUsart_t m_SimUsart[SIM_USART_COUNT];
+
+static USART_TypeDef* const m_SimUsartInstance[SIM_USART_COUNT] = { USART1, USART2, USART6 };
+static const bool m_SimUsartApb2[SIM_USART_COUNT] = { true, false, true };
+static const IRQn_Type m_SimUsartIrq[SIM_USART_COUNT] = { USART1_IRQn, USART2_IRQn, USART6_IRQn };
+
+static const STM32_DMA_REQUEST m_SimUsartRxRequest[SIM_USART_COUNT] = {
+    STM32_DMA_USART1_RX, STM32_DMA_USART2_RX, STM32_DMA_USART6_RX
+};
+
+static const STM32_DMA_REQUEST m_SimUsartTxRequest[SIM_USART_COUNT] = {
+    STM32_DMA_USART1_TX, STM32_DMA_USART2_TX, STM32_DMA_USART6_TX
+};
+
+static bool SimUsartQueuePut(SimUsartQueue_t* const queue, uint8_t data)
+{
+    uint32_t next = (queue->head + 1U) % SIM_USART_QUEUE;
+
+    if (next == queue->tail)
+    {
+        return false;
+    }
+
+    queue->data[queue->head] = data;
+    queue->head = next;
+
+    return true;
+}
+
+static bool SimUsartQueueEmpty(const SimUsartQueue_t* const queue)
+{
+    return queue->head == queue->tail;
+}
+
+static int32_t SimUsartIndex(const USART_TypeDef* usart)
+{
+    for (uint32_t i = 0; i < SIM_USART_COUNT; i++)
+    {
+        if (m_SimUsartInstance[i] == usart)
+        {
+            return (int32_t)i;
+        }
+    }
+
+    return -1;
+}
+
+/*Brief: Frame time from BRR and oversampling, register space must be open
+ * [in] - index - USART index
+ * [out] - core cycles per 10 bit frame; 0 - BRR not programmed
+ * */
+static uint64_t SimUsartFrame(uint32_t index)
+{
+    USART_TypeDef* usart = m_SimUsartInstance[index];
+    uint32_t brr = usart->BRR & 0xFFFFU;
+
+    /* RM0383 19.3.4: BRR holds the bit time in APB cycles, with the
+     * OVER8 fraction shifted by one */
+    uint32_t div = (usart->CR1 & USART_CR1_OVER8) ? (((brr >> 4U) << 3U) | (brr & 0x07U)) : brr;
+    uint64_t pclk = Stm32SimPclk(m_SimUsartApb2[index]);
+
+    if ((div == 0U) || (pclk == 0U))
+    {
+        return 0;
+    }
+
+    return (10ULL * div * SystemCoreClock) / pclk;
+}
+
+/*Brief: Load TDR into the shift register, fetch next item by DMA
+ * [in] - index - USART index
+ * [in] - start - frame start time
+ * [out] - none
+ * */
+static void SimUsartLoad(uint32_t index, uint64_t start)
+{
+    USART_TypeDef* usart = m_SimUsartInstance[index];
+    SimUsart_t* state = &m_SimUsart[index];
+
+    if (!(usart->SR & USART_SR_TXE) && !state->shifting)
+    {
+        state->shifter = state->tdr;
+        state->shifting = true;
+        state->shiftEnd = start + SimUsartFrame(index);
+        usart->SR |= USART_SR_TXE;
+    }
+
+    if ((usart->SR & USART_SR_TXE) && (usart->CR3 & USART_CR3_DMAT))
+    {
+        uint32_t data;
+
+        if (Stm32DmaPeripheralRead(m_SimUsartTxRequest[index], &usart->DR, &data))
+        {
+            state->tdr = (uint16_t)data;
+            usart->SR &= ~USART_SR_TXE;
+
+            if (!state->shifting)
+            {
+                SimUsartLoad(index, start);
+            }
+        }
+    }
+}
+
+static void SimUsartStepTx(uint32_t index, uint64_t now)
+{
+    USART_TypeDef* usart = m_SimUsartInstance[index];
+    SimUsart_t* state = &m_SimUsart[index];
+
+    SimUsartLoad(index, now);
+
+    while (state->shifting && (now >= state->shiftEnd))
+    {
+        uint64_t end = state->shiftEnd;
+
+        /* log keeps the first SIM_USART_QUEUE frames when never drained */
+        (void)SimUsartQueuePut(&state->txLog, (uint8_t)state->shifter);
+        state->shifting = false;
+
+        /* next frame follows the stop bit back to back */
+        SimUsartLoad(index, end);
+
+        if (!state->shifting)
+        {
+            usart->SR |= USART_SR_TC;
+        }
+    }
+}
+
+static void SimUsartStepRx(uint32_t index, uint64_t now)
+{
+    USART_TypeDef* usart = m_SimUsartInstance[index];
+    SimUsart_t* state = &m_SimUsart[index];
+    uint64_t frame = SimUsartFrame(index);
+
+    while (!SimUsartQueueEmpty(&state->rx) && (now >= state->rxNext))
+    {
+        uint8_t data = state->rx.data[state->rx.tail];
+        uint32_t errors = state->rxErrors[state->rx.tail];
+
+        state->rx.tail = (state->rx.tail + 1U) % SIM_USART_QUEUE;
+
+        if (!(usart->CR1 & USART_CR1_RE))
+        {
+            state->rxNext += frame;
+            continue;
+        }
+
+        if (usart->SR & USART_SR_RXNE)
+        {
+            /* previous frame not read: new frame is lost */
+            usart->SR |= USART_SR_ORE;
+        }
+        else
+        {
+            usart->SR |= errors;
+
+            if (!((usart->CR3 & USART_CR3_DMAR)
+                  && Stm32DmaPeripheralWrite(m_SimUsartRxRequest[index], &usart->DR, data)))
+            {
+                usart->DR = data;
+                usart->SR |= USART_SR_RXNE;
+            }
+        }
+
+        state->idlePending = true;
+        state->idleAt = state->rxNext + frame;
+        state->rxNext += frame;
+    }
+
+    if (state->idlePending && SimUsartQueueEmpty(&state->rx) && (now >= state->idleAt))
+    {
+        state->idlePending = false;
+        usart->SR |= USART_SR_IDLE;
+    }
+}
+
+static void SimUsartStep(uint64_t now)
+{
+    for (uint32_t i = 0; i < SIM_USART_COUNT; i++)
+    {
+        USART_TypeDef* usart = m_SimUsartInstance[i];
+
+        if (!(usart->CR1 & USART_CR1_UE) || (SimUsartFrame(i) == 0U))
+        {
+            continue;
+        }
+
+        if (usart->CR1 & USART_CR1_TE)
+        {
+            SimUsartStepTx(i, now);
+        }
+
+        SimUsartStepRx(i, now);
+    }
+}
+
+static void SimUsartOnAccess(const MmioAccess_t* const access)
+{
+    uintptr_t offset = (access->address - (uintptr_t)USART1) % 0x40U;
+    USART_TypeDef* usart = (USART_TypeDef*)(access->address - offset);
+    int32_t index = SimUsartIndex(usart);
+
+    if (index < 0)
+    {
+        return;
+    }
+
+    SimUsart_t* state = &m_SimUsart[index];
+
+    if (offset == offsetof(USART_TypeDef, SR))
+    {
+        if (access->write)
+        {
+            usart->SR = (access->old & ~SIM_USART_SR_RC_W0) | (access->old & usart->SR & SIM_USART_SR_RC_W0);
+        }
+        else
+        {
+            state->srRead = true;
+        }
+    }
+    else if (offset == offsetof(USART_TypeDef, DR))
+    {
+        if (access->write)
+        {
+            /* TDR and RDR share the address: keep RDR readable */
+            state->tdr = (uint16_t)(usart->DR & 0x1FFU);
+            usart->DR = access->old;
+
+            if (state->srRead)
+            {
+                usart->SR &= ~USART_SR_TC;
+            }
+
+            if (usart->CR1 & USART_CR1_TE)
+            {
+                usart->SR &= ~USART_SR_TXE;
+                SimUsartLoad((uint32_t)index, SimClockNow());
+            }
+        }
+        else
+        {
+            usart->SR &= ~USART_SR_RXNE;
+
+            if (state->srRead)
+            {
+                usart->SR &= ~(USART_SR_IDLE | SIM_USART_RX_ERRORS);
+            }
+        }
+
+        state->srRead = false;
+    }
+}
+
+static bool SimUsartLevel(uint32_t index)
+{
+    USART_TypeDef* usart = m_SimUsartInstance[index];
+    uint32_t sr = usart->SR;
+    uint32_t cr1 = usart->CR1;
+    uint32_t cr3 = usart->CR3;
+
+    return ((sr & (USART_SR_RXNE | USART_SR_ORE)) && (cr1 & USART_CR1_RXNEIE))
+           || ((sr & USART_SR_IDLE) && (cr1 & USART_CR1_IDLEIE))
+           || ((sr & USART_SR_TC) && (cr1 & USART_CR1_TCIE))
+           || ((sr & USART_SR_TXE) && (cr1 & USART_CR1_TXEIE))
+           || ((sr & USART_SR_PE) && (cr1 & USART_CR1_PEIE))
+           || ((sr & (USART_SR_FE | USART_SR_NE | USART_SR_ORE)) && (cr3 & USART_CR3_EIE) && (cr3 & USART_CR3_DMAR));
+}
+
+static bool SimUsartLevel1(void)
+{
+    return SimUsartLevel(0);
+}
+
+static bool SimUsartLevel2(void)
+{
+    return SimUsartLevel(1);
+}
+
+static bool SimUsartLevel6(void)
+{
+    return SimUsartLevel(2);
+}
+
+void Stm32UsartModelInit(void)
+{
+    memset(m_SimUsart, 0, sizeof(m_SimUsart));
+
+    for (uint32_t i = 0; i < SIM_USART_COUNT; i++)
+    {
+        /* reset value: TXE and TC set */
+        m_SimUsartInstance[i]->SR = USART_SR_TXE | USART_SR_TC;
+
+        MmioHook(m_SimUsartInstance[i], sizeof(USART_TypeDef), NULL, &SimUsartOnAccess);
+    }
+
+    SimIrqSetLevel(m_SimUsartIrq[0], &SimUsartLevel1);
+    SimIrqSetLevel(m_SimUsartIrq[1], &SimUsartLevel2);
+    SimIrqSetLevel(m_SimUsartIrq[2], &SimUsartLevel6);
+
+    SimClockAddModel(&SimUsartStep);
+}
+
+void Stm32UsartReceive(USART_TypeDef* usart, const uint8_t* data, uint32_t size)
+{
+    int32_t index = SimUsartIndex(usart);
+
+    if (index < 0)
+    {
+        return;
+    }
+
+    SimUsart_t* state = &m_SimUsart[index];
+
+    MmioOpen();
+
+    if (SimUsartQueueEmpty(&state->rx))
+    {
+        state->rxNext = SimClockNow() + SimUsartFrame((uint32_t)index);
+    }
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        state->rxErrors[state->rx.head] = (uint8_t)state->nextErrors;
+        state->nextErrors = 0;
+
+        (void)SimUsartQueuePut(&state->rx, data[i]);
+    }
+
+    MmioClose();
+}
+
+void Stm32UsartReceiveError(USART_TypeDef* usart, uint32_t flags)
+{
+    int32_t index = SimUsartIndex(usart);
+
+    if (index >= 0)
+    {
+        m_SimUsart[index].nextErrors = flags & (USART_SR_PE | USART_SR_FE | USART_SR_NE);
+    }
+}
+
+uint32_t Stm32UsartTransmitted(USART_TypeDef* usart, uint8_t* data, uint32_t max)
+{
+    int32_t index = SimUsartIndex(usart);
+    uint32_t count = 0;
+
+    if (index < 0)
+    {
+        return 0;
+    }
+
+    SimUsartQueue_t* log = &m_SimUsart[index].txLog;
+
+    while (!SimUsartQueueEmpty(log) && (count < max))
+    {
+        data[count++] = log->data[log->tail];
+        log->tail = (log->tail + 1U) % SIM_USART_QUEUE;
+    }
+
+    return count;
+}
+
+uint64_t Stm32UsartFrameCycles(USART_TypeDef* usart)
+{
+    int32_t index = SimUsartIndex(usart);
+
+    if (index < 0)
+    {
+        return 0;
+    }
+
+    MmioOpen();
+    uint64_t frame = SimUsartFrame((uint32_t)index);
+    MmioClose();
+
+    return frame;
+}
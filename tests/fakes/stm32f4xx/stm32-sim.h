@@ -0,0 +1,215 @@
+#ifndef STM32_SIM_H
+#define STM32_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "stm32f411xe.h"
+
+#include "sim.h"
+#include "sim-gpio.h"
+
+/* RM0383 9.3.3 DMA request lines modelled by the peripheral models */
+typedef enum
+{
+    STM32_DMA_USART1_RX = 0,
+    STM32_DMA_USART1_TX,
+    STM32_DMA_USART2_RX,
+    STM32_DMA_USART2_TX,
+    STM32_DMA_USART6_RX,
+    STM32_DMA_USART6_TX,
+    STM32_DMA_SPI1_RX,
+    STM32_DMA_SPI1_TX,
+    STM32_DMA_SPI2_RX,
+    STM32_DMA_SPI2_TX,
+    STM32_DMA_SPI3_RX,
+    STM32_DMA_SPI3_TX,
+    STM32_DMA_SPI4_RX,
+    STM32_DMA_SPI4_TX,
+    STM32_DMA_SPI5_RX,
+    STM32_DMA_SPI5_TX,
+    STM32_DMA_REQUEST_COUNT
+} STM32_DMA_REQUEST;
+
+/*Brief: Slave on the SPI bus, exchanges one frame
+ * NOTE: runs in model context, must not call the code under test
+ * [in] - mosi - frame sent by the master
+ * [in] - wide - true - 16-bit frame
+ * [in] - context - slave context
+ * [out] - frame returned on MISO
+ * */
+typedef uint16_t (*Stm32SpiSlave_t)(uint16_t mosi, bool wide, void* context);
+
+/* SDA held until the bus is reset by other means */
+#define STM32_I2C_HOLD_FOREVER  (UINT32_MAX)
+
+/* Register device on the I2C bus: the first written byte sets the register
+ * pointer, following bytes are written or read from it with auto-increment */
+typedef struct
+{
+    uint8_t address;        /* 7 bit */
+    uint8_t regs[256];
+    uint32_t nackAfter;     /* bytes acknowledged per write access, 0 - all */
+    /* set by model */
+    uint8_t pointer;
+    uint32_t written;       /* register bytes written */
+    uint32_t read;          /* register bytes read */
+    uint32_t stops;         /* accesses ended by STOP (not by repeated START) */
+} Stm32I2cDevice_t;
+
+/*Brief: Reset simulated STM32F411: registers, clock tree, models, NVIC
+ * NOTE: call before every test, trapping is enabled on return
+ * [in] - hclk - core clock in Hz
+ * [in] - apb1Divider - APB1 prescaler (1, 2, 4, 8, 16)
+ * [in] - apb2Divider - APB2 prescaler (1, 2, 4, 8, 16)
+ * [out] - none
+ * */
+void Stm32SimReset(uint32_t hclk, uint32_t apb1Divider, uint32_t apb2Divider);
+
+/*Brief: Program RCC (PLL from 25 MHz HSE) and SystemCoreClock
+ * [in] - hclk - core clock in Hz
+ * [in] - apb1Divider - APB1 prescaler
+ * [in] - apb2Divider - APB2 prescaler
+ * [out] - none
+ * */
+void Stm32SimSetClocks(uint32_t hclk, uint32_t apb1Divider, uint32_t apb2Divider);
+
+/*Brief: APB clock programmed in RCC
+ * [in] - apb2 - true - APB2; false - APB1
+ * [out] - Hz
+ * */
+uint32_t Stm32SimPclk(bool apb2);
+
+/* GPIO ports, EXTI and SYSCFG line mapping */
+void Stm32GpioModelInit(void);
+
+/*Brief: Drive pad from a peripheral model (bus pull-up, slave holding a line)
+ * NOTE: for model context, unlike SimGpioDrive no interrupt is served
+ * [in] - pin - pin name
+ * [in] - level - true - high
+ * [out] - none
+ * */
+void Stm32GpioModelDrive(uint8_t pin, bool level);
+
+/* DMA1/DMA2 streams: direct mode, byte and half-word items, circular mode */
+void Stm32DmaModelInit(void);
+
+/*Brief: Peripheral hands received item to DMA (peripheral to memory)
+ * [in] - request - request line
+ * [in] - dr - peripheral data register
+ * [in] - data - item
+ * [out] - true - stream took the item; false - no stream serves the request
+ * */
+bool Stm32DmaPeripheralWrite(STM32_DMA_REQUEST request, volatile const uint32_t* dr, uint32_t data);
+
+/*Brief: Peripheral asks DMA for next item (memory to peripheral)
+ * [in] - request - request line
+ * [in] - dr - peripheral data register
+ * [out] - data - item
+ * [out] - true - item fetched; false - no stream serves the request
+ * */
+bool Stm32DmaPeripheralRead(STM32_DMA_REQUEST request, volatile const uint32_t* dr, uint32_t* data);
+
+/*Brief: Number of times the stream was enabled since reset
+ * [in] - stream - DMA stream
+ * [out] - count
+ * */
+uint32_t Stm32DmaStarts(const DMA_Stream_TypeDef* stream);
+
+/*Brief: Fail the next item of the stream with a transfer error (TEIF)
+ * [in] - stream - DMA stream
+ * [out] - none
+ * */
+void Stm32DmaInjectError(const DMA_Stream_TypeDef* stream);
+
+/* USART1/2/6: 8N1 frames at the rate programmed in BRR */
+void Stm32UsartModelInit(void);
+
+/*Brief: Put frames on the RX line, one per frame time, line goes idle after
+ * [in] - usart - peripheral
+ * [in] - data - frames
+ * [in] - size - number of frames
+ * [out] - none
+ * */
+void Stm32UsartReceive(USART_TypeDef* usart, const uint8_t* data, uint32_t size);
+
+/*Brief: Mark the next received frame with line errors
+ * [in] - usart - peripheral
+ * [in] - flags - USART_SR_FE, USART_SR_NE, USART_SR_PE
+ * [out] - none
+ * */
+void Stm32UsartReceiveError(USART_TypeDef* usart, uint32_t flags);
+
+/*Brief: Take frames shifted out on the TX line since the last call
+ * [in] - usart - peripheral
+ * [out] - data - frames
+ * [in] - max - buffer size
+ * [out] - number of frames
+ * */
+uint32_t Stm32UsartTransmitted(USART_TypeDef* usart, uint8_t* data, uint32_t max);
+
+/*Brief: Frame time at the programmed rate
+ * [in] - usart - peripheral
+ * [out] - core cycles per 10 bit frame
+ * */
+uint64_t Stm32UsartFrameCycles(USART_TypeDef* usart);
+
+/* SPI1..5 in master mode: full duplex frames at the rate programmed in BR */
+void Stm32SpiModelInit(void);
+
+/*Brief: Attach slave to SPI bus (MISO reads all ones without slave)
+ * [in] - spi - peripheral
+ * [in] - slave - frame exchange, NULL - detach
+ * [in] - context - slave context
+ * [out] - none
+ * */
+void Stm32SpiAttach(SPI_TypeDef* spi, Stm32SpiSlave_t slave, void* context);
+
+/*Brief: Frame time at the programmed rate
+ * [in] - spi - peripheral
+ * [in] - wide - true - 16-bit frame
+ * [out] - core cycles per frame
+ * */
+uint64_t Stm32SpiFrameCycles(SPI_TypeDef* spi, bool wide);
+
+/* I2C1..3 in master mode: byte level bus with register devices, timing from
+ * CCR; DMA requests and slave mode are not modelled */
+void Stm32I2cModelInit(void);
+
+/*Brief: Attach device to I2C bus, bus lines get their pull-ups
+ * NOTE: up to 4 devices, device must stay valid until next reset
+ * [in] - i2c - peripheral
+ * [in] - device - register device
+ * [out] - none
+ * */
+void Stm32I2cAttach(I2C_TypeDef* i2c, Stm32I2cDevice_t* device);
+
+/*Brief: Slave holds SDA low, as after a reset in the middle of a read
+ * [in] - i2c - peripheral
+ * [in] - clocks - SCL clocks until SDA is released, STM32_I2C_HOLD_FOREVER - never
+ * [out] - none
+ * */
+void Stm32I2cHoldSda(I2C_TypeDef* i2c, uint32_t clocks);
+
+/*Brief: Slave stretches SCL once before a data byte of the next access
+ * [in] - i2c - peripheral
+ * [in] - byte - data byte index in the access
+ * [in] - cycles - core cycles SCL is held low
+ * [out] - none
+ * */
+void Stm32I2cStretch(I2C_TypeDef* i2c, uint32_t byte, uint64_t cycles);
+
+/*Brief: SCL clocks generated by software since reset (bus recovery)
+ * NOTE: rising edges on the pad while the peripheral is disabled
+ * [in] - i2c - peripheral
+ * [out] - count
+ * */
+uint32_t Stm32I2cSclClocks(I2C_TypeDef* i2c);
+
+/*Brief: Byte time at the programmed rate
+ * [in] - i2c - peripheral
+ * [out] - core cycles per 9 SCL clocks
+ * */
+uint64_t Stm32I2cByteCycles(I2C_TypeDef* i2c);
+
+#endif /* STM32_SIM_H */
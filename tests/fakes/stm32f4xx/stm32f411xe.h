@@ -0,0 +1,342 @@
+#ifndef STM32F411XE_H
+#define STM32F411XE_H
+
+/* Host stand-in for the CMSIS device header: same type, register and bit
+ * names, but register blocks sit in the trapped register space g_Stm32Mmio
+ * (see mmio.h) instead of at their bus addresses. Offsets of DMA streams
+ * inside a controller and the 0x400 GPIO port pitch match RM0383, the rest
+ * of the map is packed. Core functions (NVIC, PRIMASK, intrinsics) are
+ * provided by sim-core.c */
+
+#include <stdint.h>
+
+#define __IO    volatile
+
+#define STM32_MMIO_SIZE     (0x3000U)
+
+extern uint8_t g_Stm32Mmio[STM32_MMIO_SIZE];
+
+typedef enum
+{
+    EXTI0_IRQn = 6,
+    EXTI1_IRQn = 7,
+    EXTI2_IRQn = 8,
+    EXTI3_IRQn = 9,
+    EXTI4_IRQn = 10,
+    DMA1_Stream0_IRQn = 11,
+    DMA1_Stream1_IRQn = 12,
+    DMA1_Stream2_IRQn = 13,
+    DMA1_Stream3_IRQn = 14,
+    DMA1_Stream4_IRQn = 15,
+    DMA1_Stream5_IRQn = 16,
+    DMA1_Stream6_IRQn = 17,
+    EXTI9_5_IRQn = 23,
+    TIM2_IRQn = 28,
+    TIM3_IRQn = 29,
+    TIM4_IRQn = 30,
+    I2C1_EV_IRQn = 31,
+    I2C1_ER_IRQn = 32,
+    I2C2_EV_IRQn = 33,
+    I2C2_ER_IRQn = 34,
+    SPI1_IRQn = 35,
+    SPI2_IRQn = 36,
+    USART1_IRQn = 37,
+    USART2_IRQn = 38,
+    EXTI15_10_IRQn = 40,
+    DMA1_Stream7_IRQn = 47,
+    SPI3_IRQn = 51,
+    DMA2_Stream0_IRQn = 56,
+    DMA2_Stream1_IRQn = 57,
+    DMA2_Stream2_IRQn = 58,
+    DMA2_Stream3_IRQn = 59,
+    DMA2_Stream4_IRQn = 60,
+    DMA2_Stream5_IRQn = 68,
+    DMA2_Stream6_IRQn = 69,
+    DMA2_Stream7_IRQn = 70,
+    USART6_IRQn = 71,
+    I2C3_EV_IRQn = 72,
+    I2C3_ER_IRQn = 73,
+    SPI4_IRQn = 84,
+    SPI5_IRQn = 85,
+} IRQn_Type;
+
+typedef struct { __IO uint32_t SR, DR, BRR, CR1, CR2, CR3, GTPR; } USART_TypeDef;
+typedef struct { __IO uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR; } TIM_TypeDef;
+typedef struct { __IO uint32_t CR, NDTR, PAR, M0AR, M1AR, FCR; } DMA_Stream_TypeDef;
+typedef struct { __IO uint32_t LISR, HISR, LIFCR, HIFCR; } DMA_TypeDef;
+typedef struct { __IO uint32_t CR, PLLCFGR, CFGR, CIR, AHB1RSTR, AHB2RSTR, RESERVED0[2], APB1RSTR, APB2RSTR,
+                 RESERVED1[2], AHB1ENR, AHB2ENR, RESERVED2[2], APB1ENR, APB2ENR; } RCC_TypeDef;
+typedef struct { __IO uint32_t CR1, CR2, SR, DR, CRCPR, RXCRCR, TXCRCR, I2SCFGR, I2SPR; } SPI_TypeDef;
+typedef struct { __IO uint32_t CR1, CR2, OAR1, OAR2, DR, SR1, SR2, CCR, TRISE, FLTR; } I2C_TypeDef;
+typedef struct { __IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2]; } GPIO_TypeDef;
+typedef struct { __IO uint32_t IMR, EMR, RTSR, FTSR, SWIER, PR; } EXTI_TypeDef;
+typedef struct { __IO uint32_t MEMRMP, PMC, EXTICR[4]; } SYSCFG_TypeDef;
+typedef struct { __IO uint32_t CTRL, LOAD, VAL, CALIB; } SysTick_Type;
+typedef struct { __IO uint32_t CTRL, CYCCNT; } DWT_Type;
+typedef struct { __IO uint32_t DHCSR, DCRSR, DCRDR, DEMCR; } CoreDebug_Type;
+
+extern uint32_t SystemCoreClock;
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_SetPendingIRQ(IRQn_Type irq);
+
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+uint32_t __CLZ(uint32_t value);
+uint32_t __RBIT(uint32_t value);
+void __DSB(void);
+void __DMB(void);
+
+#define SIM_BIT(n)                      (1UL << (n))
+
+#define USART_SR_PE                     SIM_BIT(0)
+#define USART_SR_FE                     SIM_BIT(1)
+#define USART_SR_NE                     SIM_BIT(2)
+#define USART_SR_ORE                    SIM_BIT(3)
+#define USART_SR_IDLE                   SIM_BIT(4)
+#define USART_SR_RXNE                   SIM_BIT(5)
+#define USART_SR_TC                     SIM_BIT(6)
+#define USART_SR_TXE                    SIM_BIT(7)
+#define USART_SR_CTS                    SIM_BIT(9)
+#define USART_CR1_RE                    SIM_BIT(2)
+#define USART_CR1_TE                    SIM_BIT(3)
+#define USART_CR1_IDLEIE                SIM_BIT(4)
+#define USART_CR1_RXNEIE                SIM_BIT(5)
+#define USART_CR1_TCIE                  SIM_BIT(6)
+#define USART_CR1_TXEIE                 SIM_BIT(7)
+#define USART_CR1_PEIE                  SIM_BIT(8)
+#define USART_CR1_PCE                   SIM_BIT(10)
+#define USART_CR1_M                     SIM_BIT(12)
+#define USART_CR1_UE                    SIM_BIT(13)
+#define USART_CR1_OVER8                 SIM_BIT(15)
+#define USART_CR2_STOP                  (3UL<<12)
+#define USART_CR3_EIE                   SIM_BIT(0)
+#define USART_CR3_HDSEL                 SIM_BIT(3)
+#define USART_CR3_DMAR                  SIM_BIT(6)
+#define USART_CR3_DMAT                  SIM_BIT(7)
+#define USART_CR3_RTSE                  SIM_BIT(8)
+#define USART_CR3_CTSE                  SIM_BIT(9)
+#define USART_CR3_CTSIE                 SIM_BIT(10)
+#define RCC_APB2ENR_USART1EN            SIM_BIT(4)
+#define RCC_APB2ENR_USART6EN            SIM_BIT(5)
+#define RCC_APB1ENR_USART2EN            SIM_BIT(17)
+#define RCC_AHB1ENR_DMA1EN              SIM_BIT(21)
+#define RCC_AHB1ENR_DMA2EN              SIM_BIT(22)
+#define RCC_APB1ENR_TIM2EN              SIM_BIT(0)
+#define RCC_APB1ENR_TIM3EN              SIM_BIT(1)
+#define RCC_APB1ENR_TIM4EN              SIM_BIT(2)
+#define RCC_APB2ENR_SPI1EN              SIM_BIT(12)
+#define RCC_APB1ENR_SPI2EN              SIM_BIT(14)
+#define RCC_APB1ENR_SPI3EN              SIM_BIT(15)
+#define RCC_APB2ENR_SPI4EN              SIM_BIT(13)
+#define RCC_APB2ENR_SPI5EN              SIM_BIT(20)
+#define RCC_APB1ENR_I2C1EN              SIM_BIT(21)
+#define RCC_APB1ENR_I2C2EN              SIM_BIT(22)
+#define RCC_APB1ENR_I2C3EN              SIM_BIT(23)
+#define RCC_APB1RSTR_I2C1RST            SIM_BIT(21)
+#define RCC_APB1RSTR_I2C2RST            SIM_BIT(22)
+#define RCC_APB1RSTR_I2C3RST            SIM_BIT(23)
+#define RCC_AHB1ENR_GPIOAEN             SIM_BIT(0)
+#define RCC_AHB1ENR_GPIOBEN             SIM_BIT(1)
+#define RCC_AHB1ENR_GPIOCEN             SIM_BIT(2)
+#define RCC_AHB1ENR_GPIODEN             SIM_BIT(3)
+#define RCC_AHB1ENR_GPIOEEN             SIM_BIT(4)
+#define RCC_AHB1ENR_GPIOHEN             SIM_BIT(7)
+#define RCC_APB2ENR_SYSCFGEN            SIM_BIT(14)
+#define RCC_CFGR_SWS                    (3UL<<2)
+#define RCC_CFGR_SWS_HSI                0
+#define RCC_CFGR_SWS_HSE                (1UL<<2)
+#define RCC_CFGR_SWS_PLL                (2UL<<2)
+#define RCC_CFGR_HPRE_Pos               4
+#define RCC_CFGR_PPRE1_Pos              10
+#define RCC_CFGR_PPRE2_Pos              13
+#define RCC_PLLCFGR_PLLM_Pos            0
+#define RCC_PLLCFGR_PLLM                (0x3FUL)
+#define RCC_PLLCFGR_PLLN_Pos            6
+#define RCC_PLLCFGR_PLLN                (0x1FFUL<<6)
+#define RCC_PLLCFGR_PLLP_Pos            16
+#define RCC_PLLCFGR_PLLP                (3UL<<16)
+#define RCC_PLLCFGR_PLLSRC              SIM_BIT(22)
+#define TIM_SR_UIF                      SIM_BIT(0)
+#define TIM_EGR_UG                      SIM_BIT(0)
+#define TIM_CR1_OPM                     SIM_BIT(3)
+#define TIM_CR1_CEN                     SIM_BIT(0)
+#define TIM_DIER_UIE                    SIM_BIT(0)
+#define DMA_SxCR_EN                     SIM_BIT(0)
+#define DMA_SxCR_DMEIE                  SIM_BIT(1)
+#define DMA_SxCR_TEIE                   SIM_BIT(2)
+#define DMA_SxCR_HTIE                   SIM_BIT(3)
+#define DMA_SxCR_TCIE                   SIM_BIT(4)
+#define DMA_SxCR_DIR_0                  SIM_BIT(6)
+#define DMA_SxCR_DIR_1                  SIM_BIT(7)
+#define DMA_SxCR_CIRC                   SIM_BIT(8)
+#define DMA_SxCR_PINC                   SIM_BIT(9)
+#define DMA_SxCR_MINC                   SIM_BIT(10)
+#define DMA_SxCR_PSIZE_0                SIM_BIT(11)
+#define DMA_SxCR_MSIZE_0                SIM_BIT(13)
+#define DMA_SxCR_PL_0                   SIM_BIT(16)
+#define DMA_SxCR_PL_1                   SIM_BIT(17)
+#define DMA_SxCR_DBM                    SIM_BIT(18)
+#define DMA_SxCR_CT                     SIM_BIT(19)
+#define DMA_SxCR_CHSEL_Pos              25
+#define DMA_SxCR_CHSEL                  (7UL<<25)
+#define DMA_LISR_TCIF0                  SIM_BIT(5)
+#define SPI_CR1_CPHA                    SIM_BIT(0)
+#define SPI_CR1_CPOL                    SIM_BIT(1)
+#define SPI_CR1_MSTR                    SIM_BIT(2)
+#define SPI_CR1_BR_Pos                  3
+#define SPI_CR1_BR_Msk                  (7UL<<3)
+#define SPI_CR1_BR                      (7UL<<3)
+#define SPI_CR1_SPE                     SIM_BIT(6)
+#define SPI_CR1_LSBFIRST                SIM_BIT(7)
+#define SPI_CR1_SSI                     SIM_BIT(8)
+#define SPI_CR1_SSM                     SIM_BIT(9)
+#define SPI_CR1_RXONLY                  SIM_BIT(10)
+#define SPI_CR1_DFF                     SIM_BIT(11)
+#define SPI_CR1_CRCNEXT                 SIM_BIT(12)
+#define SPI_CR1_CRCEN                   SIM_BIT(13)
+#define SPI_CR1_BIDIOE                  SIM_BIT(14)
+#define SPI_CR1_BIDIMODE                SIM_BIT(15)
+#define SPI_CR2_RXDMAEN                 SIM_BIT(0)
+#define SPI_CR2_TXDMAEN                 SIM_BIT(1)
+#define SPI_CR2_ERRIE                   SIM_BIT(5)
+#define SPI_CR2_RXNEIE                  SIM_BIT(6)
+#define SPI_CR2_TXEIE                   SIM_BIT(7)
+#define SPI_SR_RXNE                     SIM_BIT(0)
+#define SPI_SR_TXE                      SIM_BIT(1)
+#define SPI_SR_OVR                      SIM_BIT(6)
+#define SPI_SR_BSY                      SIM_BIT(7)
+#define I2C_CR1_PE                      SIM_BIT(0)
+#define I2C_CR1_START                   SIM_BIT(8)
+#define I2C_CR1_STOP                    SIM_BIT(9)
+#define I2C_CR1_ACK                     SIM_BIT(10)
+#define I2C_CR1_POS                     SIM_BIT(11)
+#define I2C_CR1_SWRST                   SIM_BIT(15)
+#define I2C_CR2_FREQ                    0x3FUL
+#define I2C_CR2_ITERREN                 SIM_BIT(8)
+#define I2C_CR2_ITEVTEN                 SIM_BIT(9)
+#define I2C_CR2_ITBUFEN                 SIM_BIT(10)
+#define I2C_CR2_DMAEN                   SIM_BIT(11)
+#define I2C_CR2_LAST                    SIM_BIT(12)
+#define I2C_OAR1_ADD1_7                 (0x7FUL<<1)
+#define I2C_OAR1_ADD1_Pos               1
+#define I2C_OAR1_ADDMODE                SIM_BIT(15)
+#define I2C_SR1_SB                      SIM_BIT(0)
+#define I2C_SR1_ADDR                    SIM_BIT(1)
+#define I2C_SR1_BTF                     SIM_BIT(2)
+#define I2C_SR1_STOPF                   SIM_BIT(4)
+#define I2C_SR1_RXNE                    SIM_BIT(6)
+#define I2C_SR1_TXE                     SIM_BIT(7)
+#define I2C_SR1_BERR                    SIM_BIT(8)
+#define I2C_SR1_ARLO                    SIM_BIT(9)
+#define I2C_SR1_AF                      SIM_BIT(10)
+#define I2C_SR1_OVR                     SIM_BIT(11)
+#define I2C_SR1_TIMEOUT                 SIM_BIT(14)
+#define I2C_SR2_MSL                     SIM_BIT(0)
+#define I2C_SR2_BUSY                    SIM_BIT(1)
+#define I2C_SR2_TRA                     SIM_BIT(2)
+#define I2C_CCR_CCR                     0xFFFUL
+#define I2C_CCR_DUTY                    SIM_BIT(14)
+#define I2C_CCR_FS                      SIM_BIT(15)
+#define I2C_TRISE_TRISE                 0x3FUL
+#define SysTick_CTRL_CLKSOURCE_Msk      SIM_BIT(2)
+#define SysTick_CTRL_ENABLE_Msk         SIM_BIT(0)
+#define SysTick_CTRL_COUNTFLAG_Msk      SIM_BIT(16)
+#define DWT_CTRL_CYCCNTENA_Msk          SIM_BIT(0)
+#define CoreDebug_DEMCR_TRCENA_Msk      SIM_BIT(24)
+#define USART_SR_LBD                    SIM_BIT(8)
+#define SPI_SR_CHSIDE                   SIM_BIT(2)
+#define SPI_SR_UDR                      SIM_BIT(3)
+#define SPI_SR_CRCERR                   SIM_BIT(4)
+#define SPI_SR_MODF                     SIM_BIT(5)
+#define SPI_SR_FRE                      SIM_BIT(8)
+#define SPI_CR2_SSOE                    SIM_BIT(2)
+#define I2C_SR1_ADD10                   SIM_BIT(3)
+#define I2C_SR1_PECERR                  SIM_BIT(12)
+#define I2C_SR1_SMBALERT                SIM_BIT(15)
+#define I2C_CR1_NOSTRETCH               SIM_BIT(7)
+#define DMA_SxCR_DIR                    (3UL << 6)
+#define DMA_SxCR_PSIZE                  (3UL << 11)
+#define DMA_SxCR_MSIZE                  (3UL << 13)
+#define DMA_SxCR_PSIZE_1                SIM_BIT(12)
+#define DMA_SxCR_MSIZE_1                SIM_BIT(14)
+
+#define GPIOA_BASE          ((uintptr_t)&g_Stm32Mmio[0x0000U])
+#define GPIOB_BASE          ((uintptr_t)&g_Stm32Mmio[0x0400U])
+#define GPIOC_BASE          ((uintptr_t)&g_Stm32Mmio[0x0800U])
+#define GPIOD_BASE          ((uintptr_t)&g_Stm32Mmio[0x0C00U])
+#define GPIOE_BASE          ((uintptr_t)&g_Stm32Mmio[0x1000U])
+#define GPIOH_BASE          ((uintptr_t)&g_Stm32Mmio[0x1C00U])
+#define RCC_BASE            ((uintptr_t)&g_Stm32Mmio[0x2000U])
+#define EXTI_BASE           ((uintptr_t)&g_Stm32Mmio[0x2100U])
+#define SYSCFG_BASE         ((uintptr_t)&g_Stm32Mmio[0x2140U])
+#define USART1_BASE         ((uintptr_t)&g_Stm32Mmio[0x2200U])
+#define USART2_BASE         ((uintptr_t)&g_Stm32Mmio[0x2240U])
+#define USART6_BASE         ((uintptr_t)&g_Stm32Mmio[0x2280U])
+#define TIM2_BASE           ((uintptr_t)&g_Stm32Mmio[0x2300U])
+#define TIM3_BASE           ((uintptr_t)&g_Stm32Mmio[0x2340U])
+#define TIM4_BASE           ((uintptr_t)&g_Stm32Mmio[0x2380U])
+#define DMA1_BASE           ((uintptr_t)&g_Stm32Mmio[0x2400U])
+#define DMA2_BASE           ((uintptr_t)&g_Stm32Mmio[0x2800U])
+#define SPI1_BASE           ((uintptr_t)&g_Stm32Mmio[0x2C00U])
+#define SPI2_BASE           ((uintptr_t)&g_Stm32Mmio[0x2C40U])
+#define SPI3_BASE           ((uintptr_t)&g_Stm32Mmio[0x2C80U])
+#define SPI4_BASE           ((uintptr_t)&g_Stm32Mmio[0x2CC0U])
+#define SPI5_BASE           ((uintptr_t)&g_Stm32Mmio[0x2D00U])
+#define I2C1_BASE           ((uintptr_t)&g_Stm32Mmio[0x2E00U])
+#define I2C2_BASE           ((uintptr_t)&g_Stm32Mmio[0x2E40U])
+#define I2C3_BASE           ((uintptr_t)&g_Stm32Mmio[0x2E80U])
+#define SysTick_BASE        ((uintptr_t)&g_Stm32Mmio[0x2F00U])
+#define DWT_BASE            ((uintptr_t)&g_Stm32Mmio[0x2F40U])
+#define CoreDebug_BASE      ((uintptr_t)&g_Stm32Mmio[0x2F80U])
+#define GPIOA               ((GPIO_TypeDef*)&g_Stm32Mmio[0x0000U])
+#define GPIOB               ((GPIO_TypeDef*)&g_Stm32Mmio[0x0400U])
+#define GPIOC               ((GPIO_TypeDef*)&g_Stm32Mmio[0x0800U])
+#define GPIOD               ((GPIO_TypeDef*)&g_Stm32Mmio[0x0C00U])
+#define GPIOE               ((GPIO_TypeDef*)&g_Stm32Mmio[0x1000U])
+#define GPIOH               ((GPIO_TypeDef*)&g_Stm32Mmio[0x1C00U])
+#define RCC                 ((RCC_TypeDef*)&g_Stm32Mmio[0x2000U])
+#define EXTI                ((EXTI_TypeDef*)&g_Stm32Mmio[0x2100U])
+#define SYSCFG              ((SYSCFG_TypeDef*)&g_Stm32Mmio[0x2140U])
+#define USART1              ((USART_TypeDef*)&g_Stm32Mmio[0x2200U])
+#define USART2              ((USART_TypeDef*)&g_Stm32Mmio[0x2240U])
+#define USART6              ((USART_TypeDef*)&g_Stm32Mmio[0x2280U])
+#define TIM2                ((TIM_TypeDef*)&g_Stm32Mmio[0x2300U])
+#define TIM3                ((TIM_TypeDef*)&g_Stm32Mmio[0x2340U])
+#define TIM4                ((TIM_TypeDef*)&g_Stm32Mmio[0x2380U])
+#define DMA1                ((DMA_TypeDef*)&g_Stm32Mmio[0x2400U])
+#define DMA2                ((DMA_TypeDef*)&g_Stm32Mmio[0x2800U])
+#define SPI1                ((SPI_TypeDef*)&g_Stm32Mmio[0x2C00U])
+#define SPI2                ((SPI_TypeDef*)&g_Stm32Mmio[0x2C40U])
+#define SPI3                ((SPI_TypeDef*)&g_Stm32Mmio[0x2C80U])
+#define SPI4                ((SPI_TypeDef*)&g_Stm32Mmio[0x2CC0U])
+#define SPI5                ((SPI_TypeDef*)&g_Stm32Mmio[0x2D00U])
+#define I2C1                ((I2C_TypeDef*)&g_Stm32Mmio[0x2E00U])
+#define I2C2                ((I2C_TypeDef*)&g_Stm32Mmio[0x2E40U])
+#define I2C3                ((I2C_TypeDef*)&g_Stm32Mmio[0x2E80U])
+#define SysTick             ((SysTick_Type*)&g_Stm32Mmio[0x2F00U])
+#define DWT                 ((DWT_Type*)&g_Stm32Mmio[0x2F40U])
+#define CoreDebug           ((CoreDebug_Type*)&g_Stm32Mmio[0x2F80U])
+#define DMA1_Stream0        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x2410U])
+#define DMA1_Stream1        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x2428U])
+#define DMA1_Stream2        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x2440U])
+#define DMA1_Stream3        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x2458U])
+#define DMA1_Stream4        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x2470U])
+#define DMA1_Stream5        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x2488U])
+#define DMA1_Stream6        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x24A0U])
+#define DMA1_Stream7        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x24B8U])
+#define DMA2_Stream0        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x2810U])
+#define DMA2_Stream1        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x2828U])
+#define DMA2_Stream2        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x2840U])
+#define DMA2_Stream3        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x2858U])
+#define DMA2_Stream4        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x2870U])
+#define DMA2_Stream5        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x2888U])
+#define DMA2_Stream6        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x28A0U])
+#define DMA2_Stream7        ((DMA_Stream_TypeDef*)&g_Stm32Mmio[0x28B8U])
+
+#endif /* STM32F411XE_H */
@@ -0,0 +1,123 @@
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "custom-assert.h"
+#include "test.h"
+
+jmp_buf g_TestAssertJump;
+volatile bool g_TestAssertArmed;
+
+static jmp_buf m_TestAbortJump;
+static const char* m_TestName;
+static uint32_t m_TestFailures;
+
+bool TestCheck(bool passed, const char* file, int line, const char* expr)
+{
+    if (!passed)
+    {
+        m_TestFailures++;
+        printf("    %s:%d: check failed: %s\n", file, line, expr);
+    }
+
+    return passed;
+}
+
+bool TestCheckEqual(int64_t actual, int64_t expected, const char* file, int line,
+                    const char* actualExpr, const char* expectedExpr)
+{
+    if (actual != expected)
+    {
+        m_TestFailures++;
+        printf("    %s:%d: %s == %" PRId64 " (0x%" PRIx64 "), expected %s == %" PRId64 " (0x%" PRIx64 ")\n",
+               file, line, actualExpr, actual, (uint64_t)actual, expectedExpr, expected, (uint64_t)expected);
+        return false;
+    }
+
+    return true;
+}
+
+bool TestCheckMemory(const void* actual, const void* expected, uint32_t size, const char* file, int line,
+                     const char* actualExpr, const char* expectedExpr)
+{
+    const uint8_t* a = actual;
+    const uint8_t* e = expected;
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        if (a[i] != e[i])
+        {
+            m_TestFailures++;
+            printf("    %s:%d: %s[%u] == 0x%02X, expected %s[%u] == 0x%02X\n",
+                   file, line, actualExpr, i, a[i], expectedExpr, i, e[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void TestPrint(const char* format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    printf("    ");
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+/* replaces core/assert/custom-assert.c: expected asserts return to the test,
+ * unexpected ones fail the running test instead of hanging */
+void ErrorHandler(const char* file, int line, const char* expr)
+{
+    if (g_TestAssertArmed)
+    {
+        g_TestAssertArmed = false;
+        longjmp(g_TestAssertJump, 1);
+    }
+
+    m_TestFailures++;
+    printf("    %s:%d: ASSERT(%s)\n", file, line, expr);
+
+    longjmp(m_TestAbortJump, 1);
+}
+
+int TestRun(const char* suite, const Test_t* tests, uint32_t count, TestFunction_t setup)
+{
+    volatile uint32_t failed = 0;
+
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    printf("%s\n", suite);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        m_TestName = tests[i].name;
+        m_TestFailures = 0;
+        g_TestAssertArmed = false;
+
+        if (setjmp(m_TestAbortJump) == 0)
+        {
+            if (setup != NULL)
+            {
+                (*setup)();
+            }
+
+            (*tests[i].function)();
+        }
+
+        if (m_TestFailures != 0)
+        {
+            failed++;
+        }
+
+        printf("  %s %s\n", (m_TestFailures == 0) ? "PASS" : "FAIL", m_TestName);
+    }
+
+    printf("%s: %u passed, %u failed\n\n", suite, count - failed, failed);
+
+    return (failed == 0) ? 0 : 1;
+}
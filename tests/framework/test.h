@@ -0,0 +1,96 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <setjmp.h>
+
+/* Minimal host test runner: every test is a void function, checks record
+ * failures and keep going, ASSERT inside the code under test ends the test
+ * unless it is expected by TEST_EXPECT_ASSERT */
+
+typedef void (*TestFunction_t)(void);
+
+typedef struct
+{
+    const char* name;
+    TestFunction_t function;
+} Test_t;
+
+#define TEST(function)      { #function, &function }
+
+#define TEST_COUNT(tests)   ((uint32_t)(sizeof(tests) / sizeof((tests)[0])))
+
+#define CHECK(expr) \
+    TestCheck((expr), __FILE__, __LINE__, #expr)
+
+#define CHECK_EQ(actual, expected) \
+    TestCheckEqual((int64_t)(actual), (int64_t)(expected), __FILE__, __LINE__, #actual, #expected)
+
+#define CHECK_MEM(actual, expected, size) \
+    TestCheckMemory((actual), (expected), (size), __FILE__, __LINE__, #actual, #expected)
+
+/* statement must end in ASSERT of the code under test */
+#define TEST_EXPECT_ASSERT(statement) \
+    do { \
+        g_TestAssertArmed = true; \
+        if (setjmp(g_TestAssertJump) == 0) { \
+            statement; \
+            g_TestAssertArmed = false; \
+            TestCheck(false, __FILE__, __LINE__, "ASSERT expected: " #statement); \
+        } \
+    } while (0)
+
+extern jmp_buf g_TestAssertJump;
+extern volatile bool g_TestAssertArmed;
+
+/*Brief: Record check result
+ * [in] - passed - check result
+ * [in] - file - source file
+ * [in] - line - source line
+ * [in] - expr - checked expression
+ * [out] - passed
+ * */
+bool TestCheck(bool passed, const char* file, int line, const char* expr);
+
+/*Brief: Record equality check result
+ * [in] - actual - actual value
+ * [in] - expected - expected value
+ * [in] - file - source file
+ * [in] - line - source line
+ * [in] - actualExpr - actual value expression
+ * [in] - expectedExpr - expected value expression
+ * [out] - true - values are equal
+ * */
+bool TestCheckEqual(int64_t actual, int64_t expected, const char* file, int line,
+                    const char* actualExpr, const char* expectedExpr);
+
+/*Brief: Record memory equality check result
+ * [in] - actual - actual data
+ * [in] - expected - expected data
+ * [in] - size - data size
+ * [in] - file - source file
+ * [in] - line - source line
+ * [in] - actualExpr - actual data expression
+ * [in] - expectedExpr - expected data expression
+ * [out] - true - data are equal
+ * */
+bool TestCheckMemory(const void* actual, const void* expected, uint32_t size, const char* file, int line,
+                     const char* actualExpr, const char* expectedExpr);
+
+/*Brief: Print informational line of the running test (benchmark results)
+ * [in] - format - printf format
+ * [out] - none
+ * */
+void TestPrint(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+/*Brief: Run tests
+ * [in] - suite - suite name
+ * [in] - tests - test table
+ * [in] - count - number of tests
+ * [in] - setup - called before each test to reset fakes, may be NULL
+ * [out] - process exit code: 0 - all tests passed
+ * */
+int TestRun(const char* suite, const Test_t* tests, uint32_t count, TestFunction_t setup);
+
+#endif /* TEST_H */
@@ -0,0 +1,30 @@
+#ifndef GPIO_BOARD_H
+#define GPIO_BOARD_H
+
+#include <avr/interrupt.h>
+
+#include "avr-sim.h"
+#include "gpio-name.h"
+
+/* ATmega328P pins of the GPIO conformance suite (platforms/test-gpio.c);
+ * input and group share PCINT2, so edges of the group must be filtered out */
+
+#define BOARD_NAME              "atmega328"
+
+#define BOARD_PIN_OUT           PB_1
+#define BOARD_PIN_IN            PD_2
+#define BOARD_PIN_GROUP         PD_3        /* PD_3 - PD_6 */
+#define BOARD_PIN_GUARD         PD_7        /* next pin of the group port */
+
+#define BOARD_PULL_DOWN         (0)         /* 0 - pull-down asserts */
+#define BOARD_EVENTS            (0)         /* 0 - no event mode ops, interrupt without handler asserts */
+
+static inline void BoardReset(void)
+{
+    AvrSimReset(16000000U);
+
+    /* application enables interrupts after init */
+    sei();
+}
+
+#endif /* GPIO_BOARD_H */
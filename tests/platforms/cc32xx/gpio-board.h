@@ -0,0 +1,25 @@
+#ifndef GPIO_BOARD_H
+#define GPIO_BOARD_H
+
+#include "cc32xx-sim.h"
+#include "gpio-name.h"
+
+/* CC3220 pins of the GPIO conformance suite (platforms/test-gpio.c);
+ * input and group share the GPIOA0 vector, output is not bit 0 of its port */
+
+#define BOARD_NAME              "cc32xx"
+
+#define BOARD_PIN_OUT           PIN_GPIOA1_2
+#define BOARD_PIN_IN            PIN_GPIOA0_1
+#define BOARD_PIN_GROUP         PIN_GPIOA0_2    /* GPIOA0 2 - 5 */
+#define BOARD_PIN_GUARD         PIN_GPIOA0_6    /* next pin of the group port */
+
+#define BOARD_PULL_DOWN         (1)         /* 0 - pull-down asserts */
+#define BOARD_EVENTS            (0)         /* 0 - no event mode ops, interrupt without handler asserts */
+
+static inline void BoardReset(void)
+{
+    Cc32xxSimReset(80000000U);
+}
+
+#endif /* GPIO_BOARD_H */
@@ -0,0 +1,184 @@
+#include <time.h>
+
+#include "test.h"
+#include "mmio.h"
+#include "stm32-sim.h"
+#include "gpio.h"
+#include "gpio-fast.h"
+#include "ignore.h"
+
+/* GpioOps_t vtable path against the gpio-fast.h inline path on one output
+ * pin. Both end in a single BSRR store, so the register side is checked with
+ * trapping on, then the call overhead (vtable call, ASSERT, initialized check,
+ * port decode) is timed natively with trapping off. Host ns/op are a relative
+ * measure only, not Cortex-M4 cycles. */
+
+#define BENCH_ITERATIONS        (20000000U)
+#define BENCH_PIN               PA_5
+
+extern const GpioOps_t g_GpioOps;
+
+static GpioHandle_t m_Pin;
+
+static void Setup(void)
+{
+    Stm32SimReset(100000000U, 2, 1);
+
+    m_Pin.ops = &g_GpioOps;
+    m_Pin.ops->open(&m_Pin, BENCH_PIN, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL, PIN_STRENGTH_HIGH,
+                    PIN_CONFIG_PUSH_PULL, PIN_STATE_LOW);
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static uint64_t Accesses(void (*operation)(void))
+{
+    uint64_t before = MmioAccessCount();
+
+    (*operation)();
+
+    return MmioAccessCount() - before;
+}
+
+static void OpsWriteHigh(void)
+{
+    m_Pin.ops->write(&m_Pin, PIN_STATE_HIGH);
+}
+
+static void FastWriteHigh(void)
+{
+    GpioFastWrite(GPIO_FAST_PIN(BENCH_PIN), true);
+}
+
+static void OpsToggle(void)
+{
+    m_Pin.ops->toggle(&m_Pin);
+}
+
+static void FastToggle(void)
+{
+    GpioFastToggle(GPIO_FAST_PIN(BENCH_PIN));
+}
+
+static void TestSameRegisterEffect(void)
+{
+    GpioFast_t bound = GpioFastBind(&m_Pin);
+    GpioFast_t named = GPIO_FAST_PIN(BENCH_PIN);
+
+    CHECK(bound.port == named.port);
+    CHECK_EQ(bound.mask, named.mask);
+
+    /* one BSRR store either way: the saving is the code around it */
+    CHECK_EQ(Accesses(&OpsWriteHigh), 1);
+    CHECK(SimGpioLevel(BENCH_PIN));
+
+    GpioFastReset(named);
+    CHECK(!SimGpioLevel(BENCH_PIN));
+
+    CHECK_EQ(Accesses(&FastWriteHigh), 1);
+    CHECK(SimGpioLevel(BENCH_PIN));
+
+    /* ODR load and BSRR store either way */
+    CHECK_EQ(Accesses(&OpsToggle), 2);
+    CHECK(!SimGpioLevel(BENCH_PIN));
+
+    CHECK_EQ(Accesses(&FastToggle), 2);
+    CHECK(SimGpioLevel(BENCH_PIN));
+}
+
+static void TestWriteOverhead(void)
+{
+    GpioFast_t bound = GpioFastBind(&m_Pin);
+
+    /* registers become plain memory, nothing but the drivers runs */
+    MmioTrap(false);
+
+    uint64_t start = NowNs();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        m_Pin.ops->write(&m_Pin, (i & 1U) ? PIN_STATE_HIGH : PIN_STATE_LOW);
+    }
+
+    uint64_t ops = NowNs() - start;
+
+    start = NowNs();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        GpioFastWrite(bound, (i & 1U) != 0U);
+    }
+
+    uint64_t fastBound = NowNs() - start;
+
+    start = NowNs();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        GpioFastWrite(GPIO_FAST_PIN(BENCH_PIN), (i & 1U) != 0U);
+    }
+
+    uint64_t fastNamed = NowNs() - start;
+
+    MmioTrap(true);
+
+    TestPrint("write: ops %.2f ns, fast bound %.2f ns, fast compile time %.2f ns per call",
+              (double)ops / BENCH_ITERATIONS, (double)fastBound / BENCH_ITERATIONS,
+              (double)fastNamed / BENCH_ITERATIONS);
+
+    CHECK(fastBound < ops);
+    CHECK(fastNamed < ops);
+}
+
+static void TestReadOverhead(void)
+{
+    GpioFast_t bound = GpioFastBind(&m_Pin);
+    uint32_t sum = 0;
+
+    MmioTrap(false);
+
+    uint64_t start = NowNs();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        sum += m_Pin.ops->read(&m_Pin);
+    }
+
+    uint64_t ops = NowNs() - start;
+
+    start = NowNs();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        sum += GpioFastRead(bound) ? 1U : 0U;
+    }
+
+    uint64_t fast = NowNs() - start;
+
+    MmioTrap(true);
+
+    IGNORE(sum);
+
+    TestPrint("read: ops %.2f ns, fast %.2f ns per call",
+              (double)ops / BENCH_ITERATIONS, (double)fast / BENCH_ITERATIONS);
+
+    CHECK(fast < ops);
+}
+
+static const Test_t m_Tests[] = {
+    TEST(TestSameRegisterEffect),
+    TEST(TestWriteOverhead),
+    TEST(TestReadOverhead),
+};
+
+int main(void)
+{
+    return TestRun("stm32f4xx gpio fast path", m_Tests, TEST_COUNT(m_Tests), &Setup);
+}
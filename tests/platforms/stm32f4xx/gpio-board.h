@@ -0,0 +1,28 @@
+#ifndef GPIO_BOARD_H
+#define GPIO_BOARD_H
+
+#include "stm32-sim.h"
+#include "event.h"
+#include "gpio-name.h"
+
+/* STM32F411 pins of the GPIO conformance suite (platforms/test-gpio.c) */
+
+#define BOARD_NAME              "stm32f4xx"
+
+#define BOARD_PIN_OUT           PA_5
+#define BOARD_PIN_IN            PC_13
+#define BOARD_PIN_GROUP         PB_4        /* PB_4 - PB_7 */
+#define BOARD_PIN_GUARD         PB_8        /* next pin of the group port */
+
+#define BOARD_PULL_DOWN         (1)         /* 0 - pull-down asserts */
+#define BOARD_EVENTS            (1)         /* 0 - no event mode ops, interrupt without handler asserts */
+
+static inline void BoardReset(void)
+{
+    Stm32SimReset(100000000U, 2, 1);
+
+    /* event mode announces edges on the application event queue */
+    EventQueueInit();
+}
+
+#endif /* GPIO_BOARD_H */
@@ -0,0 +1,154 @@
+#include <string.h>
+
+#include "test.h"
+#include "stm32-sim.h"
+#include "event.h"
+#include "gpio.h"
+#include "gpio-name.h"
+#include "timebase.h"
+
+/* GPIO event mode on the register-level STM32F411 model: edges of PC_13
+ * queued for getEvents, announced by EVENT_GPIO_EDGE, debounce settle check
+ * run by the FreeRTOS software timer */
+
+#define TEST_HCLK               (100000000U)
+#define TEST_PIN                PC_13
+#define TEST_IRQ_PRIORITY       (6U)
+#define TEST_DEBOUNCE_US        (1000U)
+#define TEST_EVENTS_MAX         (8U)
+
+extern const GpioOps_t g_GpioOps;
+
+static GpioHandle_t m_Pin;
+static GpioEvent_t m_Events[TEST_EVENTS_MAX];
+
+/*Brief: Count EVENT_GPIO_EDGE entries and empty the event queue
+ * */
+static uint32_t TakeEdgeEvents(void)
+{
+    Event_t event;
+    uint32_t count = 0;
+
+    while (EventQueue_Dequeue(&event))
+    {
+        CHECK_EQ(event.type, EVENT_GPIO_EDGE);
+        count++;
+    }
+
+    return count;
+}
+
+static void Setup(void)
+{
+    Stm32SimReset(TEST_HCLK, 2, 1);
+    EventQueueInit();
+
+    SimGpioDrive(TEST_PIN, false);
+
+    memset(&m_Pin, 0, sizeof(m_Pin));
+    m_Pin.ops = &g_GpioOps;
+    m_Pin.ops->open(&m_Pin, TEST_PIN, PIN_MODE_INPUT, PIN_TYPE_NO_PULL, PIN_STRENGTH_LOW, PIN_CONFIG_PUSH_PULL, 0);
+    m_Pin.ops->interrupt(&m_Pin, PIN_IRQ_BOTH, TEST_IRQ_PRIORITY, NULL);
+
+    /* queue is shared by all tests of the binary */
+    while (m_Pin.ops->getEvents(m_Events, TEST_EVENTS_MAX) != 0U)
+    {
+    }
+}
+
+static void TestEdgesAnnouncedOncePerBatch(void)
+{
+    SimGpioDrive(TEST_PIN, true);
+    SimClockRun(SimClockUs(10));
+    SimGpioDrive(TEST_PIN, false);
+    SimClockRun(SimClockUs(10));
+    SimGpioDrive(TEST_PIN, true);
+
+    CHECK_EQ(TakeEdgeEvents(), 1);
+    CHECK_EQ(m_Pin.ops->getEvents(m_Events, TEST_EVENTS_MAX), 3);
+    CHECK_EQ(m_Events[0].state, PIN_STATE_HIGH);
+    CHECK_EQ(m_Events[1].state, PIN_STATE_LOW);
+    CHECK_EQ(m_Events[2].state, PIN_STATE_HIGH);
+    CHECK(m_Events[0].handle == &m_Pin);
+    CHECK((uint32_t)(m_Events[1].timestamp - m_Events[0].timestamp) >= TimebaseUsToTicks(10));
+
+    /* drained: the next edge is announced again */
+    SimGpioDrive(TEST_PIN, false);
+
+    CHECK_EQ(TakeEdgeEvents(), 1);
+    CHECK_EQ(m_Pin.ops->getEvents(m_Events, TEST_EVENTS_MAX), 1);
+    CHECK_EQ(m_Pin.ops->getEventsLost(), 0);
+}
+
+static void TestBounceSettlesFromTimer(void)
+{
+    m_Pin.ops->filter(&m_Pin, TEST_DEBOUNCE_US);
+
+    SimGpioDrive(TEST_PIN, true);
+
+    CHECK_EQ(TakeEdgeEvents(), 1);
+    CHECK(m_Pin.ops->getEvent(&m_Events[0]));
+    CHECK_EQ(m_Events[0].state, PIN_STATE_HIGH);
+
+    /* contact bounces and settles low inside the window */
+    SimClockRun(SimClockUs(20));
+    SimGpioDrive(TEST_PIN, false);
+    SimClockRun(SimClockUs(20));
+    SimGpioDrive(TEST_PIN, true);
+    SimClockRun(SimClockUs(20));
+
+    uint32_t bounce = TimebaseNow();
+
+    SimGpioDrive(TEST_PIN, false);
+
+    /* nothing to read and nothing announced while the window is open */
+    SimClockRun(SimClockUs(TEST_DEBOUNCE_US / 2U));
+    CHECK_EQ(TakeEdgeEvents(), 0);
+    CHECK_EQ(m_Pin.ops->getEvents(m_Events, TEST_EVENTS_MAX), 0);
+    CHECK_EQ(TakeEdgeEvents(), 0);
+
+    SimClockRun(SimClockUs(3U * TEST_DEBOUNCE_US));
+
+    CHECK_EQ(TakeEdgeEvents(), 1);
+    CHECK_EQ(m_Pin.ops->getEvents(m_Events, TEST_EVENTS_MAX), 1);
+    CHECK_EQ(m_Events[0].state, PIN_STATE_LOW);
+    CHECK((uint32_t)(m_Events[0].timestamp - bounce) < TimebaseUsToTicks(1));
+}
+
+static void TestBounceBackToStableLevelIsSilent(void)
+{
+    m_Pin.ops->filter(&m_Pin, TEST_DEBOUNCE_US);
+
+    SimGpioDrive(TEST_PIN, true);
+
+    CHECK_EQ(TakeEdgeEvents(), 1);
+    CHECK_EQ(m_Pin.ops->getEvents(m_Events, TEST_EVENTS_MAX), 1);
+
+    SimClockRun(SimClockUs(20));
+    SimGpioDrive(TEST_PIN, false);
+    SimClockRun(SimClockUs(20));
+    SimGpioDrive(TEST_PIN, true);
+
+    SimClockRun(SimClockUs(3U * TEST_DEBOUNCE_US));
+
+    CHECK_EQ(TakeEdgeEvents(), 0);
+    CHECK_EQ(m_Pin.ops->getEvents(m_Events, TEST_EVENTS_MAX), 0);
+
+    /* window is over: a real release is reported at once */
+    SimGpioDrive(TEST_PIN, false);
+
+    CHECK_EQ(TakeEdgeEvents(), 1);
+    CHECK_EQ(m_Pin.ops->getEvents(m_Events, TEST_EVENTS_MAX), 1);
+    CHECK_EQ(m_Events[0].state, PIN_STATE_LOW);
+}
+
+static const Test_t m_Tests[] = {
+    TEST(TestEdgesAnnouncedOncePerBatch),
+    TEST(TestBounceSettlesFromTimer),
+    TEST(TestBounceBackToStableLevelIsSilent),
+};
+
+int main(void)
+{
+    return TestRun("stm32f4xx gpio events", m_Tests, TEST_COUNT(m_Tests), &Setup);
+}
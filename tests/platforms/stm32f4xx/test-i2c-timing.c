@@ -0,0 +1,203 @@
+#include <string.h>
+
+#include "test.h"
+#include "mmio.h"
+#include "stm32-sim.h"
+#include "i2c.h"
+
+/* CCR, TRISE and CR2 FREQ programmed by I2C_Init against RM0383 18.6.8 and
+ * 18.6.9 (Sm 100 kHz at 8 MHz: CCR 0x28, TRISE 9; Fm 400 kHz needs PCLK1
+ * multiple of 10 MHz with DUTY = 1) and the board clocks */
+
+static I2C_Handle_t m_I2c;
+
+typedef struct
+{
+    uint32_t hclk;
+    uint32_t apb1Divider;
+    uint32_t speed;
+    uint8_t duty;
+    uint16_t ccr;               /* CCR field */
+    uint8_t trise;
+    uint32_t scl;               /* resulting SCL, Hz */
+} TimingRow_t;
+
+static const TimingRow_t m_Rows[] = {
+    /* RM0383 examples */
+    { 8000000, 1, 100000, 0, 0x28, 9, 100000 },
+    { 10000000, 1, 400000, 1, 1, 4, 400000 },
+    /* standard mode down to the 2 MHz minimum */
+    { 2000000, 1, 100000, 0, 10, 3, 100000 },
+    { 16000000, 1, 100000, 0, 80, 17, 100000 },
+    { 100000000, 2, 100000, 0, 250, 51, 100000 },
+    { 84000000, 2, 100000, 0, 210, 43, 100000 },
+    /* CCR minimum of 4 in standard mode */
+    { 2000000, 1, 90000, 0, 12, 3, 83333 },
+    /* any speed, rounded down */
+    { 100000000, 2, 50000, 0, 500, 51, 50000 },
+    { 100000000, 2, 250000, 0, 67, 16, 248756 },
+    { 16000000, 1, 330000, 0, 17, 5, 313725 },
+    /* fast mode, Tlow/Thigh = 2 */
+    { 84000000, 2, 400000, 0, 35, 13, 400000 },
+    { 100000000, 2, 400000, 0, 42, 16, 396825 },
+    { 4000000, 1, 400000, 0, 4, 2, 333333 },
+    /* fast mode, Tlow/Thigh = 16/9 */
+    { 100000000, 2, 400000, 1, 5, 16, 400000 },
+    { 84000000, 2, 400000, 1, 5, 13, 336000 },
+};
+
+static void Setup(void)
+{
+    Stm32SimReset(100000000U, 2, 1);
+
+    memset(&m_I2c, 0, sizeof(m_I2c));
+}
+
+static void Init(uint32_t speed, uint8_t duty)
+{
+    memset(&m_I2c, 0, sizeof(m_I2c));
+
+    m_I2c.config.speed = speed;
+    m_I2c.config.ackControl = 1;
+    m_I2c.config.dutyCycle = duty;
+
+    I2C_Init(&m_I2c, I2C_1);
+}
+
+typedef struct
+{
+    uint32_t ccr;
+    uint32_t trise;
+    uint32_t freq;
+} Timing_t;
+
+static Timing_t ReadTiming(void)
+{
+    Timing_t timing;
+
+    MmioOpen();
+    timing.ccr = I2C1->CCR;
+    timing.trise = I2C1->TRISE;
+    timing.freq = I2C1->CR2 & I2C_CR2_FREQ;
+    MmioClose();
+
+    return timing;
+}
+
+static void TestTimingMatchesReference(void)
+{
+    for (uint32_t i = 0; i < sizeof(m_Rows) / sizeof(m_Rows[0]); i++)
+    {
+        const TimingRow_t* row = &m_Rows[i];
+        uint32_t pclk1 = row->hclk / row->apb1Divider;
+        bool fastMode = row->speed > I2C_SPEED_STANDARD_MODE;
+
+        Stm32SimSetClocks(row->hclk, row->apb1Divider, 1);
+        Init(row->speed, row->duty);
+
+        Timing_t timing = ReadTiming();
+
+        uint32_t ccr = timing.ccr & I2C_CCR_CCR;
+        uint32_t ticks = !fastMode ? 2U : (row->duty ? 25U : 3U);
+        uint32_t scl = pclk1 / (ticks * ccr);
+
+        bool passed = CHECK_EQ(ccr, row->ccr);
+
+        passed = CHECK_EQ(timing.trise, row->trise) && passed;
+        passed = CHECK_EQ(timing.freq, pclk1 / 1000000U) && passed;
+        passed = CHECK_EQ((timing.ccr & I2C_CCR_FS) != 0U, fastMode) && passed;
+        passed = CHECK_EQ((timing.ccr & I2C_CCR_DUTY) != 0U, fastMode && row->duty) && passed;
+        passed = CHECK_EQ(scl, row->scl) && passed;
+
+        /* never faster than requested */
+        passed = CHECK(scl <= row->speed) && passed;
+
+        if (!passed)
+        {
+            TestPrint("row %u: %u Hz / %u, %u Hz duty %u", i, row->hclk, row->apb1Divider, row->speed, row->duty);
+        }
+    }
+}
+
+static void TestPclk1FromEveryClockSource(void)
+{
+    /* HSI 16 MHz, AHB and APB1 not divided */
+    MmioOpen();
+    RCC->CFGR = RCC_CFGR_SWS_HSI;
+    MmioClose();
+
+    Init(I2C_SPEED_STANDARD_MODE, 0);
+
+    Timing_t timing = ReadTiming();
+
+    CHECK_EQ(timing.freq, 16);
+    CHECK_EQ(timing.ccr, 80);
+    CHECK_EQ(timing.trise, 17);
+
+    /* HSE 25 MHz, APB1 / 2 */
+    MmioOpen();
+    RCC->CFGR = RCC_CFGR_SWS_HSE | (4U << RCC_CFGR_PPRE1_Pos);
+    MmioClose();
+
+    Init(I2C_SPEED_STANDARD_MODE, 0);
+
+    timing = ReadTiming();
+
+    CHECK_EQ(timing.freq, 12);
+    CHECK_EQ(timing.ccr, 63);
+    CHECK_EQ(timing.trise, 13);
+
+    /* PLL: 25 MHz HSE / 25 * 168 / 2 = 84 MHz, AHB / 2, APB1 / 2 */
+    MmioOpen();
+    RCC->PLLCFGR = RCC_PLLCFGR_PLLSRC | (25U << RCC_PLLCFGR_PLLM_Pos) | (168U << RCC_PLLCFGR_PLLN_Pos);
+    RCC->CFGR = RCC_CFGR_SWS_PLL | (8U << RCC_CFGR_HPRE_Pos) | (4U << RCC_CFGR_PPRE1_Pos);
+    MmioClose();
+
+    Init(I2C_SPEED_STANDARD_MODE, 0);
+
+    timing = ReadTiming();
+
+    CHECK_EQ(timing.freq, 21);
+    CHECK_EQ(timing.ccr, 105);
+    CHECK_EQ(timing.trise, 22);
+}
+
+static void TestSpeedAboveFastModeAsserts(void)
+{
+    /* no Fast-mode Plus on STM32F411 */
+    TEST_EXPECT_ASSERT(Init(1000000, 0));
+    TEST_EXPECT_ASSERT(Init(I2C_SPEED_FAST_MODE + 1U, 0));
+}
+
+static void TestPclk1BelowMinimumAsserts(void)
+{
+    /* fast mode needs 4 MHz */
+    Stm32SimSetClocks(2000000U, 1, 1);
+
+    TEST_EXPECT_ASSERT(Init(I2C_SPEED_FAST_MODE, 0));
+}
+
+static void TestBusRunsAtProgrammedRate(void)
+{
+    /* 100 MHz, APB1 / 2: SCL period of 2.5 us with DUTY = 1 */
+    Init(I2C_SPEED_FAST_MODE, 1);
+
+    CHECK_EQ(Stm32I2cByteCycles(I2C1), SimClockUs(9U * 5U) / 2U);
+
+    Init(I2C_SPEED_STANDARD_MODE, 0);
+
+    CHECK_EQ(Stm32I2cByteCycles(I2C1), SimClockUs(90));
+}
+
+static const Test_t m_Tests[] = {
+    TEST(TestTimingMatchesReference),
+    TEST(TestPclk1FromEveryClockSource),
+    TEST(TestSpeedAboveFastModeAsserts),
+    TEST(TestPclk1BelowMinimumAsserts),
+    TEST(TestBusRunsAtProgrammedRate),
+};
+
+int main(void)
+{
+    return TestRun("stm32f4xx i2c timing", m_Tests, TEST_COUNT(m_Tests), &Setup);
+}
@@ -0,0 +1,396 @@
+#include <string.h>
+
+#include "test.h"
+#include "mmio.h"
+#include "stm32-sim.h"
+#include "i2c.h"
+#include "dma.h"
+#include "gpio-name.h"
+#include "ignore.h"
+
+/* Blocking I2C master on the register-level STM32F411 model: I2C1 at
+ * 100 kHz from 50 MHz APB1, register device at 0x50, bus faults injected
+ * by the board side of the model (SDA held by a slave, clock stretching) */
+
+#define TEST_HCLK               (100000000U)
+#define TEST_ADDRESS            (0x50U)
+#define TEST_WAIT_TIMEOUT       (2000U)     /* us, I2C_WAIT_FLAG_TIMEOUT of the driver */
+
+static I2C_Handle_t m_I2c;
+static Stm32I2cDevice_t m_Device;
+
+static void Setup(void)
+{
+    Stm32SimReset(TEST_HCLK, 2, 1);
+
+    memset(&m_I2c, 0, sizeof(m_I2c));
+    memset(&m_Device, 0, sizeof(m_Device));
+
+    for (uint32_t i = 0; i < sizeof(m_Device.regs); i++)
+    {
+        m_Device.regs[i] = (uint8_t)(i * 7U + 3U);
+    }
+
+    m_Device.address = TEST_ADDRESS;
+    Stm32I2cAttach(I2C1, &m_Device);
+
+    m_I2c.config.speed = I2C_SPEED_STANDARD_MODE;
+    m_I2c.config.ackControl = 1;
+    m_I2c.config.dutyCycle = 0;
+
+    I2C_Init(&m_I2c, I2C_1);
+}
+
+static bool BusBusy(void)
+{
+    MmioOpen();
+    bool busy = (I2C1->SR2 & I2C_SR2_BUSY) != 0U;
+    MmioClose();
+
+    return busy;
+}
+
+/*Brief: Set register pointer of the device
+ * */
+static void Point(uint8_t reg)
+{
+    CHECK_EQ(I2C_MasterTransmit(&m_I2c, &reg, 1, TEST_ADDRESS), I2C_OK);
+}
+
+static void TestTransmitWritesRegisters(void)
+{
+    const uint8_t data[5] = { 0x10, 0xA1, 0xB2, 0xC3, 0xD4 };
+
+    uint64_t start = SimClockNow();
+
+    CHECK_EQ(I2C_MasterTransmit(&m_I2c, data, sizeof(data), TEST_ADDRESS), I2C_OK);
+
+    /* address and 5 bytes back to back, no timeout on the way */
+    uint64_t elapsed = SimClockNow() - start;
+    uint64_t byte = Stm32I2cByteCycles(I2C1);
+
+    CHECK_EQ(byte, SimClockUs(90));
+    CHECK(elapsed >= 6U * byte);
+    CHECK(elapsed < 7U * byte);
+
+    CHECK_EQ(m_Device.written, 4);
+    CHECK_MEM(&m_Device.regs[0x10], &data[1], 4);
+
+    SimClockRun(byte);
+    CHECK(!BusBusy());
+}
+
+static void TestReceiveLengths(void)
+{
+    static const uint8_t LENGTHS[] = { 1, 2, 3, 4, 7 };
+
+    for (uint32_t i = 0; i < sizeof(LENGTHS); i++)
+    {
+        uint8_t rx[8] = { 0 };
+        uint8_t len = LENGTHS[i];
+        uint8_t reg = (uint8_t)(0x20U + i * 0x10U);
+
+        Point(reg);
+
+        m_Device.read = 0;
+
+        bool passed = CHECK_EQ(I2C_MasterReceive(&m_I2c, rx, len, TEST_ADDRESS), I2C_OK);
+
+        passed = CHECK_MEM(rx, &m_Device.regs[reg], len) && passed;
+
+        /* last byte NACKed in time: device was not asked for more */
+        passed = CHECK_EQ(m_Device.read, len) && passed;
+
+        SimClockRun(Stm32I2cByteCycles(I2C1));
+        passed = CHECK(!BusBusy()) && passed;
+
+        MmioOpen();
+        passed = CHECK(I2C1->CR1 & I2C_CR1_ACK) && passed;
+        passed = CHECK(!(I2C1->CR1 & I2C_CR1_POS)) && passed;
+        MmioClose();
+
+        if (!passed)
+        {
+            TestPrint("length %u", len);
+        }
+    }
+}
+
+static void TestAddressNack(void)
+{
+    const uint8_t data[2] = { 0x00, 0x55 };
+
+    uint64_t start = SimClockNow();
+
+    CHECK_EQ(I2C_MasterTransmit(&m_I2c, data, sizeof(data), 0x51), I2C_NACK);
+
+    /* AF ends the address wait, no timeout */
+    CHECK(SimClockNow() - start < 2U * Stm32I2cByteCycles(I2C1));
+
+    uint8_t rx;
+
+    CHECK_EQ(I2C_MasterReceive(&m_I2c, &rx, 1, 0x51), I2C_NACK);
+
+    /* STOP released the bus, no recovery was needed */
+    CHECK_EQ(I2C_MasterTransmit(&m_I2c, data, sizeof(data), TEST_ADDRESS), I2C_OK);
+    CHECK_EQ(Stm32I2cSclClocks(I2C1), 0);
+}
+
+static void TestDataNack(void)
+{
+    const uint8_t data[4] = { 0x30, 0x01, 0x02, 0x03 };
+
+    /* register pointer and one data byte accepted */
+    m_Device.nackAfter = 2;
+
+    CHECK_EQ(I2C_MasterTransmit(&m_I2c, data, sizeof(data), TEST_ADDRESS), I2C_NACK);
+    CHECK_EQ(m_Device.written, 1);
+
+    m_Device.nackAfter = 0;
+
+    CHECK_EQ(I2C_MasterTransmit(&m_I2c, data, sizeof(data), TEST_ADDRESS), I2C_OK);
+    CHECK_EQ(m_Device.written, 4);
+}
+
+static void TestStuckSdaIsRecovered(void)
+{
+    const uint8_t data[2] = { 0x40, 0x5A };
+
+    /* slave was reset in the middle of a read, 5 bits of the byte left */
+    Stm32I2cHoldSda(I2C1, 5);
+
+    CHECK_EQ(I2C_MasterTransmit(&m_I2c, data, sizeof(data), TEST_ADDRESS), I2C_OK);
+    CHECK_EQ(m_Device.regs[0x40], 0x5A);
+
+    /* 5 clocks release SDA, one more for STOP */
+    CHECK_EQ(Stm32I2cSclClocks(I2C1), 6);
+
+    /* peripheral programming restored by the software reset path */
+    MmioOpen();
+    CHECK_EQ(I2C1->CCR, 250);
+    CHECK_EQ(I2C1->TRISE, 51);
+    CHECK_EQ(I2C1->CR2 & I2C_CR2_FREQ, 50);
+    MmioClose();
+}
+
+static void TestStuckBusReportsBusy(void)
+{
+    const uint8_t data[2] = { 0x40, 0x5A };
+
+    Stm32I2cHoldSda(I2C1, STM32_I2C_HOLD_FOREVER);
+
+    uint64_t start = SimClockNow();
+
+    CHECK_EQ(I2C_MasterTransmit(&m_I2c, data, sizeof(data), TEST_ADDRESS), I2C_BUSY);
+
+    /* 9 clocks and STOP, then given up: bounded by BUSY wait and recovery */
+    CHECK_EQ(Stm32I2cSclClocks(I2C1), 10);
+    CHECK(SimClockNow() - start < SimClockUs(TEST_WAIT_TIMEOUT + 200U));
+
+    uint8_t rx;
+
+    CHECK_EQ(I2C_MasterReceive(&m_I2c, &rx, 1, TEST_ADDRESS), I2C_BUSY);
+    CHECK_EQ(m_Device.read, 0);
+}
+
+static void TestBusyGlitchClearedBySoftwareReset(void)
+{
+    const uint8_t data[2] = { 0x40, 0x5A };
+
+    /* noise on SDA latches BUSY, lines are high again */
+    SimGpioDrive(PB_9, false);
+    SimClockRun(SimClockUs(1));
+    SimGpioDrive(PB_9, true);
+    SimClockRun(SimClockUs(1));
+
+    CHECK(BusBusy());
+
+    CHECK_EQ(I2C_MasterTransmit(&m_I2c, data, sizeof(data), TEST_ADDRESS), I2C_OK);
+
+    /* SDA was free: no clocks, STOP only */
+    CHECK_EQ(Stm32I2cSclClocks(I2C1), 1);
+}
+
+static void TestStretchWithinTimeout(void)
+{
+    const uint8_t data[4] = { 0x50, 0x01, 0x02, 0x03 };
+
+    Stm32I2cStretch(I2C1, 2, SimClockUs(1500));
+
+    uint64_t start = SimClockNow();
+
+    CHECK_EQ(I2C_MasterTransmit(&m_I2c, data, sizeof(data), TEST_ADDRESS), I2C_OK);
+    CHECK(SimClockNow() - start >= SimClockUs(1500));
+    CHECK_EQ(m_Device.written, 3);
+    CHECK_EQ(Stm32I2cSclClocks(I2C1), 0);
+}
+
+static void TestStretchBeyondTimeout(void)
+{
+    const uint8_t data[4] = { 0x50, 0x01, 0x02, 0x03 };
+
+    Stm32I2cStretch(I2C1, 1, SimClockUs(5000));
+
+    uint64_t start = SimClockNow();
+
+    CHECK_EQ(I2C_MasterTransmit(&m_I2c, data, sizeof(data), TEST_ADDRESS), I2C_TIMEOUT);
+
+    /* one flag wait, not the whole stretch */
+    CHECK(SimClockNow() - start < SimClockUs(TEST_WAIT_TIMEOUT + 500U));
+
+    /* slave lets SCL go, bus works without reinit */
+    SimClockRun(SimClockUs(5000));
+
+    CHECK_EQ(I2C_MasterTransmit(&m_I2c, data, sizeof(data), TEST_ADDRESS), I2C_OK);
+    CHECK_MEM(&m_Device.regs[0x50], &data[1], 3);
+}
+
+/* single byte reads, the next one queued from the completion of the previous */
+static uint8_t m_ItRx[2];
+static volatile I2C_STATUS m_ItStatus[2];
+static uint64_t m_ItDoneAt[2];
+static uint32_t m_ItDone;
+
+static void OnItReadDone(void* context)
+{
+    IGNORE(context);
+
+    m_ItDoneAt[m_ItDone] = SimClockNow();
+    m_ItDone++;
+
+    if (m_ItDone == 1U)
+    {
+        I2C_Transaction_t t = {
+            .devAddress = TEST_ADDRESS,
+            .rxBuffer = &m_ItRx[1],
+            .rxLen = 1,
+            .onRxDone = &OnItReadDone,
+            .status = &m_ItStatus[1],
+        };
+
+        CHECK_EQ(I2C_MasterTransfer_IT(&m_I2c, &t), I2C_OK);
+    }
+}
+
+static bool ItReadsDone(void* context)
+{
+    IGNORE(context);
+
+    return m_ItDone == 2U;
+}
+
+static void TestStartAfterStopWaitsForTimer(void)
+{
+    Point(0x30);
+
+    m_ItDone = 0;
+
+    uint32_t events = SimIrqCount(I2C1_EV_IRQn);
+
+    I2C_Transaction_t t = {
+        .devAddress = TEST_ADDRESS,
+        .rxBuffer = &m_ItRx[0],
+        .rxLen = 1,
+        .onRxDone = &OnItReadDone,
+        .status = &m_ItStatus[0],
+    };
+
+    CHECK_EQ(I2C_MasterTransfer_IT(&m_I2c, &t), I2C_OK);
+
+    CHECK(SimClockRunUntil(&ItReadsDone, NULL, SimClockUs(5000)));
+
+    CHECK_EQ(m_ItStatus[0], I2C_STATUS_DONE);
+    CHECK_EQ(m_ItStatus[1], I2C_STATUS_DONE);
+    CHECK_EQ(m_ItRx[0], m_Device.regs[0x30]);
+    CHECK_EQ(m_ItRx[1], m_Device.regs[0x31]);
+
+    /* STOP of the first read was pending: START came from the one tick
+     * timer, not from the event interrupt re-pending itself */
+    CHECK(m_ItDoneAt[1] - m_ItDoneAt[0] < SimClockUs(2000));
+    CHECK_EQ(SimIrqCount(I2C1_EV_IRQn) - events, 6);
+
+    SimClockRun(Stm32I2cByteCycles(I2C1));
+    CHECK(!BusBusy());
+}
+
+static void OnItWriteDone(void* context)
+{
+    IGNORE(context);
+
+    m_ItDone++;
+}
+
+static void TestWriteOnlyTransactionsEndWithStop(void)
+{
+    /* address only writes, both queued at once */
+    I2C_Transaction_t t = {
+        .devAddress = TEST_ADDRESS,
+        .onTxDone = &OnItWriteDone,
+    };
+
+    m_ItDone = 0;
+
+    t.status = &m_ItStatus[0];
+    CHECK_EQ(I2C_MasterTransfer_IT(&m_I2c, &t), I2C_OK);
+
+    t.status = &m_ItStatus[1];
+    CHECK_EQ(I2C_MasterTransfer_IT(&m_I2c, &t), I2C_OK);
+
+    CHECK(SimClockRunUntil(&ItReadsDone, NULL, SimClockUs(5000)));
+
+    CHECK_EQ(m_ItStatus[0], I2C_STATUS_DONE);
+    CHECK_EQ(m_ItStatus[1], I2C_STATUS_DONE);
+
+    SimClockRun(Stm32I2cByteCycles(I2C1));
+    CHECK(!BusBusy());
+
+    /* the device saw each write committed by its own STOP */
+    CHECK_EQ(m_Device.stops, 2);
+}
+
+static void OtherDmaHandler(void* context)
+{
+    IGNORE(context);
+}
+
+static void TestSharedDmaStreamsAreExclusive(void)
+{
+    /* SPI3 RX uses the DMA1 stream 0 of I2C1 RX */
+    static const DMA_Stream_t SPI3_RX = { DMA1, DMA1_Stream0, 0, 0, DMA1_Stream0_IRQn };
+    static I2C_Handle_t i2c2;
+    static uint8_t other;
+
+    TEST_EXPECT_ASSERT(DmaRegisterHandler(&SPI3_RX, &OtherDmaHandler, &other));
+
+    /* I2C2 TX uses the DMA1 stream 7 of I2C1 TX */
+    i2c2.config = m_I2c.config;
+    TEST_EXPECT_ASSERT(I2C_Init(&i2c2, I2C_2));
+
+    I2C_Deinit(&m_I2c);
+
+    DmaRegisterHandler(&SPI3_RX, &OtherDmaHandler, &other);
+    DmaUnregisterHandler(&SPI3_RX);
+
+    I2C_Init(&i2c2, I2C_2);
+    I2C_Deinit(&i2c2);
+}
+
+static const Test_t m_Tests[] = {
+    TEST(TestTransmitWritesRegisters),
+    TEST(TestReceiveLengths),
+    TEST(TestAddressNack),
+    TEST(TestDataNack),
+    TEST(TestStuckSdaIsRecovered),
+    TEST(TestStuckBusReportsBusy),
+    TEST(TestBusyGlitchClearedBySoftwareReset),
+    TEST(TestStretchWithinTimeout),
+    TEST(TestStretchBeyondTimeout),
+    TEST(TestStartAfterStopWaitsForTimer),
+    TEST(TestWriteOnlyTransactionsEndWithStop),
+    TEST(TestSharedDmaStreamsAreExclusive),
+};
+
+int main(void)
+{
+    return TestRun("stm32f4xx i2c", m_Tests, TEST_COUNT(m_Tests), &Setup);
+}
@@ -0,0 +1,601 @@
+#include <string.h>
+
+#include "test.h"
+#include "mmio.h"
+#include "stm32-sim.h"
+#include "timebase.h"
+#include "spi.h"
+#include "ignore.h"
+
+/* SPI master on the register-level STM32F411 model: SPI1 from 100 MHz APB2,
+ * DMA2 stream 0 (RX) and 5 (TX), slave device behind a frame callback */
+
+#define TEST_HCLK               (100000000U)
+#define TEST_LEGACY_TIMEOUT     (100U)      /* us, per flag wait of the byte loop */
+
+static SPI_Handle_t m_Spi;
+
+static uint8_t m_Tx[512];
+static uint8_t m_Rx[512];
+
+/* slave: answers every frame with its complement, logs MOSI frames */
+typedef struct
+{
+    uint16_t mosi[512];
+    bool wide[512];
+    uint32_t frames;
+    uint32_t pendAt;        /* frame raising the test interrupt, 0 - none */
+    uint8_t csLow[512];     /* CS pins driven low during the frame, bit per device */
+} Slave_t;
+
+static Slave_t m_Slave;
+
+static const uint8_t m_CsPins[2] = { PA_4, PB_6 };
+
+static uint64_t m_StallCycles;
+
+static uint16_t SlaveExchange(uint16_t mosi, bool wide, void* context)
+{
+    Slave_t* slave = (Slave_t*)context;
+
+    if (slave->frames < sizeof(slave->mosi) / sizeof(slave->mosi[0]))
+    {
+        slave->mosi[slave->frames] = mosi;
+        slave->wide[slave->frames] = wide;
+        slave->csLow[slave->frames] = 0;
+
+        for (uint32_t i = 0; i < sizeof(m_CsPins); i++)
+        {
+            if (SimGpioDriven(m_CsPins[i]) && !SimGpioLevel(m_CsPins[i]))
+            {
+                slave->csLow[slave->frames] |= (uint8_t)(1U << i);
+            }
+        }
+    }
+
+    slave->frames++;
+
+    if (slave->frames == slave->pendAt)
+    {
+        SimIrqPend(TIM2_IRQn);
+    }
+
+    return (uint16_t)~mosi;
+}
+
+/* higher priority code keeping the core busy for a while */
+void TIM2_IRQHandler(void)
+{
+    SimClockAdvance(m_StallCycles);
+}
+
+static void Setup(void)
+{
+    Stm32SimReset(TEST_HCLK, 2, 1);
+
+    memset(&m_Slave, 0, sizeof(m_Slave));
+    memset(m_Rx, 0, sizeof(m_Rx));
+
+    for (uint32_t i = 0; i < sizeof(m_Tx); i++)
+    {
+        m_Tx[i] = (uint8_t)(i * 11U + 5U);
+    }
+
+    m_StallCycles = 0;
+
+    Stm32SpiAttach(SPI1, &SlaveExchange, &m_Slave);
+}
+
+static void Init(uint32_t frequencyHz)
+{
+    memset(&m_Spi, 0, sizeof(m_Spi));
+
+    CHECK_EQ(SpiInit(&m_Spi, SPI_1, CPOL_0, CPHA_0, frequencyHz), frequencyHz);
+}
+
+static bool LegacyWaitFlag(volatile uint32_t* reg, uint32_t flag, bool state, uint32_t timeoutUs)
+{
+    while (((*reg & flag) ? 1 : 0) != (state ? 1 : 0))
+    {
+        if (timeoutUs == 0)
+        {
+            return false;
+        }
+
+        /* DelayUs(1) */
+        SimClockRun(SimClockUs(1));
+        timeoutUs--;
+    }
+
+    return true;
+}
+
+/*Brief: Blocking transfer before burst pipelining: one byte in flight, flag
+ * waits polled once per microsecond
+ * [in] - spi - peripheral
+ * [in] - txBuffer - buffer to transmit (NULL - 0xFF is sent)
+ * [in] - rxBuffer - buffer to receive (NULL - received data is discarded)
+ * [in] - size - buffer size
+ * [out] - true - transfer successful; false - timeout
+ * */
+static bool LegacyTransfer(SPI_TypeDef* spi, const uint8_t* txBuffer, uint8_t* rxBuffer, uint8_t size)
+{
+    volatile uint32_t dummy = 0;
+
+    for (uint8_t i = 0; i < size; i++)
+    {
+        if (!LegacyWaitFlag(&spi->SR, SPI_SR_TXE, 1, TEST_LEGACY_TIMEOUT))
+        {
+            return false;
+        }
+
+        spi->DR = (txBuffer != NULL) ? txBuffer[i] : 0xFF;
+
+        if (!LegacyWaitFlag(&spi->SR, SPI_SR_RXNE, 1, TEST_LEGACY_TIMEOUT))
+        {
+            return false;
+        }
+
+        if (rxBuffer != NULL)
+        {
+            rxBuffer[i] = (uint8_t)spi->DR;
+        }
+        else
+        {
+            dummy = spi->DR;
+            IGNORE(dummy);
+        }
+    }
+
+    return LegacyWaitFlag(&spi->SR, SPI_SR_BSY, 0, TEST_LEGACY_TIMEOUT);
+}
+
+static bool CheckComplement(const uint8_t* rx, const uint8_t* tx, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        if (!CHECK_EQ(rx[i], (uint8_t)~tx[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static uint32_t ReadCr1(void)
+{
+    MmioOpen();
+    uint32_t cr1 = SPI1->CR1;
+    MmioClose();
+
+    return cr1;
+}
+
+static uint32_t ReadSr(void)
+{
+    MmioOpen();
+    uint32_t sr = SPI1->SR;
+    MmioClose();
+
+    return sr;
+}
+
+static void TestInitProgramsMaster(void)
+{
+    Init(12500000U);
+
+    uint32_t cr1 = ReadCr1();
+
+    CHECK_EQ(cr1 & (SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI | SPI_CR1_SPE),
+             SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI | SPI_CR1_SPE);
+    CHECK_EQ((cr1 & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos, 2);
+    CHECK(!(cr1 & (SPI_CR1_DFF | SPI_CR1_CPOL | SPI_CR1_CPHA)));
+
+    /* 100 MHz / 8: 64 core cycles per byte */
+    CHECK_EQ(Stm32SpiFrameCycles(SPI1, false), 64);
+
+    /* SPI2 sits on 50 MHz APB1 */
+    static SPI_Handle_t spi2;
+
+    CHECK_EQ(SpiInit(&spi2, SPI_2, CPOL_1, CPHA_1, 12500000U), 12500000U);
+    CHECK_EQ(Stm32SpiFrameCycles(SPI2, false), 64);
+}
+
+static void TestSpi4AndSpi5ShareDmaAfterDeinit(void)
+{
+    static SPI_Handle_t spi4;
+    static SPI_Handle_t spi5;
+
+    CHECK(SpiInit(&spi4, SPI_4, CPOL_0, CPHA_0, 12500000U) != 0U);
+
+    /* DMA2 streams 3/4 are taken by SPI4 */
+    TEST_EXPECT_ASSERT(SpiInit(&spi5, SPI_5, CPOL_0, CPHA_0, 12500000U));
+
+    SpiDeinit(&spi4);
+
+    CHECK(SpiInit(&spi5, SPI_5, CPOL_0, CPHA_0, 12500000U) != 0U);
+
+    SpiDeinit(&spi5);
+}
+
+static void TestTransferIsFullDuplex(void)
+{
+    Init(12500000U);
+
+    CHECK(SpiTransfer(&m_Spi, m_Tx, m_Rx, 5));
+
+    CHECK_EQ(m_Slave.frames, 5);
+    CHECK(CheckComplement(m_Rx, m_Tx, 5));
+
+    for (uint32_t i = 0; i < 5U; i++)
+    {
+        CHECK_EQ(m_Slave.mosi[i], m_Tx[i]);
+        CHECK(!m_Slave.wide[i]);
+    }
+
+    CHECK(!(ReadSr() & (SPI_SR_BSY | SPI_SR_RXNE | SPI_SR_OVR)));
+}
+
+static void TestEvenBurstUsesWideFrames(void)
+{
+    Init(12500000U);
+
+    CHECK(SpiTransfer(&m_Spi, m_Tx, m_Rx, 16));
+
+    /* two bytes per frame, MSB first: byte order on the wire is unchanged */
+    CHECK_EQ(m_Slave.frames, 8);
+
+    for (uint32_t i = 0; i < 8U; i++)
+    {
+        CHECK(m_Slave.wide[i]);
+        CHECK_EQ(m_Slave.mosi[i], ((uint16_t)m_Tx[2U * i] << 8) | m_Tx[2U * i + 1U]);
+    }
+
+    CHECK(CheckComplement(m_Rx, m_Tx, 16));
+
+    /* 8-bit format is restored */
+    CHECK(!(ReadCr1() & SPI_CR1_DFF));
+    CHECK(ReadCr1() & SPI_CR1_SPE);
+}
+
+static void TestShortOrOddTransferUsesByteFrames(void)
+{
+    Init(12500000U);
+
+    CHECK(SpiTransfer(&m_Spi, m_Tx, m_Rx, 6));
+    CHECK(SpiTransfer(&m_Spi, m_Tx, m_Rx, 9));
+
+    CHECK_EQ(m_Slave.frames, 15);
+
+    for (uint32_t i = 0; i < 15U; i++)
+    {
+        CHECK(!m_Slave.wide[i]);
+    }
+}
+
+static void TestNullBuffers(void)
+{
+    Init(12500000U);
+
+    /* dummy 0xFF frames, wide and narrow */
+    CHECK(SpiTransfer(&m_Spi, NULL, m_Rx, 8));
+    CHECK(SpiTransfer(&m_Spi, NULL, m_Rx, 3));
+
+    CHECK_EQ(m_Slave.frames, 7);
+    CHECK_EQ(m_Slave.mosi[0], 0xFFFF);
+    CHECK_EQ(m_Slave.mosi[4], 0xFF);
+    CHECK_EQ(m_Rx[0], 0x00);
+
+    /* received data is discarded */
+    CHECK(SpiTransfer(&m_Spi, m_Tx, NULL, 4));
+    CHECK_EQ(m_Slave.frames, 11);
+    CHECK(!(ReadSr() & (SPI_SR_RXNE | SPI_SR_OVR)));
+}
+
+static void TestLongInterruptFailsWithOverrun(void)
+{
+    Init(12500000U);
+
+    /* interrupt keeps the core for four frame times in the middle of the burst */
+    m_StallCycles = 4U * Stm32SpiFrameCycles(SPI1, false);
+    m_Slave.pendAt = 3;
+    NVIC_EnableIRQ(TIM2_IRQn);
+
+    CHECK(!SpiTransfer(&m_Spi, m_Tx, m_Rx, 7));
+    CHECK_EQ(SimIrqCount(TIM2_IRQn), 1);
+
+    /* overrun is cleared, next transfer goes through */
+    CHECK(!(ReadSr() & (SPI_SR_RXNE | SPI_SR_OVR)));
+
+    CHECK(SpiTransfer(&m_Spi, m_Tx, m_Rx, 7));
+    CHECK(CheckComplement(m_Rx, m_Tx, 7));
+}
+
+/*Brief: Measure blocking transfer
+ * [in] - legacy - true - byte loop; false - SpiTransfer
+ * [in] - size - bytes
+ * [out] - core cycles
+ * */
+static uint64_t MeasureTransfer(bool legacy, uint32_t size)
+{
+    memset(m_Rx, 0, sizeof(m_Rx));
+
+    uint64_t start = SimClockNow();
+    bool result = legacy ? LegacyTransfer(SPI1, m_Tx, m_Rx, (uint8_t)size) : SpiTransfer(&m_Spi, m_Tx, m_Rx, size);
+    uint64_t cycles = SimClockNow() - start;
+
+    CHECK(result);
+    CHECK(CheckComplement(m_Rx, m_Tx, size));
+
+    return cycles;
+}
+
+static void TestThroughputAgainstByteLoop(void)
+{
+    static const uint32_t RATES[] = { 25000000U, 12500000U, 6250000U, 1562500U };
+    static const uint32_t SIZES[] = { 7U, 64U, 255U };
+
+    for (uint32_t r = 0; r < sizeof(RATES) / sizeof(RATES[0]); r++)
+    {
+        Init(RATES[r]);
+
+        uint64_t byteCycles = Stm32SpiFrameCycles(SPI1, false);
+
+        for (uint32_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++)
+        {
+            uint32_t size = SIZES[s];
+            uint64_t legacy = MeasureTransfer(true, size);
+            uint64_t pipelined = MeasureTransfer(false, size);
+            uint64_t line = byteCycles * size;
+
+            TestPrint("%5u kHz %3u B: byte loop %6u kB/s, pipelined %6u kB/s (%3u %% of line rate)",
+                      RATES[r] / 1000U, size,
+                      (uint32_t)((uint64_t)size * TEST_HCLK / legacy / 1000U),
+                      (uint32_t)((uint64_t)size * TEST_HCLK / pipelined / 1000U),
+                      (uint32_t)(line * 100U / pipelined));
+
+            CHECK(pipelined < legacy);
+
+            /* bursts run at line rate: fixed cost of format switch and final BSY wait only */
+            if (size >= 64U)
+            {
+                CHECK(pipelined * 100U <= line * 110U);
+            }
+        }
+    }
+}
+
+static volatile SPI_STATUS m_Status[4];
+static uint32_t m_Order[4];
+static uint32_t m_Done;
+static uint32_t m_Errors;
+
+static void OnDone(void* context)
+{
+    m_Order[m_Done++] = (uint32_t)(uintptr_t)context;
+}
+
+static void OnError(SPI_STATUS status, void* context)
+{
+    CHECK_EQ(status, SPI_STATUS_DMA_ERROR);
+    IGNORE(context);
+
+    m_Errors++;
+}
+
+static void PrepareTransaction(SPI_Transaction_t* t, uint32_t id)
+{
+    memset(t, 0, sizeof(*t));
+
+    t->onTransactionDone = &OnDone;
+    t->onError = &OnError;
+    t->status = &m_Status[id];
+    t->context = (void*)(uintptr_t)id;
+}
+
+static bool Finished(void* context)
+{
+    return *(volatile SPI_STATUS*)context != SPI_STATUS_PENDING;
+}
+
+static void WaitFinished(uint32_t id)
+{
+    CHECK(SimClockRunUntil(&Finished, (void*)&m_Status[id], SimClockUs(1000)));
+}
+
+static void ResetCallbacks(void)
+{
+    m_Done = 0;
+    m_Errors = 0;
+    memset(m_Order, 0, sizeof(m_Order));
+}
+
+static void TestDmaTransactionSegments(void)
+{
+    Init(12500000U);
+    ResetCallbacks();
+
+    static uint8_t command[2] = { 0x0B, 0x42 };
+    static uint8_t data[24];
+
+    static const SPI_Segment_t segments[] = {
+        { command, NULL, sizeof(command) },
+        { NULL, data, sizeof(data) },
+    };
+
+    static SPI_Transaction_t t;
+
+    PrepareTransaction(&t, 0);
+    t.segments = segments;
+    t.segmentCount = 2;
+
+    CHECK_EQ(SpiTransfer_IT(&m_Spi, &t), SPI_OK);
+    WaitFinished(0);
+
+    CHECK_EQ(m_Status[0], SPI_STATUS_DONE);
+    CHECK_EQ(m_Done, 1);
+
+    /* command goes out, dummy bytes clock the answer in */
+    CHECK_EQ(m_Slave.frames, 26);
+    CHECK_EQ(m_Slave.mosi[0], 0x0B);
+    CHECK_EQ(m_Slave.mosi[1], 0x42);
+    CHECK_EQ(m_Slave.mosi[2], 0xFF);
+    CHECK_EQ(data[0], 0x00);
+
+    /* one RX completion per segment, no per-byte CPU work */
+    CHECK_EQ(Stm32DmaStarts(DMA2_Stream0), 2);
+    CHECK_EQ(Stm32DmaStarts(DMA2_Stream5), 2);
+    CHECK_EQ(SimIrqCount(DMA2_Stream0_IRQn), 2);
+    CHECK(!(ReadSr() & (SPI_SR_RXNE | SPI_SR_OVR)));
+}
+
+static void TestDmaErrorDropsTransaction(void)
+{
+    Init(12500000U);
+    ResetCallbacks();
+
+    static SPI_Transaction_t t;
+
+    Stm32DmaInjectError(DMA2_Stream0);
+
+    PrepareTransaction(&t, 0);
+    t.txBuffer = m_Tx;
+    t.rxBuffer = m_Rx;
+    t.txLen = 16;
+    t.rxLen = 16;
+
+    CHECK_EQ(SpiTransfer_IT(&m_Spi, &t), SPI_OK);
+    WaitFinished(0);
+
+    CHECK_EQ(m_Status[0], SPI_STATUS_DMA_ERROR);
+    CHECK_EQ(m_Errors, 1);
+    CHECK_EQ(m_Done, 0);
+
+    /* frames in flight are drained, the next transaction gets clean data */
+    CHECK(!(ReadSr() & (SPI_SR_BSY | SPI_SR_RXNE | SPI_SR_OVR)));
+    memset(m_Rx, 0, sizeof(m_Rx));
+
+    PrepareTransaction(&t, 1);
+    t.txBuffer = &m_Tx[16];
+    t.rxBuffer = m_Rx;
+    t.txLen = 16;
+    t.rxLen = 16;
+
+    CHECK_EQ(SpiTransfer_IT(&m_Spi, &t), SPI_OK);
+    WaitFinished(1);
+
+    CHECK_EQ(m_Status[1], SPI_STATUS_DONE);
+    CHECK(CheckComplement(m_Rx, &m_Tx[16], 16));
+}
+
+static void TestDevicesSwitchModeAndCs(void)
+{
+    Init(12500000U);
+    ResetCallbacks();
+
+    static SPI_Device_t flash;
+    static SPI_Device_t sensor;
+
+    CHECK_EQ(SpiDeviceInit(&flash, &m_Spi, CPOL_0, CPHA_0, 25000000U, m_CsPins[0]), 25000000U);
+    CHECK_EQ(SpiDeviceInit(&sensor, &m_Spi, CPOL_1, CPHA_1, 1562500U, m_CsPins[1]), 1562500U);
+
+    CHECK(SimGpioLevel(m_CsPins[0]));
+    CHECK(SimGpioLevel(m_CsPins[1]));
+
+    CHECK(SpiDeviceTransfer(&flash, m_Tx, m_Rx, 3));
+    CHECK_EQ((ReadCr1() & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos, 1);
+
+    static SPI_Transaction_t t;
+
+    PrepareTransaction(&t, 0);
+    t.txBuffer = m_Tx;
+    t.txLen = 4;
+
+    CHECK_EQ(SpiDeviceTransfer_IT(&sensor, &t), SPI_OK);
+    WaitFinished(0);
+
+    uint32_t cr1 = ReadCr1();
+
+    CHECK_EQ(cr1 & (SPI_CR1_CPOL | SPI_CR1_CPHA), SPI_CR1_CPOL | SPI_CR1_CPHA);
+    CHECK_EQ((cr1 & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos, 5);
+
+    /* exactly the addressed device is selected during each frame */
+    CHECK_EQ(m_Slave.frames, 7);
+
+    for (uint32_t i = 0; i < 7U; i++)
+    {
+        CHECK_EQ(m_Slave.csLow[i], (i < 3U) ? 0x01 : 0x02);
+    }
+
+    CHECK(SimGpioLevel(m_CsPins[0]));
+    CHECK(SimGpioLevel(m_CsPins[1]));
+}
+
+static void TestQueueServesHighPriorityFirst(void)
+{
+    Init(12500000U);
+    ResetCallbacks();
+
+    static SPI_Transaction_t t;
+
+    /* first transaction occupies the bus while the others are queued */
+    PrepareTransaction(&t, 0);
+    t.txBuffer = m_Tx;
+    t.txLen = 64;
+    CHECK_EQ(SpiTransfer_IT(&m_Spi, &t), SPI_OK);
+
+    PrepareTransaction(&t, 1);
+    t.txBuffer = m_Tx;
+    t.txLen = 4;
+    t.priority = SPI_PRIORITY_LOW;
+    CHECK_EQ(SpiTransfer_IT(&m_Spi, &t), SPI_OK);
+
+    PrepareTransaction(&t, 2);
+    t.txBuffer = m_Tx;
+    t.txLen = 4;
+    t.priority = SPI_PRIORITY_NORMAL;
+    CHECK_EQ(SpiTransfer_IT(&m_Spi, &t), SPI_OK);
+
+    PrepareTransaction(&t, 3);
+    t.txBuffer = m_Tx;
+    t.txLen = 4;
+    t.priority = SPI_PRIORITY_HIGH;
+    CHECK_EQ(SpiTransfer_IT(&m_Spi, &t), SPI_OK);
+
+    WaitFinished(1);
+
+    CHECK_EQ(m_Done, 4);
+    CHECK_EQ(m_Order[0], 0);
+    CHECK_EQ(m_Order[1], 3);
+    CHECK_EQ(m_Order[2], 2);
+    CHECK_EQ(m_Order[3], 1);
+
+    SPI_Stats_t stats;
+
+    SpiGetStats(&m_Spi, SPI_PRIORITY_LOW, &stats);
+    CHECK_EQ(stats.count, 1);
+
+    /* low priority waited for the burst and the two others */
+    CHECK(TimebaseTicksToUs(stats.latencyMin) >= 5U);
+}
+
+static const Test_t m_Tests[] = {
+    TEST(TestInitProgramsMaster),
+    TEST(TestSpi4AndSpi5ShareDmaAfterDeinit),
+    TEST(TestTransferIsFullDuplex),
+    TEST(TestEvenBurstUsesWideFrames),
+    TEST(TestShortOrOddTransferUsesByteFrames),
+    TEST(TestNullBuffers),
+    TEST(TestLongInterruptFailsWithOverrun),
+    TEST(TestThroughputAgainstByteLoop),
+    TEST(TestDmaTransactionSegments),
+    TEST(TestDmaErrorDropsTransaction),
+    TEST(TestDevicesSwitchModeAndCs),
+    TEST(TestQueueServesHighPriorityFirst),
+};
+
+int main(void)
+{
+    return TestRun("stm32f4xx spi", m_Tests, TEST_COUNT(m_Tests), &Setup);
+}
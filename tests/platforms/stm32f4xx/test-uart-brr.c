@@ -0,0 +1,179 @@
+#include <stdlib.h>
+
+#include "test.h"
+#include "mmio.h"
+#include "stm32-sim.h"
+#include "uart.h"
+
+/* BRR computed by UartSetBaudRate against the error calculation tables of
+ * RM0383 19.3.4 (fPCLK 8, 16, 84 MHz, OVER8 = 0 and 1) and the board
+ * clocks (100 MHz APB2, 50 MHz APB1, 42 MHz APB2 at 84 MHz / 2) */
+
+UART_HANDLE_DEFINE(m_Uart, 16, 16);
+
+typedef struct
+{
+    uint32_t hclk;
+    uint32_t apbDivider;        /* of the port bus */
+    UART_NAMES uart;
+    uint32_t baud;
+    uint16_t brr;
+    bool over8;
+    uint32_t error;             /* reference error in 0.01 % */
+} BrrRow_t;
+
+static const BrrRow_t m_Rows[] = {
+    /* RM0383: fPCLK = 8 MHz, OVER8 = 0 */
+    { 8000000, 1, UART_1, 2400, 0xD05, false, 0 },
+    { 8000000, 1, UART_1, 9600, 0x341, false, 4 },
+    { 8000000, 1, UART_1, 19200, 0x1A1, false, 8 },
+    { 8000000, 1, UART_1, 57600, 0x8B, false, 8 },
+    { 8000000, 1, UART_1, 115200, 0x45, false, 64 },
+    { 8000000, 1, UART_1, 230400, 0x23, false, 79 },
+    { 8000000, 1, UART_1, 460800, 0x11, false, 212 },
+    /* RM0383: fPCLK = 8 MHz, OVER8 = 1 (divider by 16 would be below 16) */
+    { 8000000, 1, UART_1, 921600, 0x11, true, 355 },
+    /* RM0383: fPCLK = 16 MHz, OVER8 = 0 */
+    { 16000000, 1, UART_1, 115200, 0x8B, false, 8 },
+    { 16000000, 1, UART_1, 460800, 0x23, false, 79 },
+    { 16000000, 1, UART_1, 921600, 0x11, false, 212 },
+    /* RM0383: fPCLK = 84 MHz, OVER8 = 0 */
+    { 84000000, 1, UART_1, 9600, 0x222E, false, 0 },
+    { 84000000, 1, UART_1, 115200, 0x2D9, false, 2 },
+    { 84000000, 1, UART_1, 921600, 0x5B, false, 16 },
+    /* RM0383: fPCLK = 84 MHz, OVER8 = 1 (above 1 Mbaud) */
+    { 84000000, 1, UART_1, 2000000, 0x52, true, 0 },
+    { 84000000, 1, UART_1, 4000000, 0x25, true, 0 },
+    { 84000000, 1, UART_1, 6000000, 0x16, true, 0 },
+    /* board clocks */
+    { 100000000, 1, UART_1, 115200, 0x364, false, 1 },
+    { 100000000, 1, UART_1, 921600, 0x6D, false, 45 },
+    { 100000000, 1, UART_1, 6000000, 0x21, true, 196 },
+    { 100000000, 2, UART_2, 115200, 0x1B2, false, 1 },
+    { 84000000, 2, UART_6, 115200, 0x16D, false, 11 },
+};
+
+static void Setup(void)
+{
+    Stm32SimReset(100000000U, 2, 1);
+}
+
+static void SetPortClock(UART_NAMES uart, uint32_t hclk, uint32_t divider)
+{
+    /* USART2 sits on APB1, USART1/6 on APB2 */
+    if (uart == UART_2)
+    {
+        Stm32SimSetClocks(hclk, divider, 1);
+    }
+    else
+    {
+        Stm32SimSetClocks(hclk, 1, divider);
+    }
+}
+
+static void ReadBrr(USART_TypeDef* usart, uint16_t* brr, bool* over8)
+{
+    MmioOpen();
+    *brr = (uint16_t)usart->BRR;
+    *over8 = (usart->CR1 & USART_CR1_OVER8) != 0U;
+    MmioClose();
+}
+
+static void TestBrrMatchesReferenceTables(void)
+{
+    for (uint32_t i = 0; i < sizeof(m_Rows) / sizeof(m_Rows[0]); i++)
+    {
+        const BrrRow_t* row = &m_Rows[i];
+
+        SetPortClock(row->uart, row->hclk, row->apbDivider);
+        CHECK(UartInit(&m_Uart, row->uart, BAUD_9600));
+
+        uint32_t actual = UartSetBaudRate(&m_Uart, row->baud);
+
+        uint16_t brr;
+        bool over8;
+
+        ReadBrr(m_Uart.instance, &brr, &over8);
+
+        /* error rounded by the table to 0.01 % */
+        uint32_t error = (uint32_t)((llabs((int64_t)actual - (int64_t)row->baud) * 10000) / row->baud);
+
+        bool passed = CHECK_EQ(brr, row->brr);
+
+        passed = CHECK_EQ(over8, row->over8) && passed;
+        passed = CHECK(abs((int32_t)error - (int32_t)row->error) <= 1) && passed;
+
+        /* BRR[3] must stay cleared with OVER8 */
+        passed = CHECK(!over8 || !(brr & 0x08U)) && passed;
+
+        if (!passed)
+        {
+            TestPrint("row %u: %u Hz / %u, %u baud, actual %u", i, row->hclk, row->apbDivider, row->baud, actual);
+        }
+    }
+}
+
+static void TestUnreachableRateKeepsSetting(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_115200));
+
+    uint16_t before;
+    uint16_t after;
+    bool over8;
+
+    ReadBrr(USART1, &before, &over8);
+
+    /* 100 MHz / 1200 needs a divider above 0xFFFF */
+    CHECK_EQ(UartSetBaudRate(&m_Uart, 1200), 0);
+
+    ReadBrr(USART1, &after, &over8);
+    CHECK_EQ(after, before);
+
+    /* 42 MHz / 6 Mbaud is below the OVER8 minimum of 8 */
+    Stm32SimSetClocks(84000000U, 2, 2);
+    CHECK_EQ(UartSetBaudRate(&m_Uart, 6000000), 0);
+
+    ReadBrr(USART1, &after, &over8);
+    CHECK_EQ(after, before);
+}
+
+static void TestInitRejectsUnreachableRate(void)
+{
+    CHECK(!UartInit(&m_Uart, UART_1, BAUD_1200));
+
+    /* APB1 at 50 MHz reaches it with OVER8 = 0 */
+    CHECK(UartInit(&m_Uart, UART_2, BAUD_1200));
+}
+
+static void TestRateAboveMaximumAsserts(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_115200));
+
+    TEST_EXPECT_ASSERT(UartSetBaudRate(&m_Uart, UART_BAUD_MAX + 1U));
+}
+
+static void TestUsartRunsAtProgrammedRate(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_115200));
+
+    /* 10 bits of 868 APB2 cycles at 100 MHz */
+    CHECK_EQ(Stm32UsartFrameCycles(USART1), 8680);
+
+    CHECK(UartSetBaudRate(&m_Uart, 4000000) != 0U);
+
+    /* OVER8: 25 cycles per bit */
+    CHECK_EQ(Stm32UsartFrameCycles(USART1), 250);
+}
+
+static const Test_t m_Tests[] = {
+    TEST(TestBrrMatchesReferenceTables),
+    TEST(TestUnreachableRateKeepsSetting),
+    TEST(TestInitRejectsUnreachableRate),
+    TEST(TestRateAboveMaximumAsserts),
+    TEST(TestUsartRunsAtProgrammedRate),
+};
+
+int main(void)
+{
+    return TestRun("stm32f4xx uart brr", m_Tests, TEST_COUNT(m_Tests), &Setup);
+}
@@ -0,0 +1,242 @@
+#include <string.h>
+
+#include "test.h"
+#include "stm32-sim.h"
+#include "uart.h"
+
+/* UART circular DMA receive path on the register-level STM32F411 model:
+ * USART1 at 921600 baud, RX DMA2 stream 2 writing into the staging buffer,
+ * data copied to the ring on line idle and on half/full transfer */
+
+#define TEST_HCLK               (100000000U)
+#define TEST_TX_CAPACITY        (16U)
+#define TEST_RX_CAPACITY        (64U)
+
+UART_HANDLE_DEFINE(m_Uart, TEST_TX_CAPACITY, TEST_RX_CAPACITY);
+
+static uint8_t m_Data[256];
+static uint8_t m_Read[256];
+static uint32_t m_ReadCount;
+
+static uint32_t m_Callbacks;
+static uint64_t m_CallbackTime;
+static bool m_Drain;
+
+static void Setup(void)
+{
+    Stm32SimReset(TEST_HCLK, 2, 1);
+
+    for (uint32_t i = 0; i < sizeof(m_Data); i++)
+    {
+        m_Data[i] = (uint8_t)(i * 13U + 1U);
+    }
+
+    m_ReadCount = 0;
+    m_Callbacks = 0;
+    m_CallbackTime = 0;
+    m_Drain = false;
+
+    m_Uart.onRxDone = NULL;
+}
+
+/*Brief: Move received bytes from the ring to m_Read
+ * */
+static void ReadAll(void)
+{
+    uint8_t value;
+
+    while ((m_ReadCount < sizeof(m_Read)) && BufferGet(&m_Uart.rxBuffer, &value, sizeof(value)))
+    {
+        m_Read[m_ReadCount++] = value;
+    }
+}
+
+static void OnReceive(void* context)
+{
+    CHECK(context == &m_Uart);
+
+    m_Callbacks++;
+    m_CallbackTime = SimClockNow();
+
+    if (m_Drain)
+    {
+        ReadAll();
+    }
+}
+
+static void Init(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_921600));
+
+    UartRegisterReceiveHandler(&m_Uart, &OnReceive);
+}
+
+static void Receive(const uint8_t* data, uint32_t size)
+{
+    uint64_t frame = Stm32UsartFrameCycles(USART1);
+
+    Stm32UsartReceive(USART1, data, size);
+
+    /* frames and one idle frame */
+    SimClockRun(frame * (size + 2U));
+}
+
+static void TestIdleDeliversShortMessage(void)
+{
+    Init();
+
+    uint64_t frame = Stm32UsartFrameCycles(USART1);
+    uint64_t lastStop = SimClockNow() + frame * 5U;
+
+    Receive(m_Data, 5);
+
+    CHECK_EQ(m_Callbacks, 1);
+    CHECK_EQ(BufferCount(&m_Uart.rxBuffer), 5);
+
+    /* delivered one idle frame after the last stop bit */
+    CHECK(m_CallbackTime >= lastStop + frame);
+    CHECK(m_CallbackTime < lastStop + 2U * frame);
+
+    ReadAll();
+    CHECK_EQ(m_ReadCount, 5);
+    CHECK_MEM(m_Read, m_Data, 5);
+
+    /* no interrupt per byte */
+    CHECK_EQ(SimIrqCount(USART1_IRQn), 1);
+    CHECK_EQ(SimIrqCount(DMA2_Stream2_IRQn), 0);
+}
+
+static void TestHalfTransferDeliversLongMessage(void)
+{
+    Init();
+
+    uint64_t frame = Stm32UsartFrameCycles(USART1);
+
+    /* half of the staging buffer is reached with the 32nd byte */
+    Stm32UsartReceive(USART1, m_Data, 40);
+    SimClockRun(frame * 33U);
+
+    CHECK_EQ(m_Callbacks, 1);
+    CHECK_EQ(BufferCount(&m_Uart.rxBuffer), UART_RX_DMA_SIZE / 2);
+    CHECK_EQ(SimIrqCount(DMA2_Stream2_IRQn), 1);
+
+    SimClockRun(frame * 8U);
+
+    CHECK_EQ(m_Callbacks, 2);
+    CHECK_EQ(BufferCount(&m_Uart.rxBuffer), 40);
+
+    ReadAll();
+    CHECK_MEM(m_Read, m_Data, 40);
+}
+
+static void TestCircularWrap(void)
+{
+    Init();
+
+    m_Drain = true;
+
+    Receive(m_Data, 50);
+    Receive(&m_Data[50], 50);
+    Receive(&m_Data[100], 50);
+
+    CHECK_EQ(m_ReadCount, 150);
+    CHECK_MEM(m_Read, m_Data, 150);
+
+    UART_Stats_t stats;
+
+    UartGetStats(&m_Uart, &stats);
+    CHECK_EQ(stats.rxBytes, 150);
+    CHECK_EQ(stats.rxDropped, 0);
+}
+
+static void TestSlowReaderDropsNewBytes(void)
+{
+    Init();
+
+    /* two staging buffer laps while nobody reads */
+    Receive(m_Data, 60);
+    Receive(&m_Data[60], 70);
+
+    UART_Stats_t stats;
+
+    UartGetStats(&m_Uart, &stats);
+    CHECK_EQ(stats.rxBytes, 130);
+    CHECK_EQ(stats.rxDropped, 130 - TEST_RX_CAPACITY);
+    CHECK_EQ(BufferCount(&m_Uart.rxBuffer), TEST_RX_CAPACITY);
+
+    /* the oldest data is kept intact */
+    ReadAll();
+    CHECK_EQ(m_ReadCount, TEST_RX_CAPACITY);
+    CHECK_MEM(m_Read, m_Data, TEST_RX_CAPACITY);
+
+    /* once drained fresh data arrives in order, nothing else is dropped */
+    m_ReadCount = 0;
+
+    Receive(&m_Data[200], 10);
+    ReadAll();
+
+    CHECK_EQ(m_ReadCount, 10);
+    CHECK_MEM(m_Read, &m_Data[200], 10);
+
+    UartGetStats(&m_Uart, &stats);
+    CHECK_EQ(stats.rxDropped, 130 - TEST_RX_CAPACITY);
+}
+
+static void TestLineErrorsCounted(void)
+{
+    Init();
+
+    Stm32UsartReceiveError(USART1, USART_SR_FE);
+    Receive(m_Data, 3);
+
+    Stm32UsartReceiveError(USART1, USART_SR_NE);
+    Receive(&m_Data[3], 3);
+
+    UART_Stats_t stats;
+
+    UartGetStats(&m_Uart, &stats);
+    CHECK_EQ(stats.framingErrors, 1);
+    CHECK_EQ(stats.noiseErrors, 1);
+    CHECK_EQ(stats.overrunErrors, 0);
+
+    /* DMA keeps receiving */
+    ReadAll();
+    CHECK_EQ(m_ReadCount, 6);
+    CHECK_MEM(m_Read, m_Data, 6);
+}
+
+static void TestDmaErrorRestartsReception(void)
+{
+    Init();
+
+    Stm32DmaInjectError(DMA2_Stream2);
+    Receive(m_Data, 5);
+
+    UART_Stats_t stats;
+
+    UartGetStats(&m_Uart, &stats);
+    CHECK_EQ(stats.dmaErrors, 1);
+
+    ReadAll();
+    m_ReadCount = 0;
+
+    Receive(&m_Data[5], 5);
+
+    ReadAll();
+    CHECK_EQ(m_ReadCount, 5);
+    CHECK_MEM(m_Read, &m_Data[5], 5);
+}
+
+static const Test_t m_Tests[] = {
+    TEST(TestIdleDeliversShortMessage),
+    TEST(TestHalfTransferDeliversLongMessage),
+    TEST(TestCircularWrap),
+    TEST(TestSlowReaderDropsNewBytes),
+    TEST(TestLineErrorsCounted),
+    TEST(TestDmaErrorRestartsReception),
+};
+
+int main(void)
+{
+    return TestRun("stm32f4xx uart rx", m_Tests, TEST_COUNT(m_Tests), &Setup);
+}
@@ -0,0 +1,291 @@
+#include <string.h>
+
+#include "test.h"
+#include "mmio.h"
+#include "stm32-sim.h"
+#include "uart.h"
+
+/* UART DMA transmit path on the register-level STM32F411 model:
+ * USART1 at 921600 baud from 100 MHz APB2, TX DMA2 stream 7 */
+
+#define TEST_HCLK               (100000000U)
+#define TEST_TX_CAPACITY        (64U)
+#define TEST_RX_CAPACITY        (64U)
+
+UART_HANDLE_DEFINE(m_Uart, TEST_TX_CAPACITY, TEST_RX_CAPACITY);
+
+static uint8_t m_Data[512];
+static uint8_t m_Wire[1024];
+
+static void Setup(void)
+{
+    Stm32SimReset(TEST_HCLK, 2, 1);
+
+    m_Uart.onRxDone = NULL;
+
+    for (uint32_t i = 0; i < sizeof(m_Data); i++)
+    {
+        m_Data[i] = (uint8_t)(i * 7U + 3U);
+    }
+
+    memset(m_Wire, 0, sizeof(m_Wire));
+}
+
+static bool UartTxIdle(void* context)
+{
+    return UartIdle((UART_Handle_t*)context);
+}
+
+/*Brief: Let the line drain, then collect wire log
+ * [in] - none
+ * [out] - number of frames sent since the last call
+ * */
+static uint32_t Drain(void)
+{
+    uint64_t limit = Stm32UsartFrameCycles(USART1) * (sizeof(m_Wire) + 4U);
+
+    CHECK(SimClockRunUntil(&UartTxIdle, &m_Uart, limit));
+
+    /* TC is raised at the end of the last stop bit */
+    return Stm32UsartTransmitted(USART1, m_Wire, sizeof(m_Wire));
+}
+
+static void TestInitProgramsDmaStreams(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_921600));
+
+    MmioOpen();
+    uint32_t txCr = DMA2_Stream7->CR;
+    uint32_t rxCr = DMA2_Stream2->CR;
+    uint32_t cr3 = USART1->CR3;
+    MmioClose();
+
+    CHECK_EQ((txCr & DMA_SxCR_CHSEL) >> DMA_SxCR_CHSEL_Pos, 4);
+    CHECK_EQ(txCr & DMA_SxCR_DIR, DMA_SxCR_DIR_0);
+    CHECK(txCr & DMA_SxCR_MINC);
+    CHECK(!(txCr & DMA_SxCR_EN));
+    CHECK((cr3 & USART_CR3_DMAT) != 0U);
+
+    /* RX stream is running in circular mode right away */
+    CHECK_EQ((rxCr & DMA_SxCR_CHSEL) >> DMA_SxCR_CHSEL_Pos, 4);
+    CHECK(rxCr & DMA_SxCR_CIRC);
+    CHECK(rxCr & DMA_SxCR_EN);
+
+    CHECK(UartIdle(&m_Uart));
+}
+
+static void TestWriteIsOneDmaTransfer(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_921600));
+
+    uint64_t frame = Stm32UsartFrameCycles(USART1);
+    uint64_t start = SimClockNow();
+
+    CHECK_EQ(UartWrite_IT(&m_Uart, m_Data, 50), 50);
+    CHECK(!UartIdle(&m_Uart));
+
+    uint64_t accesses = MmioAccessCount();
+
+    CHECK_EQ(Drain(), 50);
+    CHECK_MEM(m_Wire, m_Data, 50);
+
+    /* frames go out back to back */
+    uint64_t elapsed = SimClockNow() - start;
+
+    CHECK(elapsed >= 50U * frame);
+    CHECK(elapsed < 52U * frame);
+
+    /* no per-byte CPU work: one DMA start, one DMA and one TC interrupt */
+    CHECK_EQ(Stm32DmaStarts(DMA2_Stream7), 1);
+    CHECK_EQ(SimIrqCount(DMA2_Stream7_IRQn), 1);
+    CHECK_EQ(SimIrqCount(USART1_IRQn), 1);
+    CHECK(MmioAccessCount() - accesses < 50U);
+
+    UART_Stats_t stats;
+
+    UartGetStats(&m_Uart, &stats);
+    CHECK_EQ(stats.txBytes, 50);
+    CHECK_EQ(stats.dmaErrors, 0);
+}
+
+static void TestIdleOnlyAfterLastStopBit(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_921600));
+
+    /* TC left set by reset or by a previous transfer must not end the next one */
+    for (uint32_t round = 0; round < 3U; round++)
+    {
+        CHECK_EQ(UartWrite_IT(&m_Uart, m_Data, 10), 10);
+
+        CHECK(SimClockRunUntil(&UartTxIdle, &m_Uart, Stm32UsartFrameCycles(USART1) * 20U));
+        CHECK_EQ(Stm32UsartTransmitted(USART1, m_Wire, sizeof(m_Wire)), 10);
+    }
+}
+
+static void TestWrappedDataIsTwoSegments(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_921600));
+
+    CHECK_EQ(UartWrite_IT(&m_Uart, m_Data, 40), 40);
+    CHECK_EQ(Drain(), 40);
+
+    /* 24 bytes up to the end of storage, 16 from its start */
+    CHECK_EQ(UartWrite_IT(&m_Uart, &m_Data[40], 40), 40);
+    CHECK_EQ(Drain(), 40);
+    CHECK_MEM(m_Wire, &m_Data[40], 40);
+
+    CHECK_EQ(Stm32DmaStarts(DMA2_Stream7), 3);
+}
+
+static void TestFullRingAcceptsPart(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_921600));
+
+    CHECK_EQ(UartWrite_IT(&m_Uart, m_Data, 100), TEST_TX_CAPACITY);
+    CHECK_EQ(UartWrite_IT(&m_Uart, &m_Data[TEST_TX_CAPACITY], 10), 0);
+
+    CHECK_EQ(Drain(), TEST_TX_CAPACITY);
+    CHECK_MEM(m_Wire, m_Data, TEST_TX_CAPACITY);
+}
+
+static void TestWriteWhileBusyIsChained(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_921600));
+
+    CHECK_EQ(UartWrite_IT(&m_Uart, m_Data, 20), 20);
+
+    SimClockRun(Stm32UsartFrameCycles(USART1) * 5U);
+
+    CHECK_EQ(UartWrite_IT(&m_Uart, &m_Data[20], 20), 20);
+
+    CHECK_EQ(Drain(), 40);
+    CHECK_MEM(m_Wire, m_Data, 40);
+
+    /* queued data is started from the DMA interrupt, no TC interrupt in between */
+    CHECK_EQ(Stm32DmaStarts(DMA2_Stream7), 2);
+    CHECK_EQ(SimIrqCount(USART1_IRQn), 1);
+}
+
+static void TestWriteTimeoutWaitsForSpace(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_921600));
+
+    CHECK_EQ(UartWriteTimeout(&m_Uart, m_Data, 300, 10000), 300);
+
+    CHECK_EQ(Drain(), 300);
+    CHECK_MEM(m_Wire, m_Data, 300);
+}
+
+static void TestWriteTimeoutExpires(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_9600));
+
+    /* 9600 baud drains ~10 bytes in 10 ms */
+    uint32_t accepted = UartWriteTimeout(&m_Uart, m_Data, 300, 10000);
+
+    CHECK(accepted >= TEST_TX_CAPACITY);
+    CHECK(accepted < TEST_TX_CAPACITY + 12U);
+}
+
+static void TestWriteNotifyWaitsForSpace(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_921600));
+
+    CHECK_EQ(UartWriteNotify(&m_Uart, m_Data, 300, 100), 300);
+    CHECK(m_Uart.txWaiter == NULL);
+
+    CHECK_EQ(Drain(), 300);
+    CHECK_MEM(m_Wire, m_Data, 300);
+}
+
+static void TestWriteNotifyRejectsSecondWaiter(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_921600));
+
+    /* another task is blocked on the port */
+    m_Uart.txWaiter = xTaskGetCurrentTaskHandle();
+
+    CHECK_EQ(UartWriteNotify(&m_Uart, m_Data, 10, 100), 0);
+
+    m_Uart.txWaiter = NULL;
+}
+
+static void TestDmaErrorDropsSegment(void)
+{
+    CHECK(UartInit(&m_Uart, UART_1, BAUD_921600));
+
+    Stm32DmaInjectError(DMA2_Stream7);
+
+    CHECK_EQ(UartWrite_IT(&m_Uart, m_Data, 10), 10);
+    CHECK_EQ(Drain(), 0);
+
+    /* next write goes through */
+    CHECK_EQ(UartWrite_IT(&m_Uart, &m_Data[10], 10), 10);
+    CHECK_EQ(Drain(), 10);
+    CHECK_MEM(m_Wire, &m_Data[10], 10);
+
+    UART_Stats_t stats;
+
+    UartGetStats(&m_Uart, &stats);
+    CHECK_EQ(stats.dmaErrors, 1);
+    CHECK_EQ(stats.txBytes, 10);
+}
+
+static bool DriverReleased(void* context)
+{
+    return !SimGpioLevel(*(const uint8_t*)context);
+}
+
+static void TestRs485DriverCoversLastFrame(void)
+{
+    static UART_Config_t config;
+
+    config = *UartGetDefaultConfig(UART_1);
+    config.flowControl = UART_FLOW_RS485;
+    config.dePin = PA_8;
+
+    CHECK(UartInitConfig(&m_Uart, &config, BAUD_921600));
+    CHECK(!SimGpioLevel(PA_8));
+
+    CHECK_EQ(UartWrite_IT(&m_Uart, m_Data, 10), 10);
+    CHECK(SimGpioLevel(PA_8));
+
+    /* transceiver is switched back to receive after the last stop bit */
+    CHECK(SimClockRunUntil(&DriverReleased, &config.dePin, Stm32UsartFrameCycles(USART1) * 20U));
+    CHECK_EQ(Stm32UsartTransmitted(USART1, m_Wire, sizeof(m_Wire)), 10);
+    CHECK(UartIdle(&m_Uart));
+}
+
+static void TestUsart2OnApb1(void)
+{
+    CHECK(UartInit(&m_Uart, UART_2, BAUD_115200));
+
+    CHECK_EQ(UartWrite_IT(&m_Uart, m_Data, 16), 16);
+
+    CHECK(SimClockRunUntil(&UartTxIdle, &m_Uart, Stm32UsartFrameCycles(USART2) * 20U));
+    CHECK_EQ(Stm32UsartTransmitted(USART2, m_Wire, sizeof(m_Wire)), 16);
+    CHECK_MEM(m_Wire, m_Data, 16);
+
+    CHECK_EQ(Stm32DmaStarts(DMA1_Stream6), 1);
+}
+
+static const Test_t m_Tests[] = {
+    TEST(TestInitProgramsDmaStreams),
+    TEST(TestWriteIsOneDmaTransfer),
+    TEST(TestIdleOnlyAfterLastStopBit),
+    TEST(TestWrappedDataIsTwoSegments),
+    TEST(TestFullRingAcceptsPart),
+    TEST(TestWriteWhileBusyIsChained),
+    TEST(TestWriteTimeoutWaitsForSpace),
+    TEST(TestWriteTimeoutExpires),
+    TEST(TestWriteNotifyWaitsForSpace),
+    TEST(TestWriteNotifyRejectsSecondWaiter),
+    TEST(TestDmaErrorDropsSegment),
+    TEST(TestRs485DriverCoversLastFrame),
+    TEST(TestUsart2OnApb1),
+};
+
+int main(void)
+{
+    return TestRun("stm32f4xx uart", m_Tests, TEST_COUNT(m_Tests), &Setup);
+}
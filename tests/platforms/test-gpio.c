@@ -0,0 +1,446 @@
+#include <string.h>
+
+#include "test.h"
+#include "gpio.h"
+#include "gpio-board.h"
+
+/* GpioOps_t conformance suite, built once per platform against its model.
+ * gpio-board.h of the platform (tests/platforms/<MCU>) names the pins and
+ * the documented differences between the backends */
+
+#define GROUP_WIDTH             (4U)
+
+extern const GpioOps_t g_GpioOps;
+
+static GpioHandle_t m_Pin;
+static GpioPortHandle_t m_Group;
+static uint32_t m_IrqCount;
+
+static void Setup(void)
+{
+    BoardReset();
+
+    memset(&m_Pin, 0, sizeof(m_Pin));
+    memset(&m_Group, 0, sizeof(m_Group));
+
+    m_Pin.ops = &g_GpioOps;
+    m_Group.ops = &g_GpioOps;
+    m_IrqCount = 0;
+}
+
+static void OnEdge(void)
+{
+    m_IrqCount++;
+}
+
+/*Brief: Open pin on a fresh handle
+ * */
+static void Open(GpioHandle_t* const handle, uint8_t pin, PIN_MODES mode, PIN_TYPES pull, PIN_CONFIGS config,
+                 uint32_t value)
+{
+    memset(handle, 0, sizeof(*handle));
+
+    handle->ops = &g_GpioOps;
+    handle->ops->open(handle, pin, mode, pull, PIN_STRENGTH_LOW, config, value);
+}
+
+/*Brief: Pad levels of the group pins as bus value
+ * */
+static uint32_t GroupLevels(void)
+{
+    uint32_t value = 0;
+
+    for (uint32_t i = 0; i < GROUP_WIDTH; i++)
+    {
+        value |= SimGpioLevel((uint8_t)(BOARD_PIN_GROUP + i)) ? (1U << i) : 0U;
+    }
+
+    return value;
+}
+
+static void TestOutputOpensAtInitialLevel(void)
+{
+    Open(&m_Pin, BOARD_PIN_OUT, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_PUSH_PULL, PIN_STATE_HIGH);
+
+    CHECK(m_Pin.initialized);
+    CHECK(SimGpioDriven(BOARD_PIN_OUT));
+    CHECK(SimGpioLevel(BOARD_PIN_OUT));
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 1);
+
+    Open(&m_Pin, BOARD_PIN_OUT, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_PUSH_PULL, PIN_STATE_LOW);
+
+    CHECK(SimGpioDriven(BOARD_PIN_OUT));
+    CHECK(!SimGpioLevel(BOARD_PIN_OUT));
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0);
+}
+
+static void TestWriteAndToggle(void)
+{
+    Open(&m_Pin, BOARD_PIN_OUT, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_PUSH_PULL, PIN_STATE_LOW);
+
+    m_Pin.ops->write(&m_Pin, PIN_STATE_HIGH);
+    CHECK(SimGpioLevel(BOARD_PIN_OUT));
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 1);
+
+    m_Pin.ops->write(&m_Pin, PIN_STATE_LOW);
+    CHECK(!SimGpioLevel(BOARD_PIN_OUT));
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0);
+
+    m_Pin.ops->toggle(&m_Pin);
+    CHECK(SimGpioLevel(BOARD_PIN_OUT));
+
+    m_Pin.ops->toggle(&m_Pin);
+    CHECK(!SimGpioLevel(BOARD_PIN_OUT));
+
+    /* push-pull output is stronger than the outside */
+    SimGpioDrive(BOARD_PIN_OUT, true);
+    CHECK(!SimGpioLevel(BOARD_PIN_OUT));
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0);
+}
+
+static void TestInputFollowsPad(void)
+{
+    Open(&m_Pin, BOARD_PIN_IN, PIN_MODE_INPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_PUSH_PULL, 0);
+
+    CHECK(m_Pin.initialized);
+    CHECK(!SimGpioDriven(BOARD_PIN_IN));
+
+    SimGpioDrive(BOARD_PIN_IN, true);
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 1);
+
+    SimGpioDrive(BOARD_PIN_IN, false);
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0);
+
+    /* floating */
+    SimGpioRelease(BOARD_PIN_IN);
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0);
+}
+
+static void TestInputPullUp(void)
+{
+    Open(&m_Pin, BOARD_PIN_IN, PIN_MODE_INPUT, PIN_TYPE_PULL_UP, PIN_CONFIG_PUSH_PULL, 0);
+
+    CHECK(!SimGpioDriven(BOARD_PIN_IN));
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 1);
+
+    SimGpioDrive(BOARD_PIN_IN, false);
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0);
+
+    SimGpioRelease(BOARD_PIN_IN);
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 1);
+}
+
+static void TestInputPullDown(void)
+{
+#if BOARD_PULL_DOWN
+    Open(&m_Pin, BOARD_PIN_IN, PIN_MODE_INPUT, PIN_TYPE_PULL_DOWN, PIN_CONFIG_PUSH_PULL, 0);
+
+    CHECK(!SimGpioDriven(BOARD_PIN_IN));
+
+    SimGpioDrive(BOARD_PIN_IN, true);
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 1);
+
+    SimGpioRelease(BOARD_PIN_IN);
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0);
+#else
+    /* no pull-down on the pads */
+    TEST_EXPECT_ASSERT(Open(&m_Pin, BOARD_PIN_IN, PIN_MODE_INPUT, PIN_TYPE_PULL_DOWN, PIN_CONFIG_PUSH_PULL, 0));
+#endif
+}
+
+static void TestOpenDrain(void)
+{
+    Open(&m_Pin, BOARD_PIN_OUT, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_OPEN_DRAIN, PIN_STATE_HIGH);
+
+    /* high is released: the line is up to the outside */
+    CHECK(!SimGpioDriven(BOARD_PIN_OUT));
+
+    SimGpioDrive(BOARD_PIN_OUT, false);
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0);
+
+    SimGpioDrive(BOARD_PIN_OUT, true);
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 1);
+
+    /* low wins over the outside */
+    m_Pin.ops->write(&m_Pin, PIN_STATE_LOW);
+    CHECK(SimGpioDriven(BOARD_PIN_OUT));
+    CHECK(!SimGpioLevel(BOARD_PIN_OUT));
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0);
+
+    m_Pin.ops->toggle(&m_Pin);
+    CHECK(!SimGpioDriven(BOARD_PIN_OUT));
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 1);
+
+    m_Pin.ops->toggle(&m_Pin);
+    CHECK(SimGpioDriven(BOARD_PIN_OUT));
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0);
+
+    m_Pin.ops->write(&m_Pin, PIN_STATE_HIGH);
+    SimGpioRelease(BOARD_PIN_OUT);
+    CHECK(!SimGpioDriven(BOARD_PIN_OUT));
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0);
+}
+
+/*Brief: Arm input interrupt with line low, then run two pulses
+ * [in] - mode - edges to report
+ * [out] - handler calls after each edge: rise, fall, rise, fall
+ * */
+static void Pulses(PIN_IRQ_MODES mode, uint32_t counts[4])
+{
+    Setup();
+
+    SimGpioDrive(BOARD_PIN_IN, false);
+
+    Open(&m_Pin, BOARD_PIN_IN, PIN_MODE_INPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_PUSH_PULL, 0);
+    m_Pin.ops->interrupt(&m_Pin, mode, 2, &OnEdge);
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        SimGpioDrive(BOARD_PIN_IN, (i % 2U) == 0U);
+        counts[i] = m_IrqCount;
+    }
+}
+
+static void TestInterruptEdges(void)
+{
+    uint32_t counts[4];
+
+    Pulses(PIN_IRQ_RISING, counts);
+    CHECK_EQ(counts[0], 1);
+    CHECK_EQ(counts[1], 1);
+    CHECK_EQ(counts[2], 2);
+    CHECK_EQ(counts[3], 2);
+
+    Pulses(PIN_IRQ_FALLING, counts);
+    CHECK_EQ(counts[0], 0);
+    CHECK_EQ(counts[1], 1);
+    CHECK_EQ(counts[2], 1);
+    CHECK_EQ(counts[3], 2);
+
+    Pulses(PIN_IRQ_BOTH, counts);
+    CHECK_EQ(counts[0], 1);
+    CHECK_EQ(counts[1], 2);
+    CHECK_EQ(counts[2], 3);
+    CHECK_EQ(counts[3], 4);
+}
+
+static void TestInterruptIgnoresOtherPins(void)
+{
+    GpioHandle_t out;
+
+    Open(&m_Pin, BOARD_PIN_IN, PIN_MODE_INPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_PUSH_PULL, 0);
+    m_Pin.ops->interrupt(&m_Pin, PIN_IRQ_BOTH, 2, &OnEdge);
+
+    Open(&out, BOARD_PIN_OUT, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_PUSH_PULL, PIN_STATE_LOW);
+    out.ops->toggle(&out);
+    out.ops->toggle(&out);
+
+    m_Group.ops->portOpen(&m_Group, BOARD_PIN_GROUP, GROUP_WIDTH, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL,
+                          PIN_STRENGTH_LOW, PIN_CONFIG_PUSH_PULL, 0);
+    m_Group.ops->portWrite(&m_Group, 0x0F);
+    m_Group.ops->portWrite(&m_Group, 0x05);
+
+    /* edges of other pins, on the same port too */
+    SimGpioDrive(BOARD_PIN_GUARD, true);
+    SimGpioDrive(BOARD_PIN_GUARD, false);
+
+    CHECK_EQ(m_IrqCount, 0);
+
+    SimGpioDrive(BOARD_PIN_IN, true);
+    CHECK_EQ(m_IrqCount, 1);
+}
+
+/*Brief: Event mode as a portable caller uses it: optional ops are
+ * checked for NULL before an interrupt without handler is armed
+ * */
+static void TestEventModeFollowsOps(void)
+{
+    const GpioOps_t* ops = &g_GpioOps;
+    bool events = (ops->getEvents != NULL);
+
+    CHECK_EQ(events, BOARD_EVENTS);
+
+    /* event ops are present or absent together */
+    CHECK_EQ(ops->getEvent != NULL, events);
+    CHECK_EQ(ops->getEventsLost != NULL, events);
+    CHECK_EQ(ops->filter != NULL, events);
+
+    SimGpioDrive(BOARD_PIN_IN, false);
+    Open(&m_Pin, BOARD_PIN_IN, PIN_MODE_INPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_PUSH_PULL, 0);
+
+    if (!events)
+    {
+        /* no edge queue: event mode is rejected, not silently dropped */
+        TEST_EXPECT_ASSERT(ops->interrupt(&m_Pin, PIN_IRQ_RISING, 2, NULL));
+        return;
+    }
+
+    GpioEvent_t event;
+
+    /* queue outlives the tests of this binary */
+    while (ops->getEvent(&event))
+    {
+    }
+
+    ops->interrupt(&m_Pin, PIN_IRQ_RISING, 2, NULL);
+
+    SimGpioDrive(BOARD_PIN_IN, true);
+    SimGpioDrive(BOARD_PIN_IN, false);
+
+    CHECK(ops->getEvent(&event));
+    CHECK(event.handle == &m_Pin);
+    CHECK_EQ(event.state, PIN_STATE_HIGH);
+    CHECK(!ops->getEvent(&event));
+    CHECK_EQ(ops->getEventsLost(), 0);
+}
+
+static void TestClosedPinIsIgnored(void)
+{
+    Open(&m_Pin, BOARD_PIN_OUT, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_PUSH_PULL, PIN_STATE_LOW);
+
+    m_Pin.ops->close(&m_Pin);
+    CHECK(!m_Pin.initialized);
+
+    bool level = SimGpioLevel(BOARD_PIN_OUT);
+
+    m_Pin.ops->write(&m_Pin, PIN_STATE_HIGH);
+    m_Pin.ops->toggle(&m_Pin);
+
+    CHECK_EQ(SimGpioLevel(BOARD_PIN_OUT), level);
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0xFF);
+
+    /* closing twice is harmless */
+    m_Pin.ops->close(&m_Pin);
+}
+
+static void TestUnconnectedPin(void)
+{
+    Open(&m_Pin, PIN_NC, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_PUSH_PULL, PIN_STATE_HIGH);
+
+    CHECK(!m_Pin.initialized);
+
+    m_Pin.ops->write(&m_Pin, PIN_STATE_LOW);
+    m_Pin.ops->toggle(&m_Pin);
+    m_Pin.ops->interrupt(&m_Pin, PIN_IRQ_RISING, 2, &OnEdge);
+
+    CHECK_EQ(m_Pin.ops->read(&m_Pin), 0xFF);
+}
+
+static void TestGroupWrite(void)
+{
+    GpioHandle_t guard;
+
+    Open(&guard, BOARD_PIN_GUARD, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_PUSH_PULL, PIN_STATE_HIGH);
+
+    m_Group.ops->portOpen(&m_Group, BOARD_PIN_GROUP, GROUP_WIDTH, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL,
+                          PIN_STRENGTH_LOW, PIN_CONFIG_PUSH_PULL, 0x05);
+
+    CHECK(m_Group.initialized);
+    CHECK_EQ(GroupLevels(), 0x05);
+    CHECK_EQ(m_Group.ops->portRead(&m_Group), 0x05);
+
+    m_Group.ops->portWrite(&m_Group, 0x0A);
+    CHECK_EQ(GroupLevels(), 0x0A);
+    CHECK_EQ(m_Group.ops->portRead(&m_Group), 0x0A);
+
+    /* bits above the width are dropped */
+    m_Group.ops->portWrite(&m_Group, 0xF0);
+    CHECK_EQ(GroupLevels(), 0x00);
+
+    m_Group.ops->portWrite(&m_Group, 0xFF);
+    CHECK_EQ(GroupLevels(), 0x0F);
+
+    CHECK(SimGpioLevel(BOARD_PIN_GUARD));
+
+    m_Group.ops->portWrite(&m_Group, 0x00);
+    CHECK(SimGpioLevel(BOARD_PIN_GUARD));
+}
+
+static void TestGroupSetReset(void)
+{
+    GpioHandle_t guard;
+
+    Open(&guard, BOARD_PIN_GUARD, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL, PIN_CONFIG_PUSH_PULL, PIN_STATE_HIGH);
+
+    m_Group.ops->portOpen(&m_Group, BOARD_PIN_GROUP, GROUP_WIDTH, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL,
+                          PIN_STRENGTH_LOW, PIN_CONFIG_PUSH_PULL, 0x05);
+
+    /* pin 1 in both masks: set wins; pin 3 in none: kept */
+    m_Group.ops->portSetReset(&m_Group, 0x03, 0x06);
+    CHECK_EQ(GroupLevels(), 0x03);
+
+    m_Group.ops->portSetReset(&m_Group, 0x08, 0x00);
+    CHECK_EQ(GroupLevels(), 0x0B);
+
+    m_Group.ops->portSetReset(&m_Group, 0x00, 0xFF);
+    CHECK_EQ(GroupLevels(), 0x00);
+
+    CHECK(SimGpioLevel(BOARD_PIN_GUARD));
+}
+
+static void TestGroupReadsInputs(void)
+{
+    m_Group.ops->portOpen(&m_Group, BOARD_PIN_GROUP, GROUP_WIDTH, PIN_MODE_INPUT, PIN_TYPE_NO_PULL,
+                          PIN_STRENGTH_LOW, PIN_CONFIG_PUSH_PULL, 0);
+
+    SimGpioDrive(BOARD_PIN_GROUP, true);
+    SimGpioDrive(BOARD_PIN_GROUP + 3, true);
+    SimGpioDrive(BOARD_PIN_GUARD, true);
+
+    CHECK_EQ(m_Group.ops->portRead(&m_Group), 0x09);
+
+    SimGpioDrive(BOARD_PIN_GROUP, false);
+    SimGpioDrive(BOARD_PIN_GROUP + 1, true);
+
+    CHECK_EQ(m_Group.ops->portRead(&m_Group), 0x0A);
+}
+
+static void TestGroupOpenDrain(void)
+{
+    /* all released, the bus is pulled up outside */
+    m_Group.ops->portOpen(&m_Group, BOARD_PIN_GROUP, GROUP_WIDTH, PIN_MODE_OUTPUT, PIN_TYPE_NO_PULL,
+                          PIN_STRENGTH_LOW, PIN_CONFIG_OPEN_DRAIN, 0x0F);
+
+    for (uint32_t i = 0; i < GROUP_WIDTH; i++)
+    {
+        CHECK(!SimGpioDriven((uint8_t)(BOARD_PIN_GROUP + i)));
+        SimGpioDrive((uint8_t)(BOARD_PIN_GROUP + i), true);
+    }
+
+    CHECK_EQ(m_Group.ops->portRead(&m_Group), 0x0F);
+
+    m_Group.ops->portWrite(&m_Group, 0x06);
+    CHECK_EQ(m_Group.ops->portRead(&m_Group), 0x06);
+    CHECK(SimGpioDriven(BOARD_PIN_GROUP));
+    CHECK(!SimGpioDriven(BOARD_PIN_GROUP + 1));
+
+    m_Group.ops->portSetReset(&m_Group, 0x01, 0x02);
+    CHECK_EQ(m_Group.ops->portRead(&m_Group), 0x05);
+
+    /* another device pulls a released line low */
+    SimGpioDrive(BOARD_PIN_GROUP + 2, false);
+    CHECK_EQ(m_Group.ops->portRead(&m_Group), 0x01);
+}
+
+static const Test_t m_Tests[] = {
+    TEST(TestOutputOpensAtInitialLevel),
+    TEST(TestWriteAndToggle),
+    TEST(TestInputFollowsPad),
+    TEST(TestInputPullUp),
+    TEST(TestInputPullDown),
+    TEST(TestOpenDrain),
+    TEST(TestInterruptEdges),
+    TEST(TestInterruptIgnoresOtherPins),
+    TEST(TestEventModeFollowsOps),
+    TEST(TestClosedPinIsIgnored),
+    TEST(TestUnconnectedPin),
+    TEST(TestGroupWrite),
+    TEST(TestGroupSetReset),
+    TEST(TestGroupReadsInputs),
+    TEST(TestGroupOpenDrain),
+};
+
+int main(void)
+{
+    return TestRun(BOARD_NAME " gpio", m_Tests, TEST_COUNT(m_Tests), &Setup);
+}
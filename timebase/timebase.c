@@ -0,0 +1,62 @@
+#include <stddef.h>
+
+#include "stm32f411xe.h"
+
+#include "custom-assert.h"
+#include "timebase.h"
+
+/* core clock may be changed at runtime, so it is read on every conversion */
+#define TICKS_IN_US     (SystemCoreClock / 1000000U)
+
+void TimebaseInit(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t TimebaseNow(void)
+{
+    return DWT->CYCCNT;
+}
+
+uint32_t TimebaseUsToTicks(uint32_t usec)
+{
+    uint32_t ticksInUs = TICKS_IN_US;
+
+    /* longest interval the counter can measure, see TIMEBASE_MAX_US */
+    if (usec > (UINT32_MAX / ticksInUs))
+    {
+        return UINT32_MAX;
+    }
+
+    return usec * ticksInUs;
+}
+
+uint32_t TimebaseTicksToUs(uint32_t ticks)
+{
+    return ticks / TICKS_IN_US;
+}
+
+bool TimebaseElapsed(uint32_t start, uint32_t ticks)
+{
+    return (uint32_t)(TimebaseNow() - start) >= ticks;
+}
+
+bool TimebaseWaitFlag(volatile const uint32_t* const reg, uint32_t flag, bool state, uint32_t timeoutUs)
+{
+    ASSERT(reg != NULL);
+
+    uint32_t start = TimebaseNow();
+    uint32_t ticks = TimebaseUsToTicks(timeoutUs);
+
+    while (((*reg & flag) != 0) != state)
+    {
+        if (TimebaseElapsed(start, ticks))
+        {
+            /* flag may have changed while being preempted */
+            return ((*reg & flag) != 0) == state;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,56 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Monotonic free running tick counter: CPU cycles (DWT CYCCNT) on Cortex-M4
+ * (host tests link tests/fakes/common/sim-timebase.c instead). Counter wraps,
+ * so intervals are limited to 2^32 ticks */
+
+/* longest interval at 100 MHz core clock: 2^32 cycles */
+#define TIMEBASE_MAX_US     (42949672U)
+
+/*Brief: Time base initialization (safe to call several times)
+ * [in] - none
+ * [out] - none
+ * */
+void TimebaseInit(void);
+
+/*Brief: Current tick counter
+ * [in] - none
+ * [out] - ticks
+ * */
+uint32_t TimebaseNow(void);
+
+/*Brief: Convert microseconds to ticks
+ * NOTE: intervals beyond the counter range (UINT32_MAX / ticks per us, about
+ * TIMEBASE_MAX_US at 100 MHz) saturate at UINT32_MAX ticks
+ * [in] - usec - microseconds
+ * [out] - ticks
+ * */
+uint32_t TimebaseUsToTicks(uint32_t usec);
+
+/*Brief: Convert ticks to microseconds
+ * [in] - ticks - ticks
+ * [out] - microseconds
+ * */
+uint32_t TimebaseTicksToUs(uint32_t ticks);
+
+/*Brief: Check if interval is elapsed (counter wrap safe)
+ * [in] - start - tick counter at the beginning of interval
+ * [in] - ticks - interval length
+ * [out] - true - elapsed; false - otherwise
+ * */
+bool TimebaseElapsed(uint32_t start, uint32_t ticks);
+
+/*Brief: Busy-wait until register flag gets required state or deadline expires
+ * [in] - reg - pointer to register
+ * [in] - flag - flag mask
+ * [in] - state - true - wait for flag set; false - wait for flag cleared
+ * [in] - timeoutUs - max time to wait
+ * [out] - true - flag has required state; false - timeout
+ * */
+bool TimebaseWaitFlag(volatile const uint32_t* const reg, uint32_t flag, bool state, uint32_t timeoutUs);
+
+#endif /* TIMEBASE_H */